@@ -129,9 +129,18 @@
 /* Define to 1 if you have the `rt' library (-lrt). */
 #cmakedefine HAVE_LIBRT 1
 
+/* Define to 1 if you have the <linux/io_uring.h> header file. */
+#cmakedefine HAVE_LINUX_IO_URING_H 1
+
 /* Define if you have LUSTRE. */
 #cmakedefine HAVE_LUSTRE 1
 
+/* Define if you have LZ4. */
+#cmakedefine HAVE_LZ4 1
+
+/* Define to 1 if you have the <lz4.h> header file. */
+#cmakedefine HAVE_LZ4_H 1
+
 /* Define to 1 if you have the <memory.h> header file. */
 #cmakedefine HAVE_MEMORY_H 1
 
@@ -263,6 +272,12 @@
 /* Define to 1 if you have the <zlib.h> header file. */
 #cmakedefine HAVE_ZLIB_H 1
 
+/* Define if you have ZSTD. */
+#cmakedefine HAVE_ZSTD 1
+
+/* Define to 1 if you have the <zstd.h> header file. */
+#cmakedefine HAVE_ZSTD_H 1
+
 /* Define if you have SZIP. */
 #cmakedefine HAVE_SZIP 1
 
@@ -309,6 +324,12 @@
 /* ADIOS timing is enabled */
 #cmakedefine ADIOS_TIMERS 1
 
+/* OpenMP threads copy large subvolumes */
+#cmakedefine ADIOS_OPENMP_COPY 1
+
+/* OpenMP threads calculate the statistics of large arrays */
+#cmakedefine ADIOS_OPENMP_STATS 1
+
 /* research_transports is enabled */
 #define RESEARCH_TRANSPORTS ${RESEARCH_TRANSPORTS}
 
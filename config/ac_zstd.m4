@@ -0,0 +1,117 @@
+#
+#
+# AC_ZSTD
+#
+#
+#
+dnl @synopsis AC_ZSTD
+dnl
+dnl This macro test if ZSTD is to be used.
+dnl Use in C code:
+dnl     #ifdef ZSTD
+dnl     #include "zstd.h"
+dnl     #endif
+dnl
+dnl @version 2.0
+dnl @author Norbert Podhorszki
+dnl
+AC_DEFUN([AC_ZSTD],[
+
+AC_MSG_NOTICE([=== checking for ZSTD ===])
+
+AM_CONDITIONAL(HAVE_ZSTD,true)
+
+AC_ARG_WITH(zstd,
+        [  --with-zstd=DIR      Location of ZSTD library],
+        [:], [with_zstd=no])
+
+if test "x$with_zstd" == "xno"; then
+
+   AM_CONDITIONAL(HAVE_ZSTD,false)
+
+else
+
+    save_CPPFLAGS="$CPPFLAGS"
+    save_LIBS="$LIBS"
+    save_LDFLAGS="$LDFLAGS"
+
+    if test "x$with_zstd" == "xyes"; then
+        dnl No path given
+        ZSTD_CPPFLAGS=""
+        ZSTD_LDFLAGS=""
+        ZSTD_LIBS="-lzstd"
+    else
+        dnl Path given, first try path/lib64
+        ZSTD_CPPFLAGS="-I$withval/include"
+        ZSTD_LDFLAGS="-L$withval/lib64"
+        ZSTD_LIBS="-lzstd"
+    fi
+
+    LIBS="$LIBS $ZSTD_LIBS"
+    LDFLAGS="$LDFLAGS $ZSTD_LDFLAGS"
+    CPPFLAGS="$CPPFLAGS $ZSTD_CPPFLAGS"
+
+    if test -z "${HAVE_ZSTD_TRUE}"; then
+           AC_CHECK_HEADERS(zstd.h,
+                   ,
+                   [AM_CONDITIONAL(HAVE_ZSTD,false)])
+    fi
+
+    if test -z "${HAVE_ZSTD_TRUE}"; then
+        dnl Try to link an example now
+        AC_MSG_CHECKING([if zstd code can be linked with $ZSTD_LDFLAGS])
+        AC_TRY_LINK(
+            [#include <stdlib.h>
+             #include "zstd.h"],
+            [char in[64], out[128];
+             ZSTD_CCtx * cctx = ZSTD_createCCtx ();
+             ZSTD_CCtx_setParameter (cctx, ZSTD_c_enableLongDistanceMatching, 1);
+             size_t n = ZSTD_compress2 (cctx, out, 128, in, 64);
+             return ZSTD_isError (n);],
+            [AC_MSG_RESULT(yes)],
+            [AM_CONDITIONAL(HAVE_ZSTD,false)
+             AC_MSG_RESULT(no)
+            ])
+
+        dnl If linking above failed, one reason might be that we looked in lib64/
+        dnl instead of lib/
+        if test -z "${HAVE_ZSTD_FALSE}"; then
+            if test "x$with_lustre" != "xyes"; then
+            ZSTD_LDFLAGS="-L$withval/lib"
+            LDFLAGS="$LDFLAGS $ZSTD_LDFLAGS"
+            AC_MSG_CHECKING([if zstd code can be linked with $ZSTD_LDFLAGS])
+            AC_TRY_LINK(
+                [#include <stdlib.h>
+                 #include "zstd.h"],
+                [char in[64], out[128];
+                 ZSTD_CCtx * cctx = ZSTD_createCCtx ();
+                 ZSTD_CCtx_setParameter (cctx, ZSTD_c_enableLongDistanceMatching, 1);
+                 size_t n = ZSTD_compress2 (cctx, out, 128, in, 64);
+                 return ZSTD_isError (n);],
+                [AC_MSG_RESULT(yes)],
+                [AM_CONDITIONAL(HAVE_ZSTD,false)
+                 AC_MSG_RESULT(no)
+                ])
+            fi
+        fi
+    fi
+ 
+
+    LIBS="$save_LIBS"
+    LDFLAGS="$save_LDFLAGS"
+    CPPFLAGS="$save_CPPFLAGS"
+
+    AC_SUBST(ZSTD_LIBS)
+    AC_SUBST(ZSTD_LDFLAGS)
+    AC_SUBST(ZSTD_CPPFLAGS)
+
+    # Finally, execute ACTION-IF-FOUND/ACTION-IF-NOT-FOUND:
+    if test -z "${HAVE_ZSTD_TRUE}"; then
+            ifelse([$1],,[AC_DEFINE(HAVE_ZSTD,1,[Define if you have ZSTD.])],[$1])
+            :
+    else
+            $2
+            :
+    fi
+fi
+])dnl AC_ZSTD
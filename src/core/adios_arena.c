@@ -0,0 +1,323 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "core/adios_arena.h"
+#include "core/adios_logger.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define ARENA_ALIGN 16
+
+struct adios_arena_chunk
+{
+    struct adios_arena_chunk * next;
+    uint64_t size;
+    uint64_t used;
+    char * last;      // last block handed out, it can grow in place
+    char * data;
+};
+
+#define ARENA_ADOPTED_BLOCK 62
+
+/* list of adopted blocks, itself allocated from the arena */
+struct adios_arena_adopted
+{
+    struct adios_arena_adopted * next;
+    uint64_t count;
+    void * ptrs [ARENA_ADOPTED_BLOCK];
+};
+
+static uint64_t align_up (uint64_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~((uint64_t) ARENA_ALIGN - 1);
+}
+
+static struct adios_arena_chunk * new_chunk (uint64_t size)
+{
+    struct adios_arena_chunk * c;
+    uint64_t header = align_up (sizeof (struct adios_arena_chunk));
+
+    c = (struct adios_arena_chunk *) malloc (header + size);
+    if (!c)
+    {
+        return 0;
+    }
+    c->next = 0;
+    c->size = size;
+    c->used = 0;
+    c->last = 0;
+    c->data = (char *) c + header;
+
+    return c;
+}
+
+struct adios_arena * adios_arena_create (uint64_t chunk_size)
+{
+    struct adios_arena * a;
+
+    a = (struct adios_arena *) malloc (sizeof (struct adios_arena));
+    if (!a)
+    {
+        return 0;
+    }
+    a->chunks = 0;
+    a->adopted = 0;
+    a->chunk_size = (chunk_size ? align_up (chunk_size) : ADIOS_ARENA_CHUNK_SIZE);
+    a->used = 0;
+    a->peak = 0;
+
+    return a;
+}
+
+static void free_adopted (struct adios_arena * a)
+{
+    struct adios_arena_adopted * l;
+    uint64_t i;
+
+    for (l = a->adopted; l; l = l->next)
+    {
+        for (i = 0; i < l->count; i++)
+        {
+            free (l->ptrs [i]);
+        }
+    }
+    a->adopted = 0;
+}
+
+void adios_arena_destroy (struct adios_arena * a)
+{
+    struct adios_arena_chunk * c;
+
+    if (!a)
+    {
+        return;
+    }
+
+    free_adopted (a);
+    while (a->chunks)
+    {
+        c = a->chunks;
+        a->chunks = c->next;
+        free (c);
+    }
+    free (a);
+}
+
+void adios_arena_reset (struct adios_arena * a)
+{
+    struct adios_arena_chunk * c;
+    uint64_t total = 0;
+
+    if (!a || !a->chunks)
+    {
+        return;
+    }
+
+    free_adopted (a);
+    if (a->chunks->next)
+    {
+        /* replace the chunks by one that fits the whole round */
+        while (a->chunks)
+        {
+            c = a->chunks;
+            a->chunks = c->next;
+            total += c->size;
+            free (c);
+        }
+        a->chunks = new_chunk (total);
+        log_debug ("index arena: %llu bytes used, kept in one chunk of %llu bytes\n",
+                   (unsigned long long) a->used, (unsigned long long) total);
+    }
+    else
+    {
+        a->chunks->used = 0;
+        a->chunks->last = 0;
+    }
+    a->used = 0;
+}
+
+void * adios_arena_malloc (struct adios_arena * a, uint64_t size)
+{
+    struct adios_arena_chunk * c;
+    uint64_t asize, csize;
+    char * p;
+
+    if (!a)
+    {
+        return malloc (size);
+    }
+
+    asize = align_up (size ? size : 1);
+    c = a->chunks;
+    if (!c || c->used + asize > c->size)
+    {
+        /* chunks double so a large index needs few of them */
+        csize = (c ? 2 * c->size : a->chunk_size);
+        if (csize < asize)
+        {
+            csize = asize;
+        }
+        c = new_chunk (csize);
+        if (!c)
+        {
+            return 0;
+        }
+        c->next = a->chunks;
+        a->chunks = c;
+    }
+
+    p = c->data + c->used;
+    c->used += asize;
+    c->last = p;
+
+    a->used += asize;
+    if (a->used > a->peak)
+    {
+        a->peak = a->used;
+    }
+
+    return p;
+}
+
+void * adios_arena_calloc (struct adios_arena * a, uint64_t nmemb, uint64_t size)
+{
+    void * p;
+
+    if (!a)
+    {
+        return calloc (nmemb, size);
+    }
+
+    p = adios_arena_malloc (a, nmemb * size);
+    if (p)
+    {
+        memset (p, 0, nmemb * size);
+    }
+
+    return p;
+}
+
+char * adios_arena_strdup (struct adios_arena * a, const char * s)
+{
+    size_t len;
+    char * p;
+
+    if (!a)
+    {
+        return strdup (s);
+    }
+
+    len = strlen (s) + 1;
+    p = (char *) adios_arena_malloc (a, len);
+    if (p)
+    {
+        memcpy (p, s, len);
+    }
+
+    return p;
+}
+
+void * adios_arena_realloc (struct adios_arena * a, void * ptr,
+                            uint64_t old_size, uint64_t size)
+{
+    struct adios_arena_chunk * c;
+    uint64_t old_asize, asize;
+    void * p;
+
+    if (!a || (ptr && !adios_arena_owns (a, ptr)))
+    {
+        return realloc (ptr, size);
+    }
+
+    if (!ptr)
+    {
+        return adios_arena_malloc (a, size);
+    }
+
+    c = a->chunks;
+    old_asize = align_up (old_size ? old_size : 1);
+    asize = align_up (size ? size : 1);
+    if ((char *) ptr == c->last && c->last + asize <= c->data + c->size)
+    {
+        /* the last block grows in place */
+        c->used = (uint64_t) (c->last - c->data) + asize;
+        a->used = a->used - old_asize + asize;
+        if (a->used > a->peak)
+        {
+            a->peak = a->used;
+        }
+        return ptr;
+    }
+
+    p = adios_arena_malloc (a, size);
+    if (p)
+    {
+        memcpy (p, ptr, (old_size < size ? old_size : size));
+    }
+
+    return p;
+}
+
+int adios_arena_adopt (struct adios_arena * a, void * ptr)
+{
+    struct adios_arena_adopted * l;
+
+    if (!a || !ptr)
+    {
+        return 1;
+    }
+
+    l = a->adopted;
+    if (!l || l->count == ARENA_ADOPTED_BLOCK)
+    {
+        l = (struct adios_arena_adopted *)
+                adios_arena_malloc (a, sizeof (struct adios_arena_adopted));
+        if (!l)
+        {
+            return 0;
+        }
+        l->next = a->adopted;
+        l->count = 0;
+        a->adopted = l;
+    }
+    l->ptrs [l->count++] = ptr;
+
+    return 1;
+}
+
+void adios_arena_free (struct adios_arena * a, void * ptr)
+{
+    if (ptr && !adios_arena_owns (a, ptr))
+    {
+        free (ptr);
+    }
+}
+
+int adios_arena_owns (const struct adios_arena * a, const void * ptr)
+{
+    const struct adios_arena_chunk * c;
+    const char * p = (const char *) ptr;
+
+    if (!a)
+    {
+        return 0;
+    }
+
+    for (c = a->chunks; c; c = c->next)
+    {
+        if (p >= c->data && p < c->data + c->size)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
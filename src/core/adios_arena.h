@@ -0,0 +1,71 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#ifndef ADIOS_ARENA_H
+#define ADIOS_ARENA_H
+
+/* Bump allocator for the index built and merged on the write side.
+ *
+ * An index is made of many small nodes (var/attribute entries, names,
+ * characteristics, dimensions, statistics) that all die together when the
+ * index is cleared at the end of a step. An arena hands them out from large
+ * chunks and gives everything back with one adios_arena_reset().
+ *
+ * All functions accept a NULL arena and then fall back to malloc() and
+ * friends, so code can allocate index nodes the same way with or without
+ * an arena. adios_arena_free() frees only memory the arena does not own.
+ * Blocks malloc'd elsewhere (e.g. nodes parsed without an arena and then
+ * merged into an index) can be handed over with adios_arena_adopt(), so
+ * the reset still releases the whole index without walking it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ADIOS_ARENA_CHUNK_SIZE (64*1024)   // default size of the first chunk
+
+struct adios_arena_chunk;
+struct adios_arena_adopted;
+
+struct adios_arena
+{
+    struct adios_arena_chunk * chunks;  // current chunk first
+    struct adios_arena_adopted * adopted; // malloc'd blocks freed by the next reset
+    uint64_t chunk_size;                // minimum size of a new chunk
+    uint64_t used;                      // bytes handed out since the last reset
+    uint64_t peak;                      // largest 'used' seen so far
+};
+
+struct adios_arena * adios_arena_create (uint64_t chunk_size);
+void adios_arena_destroy (struct adios_arena * a);
+
+/* Release everything allocated from the arena. The memory is kept for the
+   next round, in a single chunk if the last round needed more than one. */
+void adios_arena_reset (struct adios_arena * a);
+
+void * adios_arena_malloc (struct adios_arena * a, uint64_t size);
+void * adios_arena_calloc (struct adios_arena * a, uint64_t nmemb, uint64_t size);
+char * adios_arena_strdup (struct adios_arena * a, const char * s);
+
+/* Grow ptr (of old_size bytes) to size bytes. The last allocation of the
+   arena grows in place, other blocks are copied. ptr not owned by the
+   arena is realloc()'d. */
+void * adios_arena_realloc (struct adios_arena * a, void * ptr,
+                            uint64_t old_size, uint64_t size);
+
+/* Make ptr (from malloc()) part of the current round: it is free()'d by
+   the next adios_arena_reset() or by adios_arena_destroy(). With a NULL
+   arena nothing happens, the caller keeps freeing ptr itself.
+   Returns 0 if the block could not be recorded. */
+int adios_arena_adopt (struct adios_arena * a, void * ptr);
+
+/* free() ptr unless it belongs to the arena */
+void adios_arena_free (struct adios_arena * a, void * ptr);
+
+int adios_arena_owns (const struct adios_arena * a, const void * ptr);
+
+#endif
@@ -187,6 +187,14 @@ int adios_parse_index_offsets_v1 (struct adios_bp_buffer_struct_v1 * b)
 int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
                          struct adios_index_process_group_struct_v1 ** pg_root
                          )
+{
+    return adios_parse_process_group_index_arena_v1 (b, pg_root, NULL);
+}
+
+int adios_parse_process_group_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b,
+                         struct adios_index_process_group_struct_v1 ** pg_root,
+                         struct adios_arena * arena
+                         )
 {
     struct adios_index_process_group_struct_v1 ** root;
     if (b->length - b->offset < 16)
@@ -230,7 +238,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
         if (!*root)
         {
             *root = (struct adios_index_process_group_struct_v1 *)
-                   malloc (sizeof(struct adios_index_process_group_struct_v1));
+                   adios_arena_malloc (arena, sizeof(struct adios_index_process_group_struct_v1));
             (*root)->next = 0;
         }
         uint16_t length_of_name;
@@ -240,7 +248,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
             swap_16(length_of_name);
         }
         b->offset += 2;
-        (*root)->group_name = (char *) malloc (length_of_name + 1);
+        (*root)->group_name = (char *) adios_arena_malloc (arena, length_of_name + 1);
         (*root)->group_name [length_of_name] = '\0';
         memcpy ((*root)->group_name, b->buff + b->offset, length_of_name);
         b->offset += length_of_name;
@@ -262,7 +270,7 @@ int adios_parse_process_group_index_v1 (struct adios_bp_buffer_struct_v1 * b,
             swap_16(length_of_name);
         }
         b->offset += 2;
-        (*root)->time_index_name = (char *) malloc (length_of_name + 1);
+        (*root)->time_index_name = (char *) adios_arena_malloc (arena, length_of_name + 1);
         (*root)->time_index_name [length_of_name] = '\0';
         memcpy ((*root)->time_index_name, b->buff + b->offset, length_of_name);
         b->offset += length_of_name;
@@ -290,6 +298,16 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                               ,qhashtbl_t *hashtbl_vars
                               ,struct adios_index_var_struct_v1 ** vars_tail
                               )
+{
+    return adios_parse_vars_index_arena_v1 (b, vars_root, hashtbl_vars, vars_tail, NULL);
+}
+
+int adios_parse_vars_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b
+                              ,struct adios_index_var_struct_v1 ** vars_root
+                              ,qhashtbl_t *hashtbl_vars
+                              ,struct adios_index_var_struct_v1 ** vars_tail
+                              ,struct adios_arena * arena
+                              )
 {
     struct adios_index_var_struct_v1 ** root;
 
@@ -329,7 +347,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
         if (!*root)
         {
             *root = (struct adios_index_var_struct_v1 *)
-                          malloc (sizeof (struct adios_index_var_struct_v1));
+                          adios_arena_malloc (arena, sizeof (struct adios_index_var_struct_v1));
             (*root)->next = 0;
         }
         uint8_t flag;
@@ -355,7 +373,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->group_name = (char *) malloc (len + 1);
+        (*root)->group_name = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->group_name [len] = '\0';
         strncpy ((*root)->group_name, b->buff + b->offset, len);
         b->offset += len;
@@ -365,7 +383,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->var_name = (char *) malloc (len + 1);
+        (*root)->var_name = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->var_name [len] = '\0';
         strncpy ((*root)->var_name, b->buff + b->offset, len);
         b->offset += len;
@@ -375,7 +393,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->var_path = (char *) malloc (len + 1);
+        (*root)->var_path = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->var_path [len] = '\0';
         strncpy ((*root)->var_path, b->buff + b->offset, len);
         b->offset += len;
@@ -394,7 +412,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
 
         // validate remaining length: offsets_count * (8 + 2 * (size of type))
         uint64_t j;
-        (*root)->characteristics = malloc (characteristics_sets_count
+        (*root)->characteristics = adios_arena_malloc (arena, characteristics_sets_count
                          * sizeof (struct adios_index_characteristic_struct_v1)
                         );
         memset ((*root)->characteristics, 0, characteristics_sets_count
@@ -462,7 +480,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                             case adios_long_double:
                             case adios_complex:
                             case adios_double_complex:
-                                data = malloc (data_size);
+                                data = adios_arena_malloc (arena, data_size);
 
                                 if (!data)
                                 {
@@ -503,7 +521,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                 break;
 
                             case adios_string:
-                                data = malloc (data_size + 1);
+                                data = adios_arena_malloc (arena, data_size + 1);
 
                                 if (!data)
                                 {
@@ -535,8 +553,8 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                             case adios_characteristic_min:
                                 if (!(*root)->characteristics [j].stats)
                                 {
-                                    (*root)->characteristics [j].stats = malloc (sizeof(struct adios_index_characteristics_stat_struct *));
-                                    (*root)->characteristics [j].stats[0] = malloc (2 * sizeof(struct adios_index_characteristics_stat_struct));
+                                    (*root)->characteristics [j].stats = adios_arena_malloc (arena, sizeof(struct adios_index_characteristics_stat_struct *));
+                                    (*root)->characteristics [j].stats[0] = adios_arena_malloc (arena, 2 * sizeof(struct adios_index_characteristics_stat_struct));
                                     (*root)->characteristics [j].bitmap = 0;
                                 }
                                 (*root)->characteristics [j].stats[0][adios_statistic_min].data = data;
@@ -546,8 +564,8 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                             case adios_characteristic_max:
                                 if (!(*root)->characteristics [j].stats)
                                 {
-                                    (*root)->characteristics [j].stats = malloc (sizeof(struct adios_index_characteristics_stat_struct *));
-                                    (*root)->characteristics [j].stats[0] = malloc (2 * sizeof(struct adios_index_characteristics_stat_struct));
+                                    (*root)->characteristics [j].stats = adios_arena_malloc (arena, sizeof(struct adios_index_characteristics_stat_struct *));
+                                    (*root)->characteristics [j].stats[0] = adios_arena_malloc (arena, 2 * sizeof(struct adios_index_characteristics_stat_struct));
                                     (*root)->characteristics [j].bitmap = 0;
                                 }
                                 (*root)->characteristics [j].stats[0][adios_statistic_max].data = data;
@@ -567,11 +585,11 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                         uint64_t count = adios_get_stat_set_count(original_var_type);
                         uint16_t characteristic_size;
 
-                        (*root)->characteristics [j].stats = malloc (count * sizeof(struct adios_index_characteristics_stat_struct *));
+                        (*root)->characteristics [j].stats = adios_arena_malloc (arena, count * sizeof(struct adios_index_characteristics_stat_struct *));
 
                         for (c = 0; c < count; c ++)
                         {
-                            (*root)->characteristics [j].stats[c] = calloc(ADIOS_STAT_LENGTH, sizeof(struct adios_index_characteristics_stat_struct));
+                            (*root)->characteristics [j].stats[c] = adios_arena_calloc (arena, ADIOS_STAT_LENGTH, sizeof(struct adios_index_characteristics_stat_struct));
 
                             k = idx = 0;
                             while ((*root)->characteristics[j].bitmap >> k)
@@ -582,7 +600,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                 {
                                     if (k == adios_statistic_hist)
                                     {
-                                        struct adios_index_characteristics_hist_struct * hist = malloc(sizeof(struct adios_index_characteristics_hist_struct));
+                                        struct adios_index_characteristics_hist_struct * hist = adios_arena_malloc (arena, sizeof(struct adios_index_characteristics_hist_struct));
                                         uint32_t bi, num_breaks;
 
                                         (*root)->characteristics [j].stats[c][idx].data = hist;
@@ -611,7 +629,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                         b->offset += 8;
 
                                         // Getting the frequencies of the histogram
-                                        hist->frequencies = malloc ((num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
+                                        hist->frequencies = adios_arena_malloc (arena, (num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
                                         memcpy(hist->frequencies, (b->buff + b->offset), (num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
 
                                         if(b->change_endianness == adios_flag_yes) {
@@ -622,7 +640,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                         b->offset += 4 * (num_breaks + 1);
 
                                         // Getting the breaks of the histogram
-                                        hist->breaks = malloc (num_breaks * adios_get_type_size(adios_double, ""));
+                                        hist->breaks = adios_arena_malloc (arena, num_breaks * adios_get_type_size(adios_double, ""));
                                         memcpy(hist->breaks, (b->buff + b->offset), num_breaks * adios_get_type_size(adios_double, ""));
                                         if(b->change_endianness == adios_flag_yes) {
                                             for(bi = 0; bi < num_breaks; bi ++)
@@ -634,7 +652,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                     {
                                         // NCSU - Generic for non-histogram data
                                         characteristic_size = adios_get_stat_size((*root)->characteristics [j].stats[c][idx].data, original_var_type, k);
-                                        (*root)->characteristics [j].stats[c][idx].data = malloc (characteristic_size);
+                                        (*root)->characteristics [j].stats[c][idx].data = adios_arena_malloc (arena, characteristic_size);
 
                                         void * data = (*root)->characteristics [j].stats[c][idx].data;
                                         memcpy (data, (b->buff + b->offset), characteristic_size);
@@ -727,7 +745,7 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                         b->offset += 2;
 
                        (*root)->characteristics [j].dims.dims = (uint64_t *)
-                                                         malloc (dims_length);
+                                                         adios_arena_malloc (arena, dims_length);
                        memcpy ((*root)->characteristics [j].dims.dims
                               ,(b->buff + b->offset)
                               ,dims_length
@@ -747,6 +765,9 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
                     case adios_characteristic_transform_type:
                     {
                         adios_transform_deserialize_transform_characteristic(&(*root)->characteristics[j].transform, b);
+                        // malloc'd by the transform layer, released with the arena
+                        adios_arena_adopt (arena, (*root)->characteristics[j].transform.pre_transform_dimensions.dims);
+                        adios_arena_adopt (arena, (*root)->characteristics[j].transform.transform_metadata);
                         break;
                     }
 
@@ -784,6 +805,14 @@ int adios_parse_vars_index_v1 (struct adios_bp_buffer_struct_v1 * b
 int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                     ,struct adios_index_attribute_struct_v1 ** attrs_root
                           )
+{
+    return adios_parse_attributes_index_arena_v1 (b, attrs_root, NULL);
+}
+
+int adios_parse_attributes_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b
+                                    ,struct adios_index_attribute_struct_v1 ** attrs_root
+                                    ,struct adios_arena * arena
+                          )
 {
     struct adios_index_attribute_struct_v1 ** root;
 
@@ -822,7 +851,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
         if (!*root)
         {
             *root = (struct adios_index_attribute_struct_v1 *)
-                      malloc (sizeof (struct adios_index_attribute_struct_v1));
+                      adios_arena_malloc (arena, sizeof (struct adios_index_attribute_struct_v1));
             (*root)->next = 0;
         }
         uint8_t flag;
@@ -848,7 +877,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->group_name = (char *) malloc (len + 1);
+        (*root)->group_name = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->group_name [len] = '\0';
         strncpy ((*root)->group_name, b->buff + b->offset, len);
         b->offset += len;
@@ -858,7 +887,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->attr_name = (char *) malloc (len + 1);
+        (*root)->attr_name = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->attr_name [len] = '\0';
         strncpy ((*root)->attr_name, b->buff + b->offset, len);
         b->offset += len;
@@ -868,7 +897,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
             swap_16(len);
         }
         b->offset += 2;
-        (*root)->attr_path = (char *) malloc (len + 1);
+        (*root)->attr_path = (char *) adios_arena_malloc (arena, len + 1);
         (*root)->attr_path [len] = '\0';
         strncpy ((*root)->attr_path, b->buff + b->offset, len);
         b->offset += len;
@@ -887,7 +916,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
 
         // validate remaining length: offsets_count * (8 + 2 * (size of type))
         uint64_t j;
-        (*root)->characteristics = malloc (characteristics_sets_count
+        (*root)->characteristics = adios_arena_malloc (arena, characteristics_sets_count
                        * sizeof (struct adios_index_characteristic_struct_v1)
                       );
         memset ((*root)->characteristics, 0
@@ -937,7 +966,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                             data_size = adios_get_type_size ((*root)->type, "");
                         }
 
-                        data = malloc (data_size + 1);
+                        data = adios_arena_malloc (arena, data_size + 1);
                         ((char *) data) [data_size] = '\0';
 
                         if (!data)
@@ -1000,7 +1029,7 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                 break;
 
                             default:
-                                free (data);
+                                adios_arena_free (arena, data);
                                 data = 0;
                                 break;
                         }
@@ -1087,6 +1116,9 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                     case adios_characteristic_transform_type:
                     {
                         adios_transform_deserialize_transform_characteristic(&(*root)->characteristics[j].transform, b);
+                        // malloc'd by the transform layer, released with the arena
+                        adios_arena_adopt (arena, (*root)->characteristics[j].transform.pre_transform_dimensions.dims);
+                        adios_arena_adopt (arena, (*root)->characteristics[j].transform.transform_metadata);
                         /*
                         (*root)->characteristics [j].transform_type =
                                             *(uint8_t *) (b->buff + b->offset);
@@ -12,6 +12,7 @@
 #include "public/adios_types.h"
 #include "core/adios_transport_hooks.h"
 #include "core/qhashtbl.h"
+#include "core/adios_arena.h"
 
 #define ADIOS_VERSION_BP_FORMAT                      2
 #define ADIOS_VERSION_NUM_MASK                       0x000000FF
@@ -190,6 +191,7 @@ struct adios_index_struct_v1
     struct adios_index_attribute_struct_v1     * attrs_tail;
     qhashtbl_t *hashtbl_vars;  // to speed up merging lists
     qhashtbl_t *hashtbl_attrs; // to speed up merging lists
+    struct adios_arena * arena; // nodes of the lists, released at once by adios_clear_index_v1
 };
 
 struct adios_method_info_struct_v1
@@ -297,6 +299,22 @@ int adios_parse_attributes_index_v1 (struct adios_bp_buffer_struct_v1 * b
                                     ,struct adios_index_attribute_struct_v1 ** attrs_root
                           );
 
+// the same, allocating the index nodes from an arena (see adios_index_struct_v1)
+int adios_parse_process_group_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b
+                         ,struct adios_index_process_group_struct_v1 ** pg_root
+                         ,struct adios_arena * arena
+                         );
+int adios_parse_vars_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b
+                              ,struct adios_index_var_struct_v1 ** vars_root
+                              ,qhashtbl_t *hashtbl_vars
+                              ,struct adios_index_var_struct_v1 ** vars_tail
+                              ,struct adios_arena * arena
+                              );
+int adios_parse_attributes_index_arena_v1 (struct adios_bp_buffer_struct_v1 * b
+                                    ,struct adios_index_attribute_struct_v1 ** attrs_root
+                                    ,struct adios_arena * arena
+                          );
+
 int adios_parse_process_group_header_v1 (struct adios_bp_buffer_struct_v1 * b
                      ,struct adios_process_group_header_struct_v1 * pg_header
                      );
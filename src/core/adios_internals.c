@@ -22,6 +22,7 @@
 #include "public/adios.h"
 #include "core/adios_internals.h"
 #include "core/adios_bp_v1.h"
+#include "core/adios_stats.h"
 #include "core/qhashtbl.h"
 #include "core/adios_logger.h"
 
@@ -1720,6 +1721,7 @@ int64_t adios_common_define_var (int64_t group_id, const char * name
     v->write_offset = 0;
 
     v->data_size = 0;
+    v->data_capacity = 0;
     v->write_count = 0;
 
     v->next = 0;
@@ -2213,6 +2215,81 @@ int adios_write_process_group_header_v1 (struct adios_file_struct * fd
     return 0;
 }
 
+// Lists parsed without the arena of the index they are merged into (the
+// adios_parse_*_index_v1 functions) are handed over to that arena, so that
+// adios_clear_index_v1 releases the whole index with one reset.
+static void index_adopt_characteristics_v1 (
+        struct adios_arena * arena
+        ,enum ADIOS_DATATYPES type
+        ,struct adios_index_characteristic_struct_v1 * ch
+        ,uint64_t count
+        )
+{
+    uint64_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (ch [i].dims.count != 0)
+            adios_arena_adopt (arena, ch [i].dims.dims);
+        adios_arena_adopt (arena, ch [i].value);
+
+        if (ch [i].stats != 0)
+        {
+            uint8_t c, count_sets = adios_get_stat_set_count (type);
+
+            for (c = 0; c < count_sets; c++)
+            {
+                uint8_t j = 0, idx = 0;
+
+                while (ch [i].bitmap >> j)
+                {
+                    if ((ch [i].bitmap >> j) & 1)
+                    {
+                        if (j == adios_statistic_hist)
+                        {
+                            struct adios_index_characteristics_hist_struct * hist =
+                                (struct adios_index_characteristics_hist_struct *) ch [i].stats [c][idx].data;
+                            adios_arena_adopt (arena, hist->breaks);
+                            adios_arena_adopt (arena, hist->frequencies);
+                        }
+                        adios_arena_adopt (arena, ch [i].stats [c][idx].data);
+                        idx ++;
+                    }
+                    j ++;
+                }
+                adios_arena_adopt (arena, ch [i].stats [c]);
+            }
+            adios_arena_adopt (arena, ch [i].stats);
+        }
+
+        adios_arena_adopt (arena, ch [i].transform.pre_transform_dimensions.dims);
+        adios_arena_adopt (arena, ch [i].transform.transform_metadata);
+    }
+}
+
+// The characteristics array of a new list entry may grow later, so it is
+// moved into the arena instead of being adopted
+static void * index_adopt_characteristics_array_v1 (
+        struct adios_arena * arena
+        ,void * characteristics
+        ,uint64_t count
+        )
+{
+    uint64_t size = count * sizeof (struct adios_index_characteristic_struct_v1);
+    void * p = adios_arena_malloc (arena, size);
+
+    if (!p)
+    {
+        adios_error (err_no_memory, "Cannot move the characteristics of a merged "
+                "index entry into the index arena, they will not be freed\n");
+        return characteristics;
+    }
+    memcpy (p, characteristics, size);
+    free (characteristics);
+
+    return p;
+}
+
 static void index_append_process_group_v1 (
         struct adios_index_process_group_struct_v1 ** root
         ,struct adios_index_process_group_struct_v1 * item
@@ -2238,6 +2315,14 @@ static void index_append_var_v1 (
         )
 {
     struct adios_index_var_struct_v1 * olditem;
+    int adopt = (index->arena && !adios_arena_owns (index->arena, item));
+
+    if (adopt)
+    {
+        index_adopt_characteristics_v1 (index->arena
+                ,adios_transform_get_var_original_type_index (item)
+                ,item->characteristics, item->characteristics_count);
+    }
 
     olditem = (struct adios_index_var_struct_v1 *)
             index->hashtbl_vars->get2 (index->hashtbl_vars,
@@ -2247,6 +2332,17 @@ static void index_append_var_v1 (
     log_debug ("var tail = %p, name=%s\n", index->vars_tail,
                 (index->vars_tail ? index->vars_tail->var_name : ""));
     if (!olditem) {
+        if (adopt)
+        {
+            item->characteristics = index_adopt_characteristics_array_v1 (
+                    index->arena, item->characteristics, item->characteristics_count);
+            item->characteristics_allocated = item->characteristics_count;
+            adios_arena_adopt (index->arena, item->group_name);
+            adios_arena_adopt (index->arena, item->var_name);
+            adios_arena_adopt (index->arena, item->var_path);
+            adios_arena_adopt (index->arena, item);
+        }
+
         // new variable, insert into var list
         if (!index->vars_root) {
             log_debug ("   Very first variable\n");
@@ -2293,12 +2389,18 @@ static void index_append_var_v1 (
               > olditem->characteristics_allocated
            )
         {
+            // grow geometrically, merging thousands of blocks would copy too much
+            uint64_t old_allocated = olditem->characteristics_allocated;
             int new_items = (item->characteristics_count == 1)
                 ? 100 : item->characteristics_count;
             olditem->characteristics_allocated =
                 olditem->characteristics_count + new_items;
-            void * ptr = realloc (
+            if (olditem->characteristics_allocated < 2 * old_allocated)
+                olditem->characteristics_allocated = 2 * old_allocated;
+            void * ptr = adios_arena_realloc (index->arena,
                     olditem->characteristics,
+                    old_allocated *
+                        sizeof (struct adios_index_characteristic_struct_v1),
                     olditem->characteristics_allocated *
                         sizeof (struct adios_index_characteristic_struct_v1)
                     );
@@ -2322,23 +2424,42 @@ static void index_append_var_v1 (
 
         olditem->characteristics_count += item->characteristics_count;
 
-        free (item->characteristics);
-        free (item->group_name);
-        free (item->var_name);
-        free (item->var_path);
-        free (item);
+        adios_arena_free (index->arena, item->characteristics);
+        adios_arena_free (index->arena, item->group_name);
+        adios_arena_free (index->arena, item->var_name);
+        adios_arena_free (index->arena, item->var_path);
+        adios_arena_free (index->arena, item);
     }
 }
 
 static void index_append_attribute_v1
-(struct adios_index_attribute_struct_v1 ** root
+(struct adios_index_struct_v1 * index
  ,struct adios_index_attribute_struct_v1 * item
  )
 {
+    struct adios_index_attribute_struct_v1 ** root = &index->attrs_root;
+    int adopt = (index->arena && !adios_arena_owns (index->arena, item));
+
+    if (adopt)
+    {
+        index_adopt_characteristics_v1 (index->arena, item->type
+                ,item->characteristics, item->characteristics_count);
+    }
+
     while (root)
     {
         if (!*root)
         {
+            if (adopt)
+            {
+                item->characteristics = index_adopt_characteristics_array_v1 (
+                        index->arena, item->characteristics, item->characteristics_count);
+                item->characteristics_allocated = item->characteristics_count;
+                adios_arena_adopt (index->arena, item->group_name);
+                adios_arena_adopt (index->arena, item->attr_name);
+                adios_arena_adopt (index->arena, item->attr_path);
+                adios_arena_adopt (index->arena, item);
+            }
             *root = item;
             root = 0;
         }
@@ -2354,12 +2475,18 @@ static void index_append_attribute_v1
                         > (*root)->characteristics_allocated
                    )
                 {
+                    uint64_t old_allocated = (*root)->characteristics_allocated;
                     int new_items = (item->characteristics_count == 1)
                         ? 100 : item->characteristics_count;
                     (*root)->characteristics_allocated =
                         (*root)->characteristics_count + new_items;
+                    if ((*root)->characteristics_allocated < 2 * old_allocated)
+                        (*root)->characteristics_allocated = 2 * old_allocated;
                     void * ptr;
-                    ptr = realloc ((*root)->characteristics
+                    ptr = adios_arena_realloc (index->arena
+                            ,(*root)->characteristics
+                            ,  old_allocated
+                            * sizeof (struct adios_index_characteristic_struct_v1)
                             ,  (*root)->characteristics_allocated
                             * sizeof (struct adios_index_characteristic_struct_v1)
                             );
@@ -2384,11 +2511,11 @@ static void index_append_attribute_v1
 
                 (*root)->characteristics_count += item->characteristics_count;
 
-                free (item->characteristics);
-                free (item->group_name);
-                free (item->attr_name);
-                free (item->attr_path);
-                free (item);
+                adios_arena_free (index->arena, item->characteristics);
+                adios_arena_free (index->arena, item->group_name);
+                adios_arena_free (index->arena, item->attr_name);
+                adios_arena_free (index->arena, item->attr_path);
+                adios_arena_free (index->arena, item);
 
                 root = 0;  // exit the loop
             }
@@ -2408,6 +2535,18 @@ void adios_merge_index_v1 (
                   ,struct adios_index_attribute_struct_v1 * new_attrs_root
                   )
 {
+    struct adios_index_process_group_struct_v1 * p;
+
+    for (p = new_pg_root; p && main_index->arena; p = p->next)
+    {
+        if (!adios_arena_owns (main_index->arena, p))
+        {
+            adios_arena_adopt (main_index->arena, p->group_name);
+            adios_arena_adopt (main_index->arena, p->time_index_name);
+            adios_arena_adopt (main_index->arena, p);
+        }
+    }
+
     // this will just add it on to the end and all should work fine
     index_append_process_group_v1 (&main_index->pg_root, new_pg_root);
 
@@ -2430,7 +2569,7 @@ void adios_merge_index_v1 (
     {
         a_temp = a->next;
         a->next = 0;
-        index_append_attribute_v1 (&main_index->attrs_root, a);
+        index_append_attribute_v1 (main_index, a);
         a = a_temp;
     }
 }
@@ -2717,6 +2856,7 @@ struct adios_index_struct_v1 * adios_alloc_index_v1 (int alloc_hashtables)
         index->hashtbl_vars = NULL;
         index->hashtbl_attrs = NULL;
     }
+    index->arena = adios_arena_create (0);
     return index;
 }
 
@@ -2731,6 +2871,7 @@ void adios_free_index_v1 (struct adios_index_struct_v1 * index)
         index->hashtbl_vars->free  (index->hashtbl_vars);
     if (index->hashtbl_attrs)
         index->hashtbl_attrs->free (index->hashtbl_attrs);
+    adios_arena_destroy (index->arena);
     free(index);
 }
 
@@ -2739,9 +2880,17 @@ void adios_clear_index_v1 (struct adios_index_struct_v1 * index)
     if (!index)
         return;
 
-    adios_clear_process_groups_index_v1 (index->pg_root);
-    adios_clear_vars_index_v1 (index->vars_root);
-    adios_clear_attributes_index_v1 (index->attrs_root);
+    if (index->arena)
+    {
+        // every node is allocated or adopted by the arena
+        adios_arena_reset (index->arena);
+    }
+    else
+    {
+        adios_clear_process_groups_index_v1 (index->pg_root);
+        adios_clear_vars_index_v1 (index->vars_root);
+        adios_clear_attributes_index_v1 (index->attrs_root);
+    }
     index->pg_root = NULL;
     index->vars_root = NULL;
     index->vars_tail = NULL;
@@ -2892,6 +3041,7 @@ void adios_copy_var_written (struct adios_group_struct * g, struct adios_var_str
     var_new->free_data = var->free_data;
     var_new->data = 0;
     var_new->data_size = var->data_size;
+    var_new->data_capacity = 0;
             var_new->write_count = var->write_count;
     var_new->next = 0;
 
@@ -3078,6 +3228,7 @@ void adios_copy_var_written (struct adios_var_struct ** root
             var_new->free_data = var->free_data;
             var_new->data = 0;
             var_new->data_size = var->data_size;
+            var_new->data_capacity = 0;
             var_new->next = 0;
 
             uint64_t size = adios_get_type_size (var->type, var->data);
@@ -3227,11 +3378,11 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
     struct adios_index_process_group_struct_v1 * g_item;
 
     g_item = (struct adios_index_process_group_struct_v1 *)
-        malloc (sizeof (struct adios_index_process_group_struct_v1));
-    g_item->group_name = (g->name ? strdup (g->name) : 0L);
+        adios_arena_malloc (index->arena, sizeof (struct adios_index_process_group_struct_v1));
+    g_item->group_name = (g->name ? adios_arena_strdup (index->arena, g->name) : 0L);
     g_item->adios_host_language_fortran = g->adios_host_language_fortran;
     g_item->process_id = g->process_id;
-    g_item->time_index_name = (g->time_index_name ? strdup (g->time_index_name) : 0L);
+    g_item->time_index_name = (g->time_index_name ? adios_arena_strdup (index->arena, g->time_index_name) : 0L);
     g_item->time_index = g->time_index;
     g_item->offset_in_file = fd->pg_start_in_file;
     g_item->next = 0;
@@ -3245,15 +3396,15 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
         if (v->write_offset != 0)
         {
             struct adios_index_var_struct_v1 * v_index;
-            v_index = malloc (sizeof (struct adios_index_var_struct_v1));
-            v_index->characteristics = malloc (
+            v_index = adios_arena_malloc (index->arena, sizeof (struct adios_index_var_struct_v1));
+            v_index->characteristics = adios_arena_malloc (index->arena, 
                     sizeof (struct adios_index_characteristic_struct_v1)
                     );
 
             v_index->id = v->id;
-            v_index->group_name = (g->name ? strdup (g->name) : 0L);
-            v_index->var_name = (v->name ? strdup (v->name) : 0L);
-            v_index->var_path = (v->path ? strdup (v->path) : 0L);
+            v_index->group_name = (g->name ? adios_arena_strdup (index->arena, g->name) : 0L);
+            v_index->var_name = (v->name ? adios_arena_strdup (index->arena, v->name) : 0L);
+            v_index->var_path = (v->path ? adios_arena_strdup (index->arena, v->path) : 0L);
             v_index->type = v->type;
             v_index->characteristics_count = 1;
             v_index->characteristics_allocated = 1;
@@ -3310,12 +3461,12 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
                         uint64_t characteristic_size;
 
                         v_index->characteristics [0].bitmap = v->bitmap;
-                        v_index->characteristics [0].stats = malloc (count * sizeof(struct adios_index_characteristics_stat_struct *));
+                        v_index->characteristics [0].stats = adios_arena_malloc (index->arena, count * sizeof(struct adios_index_characteristics_stat_struct *));
 
                         // Set of characteristics will be repeated thrice for complex numbers
                         for (c = 0; c < count; c ++)
                         {
-                            v_index->characteristics [0].stats[c] = calloc(ADIOS_STAT_LENGTH, sizeof (struct adios_index_characteristics_stat_struct));
+                            v_index->characteristics [0].stats[c] = adios_arena_calloc (index->arena, ADIOS_STAT_LENGTH, sizeof (struct adios_index_characteristics_stat_struct));
 
                             j = idx = 0;
                             while (v_index->characteristics [0].bitmap >> j)
@@ -3326,7 +3477,7 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
                                     {
                                         if (j == adios_statistic_hist)
                                         {
-                                            v_index->characteristics [0].stats[c][idx].data = (struct adios_index_characteristics_hist_struct *) malloc (sizeof(struct adios_index_characteristics_hist_struct));
+                                            v_index->characteristics [0].stats[c][idx].data = (struct adios_index_characteristics_hist_struct *) adios_arena_malloc (index->arena, sizeof(struct adios_index_characteristics_hist_struct));
 
                                             struct adios_hist_struct * v_hist = v->stats[c][idx].data;
                                             struct adios_hist_struct * v_index_hist = v_index->characteristics [0].stats[c][idx].data;
@@ -3335,15 +3486,15 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
                                             v_index_hist->max = v_hist->max;
                                             v_index_hist->num_breaks = v_hist->num_breaks;
 
-                                            v_index_hist->frequencies = malloc ((v_hist->num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
+                                            v_index_hist->frequencies = adios_arena_malloc (index->arena, (v_hist->num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
                                             memcpy (v_index_hist->frequencies, v_hist->frequencies, (v_hist->num_breaks + 1) * adios_get_type_size(adios_unsigned_integer, ""));
-                                            v_index_hist->breaks = malloc ((v_hist->num_breaks) * adios_get_type_size(adios_double, ""));
+                                            v_index_hist->breaks = adios_arena_malloc (index->arena, (v_hist->num_breaks) * adios_get_type_size(adios_double, ""));
                                             memcpy (v_index_hist->breaks, v_hist->breaks, (v_hist->num_breaks) * adios_get_type_size(adios_double, ""));
                                         }
                                         else
                                         {
                                             characteristic_size = adios_get_stat_size(v->stats[c][idx].data, original_var_type, j);
-                                            v_index->characteristics [0].stats[c][idx].data = malloc (characteristic_size);
+                                            v_index->characteristics [0].stats[c][idx].data = adios_arena_malloc (index->arena, characteristic_size);
                                             memcpy (v_index->characteristics [0].stats[c][idx].data, v->stats[c][idx].data, characteristic_size);
                                         }
 
@@ -3357,12 +3508,13 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
 
                         // NCSU ALACRITY-ADIOS - copy transform type field
                         adios_transform_copy_transform_characteristic(&v_index->characteristics[0].transform, v);
+                        adios_arena_adopt (index->arena, v_index->characteristics[0].transform.pre_transform_dimensions.dims);
+                        adios_arena_adopt (index->arena, v_index->characteristics[0].transform.transform_metadata);
 
                         c = count_dimensions (v->dimensions);
                         v_index->characteristics [0].dims.count = c;
                         // (local, global, local offset)
-                        v_index->characteristics [0].dims.dims = malloc
-                            (3 * 8 * v_index->characteristics [0].dims.count);
+                        v_index->characteristics [0].dims.dims = adios_arena_malloc (index->arena, 3 * 8 * v_index->characteristics [0].dims.count);
                         for (j = 0; j < c; j++)
                         {
                             v_index->characteristics [0].dims.dims [j * 3 + 0] =
@@ -3383,10 +3535,11 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
                         v_index->characteristics [0].bitmap = 0;
                         v_index->characteristics [0].stats = 0;
                         // NCSU ALACRITY-ADIOS - Clear the transform metadata
-                        // This is probably redundant with above code, but do it anyway to be safe
-                        adios_transform_clear_transform_characteristic(&v_index->characteristics[0].transform);
+                        // This is probably redundant with above code, but do it anyway to be safe.
+                        // Only reset it, the arena already adopted what the dimensions case copied.
+                        adios_transform_init_transform_characteristic(&v_index->characteristics[0].transform);
 
-                        v_index->characteristics [0].value = malloc (size);
+                        v_index->characteristics [0].value = adios_arena_malloc (index->arena, size);
                         memcpy (v_index->characteristics [0].value, v->data
                                 ,size
                                );
@@ -3398,7 +3551,7 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
 
                 case adios_string:
                     {
-                        v_index->characteristics [0].value = malloc (size + 1);
+                        v_index->characteristics [0].value = adios_arena_malloc (index->arena, size + 1);
                         memcpy (v_index->characteristics [0].value, v->data, size);
                         ((char *) (v_index->characteristics [0].value)) [size] = 0;
 
@@ -3426,15 +3579,15 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
         if (a->write_offset != 0)
         {
             struct adios_index_attribute_struct_v1 * a_index;
-            a_index = malloc (sizeof (struct adios_index_attribute_struct_v1));
-            a_index->characteristics = malloc (
+            a_index = adios_arena_malloc (index->arena, sizeof (struct adios_index_attribute_struct_v1));
+            a_index->characteristics = adios_arena_malloc (index->arena, 
                     sizeof (struct adios_index_characteristic_struct_v1)
                     );
 
             a_index->id = a->id;
-            a_index->group_name = (g->name ? strdup (g->name) : 0L);
-            a_index->attr_name = (a->name ? strdup (a->name) : 0L);
-            a_index->attr_path = (a->path ? strdup (a->path) : 0L);
+            a_index->group_name = (g->name ? adios_arena_strdup (index->arena, g->name) : 0L);
+            a_index->attr_name = (a->name ? adios_arena_strdup (index->arena, a->name) : 0L);
+            a_index->attr_path = (a->path ? adios_arena_strdup (index->arena, a->path) : 0L);
             a_index->type = a->type;
             a_index->characteristics_count = 1;
             a_index->characteristics_allocated = 1;
@@ -3454,7 +3607,7 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
 
             if (a->value)
             {
-                a_index->characteristics [0].value = malloc (size + 1);
+                a_index->characteristics [0].value = adios_arena_malloc (index->arena, size + 1);
                 ((char *) (a_index->characteristics [0].value)) [size] = 0;
                 memcpy (a_index->characteristics [0].value, a->value, size);
             }
@@ -3472,7 +3625,7 @@ void adios_build_index_v1 (struct adios_file_struct * fd,
             a_index->next = 0;
 
             // this fn will either take ownership for free
-            index_append_attribute_v1 (&index->attrs_root, a_index);
+            index_append_attribute_v1 (index, a_index);
         }
 
         a = a->next;
@@ -4320,121 +4473,70 @@ static uint16_t calc_dimensions_size (struct adios_dimension_struct * dimension)
     return size;
 }
 
-static
-uint64_t adios_write_dimension_v1 (struct adios_file_struct * fd
-        ,struct adios_dimension_struct * dimension
+/* One item of a dimension: the member id if the layout item refers to a
+   variable, an attribute or the time index, else the number in value */
+static uint64_t adios_write_dimension_item_v1 (struct adios_file_struct * fd
+        ,struct adios_dimension_item_struct * layout
+        ,struct adios_dimension_item_struct * value
         )
 {
-    uint64_t size = 0;
     uint32_t id;
     uint8_t var;
 
-    if (    dimension->dimension.var == NULL
-         && dimension->dimension.attr == NULL
-         && dimension->dimension.time_index == adios_flag_no
-       )
-    {
-        var = 'n';
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset
-                ,&dimension->dimension.rank, 8
-                );
-        size += 8;
-    }
-    else
-    {
-        if (dimension->dimension.var != NULL)
-            id = dimension->dimension.var->id;
-        else if (dimension->dimension.attr != NULL)
-            id = dimension->dimension.attr->id;
-        else
-            id = 0; // just write this garbage
-        var = 'y';
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &id, 4);
-        size += 4;
-    }
-
-    if (    dimension->global_dimension.var == NULL
-         && dimension->global_dimension.attr == NULL
-         && dimension->global_dimension.time_index == adios_flag_no
+    if (    layout->var == NULL
+         && layout->attr == NULL
+         && layout->time_index == adios_flag_no
        )
     {
         var = 'n';
         buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
         buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset
-                ,&dimension->global_dimension.rank, 8
+                ,&value->rank, 8
                 );
-        size += 8;
-    }
-    else
-    {
-        if (dimension->global_dimension.var != NULL)
-            id = dimension->global_dimension.var->id;
-        else if (dimension->global_dimension.attr != NULL)
-            id = dimension->global_dimension.attr->id;
-        else
-            id = 0; // just write this garbage
-        var = 'y';
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &id, 4);
-        size += 4;
+        return 1 + 8;
     }
 
-    if (    dimension->local_offset.var == NULL
-         && dimension->local_offset.attr == NULL
-         && dimension->local_offset.time_index == adios_flag_no
-       )
-    {
-        var = 'n';
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset
-                ,&dimension->local_offset.rank, 8
-                );
-        size += 8;
-    }
+    if (layout->var != NULL)
+        id = layout->var->id;
+    else if (layout->attr != NULL)
+        id = layout->attr->id;
     else
-    {
-        if (dimension->local_offset.var != NULL)
-            id = dimension->local_offset.var->id;
-        else if (dimension->local_offset.attr != NULL)
-            id = dimension->local_offset.attr->id;
-        else
-            id = 0; // just write this garbage
-        var = 'y';
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
-        size += 1;
-        buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &id, 4);
-        size += 4;
-    }
-
-    return size;
+        id = 0; // just write this garbage
+    var = 'y';
+    buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &var, 1);
+    buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &id, 4);
+    return 1 + 4;
 }
 
+/* The dimensions with the layout of the ones in layout (see
+   adios_write_dimension_item_v1) and the numbers of the ones in values.
+   Both lists have the same length. */
 static
 uint16_t adios_write_dimensions_v1 (struct adios_file_struct * fd
-        ,struct adios_dimension_struct * dimensions
+        ,struct adios_dimension_struct * layout
+        ,struct adios_dimension_struct * values
         )
 {
     uint16_t size = 0;
-    uint16_t dimensions_size = calc_dimensions_size (dimensions);
-    uint8_t ranks = count_dimensions (dimensions);
+    uint16_t dimensions_size = calc_dimensions_size (layout);
+    uint8_t ranks = count_dimensions (layout);
 
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &ranks, 1);
     size += 1;
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &dimensions_size, 2);
     size += 2;
 
-    while (dimensions)
+    while (layout && values)
     {
-        size += adios_write_dimension_v1 (fd, dimensions);
+        size += adios_write_dimension_item_v1 (fd, &layout->dimension
+                                              ,&values->dimension);
+        size += adios_write_dimension_item_v1 (fd, &layout->global_dimension
+                                              ,&values->global_dimension);
+        size += adios_write_dimension_item_v1 (fd, &layout->local_offset
+                                              ,&values->local_offset);
 
-        dimensions = dimensions->next;
+        layout = layout->next;
+        values = values->next;
     }
 
     return size;
@@ -4675,7 +4777,6 @@ uint16_t adios_write_var_characteristics_v1 (struct adios_file_struct * fd
 int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd, struct adios_var_struct * var)
 {
     uint64_t total_size = 0;
-    uint64_t size = 0;
     enum ADIOS_DATATYPES original_var_type = adios_transform_get_var_original_type_var(var);
 
     if (var->transform_type != adios_transform_none) {
@@ -4687,432 +4788,85 @@ int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd, struct
     if (var->bitmap == 0)
         return 0;
 
-    int32_t map[32];
-    memset (map, -1, sizeof(map));
-
-#if 1
-#define HIST(a) \
-    { \
-        int low, high, mid; \
-        low=0; \
-        high=hist->num_breaks - 1; \
-        if (hist->breaks[low] > a) \
-        hist->frequencies[0] += 1; \
-        else if (a >= hist->breaks[high]) \
-        hist->frequencies[high + 1] += 1; \
-        else if (hist->breaks[low] <= a && a < hist->breaks[high]) \
-        { \
-            while(high-low>=2) \
-            { \
-                mid=(high+low)/2; \
-                if(a >= hist->breaks[mid]) \
-                { \
-                    low=mid; \
-                } \
-                else \
-                { \
-                    high=mid; \
-                } \
-            } \
-            hist->frequencies[low + 1] += 1; \
-        } \
-    }
-#endif
-
-#if 1
-#define ADIOS_STATISTICS(a,b) \
-{\
-    a * data = (a *) var->data; \
-    int i, j; \
-    struct adios_stat_struct * stats = var->stats[0]; \
-    a * min, * max; \
-    double * sum, * sum_square; \
-    uint32_t * cnt; \
-    struct adios_hist_struct * hist = 0; \
-    i = j = 0; \
-    while (var->bitmap >> j) { \
-        if ((var->bitmap >> j) & 1)    {\
-            map [j] = i; \
-            if (j == adios_statistic_hist) \
-            ;\
-            else \
-            stats[i].data = malloc(adios_get_stat_size(NULL, original_var_type, j)); \
-            i ++; \
-        } \
-        j ++; \
-    } \
-        min = (a *) stats[map[adios_statistic_min]].data; \
-        max = (a *) stats[map[adios_statistic_max]].data; \
-        sum = (double *) stats[map[adios_statistic_sum]].data; \
-        sum_square = (double *) stats[map[adios_statistic_sum_square]].data; \
-        cnt = (uint32_t *) stats[map[adios_statistic_cnt]].data; \
-        *cnt = 0;\
-        if (map[adios_statistic_hist] != -1) {\
-            hist = (struct adios_hist_struct *) stats[map[adios_statistic_hist]].data; \
-            hist->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, "")); \
-        } \
-        int finite = 0; \
-        size = 0; \
-        while ((size * b) < total_size) \
-        { \
-            if (isnan (data [size]) || !isfinite (data [size])) {\
-                size ++; \
-                continue; \
-            }\
-            if (!finite) { \
-                *min = data [size]; \
-                *max = data [size]; \
-                *sum = data [size]; \
-                *sum_square = (data [size] * data [size]) ; \
-                *cnt = *cnt + 1; \
-                if (map[adios_statistic_hist] != -1) \
-                HIST(data [size]); \
-                finite = 1; \
-                size ++; \
-                continue; \
-            } \
-            if (data [size] < *min) \
-            *min = data [size]; \
-            if (data [size] > *max) \
-            *max = data [size]; \
-            *sum += data [size]; \
-            *sum_square += (data [size] * data [size]) ; \
-            *cnt = *cnt + 1; \
-            if (map[adios_statistic_hist] != -1) \
-            HIST(data [size]); \
-            size++; \
-        } \
-        if (map[adios_statistic_finite] != -1) \
-        * ((uint8_t * ) stats[map[adios_statistic_finite]].data) = finite; \
-        return 0; \
-    }
-#else
-#define MIN_MAX(a,b)\
-    {\
-        a * data = (a *) var->data; \
-        var->min = malloc (b); \
-        var->max = malloc (b); \
-        a * min = (a *) var->min; \
-        a * max = (a *) var->max; \
-        *min = data [0]; \
-        *max = data [0]; \
-        return 0; \
-    }
-#endif
-
     switch (original_var_type)
     {
         case adios_byte:
-            ADIOS_STATISTICS(int8_t,1)
-
         case adios_unsigned_byte:
-                ADIOS_STATISTICS(uint8_t,1)
-
         case adios_short:
-                    ADIOS_STATISTICS(int16_t,2)
-
         case adios_unsigned_short:
-                        ADIOS_STATISTICS(uint16_t,2)
-
         case adios_integer:
-                            ADIOS_STATISTICS(int32_t,4)
-
         case adios_unsigned_integer:
-                                ADIOS_STATISTICS(uint32_t,4)
-
         case adios_long:
-                                    ADIOS_STATISTICS(int64_t,8)
-
         case adios_unsigned_long:
-                                        ADIOS_STATISTICS(uint64_t,8)
-
         case adios_real:
-                                            ADIOS_STATISTICS(float,4)
-
         case adios_double:
-                                                ADIOS_STATISTICS(double,8)
-
         case adios_long_double:
-                                                    ADIOS_STATISTICS(long double,16)
-
         case adios_complex:
-        {
-            int i, j, c, count = 3;
-            struct adios_stat_struct ** stats = var->stats;
-            float * data = var->data;
-            i = j = 0;
-
-            while (var->bitmap >> j) {
-                if ((var->bitmap >> j) & 1)    {
-                    map [j] = i;
-                    for (c = 0; c < count; c ++)
-                        if (j != adios_statistic_hist)
-                            stats[c][i].data = malloc(adios_get_stat_size(NULL, original_var_type, j));
-                    i ++;
-                }
-                j ++;
-            }
-
-            double *min_i, *min_r, *min_m;
-            double *max_i, *max_r, *max_m;
-            double *sum_i, *sum_r, *sum_m;
-            double *sum_square_i, *sum_square_r, *sum_square_m;
-            //struct adios_hist_struct *hist, *hist_i, *hist_r, *hist_m;
-            uint32_t *cnt_i, *cnt_r, *cnt_m;
-            double magnitude;
-            uint8_t finite = 0;
-
-            min_m = (double *) stats[0][map[adios_statistic_min]].data;
-            min_r = (double *) stats[1][map[adios_statistic_min]].data;
-            min_i = (double *) stats[2][map[adios_statistic_min]].data;
-
-            max_m = (double *) stats[0][map[adios_statistic_max]].data;
-            max_r = (double *) stats[1][map[adios_statistic_max]].data;
-            max_i = (double *) stats[2][map[adios_statistic_max]].data;
-
-            sum_m = (double *) stats[0][map[adios_statistic_sum]].data;
-            sum_r = (double *) stats[1][map[adios_statistic_sum]].data;
-            sum_i = (double *) stats[2][map[adios_statistic_sum]].data;
-
-            sum_square_m = (double *) stats[0][map[adios_statistic_sum_square]].data;
-            sum_square_r = (double *) stats[1][map[adios_statistic_sum_square]].data;
-            sum_square_i = (double *) stats[2][map[adios_statistic_sum_square]].data;
-
-            cnt_m = (uint32_t *) stats[0][map[adios_statistic_cnt]].data;
-            cnt_r = (uint32_t *) stats[1][map[adios_statistic_cnt]].data;
-            cnt_i = (uint32_t *) stats[2][map[adios_statistic_cnt]].data;
-
-            // Histogram is not available for complex numbers, yet.
-            /*
-            if (map[adios_statistic_hist] != -1) {
-                hist_r = (struct adios_hist_struct *) stat[0][map[adios_statistic_hist]].data;
-                hist_i = (struct adios_hist_struct *) stat[1][map[adios_statistic_hist]].data;
-                hist_m = (struct adios_hist_struct *) stat[2][map[adios_statistic_hist]].data;
-
-                hist_r->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-                hist_i->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-                hist_m->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-            }
-            */
-
-            *cnt_r = *cnt_i = *cnt_m = 0;
-            *min_r = *min_i = *min_m = HUGE_VAL;
-            *max_r = *max_i = *max_m = -HUGE_VAL;
-            *sum_r = *sum_i = *sum_m = 0;
-            *sum_square_r = *sum_square_i = *sum_square_m = 0;
-
-            while ((size * sizeof(float)) < total_size) {
-
-                magnitude = sqrt((double) data [size] * data [size] + (double) data[size + 1] * data[size + 1]);
-
-                // Both real and imaginary parts have to be finite, else skip calculating the characteristic
-                if ( isnan(data [size]) || !isfinite(data [size]) || isnan(data[size + 1]) || !isfinite(data[size + 1]) ) {
-                    size += 2;
-                    continue;
-                }
-
-                finite = 1;
-
-                // Updating the characteristic values
-                if (data [size] < *min_r)
-                    *min_r = data [size];
-                if (data [size + 1] < *min_i)
-                    *min_i = data [size + 1];
-                if (magnitude < *min_m)
-                    *min_m = magnitude;
-
-                if (data [size] > *max_r)
-                    *max_r = data [size];
-                if (data [size + 1] > *max_i)
-                    *max_i = data [size + 1];
-                if (magnitude > *max_m)
-                    *max_m = magnitude;
-
-                *sum_r += data [size];
-                *sum_i += data [size + 1];
-                *sum_m += magnitude;
-
-                *sum_square_r += (double) data [size] * data [size];
-                *sum_square_i += (double) data [size + 1] * data [size + 1];
-                *sum_square_m += magnitude * magnitude;
-
-                *cnt_r = *cnt_r + 1;
-                *cnt_i = *cnt_i + 1;
-                *cnt_m = *cnt_m + 1;
-                // Histogram not available yet
-                /*
-                if (map[adios_statistic_hist] != -1)
-                {
-                    hist = hist_r;
-                    HIST (data[size]);
-
-                    hist = hist_i;
-                    HIST (data[size + 1]);
-
-                    hist = hist_m;
-                    HIST (magnitude);
-                }
-                */
-
-                   size += 2;
-            }
-
-            if (map[adios_statistic_finite] != -1)
-                for (c = 0; c < count; c ++)
-                    * ((uint8_t * ) stats[c][map[adios_statistic_finite]].data) = finite;
-
-            return 0;
-        }
-
         case adios_double_complex:
-        {
-            int i, j, c, count = 3;
-            struct adios_stat_struct ** stats = var->stats;
-            double * data = var->data;
-            i = j = 0;
-
-            while (var->bitmap >> j) {
-                if ((var->bitmap >> j) & 1)    {
-                    map [j] = i;
-                    for (c = 0; c < count; c ++)
-                        if (j != adios_statistic_hist)
-                            stats[c][i].data = malloc(adios_get_stat_size(NULL, original_var_type, j));
-                    i ++;
-                }
-                j ++;
-            }
-
-            long double *min_i, *min_r, *min_m;
-            long double *max_i, *max_r, *max_m;
-            long double *sum_i, *sum_r, *sum_m;
-            long double *sum_square_i, *sum_square_r, *sum_square_m;
-            //struct adios_hist_struct *hist, *hist_i, *hist_r, *hist_m;
-            uint32_t *cnt_i, *cnt_r, *cnt_m;
-            long double magnitude;
-            uint8_t finite = 0;
-
-            min_m = (long double *) stats[0][map[adios_statistic_min]].data;
-            min_r = (long double *) stats[1][map[adios_statistic_min]].data;
-            min_i = (long double *) stats[2][map[adios_statistic_min]].data;
-
-            max_m = (long double *) stats[0][map[adios_statistic_max]].data;
-            max_r = (long double *) stats[1][map[adios_statistic_max]].data;
-            max_i = (long double *) stats[2][map[adios_statistic_max]].data;
-
-            sum_m = (long double *) stats[0][map[adios_statistic_sum]].data;
-            sum_r = (long double *) stats[1][map[adios_statistic_sum]].data;
-            sum_i = (long double *) stats[2][map[adios_statistic_sum]].data;
-
-            sum_square_m = (long double *) stats[0][map[adios_statistic_sum_square]].data;
-            sum_square_r = (long double *) stats[1][map[adios_statistic_sum_square]].data;
-            sum_square_i = (long double *) stats[2][map[adios_statistic_sum_square]].data;
-
-
-            // Histogram not available for complex numbers yet
-            /*
-            if (map[adios_statistic_hist] != -1) {
-                hist_r = (struct adios_hist_struct *) stat[0][map[adios_statistic_hist]].data;
-                hist_i = (struct adios_hist_struct *) stat[1][map[adios_statistic_hist]].data;
-                hist_m = (struct adios_hist_struct *) stat[2][map[adios_statistic_hist]].data;
-
-                hist_r->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-                hist_i->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-                hist_m->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
-            }
-            */
-
-            cnt_m = (uint32_t *) stats[0][map[adios_statistic_cnt]].data;
-            cnt_r = (uint32_t *) stats[1][map[adios_statistic_cnt]].data;
-            cnt_i = (uint32_t *) stats[2][map[adios_statistic_cnt]].data;
-
-            *cnt_r = *cnt_i = *cnt_m = 0;
-            *min_r = *min_i = *min_m = HUGE_VAL;
-            *max_r = *max_i = *max_m = -HUGE_VAL;
-            *sum_r = *sum_i = *sum_m = 0;
-            *sum_square_r = *sum_square_i = *sum_square_m = 0;
-
-            while ((size * sizeof(double)) < total_size)
-            {
-                magnitude = sqrt((long double) data [size] * data [size] + 
-                                 (long double) data[size + 1] * data[size + 1]);
-
-                // Both real and imaginary parts have to be finite, else skip calculating the characteristic
-                if ( isnan(data [size]) || !isfinite(data [size]) || isnan(data[size + 1]) || !isfinite(data[size + 1]) ) {
-                    size += 2;
-                    continue;
-                }
-
-                finite = 1;
-
-                if (data [size] < *min_r)
-                    *min_r = data [size];
-                if (data [size + 1] < *min_i)
-                    *min_i = data [size + 1];
-                if (magnitude < *min_m)
-                    *min_m = magnitude;
-
-                if (data [size] > *max_r)
-                    *max_r = data [size];
-                if (data [size + 1] > *max_i)
-                    *max_i = data [size + 1];
-                if (magnitude > *max_m)
-                    *max_m = magnitude;
-
-                *sum_r += data [size];
-                *sum_i += data [size + 1];
-                *sum_m += magnitude;
-
-                *sum_square_r += (long double) data [size] * data [size];
-                *sum_square_i += (long double) data [size + 1] * data [size + 1];
-                *sum_square_m += magnitude * magnitude;
-
-                // Histgram has not available for complex yet
-                /*
-                if (map[adios_statistic_hist] != -1)
-                {
-                    hist = hist_r;
-                    HIST (data[size]);
-
-                    hist = hist_i;
-                    HIST (data[size + 1]);
-
-                    hist = hist_m;
-                    HIST (magnitude);
-                }
-                */
+            break;
 
-                *cnt_r = *cnt_r + 1;
-                *cnt_i = *cnt_i + 1;
-                *cnt_m = *cnt_m + 1;
+        case adios_string:
+        default:
+            var->stats = 0;
+            return 0;
+    }
 
-                   size += 2;
-            }
+    int32_t map[32];
+    memset (map, -1, sizeof(map));
 
-            if (map[adios_statistic_finite] != -1)
-                for (c = 0; c < count; c ++)
-                    * ((uint8_t * ) stats[c][map[adios_statistic_finite]].data) = finite;
+    int i, j, c;
+    uint8_t count = adios_get_stat_set_count (original_var_type);
+    struct adios_stat_struct ** stats = var->stats;
+    struct adios_stats_out out[3];
 
-            return 0;
-        }
-        case adios_string:
+    i = j = 0;
+    while (var->bitmap >> j)
+    {
+        if ((var->bitmap >> j) & 1)
         {
-            var->stats = 0;
-
-            return 0;
+            map [j] = i;
+            // the histogram struct (breaks) is set up when the var is defined
+            if (j != adios_statistic_hist)
+                for (c = 0; c < count; c ++)
+                    stats[c][i].data = malloc(adios_get_stat_size(NULL, original_var_type, j));
+            i ++;
         }
+        j ++;
+    }
 
-        default:
-        {
-            var->stats = 0;
+#define STAT_DATA(s) (map[s] != -1 ? stats[c][map[s]].data : 0)
+    memset (out, 0, sizeof (out));
+    for (c = 0; c < count; c ++)
+    {
+        out[c].min = STAT_DATA(adios_statistic_min);
+        out[c].max = STAT_DATA(adios_statistic_max);
+        out[c].sum = STAT_DATA(adios_statistic_sum);
+        out[c].sum_square = STAT_DATA(adios_statistic_sum_square);
+        out[c].cnt = (uint32_t *) STAT_DATA(adios_statistic_cnt);
+        out[c].finite = (uint8_t *) STAT_DATA(adios_statistic_finite);
+    }
+#undef STAT_DATA
 
-            return 0;
-        }
+    // Histogram is not available for complex numbers, yet.
+    if (count == 1 && map[adios_statistic_hist] != -1)
+    {
+        struct adios_hist_struct * hist = (struct adios_hist_struct *) stats[0][map[adios_statistic_hist]].data;
+        hist->frequencies = calloc ((hist->num_breaks + 1), adios_get_type_size(adios_unsigned_integer, ""));
+        out[0].hist = hist;
     }
+
+    adios_stats_compute (original_var_type, var->data
+                        ,total_size / adios_get_type_size (original_var_type, "")
+                        ,out
+                        );
+
+    return 0;
 }
 
 // data is only there for sizing
-uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
+static uint64_t write_var_header_v1 (struct adios_file_struct * fd
         ,struct adios_var_struct * v
+        ,struct adios_dimension_struct * layout
         )
 {
     uint64_t total_size = 0;
@@ -5120,7 +4874,7 @@ uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
     uint16_t len;
 
     uint64_t start = fd->offset;  // save to write the size
-    v->write_offset = fd->offset + fd->base_offset; // save offset in file
+    v->write_offset = fd->offset + fd->base_offset + fd->zero_copy_bytes; // save offset in file
     fd->offset += 8;              // save space for the size
     total_size += 8;              // makes final parsing easier
 
@@ -5149,7 +4903,7 @@ uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &flag, 1);
     total_size += 1;
 
-    total_size += adios_write_dimensions_v1 (fd, v->dimensions);
+    total_size += adios_write_dimensions_v1 (fd, layout, v->dimensions);
 
     // Generate characteristics has been moved up, before transforms are applied
     // adios_generate_var_characteristics_v1 (fd, v);
@@ -5167,6 +4921,21 @@ uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
     return total_size;
 }
 
+uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
+        ,struct adios_var_struct * v
+        )
+{
+    return write_var_header_v1 (fd, v, v->dimensions);
+}
+
+uint64_t adios_write_var_written_header_v1 (struct adios_file_struct * fd
+        ,struct adios_var_struct * v
+        )
+{
+    return write_var_header_v1 (fd, v, v->parent_var ? v->parent_var->dimensions
+                                                     : v->dimensions);
+}
+
 int adios_write_var_payload_v1 (struct adios_file_struct * fd
         ,struct adios_var_struct * var
         )
@@ -5183,6 +4952,100 @@ int adios_write_var_payload_v1 (struct adios_file_struct * fd
     return 0;
 }
 
+int adios_write_var_payload_zero_copy_v1 (struct adios_file_struct * fd
+        ,struct adios_var_struct * var
+        )
+{
+    struct adios_zero_copy_struct * z;
+
+    if (fd->zero_copy_count == fd->zero_copy_size)
+    {
+        uint32_t n = fd->zero_copy_size ? 2 * fd->zero_copy_size : 16;
+        z = realloc (fd->zero_copy, n * sizeof (struct adios_zero_copy_struct));
+        if (!z)
+        {
+            // fall back to copying
+            return adios_write_var_payload_v1 (fd, var);
+        }
+        fd->zero_copy = z;
+        fd->zero_copy_size = n;
+    }
+
+    z = &fd->zero_copy [fd->zero_copy_count++];
+    z->buffer_offset = fd->offset;
+    z->data = var->data;
+    z->size = adios_get_var_size (var, var->data);
+    fd->zero_copy_bytes += z->size;
+
+    return 0;
+}
+
+static int add_iovec_pieces (struct iovec ** iov, int * count, int * allocated
+                            ,const char * data, uint64_t size, uint64_t max_piece
+                            )
+{
+    while (size > 0)
+    {
+        uint64_t len = (size > max_piece ? max_piece : size);
+
+        if (*count == *allocated)
+        {
+            int n = *allocated ? 2 * (*allocated) : 16;
+            struct iovec * v = realloc (*iov, n * sizeof (struct iovec));
+            if (!v)
+                return -1;
+            *iov = v;
+            *allocated = n;
+        }
+        (*iov) [*count].iov_base = (void *) data;
+        (*iov) [*count].iov_len = (size_t) len;
+        (*count)++;
+        data += len;
+        size -= len;
+    }
+
+    return 0;
+}
+
+int adios_get_zero_copy_iovec_v1 (struct adios_file_struct * fd
+                                 ,uint64_t max_piece
+                                 ,struct iovec ** iov
+                                 )
+{
+    uint64_t start = 0;
+    int count = 0, allocated = 0;
+    uint32_t i;
+    int err = 0;
+
+    *iov = 0;
+    for (i = 0; i < fd->zero_copy_count && !err; i++)
+    {
+        struct adios_zero_copy_struct * z = &fd->zero_copy [i];
+
+        err = add_iovec_pieces (iov, &count, &allocated, fd->buffer + start
+                               ,z->buffer_offset - start, max_piece)
+           || add_iovec_pieces (iov, &count, &allocated, z->data
+                               ,z->size, max_piece);
+        start = z->buffer_offset;
+    }
+    if (!err)
+    {
+        err = add_iovec_pieces (iov, &count, &allocated, fd->buffer + start
+                               ,fd->bytes_written - start, max_piece);
+    }
+
+    if (err)
+    {
+        adios_error (err_no_memory, "Cannot allocate the list of %d pieces "
+                     "of the output of %s\n", count, fd->name);
+        free (*iov);
+        *iov = 0;
+        return -1;
+    }
+
+    return count;
+}
+
 int adios_write_attribute_v1 (struct adios_file_struct * fd
         ,struct adios_attribute_struct * a
         )
@@ -5194,7 +5057,7 @@ int adios_write_attribute_v1 (struct adios_file_struct * fd
 
     // save space for attr length
     start = fd->offset;
-    a->write_offset = fd->offset + fd->base_offset; // save offset in file
+    a->write_offset = fd->offset + fd->base_offset + fd->zero_copy_bytes; // save offset in file
     fd->offset += 4;
 
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->offset, &a->id, 4);
@@ -5270,7 +5133,8 @@ int adios_write_open_vars_v1 (struct adios_file_struct * fd)
 int adios_write_close_vars_v1 (struct adios_file_struct * fd)
 {
     // close the var area (count and total size) and write the attributes
-    uint64_t size = fd->offset - fd->vars_start;
+    // (the zero-copy payloads all are in the var area)
+    uint64_t size = fd->offset - fd->vars_start + fd->zero_copy_bytes;
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->vars_start, &fd->vars_written, 4);
 
     buffer_write (&fd->buffer, &fd->buffer_size, &fd->vars_start, &size, 8);
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/uio.h>   // struct iovec
 
 // need the enum for the transports
 #include "public/adios_mpi.h"
@@ -65,6 +66,7 @@ struct adios_var_struct
     enum ADIOS_FLAG free_data;    // primarily used for writing
     void * data;                  // primarily used for reading
     uint64_t data_size;           // primarily used for reading
+    uint64_t data_capacity;       // allocated size of data from the buffer pool
     uint32_t write_count; // added to support multiple writes for transform layer.
                           // Might needed for other things in the future.
 
@@ -173,6 +175,15 @@ struct adios_group_list_struct
     struct adios_group_list_struct * next;
 };
 
+// a variable payload left in user memory instead of being copied into
+// the buffer, it goes to the file right before buffer [buffer_offset]
+struct adios_zero_copy_struct
+{
+    uint64_t buffer_offset;
+    const void * data;
+    uint64_t size;
+};
+
 struct adios_file_struct
 {
     char * name;
@@ -196,6 +207,21 @@ struct adios_file_struct
     uint64_t vars_start;    // offset for where to put the var/attr count
     uint32_t vars_written;  // count of vars/attrs to write
 
+    // payloads of at least zero_copy_threshold bytes (0 = off) are not
+    // copied, the user memory must stay valid until adios_close()
+    uint64_t zero_copy_threshold;
+    struct adios_zero_copy_struct * zero_copy;
+    uint32_t zero_copy_count;     // number used
+    uint32_t zero_copy_size;      // number allocated
+    uint64_t zero_copy_bytes;     // bytes not in the buffer
+
+    // arrays written with statistics and transform deferred to adios_close
+    // (deferred_threads > 0), the user memory must stay valid until then
+    int deferred_threads;
+    struct adios_var_struct ** deferred; // their copies in vars_written
+    uint32_t deferred_count;      // number used
+    uint32_t deferred_size;       // number allocated
+
     MPI_Comm comm;          // duplicate of comm received in adios_open()
 };
 
@@ -514,6 +540,13 @@ void adios_copy_var_written (struct adios_group_struct * g,
 uint64_t adios_write_var_header_v1 (struct adios_file_struct * fd
                                    ,struct adios_var_struct * v
                                    );
+// the same for a copy in vars_written (written later than adios_write):
+// the dimensions refer to the dimension variables like the ones of its
+// definition, so that the header has the size counted by adios_group_size
+// and by the index
+uint64_t adios_write_var_written_header_v1 (struct adios_file_struct * fd
+                                           ,struct adios_var_struct * v
+                                           );
 int adios_generate_var_characteristics_v1 (struct adios_file_struct * fd
                                           ,struct adios_var_struct * var
                                           );
@@ -523,6 +556,17 @@ uint16_t adios_write_var_characteristics_v1 (struct adios_file_struct * fd
 int adios_write_var_payload_v1 (struct adios_file_struct * fd
                                ,struct adios_var_struct * var
                                );
+// record the payload for zero-copy writing at close instead of copying it
+int adios_write_var_payload_zero_copy_v1 (struct adios_file_struct * fd
+                                         ,struct adios_var_struct * var
+                                         );
+// The buffered output in file order as pieces of at most max_piece bytes:
+// buffer ranges and the zero-copy payloads between them. Returns the number
+// of pieces in *iov (malloc'd), -1 if out of memory.
+int adios_get_zero_copy_iovec_v1 (struct adios_file_struct * fd
+                                 ,uint64_t max_piece
+                                 ,struct iovec ** iov
+                                 );
 int adios_write_attribute_v1 (struct adios_file_struct * fd
                              ,struct adios_attribute_struct * a
                              );
@@ -583,6 +627,10 @@ void adios_free_transports (struct adios_transport_struct * transports);
 int adios_parse_method (const char * buf, enum ADIOS_IO_METHOD * method
                        ,int * requires_group_comm
                        );
+// 1 if the method writes the zero-copy payloads of a buffered file, 0 if not
+int adios_method_supports_zero_copy (enum ADIOS_IO_METHOD method);
+// 1 if the method takes the variables from a buffered file only, 0 if not
+int adios_method_supports_deferred_write (enum ADIOS_IO_METHOD method);
 
 /* some internal functions that adios_internals.c and adios_internals_mxml.c share */
 int adios_int_is_var (const char * temp); // 1 == yes, 0 == no
@@ -1938,6 +1938,10 @@ static int parseBuffer (mxml_node_t * node)
     const char * size_MB = 0;
     const char * free_memory_percentage = 0;
     const char * allocate_time = 0;
+    const char * hugepages = 0;
+    const char * prefault = 0;
+    const char * zero_copy_threshold_KB = 0;
+    const char * deferred_write_threads = 0;
 
     int i;
 
@@ -1950,6 +1954,10 @@ static int parseBuffer (mxml_node_t * node)
         GET_ATTR("size-MB",attr,size_MB,"method")
             GET_ATTR("free-memory-percentage",attr,free_memory_percentage,"method")
             GET_ATTR("allocate-time",attr,allocate_time,"method")
+            GET_ATTR("hugepages",attr,hugepages,"method")
+            GET_ATTR("prefault",attr,prefault,"method")
+            GET_ATTR("zero-copy-threshold-KB",attr,zero_copy_threshold_KB,"method")
+            GET_ATTR("deferred-write-threads",attr,deferred_write_threads,"method")
             log_warn ("config.xml: unknown attribute '%s' on %s "
                     "(ignored)\n"
                     ,attr->name
@@ -1957,6 +1965,41 @@ static int parseBuffer (mxml_node_t * node)
                     );
     }
 
+    if (hugepages)
+    {
+        adios_buffer_pool_hugepages_set (!strcasecmp (hugepages, "yes"));
+    }
+    if (prefault)
+    {
+        adios_buffer_pool_prefault_set (!strcasecmp (prefault, "yes"));
+    }
+    if (zero_copy_threshold_KB)
+    {
+        int kb = atoi (zero_copy_threshold_KB);
+        if (kb < 0)
+        {
+            log_warn ("config.xml: buffer zero-copy-threshold-KB %s is invalid "
+                      "(ignored)\n", zero_copy_threshold_KB);
+        }
+        else
+        {
+            adios_buffer_zero_copy_threshold_set ((uint64_t) kb * 1024);
+        }
+    }
+    if (deferred_write_threads)
+    {
+        int n = atoi (deferred_write_threads);
+        if (n < 0)
+        {
+            log_warn ("config.xml: buffer deferred-write-threads %s is invalid "
+                      "(ignored)\n", deferred_write_threads);
+        }
+        else
+        {
+            adios_buffer_deferred_write_threads_set (n);
+        }
+    }
+
 
 
     if ((!size_MB && !free_memory_percentage) || !allocate_time)
@@ -2584,6 +2627,8 @@ int adios_common_select_method_by_group_id (int priority, const char * method
 
 void adios_cleanup ()
 {
+    adios_transform_finalize ();
+
     adios_transports_initialized = 0;
     if (adios_transports) {
         adios_free_transports (adios_transports);
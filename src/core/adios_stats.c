@@ -0,0 +1,751 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Single-pass statistics over the data of one variable block.
+ *
+ * Every statistic (min, max, sum, sum of squares, count, finite) is computed
+ * in the same sweep over the data. Each kernel keeps several independent
+ * accumulators so that the compiler (or the explicit SSE2/AVX2 code for
+ * float and double on x86-64) can process multiple elements per instruction.
+ * The AVX2 variants are picked at runtime if the CPU supports them.
+ * Large arrays are split among OpenMP threads with --enable-openmp-stats.
+ * Histograms need a search per element and use the scalar kernels.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "config.h"
+#include "core/adios_stats.h"
+#include "core/adios_internals.h"
+
+#if defined(_OPENMP) && defined(ADIOS_OPENMP_STATS)
+#include <omp.h>
+#endif
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#if defined(__x86_64__) && !defined(__INTEL_COMPILER) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define ADIOS_STATS_X86 1
+#include <immintrin.h>
+#define STATS_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* number of independent accumulators in the integer kernels */
+#define STATS_LANES 4
+
+union stats_value
+{
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+    float f;
+    double d;
+    long double ld;
+};
+
+/* Partial result of one kernel call. min/max are 0 if cnt is 0
+ * (HUGE_VAL/-HUGE_VAL for complex types).
+ */
+struct stats_part
+{
+    union stats_value min;
+    union stats_value max;
+    long double sum;
+    long double sum_square;
+    uint64_t cnt;
+};
+
+typedef void (* stats_kernel_fn) (const void * data, uint64_t n,
+                                  struct stats_part * p,
+                                  struct adios_hist_struct * hist);
+typedef void (* stats_merge_fn) (struct stats_part * a,
+                                 const struct stats_part * b, int nparts);
+
+static void stats_hist_add (struct adios_hist_struct * hist, double a)
+{
+    int low, high, mid;
+
+    low = 0;
+    high = hist->num_breaks - 1;
+    if (hist->breaks[low] > a)
+        hist->frequencies[0] += 1;
+    else if (a >= hist->breaks[high])
+        hist->frequencies[high + 1] += 1;
+    else if (hist->breaks[low] <= a && a < hist->breaks[high])
+    {
+        while (high - low >= 2)
+        {
+            mid = (high + low) / 2;
+            if (a >= hist->breaks[mid])
+                low = mid;
+            else
+                high = mid;
+        }
+        hist->frequencies[low + 1] += 1;
+    }
+}
+
+#define STATS_ALWAYS_FINITE(v) 1
+#define STATS_IS_FINITE(v) isfinite(v)
+
+/* Plain loop, used for long double, for the histogram and as fallback
+ * for float/double where there is no SIMD code.
+ */
+#define STATS_SCALAR_KERNEL(NAME, T, FIELD, IS_FINITE)                        \
+static void NAME (const void * vdata, uint64_t n,                             \
+                  struct stats_part * p, struct adios_hist_struct * hist)     \
+{                                                                             \
+    const T * data = (const T *) vdata;                                       \
+    T mn = 0, mx = 0;                                                         \
+    double s = 0, q = 0;                                                      \
+    uint64_t i, cnt = 0;                                                      \
+                                                                              \
+    for (i = 0; i < n; i++)                                                   \
+    {                                                                         \
+        T v = data[i];                                                        \
+        if (!IS_FINITE (v))                                                   \
+            continue;                                                         \
+        if (!cnt)                                                             \
+            mn = mx = v;                                                      \
+        else if (v < mn)                                                      \
+            mn = v;                                                           \
+        else if (v > mx)                                                      \
+            mx = v;                                                           \
+        s += v;                                                               \
+        q += (double) v * v;                                                  \
+        cnt++;                                                                \
+        if (hist)                                                             \
+            stats_hist_add (hist, (double) v);                                \
+    }                                                                         \
+    p->min.FIELD = mn;                                                        \
+    p->max.FIELD = mx;                                                        \
+    p->sum = s;                                                               \
+    p->sum_square = q;                                                        \
+    p->cnt = cnt;                                                             \
+}
+
+/* Integers are always finite. The lanes are independent so the inner loop
+ * turns into vector min/max/convert/add instructions. Squares are summed in
+ * double so they cannot overflow the element type.
+ */
+#define STATS_INT_KERNEL(NAME, T, FIELD, ATTR)                                \
+ATTR static void NAME (const void * vdata, uint64_t n,                        \
+                       struct stats_part * p, struct adios_hist_struct * hist)\
+{                                                                             \
+    const T * data = (const T *) vdata;                                       \
+    T mn[STATS_LANES], mx[STATS_LANES];                                       \
+    double s[STATS_LANES], q[STATS_LANES];                                    \
+    uint64_t i;                                                               \
+    int l;                                                                    \
+                                                                              \
+    p->cnt = n;                                                               \
+    p->sum = p->sum_square = 0;                                               \
+    if (!n)                                                                   \
+    {                                                                         \
+        p->min.FIELD = p->max.FIELD = 0;                                      \
+        return;                                                               \
+    }                                                                         \
+    for (l = 0; l < STATS_LANES; l++)                                         \
+    {                                                                         \
+        mn[l] = mx[l] = data[0];                                              \
+        s[l] = q[l] = 0;                                                      \
+    }                                                                         \
+    for (i = 0; i + STATS_LANES <= n; i += STATS_LANES)                       \
+    {                                                                         \
+        for (l = 0; l < STATS_LANES; l++)                                     \
+        {                                                                     \
+            T v = data[i + l];                                                \
+            mn[l] = v < mn[l] ? v : mn[l];                                    \
+            mx[l] = v > mx[l] ? v : mx[l];                                    \
+            s[l] += (double) v;                                               \
+            q[l] += (double) v * (double) v;                                  \
+        }                                                                     \
+    }                                                                         \
+    for (; i < n; i++)                                                        \
+    {                                                                         \
+        T v = data[i];                                                        \
+        mn[0] = v < mn[0] ? v : mn[0];                                        \
+        mx[0] = v > mx[0] ? v : mx[0];                                        \
+        s[0] += (double) v;                                                   \
+        q[0] += (double) v * (double) v;                                      \
+    }                                                                         \
+    for (l = 1; l < STATS_LANES; l++)                                         \
+    {                                                                         \
+        if (mn[l] < mn[0])                                                    \
+            mn[0] = mn[l];                                                    \
+        if (mx[l] > mx[0])                                                    \
+            mx[0] = mx[l];                                                    \
+        s[0] += s[l];                                                         \
+        q[0] += q[l];                                                         \
+    }                                                                         \
+    p->min.FIELD = mn[0];                                                     \
+    p->max.FIELD = mx[0];                                                     \
+    p->sum = s[0];                                                            \
+    p->sum_square = q[0];                                                     \
+}
+
+/* Complex numbers: 3 sets of results (magnitude, real, imaginary).
+ * An element is skipped if either part is not finite.
+ */
+#define STATS_COMPLEX_KERNEL(NAME, T, ACC, FIELD)                             \
+static void NAME (const void * vdata, uint64_t n,                             \
+                  struct stats_part * p, struct adios_hist_struct * hist)     \
+{                                                                             \
+    const T * data = (const T *) vdata;                                       \
+    ACC mn[3], mx[3], s[3], q[3], v[3];                                       \
+    uint64_t i, cnt = 0;                                                      \
+    int c;                                                                    \
+                                                                              \
+    for (c = 0; c < 3; c++)                                                   \
+    {                                                                         \
+        mn[c] = HUGE_VAL;                                                     \
+        mx[c] = -HUGE_VAL;                                                    \
+        s[c] = q[c] = 0;                                                      \
+    }                                                                         \
+    for (i = 0; i < n; i++)                                                   \
+    {                                                                         \
+        T re = data[2 * i];                                                   \
+        T im = data[2 * i + 1];                                               \
+        if (!isfinite (re) || !isfinite (im))                                 \
+            continue;                                                         \
+        v[0] = sqrt ((ACC) re * re + (ACC) im * im);                          \
+        v[1] = re;                                                            \
+        v[2] = im;                                                            \
+        for (c = 0; c < 3; c++)                                               \
+        {                                                                     \
+            if (v[c] < mn[c])                                                 \
+                mn[c] = v[c];                                                 \
+            if (v[c] > mx[c])                                                 \
+                mx[c] = v[c];                                                 \
+            s[c] += v[c];                                                     \
+            q[c] += v[c] * v[c];                                              \
+        }                                                                     \
+        cnt++;                                                                \
+    }                                                                         \
+    for (c = 0; c < 3; c++)                                                   \
+    {                                                                         \
+        p[c].min.FIELD = mn[c];                                               \
+        p[c].max.FIELD = mx[c];                                               \
+        p[c].sum = s[c];                                                      \
+        p[c].sum_square = q[c];                                               \
+        p[c].cnt = cnt;                                                       \
+    }                                                                         \
+}
+
+#define STATS_MERGE(NAME, FIELD)                                              \
+static void NAME (struct stats_part * a, const struct stats_part * b,         \
+                  int nparts)                                                 \
+{                                                                             \
+    int c;                                                                    \
+    for (c = 0; c < nparts; c++)                                              \
+    {                                                                         \
+        if (!b[c].cnt)                                                        \
+            continue;                                                         \
+        if (!a[c].cnt)                                                        \
+        {                                                                     \
+            a[c] = b[c];                                                      \
+            continue;                                                         \
+        }                                                                     \
+        if (b[c].min.FIELD < a[c].min.FIELD)                                  \
+            a[c].min.FIELD = b[c].min.FIELD;                                  \
+        if (b[c].max.FIELD > a[c].max.FIELD)                                  \
+            a[c].max.FIELD = b[c].max.FIELD;                                  \
+        a[c].sum += b[c].sum;                                                 \
+        a[c].sum_square += b[c].sum_square;                                   \
+        a[c].cnt += b[c].cnt;                                                 \
+    }                                                                         \
+}
+
+STATS_SCALAR_KERNEL(stats_int8_scalar, int8_t, i8, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_uint8_scalar, uint8_t, u8, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_int16_scalar, int16_t, i16, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_uint16_scalar, uint16_t, u16, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_int32_scalar, int32_t, i32, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_uint32_scalar, uint32_t, u32, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_int64_scalar, int64_t, i64, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_uint64_scalar, uint64_t, u64, STATS_ALWAYS_FINITE)
+STATS_SCALAR_KERNEL(stats_float_scalar, float, f, STATS_IS_FINITE)
+STATS_SCALAR_KERNEL(stats_double_scalar, double, d, STATS_IS_FINITE)
+STATS_SCALAR_KERNEL(stats_ldouble_scalar, long double, ld, STATS_IS_FINITE)
+
+STATS_INT_KERNEL(stats_int8_vec, int8_t, i8, )
+STATS_INT_KERNEL(stats_uint8_vec, uint8_t, u8, )
+STATS_INT_KERNEL(stats_int16_vec, int16_t, i16, )
+STATS_INT_KERNEL(stats_uint16_vec, uint16_t, u16, )
+STATS_INT_KERNEL(stats_int32_vec, int32_t, i32, )
+STATS_INT_KERNEL(stats_uint32_vec, uint32_t, u32, )
+STATS_INT_KERNEL(stats_int64_vec, int64_t, i64, )
+STATS_INT_KERNEL(stats_uint64_vec, uint64_t, u64, )
+
+STATS_COMPLEX_KERNEL(stats_complex_scalar, float, double, d)
+STATS_COMPLEX_KERNEL(stats_dcomplex_scalar, double, long double, ld)
+
+STATS_MERGE(stats_merge_i8, i8)
+STATS_MERGE(stats_merge_u8, u8)
+STATS_MERGE(stats_merge_i16, i16)
+STATS_MERGE(stats_merge_u16, u16)
+STATS_MERGE(stats_merge_i32, i32)
+STATS_MERGE(stats_merge_u32, u32)
+STATS_MERGE(stats_merge_i64, i64)
+STATS_MERGE(stats_merge_u64, u64)
+STATS_MERGE(stats_merge_f, f)
+STATS_MERGE(stats_merge_d, d)
+STATS_MERGE(stats_merge_ld, ld)
+
+#ifdef ADIOS_STATS_X86
+
+STATS_INT_KERNEL(stats_int8_avx2, int8_t, i8, STATS_AVX2)
+STATS_INT_KERNEL(stats_uint8_avx2, uint8_t, u8, STATS_AVX2)
+STATS_INT_KERNEL(stats_int16_avx2, int16_t, i16, STATS_AVX2)
+STATS_INT_KERNEL(stats_uint16_avx2, uint16_t, u16, STATS_AVX2)
+STATS_INT_KERNEL(stats_int32_avx2, int32_t, i32, STATS_AVX2)
+STATS_INT_KERNEL(stats_uint32_avx2, uint32_t, u32, STATS_AVX2)
+STATS_INT_KERNEL(stats_int64_avx2, int64_t, i64, STATS_AVX2)
+STATS_INT_KERNEL(stats_uint64_avx2, uint64_t, u64, STATS_AVX2)
+
+/* Handle the elements left over after the vector loop and store the result.
+ * Non-finite lanes were replaced by +-inf (min/max) and 0 (sums) above.
+ */
+#define STATS_FLOAT_FINISH(T, FIELD)                                          \
+    for (; i < n; i++)                                                        \
+    {                                                                         \
+        T v = data[i];                                                        \
+        if (!isfinite (v))                                                    \
+            continue;                                                         \
+        if (v < mn)                                                           \
+            mn = v;                                                           \
+        if (v > mx)                                                           \
+            mx = v;                                                           \
+        s += v;                                                               \
+        q += (double) v * v;                                                  \
+        cnt++;                                                                \
+    }                                                                         \
+    if (!cnt)                                                                 \
+        mn = mx = 0;                                                          \
+    p->min.FIELD = mn;                                                        \
+    p->max.FIELD = mx;                                                        \
+    p->sum = s;                                                               \
+    p->sum_square = q;                                                        \
+    p->cnt = cnt;
+
+/* x - x is 0 only for finite x (inf - inf and NaN - NaN are NaN) */
+static void stats_float_sse2 (const void * vdata, uint64_t n,
+                              struct stats_part * p,
+                              struct adios_hist_struct * hist)
+{
+    const float * data = (const float *) vdata;
+    const __m128 zero = _mm_setzero_ps ();
+    const __m128 pinf = _mm_set1_ps (INFINITY);
+    const __m128 ninf = _mm_set1_ps (-INFINITY);
+    __m128 vmin = pinf, vmax = ninf;
+    __m128d s0 = _mm_setzero_pd (), s1 = s0, q0 = s0, q1 = s0;
+    float fmin[4], fmax[4], mn = INFINITY, mx = -INFINITY;
+    double d[2], s, q;
+    uint64_t i, cnt = 0;
+    int l;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps (data + i);
+        __m128 ok = _mm_cmpeq_ps (_mm_sub_ps (x, x), zero);
+        __m128 xz = _mm_and_ps (ok, x);
+        __m128d lo = _mm_cvtps_pd (xz);
+        __m128d hi = _mm_cvtps_pd (_mm_movehl_ps (xz, xz));
+
+        vmin = _mm_min_ps (vmin, _mm_or_ps (xz, _mm_andnot_ps (ok, pinf)));
+        vmax = _mm_max_ps (vmax, _mm_or_ps (xz, _mm_andnot_ps (ok, ninf)));
+        s0 = _mm_add_pd (s0, lo);
+        s1 = _mm_add_pd (s1, hi);
+        q0 = _mm_add_pd (q0, _mm_mul_pd (lo, lo));
+        q1 = _mm_add_pd (q1, _mm_mul_pd (hi, hi));
+        cnt += __builtin_popcount (_mm_movemask_ps (ok));
+    }
+
+    _mm_storeu_ps (fmin, vmin);
+    _mm_storeu_ps (fmax, vmax);
+    for (l = 0; l < 4; l++)
+    {
+        if (fmin[l] < mn)
+            mn = fmin[l];
+        if (fmax[l] > mx)
+            mx = fmax[l];
+    }
+    _mm_storeu_pd (d, _mm_add_pd (s0, s1));
+    s = d[0] + d[1];
+    _mm_storeu_pd (d, _mm_add_pd (q0, q1));
+    q = d[0] + d[1];
+
+    STATS_FLOAT_FINISH(float, f)
+}
+
+static void stats_double_sse2 (const void * vdata, uint64_t n,
+                               struct stats_part * p,
+                               struct adios_hist_struct * hist)
+{
+    const double * data = (const double *) vdata;
+    const __m128d zero = _mm_setzero_pd ();
+    const __m128d pinf = _mm_set1_pd (INFINITY);
+    const __m128d ninf = _mm_set1_pd (-INFINITY);
+    __m128d vmin = pinf, vmax = ninf;
+    __m128d s0 = zero, s1 = zero, q0 = zero, q1 = zero;
+    double dmin[2], dmax[2], d[2], mn = INFINITY, mx = -INFINITY, s, q;
+    uint64_t i, cnt = 0;
+    int l;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128d x0 = _mm_loadu_pd (data + i);
+        __m128d x1 = _mm_loadu_pd (data + i + 2);
+        __m128d ok0 = _mm_cmpeq_pd (_mm_sub_pd (x0, x0), zero);
+        __m128d ok1 = _mm_cmpeq_pd (_mm_sub_pd (x1, x1), zero);
+        __m128d xz0 = _mm_and_pd (ok0, x0);
+        __m128d xz1 = _mm_and_pd (ok1, x1);
+
+        vmin = _mm_min_pd (vmin, _mm_or_pd (xz0, _mm_andnot_pd (ok0, pinf)));
+        vmin = _mm_min_pd (vmin, _mm_or_pd (xz1, _mm_andnot_pd (ok1, pinf)));
+        vmax = _mm_max_pd (vmax, _mm_or_pd (xz0, _mm_andnot_pd (ok0, ninf)));
+        vmax = _mm_max_pd (vmax, _mm_or_pd (xz1, _mm_andnot_pd (ok1, ninf)));
+        s0 = _mm_add_pd (s0, xz0);
+        s1 = _mm_add_pd (s1, xz1);
+        q0 = _mm_add_pd (q0, _mm_mul_pd (xz0, xz0));
+        q1 = _mm_add_pd (q1, _mm_mul_pd (xz1, xz1));
+        cnt += __builtin_popcount (_mm_movemask_pd (ok0))
+             + __builtin_popcount (_mm_movemask_pd (ok1));
+    }
+
+    _mm_storeu_pd (dmin, vmin);
+    _mm_storeu_pd (dmax, vmax);
+    for (l = 0; l < 2; l++)
+    {
+        if (dmin[l] < mn)
+            mn = dmin[l];
+        if (dmax[l] > mx)
+            mx = dmax[l];
+    }
+    _mm_storeu_pd (d, _mm_add_pd (s0, s1));
+    s = d[0] + d[1];
+    _mm_storeu_pd (d, _mm_add_pd (q0, q1));
+    q = d[0] + d[1];
+
+    STATS_FLOAT_FINISH(double, d)
+}
+
+STATS_AVX2 static void stats_float_avx2 (const void * vdata, uint64_t n,
+                                         struct stats_part * p,
+                                         struct adios_hist_struct * hist)
+{
+    const float * data = (const float *) vdata;
+    const __m256 zero = _mm256_setzero_ps ();
+    const __m256 pinf = _mm256_set1_ps (INFINITY);
+    const __m256 ninf = _mm256_set1_ps (-INFINITY);
+    __m256 vmin = pinf, vmax = ninf;
+    __m256d s0 = _mm256_setzero_pd (), s1 = s0, q0 = s0, q1 = s0;
+    float fmin[8], fmax[8], mn = INFINITY, mx = -INFINITY;
+    double d[4], s, q;
+    uint64_t i, cnt = 0;
+    int l;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps (data + i);
+        __m256 ok = _mm256_cmp_ps (_mm256_sub_ps (x, x), zero, _CMP_EQ_OQ);
+        __m256 xz = _mm256_and_ps (ok, x);
+        __m256d lo = _mm256_cvtps_pd (_mm256_castps256_ps128 (xz));
+        __m256d hi = _mm256_cvtps_pd (_mm256_extractf128_ps (xz, 1));
+
+        vmin = _mm256_min_ps (vmin, _mm256_blendv_ps (pinf, x, ok));
+        vmax = _mm256_max_ps (vmax, _mm256_blendv_ps (ninf, x, ok));
+        s0 = _mm256_add_pd (s0, lo);
+        s1 = _mm256_add_pd (s1, hi);
+        q0 = _mm256_add_pd (q0, _mm256_mul_pd (lo, lo));
+        q1 = _mm256_add_pd (q1, _mm256_mul_pd (hi, hi));
+        cnt += __builtin_popcount (_mm256_movemask_ps (ok));
+    }
+
+    _mm256_storeu_ps (fmin, vmin);
+    _mm256_storeu_ps (fmax, vmax);
+    for (l = 0; l < 8; l++)
+    {
+        if (fmin[l] < mn)
+            mn = fmin[l];
+        if (fmax[l] > mx)
+            mx = fmax[l];
+    }
+    _mm256_storeu_pd (d, _mm256_add_pd (s0, s1));
+    s = d[0] + d[1] + d[2] + d[3];
+    _mm256_storeu_pd (d, _mm256_add_pd (q0, q1));
+    q = d[0] + d[1] + d[2] + d[3];
+
+    STATS_FLOAT_FINISH(float, f)
+}
+
+STATS_AVX2 static void stats_double_avx2 (const void * vdata, uint64_t n,
+                                          struct stats_part * p,
+                                          struct adios_hist_struct * hist)
+{
+    const double * data = (const double *) vdata;
+    const __m256d zero = _mm256_setzero_pd ();
+    const __m256d pinf = _mm256_set1_pd (INFINITY);
+    const __m256d ninf = _mm256_set1_pd (-INFINITY);
+    __m256d vmin = pinf, vmax = ninf;
+    __m256d s0 = zero, s1 = zero, q0 = zero, q1 = zero;
+    double dmin[4], dmax[4], d[4], mn = INFINITY, mx = -INFINITY, s, q;
+    uint64_t i, cnt = 0;
+    int l;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256d x0 = _mm256_loadu_pd (data + i);
+        __m256d x1 = _mm256_loadu_pd (data + i + 4);
+        __m256d ok0 = _mm256_cmp_pd (_mm256_sub_pd (x0, x0), zero, _CMP_EQ_OQ);
+        __m256d ok1 = _mm256_cmp_pd (_mm256_sub_pd (x1, x1), zero, _CMP_EQ_OQ);
+        __m256d xz0 = _mm256_and_pd (ok0, x0);
+        __m256d xz1 = _mm256_and_pd (ok1, x1);
+
+        vmin = _mm256_min_pd (vmin, _mm256_blendv_pd (pinf, x0, ok0));
+        vmin = _mm256_min_pd (vmin, _mm256_blendv_pd (pinf, x1, ok1));
+        vmax = _mm256_max_pd (vmax, _mm256_blendv_pd (ninf, x0, ok0));
+        vmax = _mm256_max_pd (vmax, _mm256_blendv_pd (ninf, x1, ok1));
+        s0 = _mm256_add_pd (s0, xz0);
+        s1 = _mm256_add_pd (s1, xz1);
+        q0 = _mm256_add_pd (q0, _mm256_mul_pd (xz0, xz0));
+        q1 = _mm256_add_pd (q1, _mm256_mul_pd (xz1, xz1));
+        cnt += __builtin_popcount (_mm256_movemask_pd (ok0))
+             + __builtin_popcount (_mm256_movemask_pd (ok1));
+    }
+
+    _mm256_storeu_pd (dmin, vmin);
+    _mm256_storeu_pd (dmax, vmax);
+    for (l = 0; l < 4; l++)
+    {
+        if (dmin[l] < mn)
+            mn = dmin[l];
+        if (dmax[l] > mx)
+            mx = dmax[l];
+    }
+    _mm256_storeu_pd (d, _mm256_add_pd (s0, s1));
+    s = d[0] + d[1] + d[2] + d[3];
+    _mm256_storeu_pd (d, _mm256_add_pd (q0, q1));
+    q = d[0] + d[1] + d[2] + d[3];
+
+    STATS_FLOAT_FINISH(double, d)
+}
+
+static int stats_have_avx2 (void)
+{
+    static int have_avx2 = -1;
+
+    if (have_avx2 < 0)
+    {
+        __builtin_cpu_init ();
+        have_avx2 = __builtin_cpu_supports ("avx2") ? 1 : 0;
+    }
+    return have_avx2;
+}
+
+#define STATS_PICK(SCALAR, VEC, AVX2) \
+    (hist ? SCALAR : (stats_have_avx2 () ? AVX2 : VEC))
+
+#else
+
+#define STATS_PICK(SCALAR, VEC, AVX2) \
+    (hist ? SCALAR : VEC)
+
+#define stats_float_sse2 stats_float_scalar
+#define stats_double_sse2 stats_double_scalar
+
+#endif /* ADIOS_STATS_X86 */
+
+/* Run kernel over n elements of elem_size bytes. nparts is the number of
+ * result sets the kernel produces per call (3 for complex types).
+ */
+static void stats_run (const char * data, uint64_t n, int elem_size,
+                       int nparts, stats_kernel_fn kernel,
+                       stats_merge_fn merge, struct stats_part * total,
+                       struct adios_hist_struct * hist)
+{
+#if defined(_OPENMP) && defined(ADIOS_OPENMP_STATS)
+    /* the histogram is updated in place, so it stays on one thread */
+    if (!hist && n >= ADIOS_STATS_OMP_MIN_ELEMENTS
+        && omp_get_max_threads () > 1 && !omp_in_parallel ())
+    {
+        int nchunks = omp_get_max_threads ();
+        struct stats_part * parts = (struct stats_part *)
+                malloc (nchunks * nparts * sizeof (struct stats_part));
+
+        if (parts)
+        {
+            int c;
+
+#pragma omp parallel for schedule(static)
+            for (c = 0; c < nchunks; c++)
+            {
+                uint64_t lo = n / nchunks * c;
+                uint64_t hi = (c == nchunks - 1 ? n : n / nchunks * (c + 1));
+
+                kernel (data + lo * elem_size, hi - lo,
+                        parts + c * nparts, 0);
+            }
+
+            memcpy (total, parts, nparts * sizeof (struct stats_part));
+            for (c = 1; c < nchunks; c++)
+            {
+                merge (total, parts + c * nparts, nparts);
+            }
+            free (parts);
+            return;
+        }
+    }
+#endif
+    kernel (data, n, total, hist);
+}
+
+int adios_stats_compute (enum ADIOS_DATATYPES type, const void * data,
+                         uint64_t nelems, struct adios_stats_out * out)
+{
+    struct adios_hist_struct * hist = out->hist;
+    struct stats_part total[3];
+    stats_kernel_fn kernel;
+    stats_merge_fn merge;
+    int elem_size, nparts = 1, c;
+
+    switch (type)
+    {
+        case adios_byte:
+            kernel = STATS_PICK(stats_int8_scalar, stats_int8_vec, stats_int8_avx2);
+            merge = stats_merge_i8;
+            elem_size = 1;
+            break;
+
+        case adios_unsigned_byte:
+            kernel = STATS_PICK(stats_uint8_scalar, stats_uint8_vec, stats_uint8_avx2);
+            merge = stats_merge_u8;
+            elem_size = 1;
+            break;
+
+        case adios_short:
+            kernel = STATS_PICK(stats_int16_scalar, stats_int16_vec, stats_int16_avx2);
+            merge = stats_merge_i16;
+            elem_size = 2;
+            break;
+
+        case adios_unsigned_short:
+            kernel = STATS_PICK(stats_uint16_scalar, stats_uint16_vec, stats_uint16_avx2);
+            merge = stats_merge_u16;
+            elem_size = 2;
+            break;
+
+        case adios_integer:
+            kernel = STATS_PICK(stats_int32_scalar, stats_int32_vec, stats_int32_avx2);
+            merge = stats_merge_i32;
+            elem_size = 4;
+            break;
+
+        case adios_unsigned_integer:
+            kernel = STATS_PICK(stats_uint32_scalar, stats_uint32_vec, stats_uint32_avx2);
+            merge = stats_merge_u32;
+            elem_size = 4;
+            break;
+
+        case adios_long:
+            kernel = STATS_PICK(stats_int64_scalar, stats_int64_vec, stats_int64_avx2);
+            merge = stats_merge_i64;
+            elem_size = 8;
+            break;
+
+        case adios_unsigned_long:
+            kernel = STATS_PICK(stats_uint64_scalar, stats_uint64_vec, stats_uint64_avx2);
+            merge = stats_merge_u64;
+            elem_size = 8;
+            break;
+
+        case adios_real:
+            kernel = STATS_PICK(stats_float_scalar, stats_float_sse2, stats_float_avx2);
+            merge = stats_merge_f;
+            elem_size = 4;
+            break;
+
+        case adios_double:
+            kernel = STATS_PICK(stats_double_scalar, stats_double_sse2, stats_double_avx2);
+            merge = stats_merge_d;
+            elem_size = 8;
+            break;
+
+        case adios_long_double:
+            kernel = stats_ldouble_scalar;
+            merge = stats_merge_ld;
+            elem_size = sizeof (long double);
+            break;
+
+        case adios_complex:
+            kernel = stats_complex_scalar;
+            merge = stats_merge_d;
+            elem_size = 2 * sizeof (float);
+            nparts = 3;
+            hist = 0;
+            break;
+
+        case adios_double_complex:
+            kernel = stats_dcomplex_scalar;
+            merge = stats_merge_ld;
+            elem_size = 2 * sizeof (double);
+            nparts = 3;
+            hist = 0;
+            break;
+
+        default:
+            return 1;
+    }
+
+    stats_run ((const char *) data, nelems, elem_size, nparts,
+               kernel, merge, total, hist);
+
+    for (c = 0; c < nparts; c++)
+    {
+        /* min/max are the element type, sums are double, except for the
+           complex types which use double/long double for everything */
+        int value_size = (type == adios_complex ? sizeof (double)
+                         : type == adios_double_complex ? sizeof (long double)
+                         : elem_size);
+
+        if (out[c].min)
+            memcpy (out[c].min, &total[c].min, value_size);
+        if (out[c].max)
+            memcpy (out[c].max, &total[c].max, value_size);
+        if (type == adios_double_complex)
+        {
+            if (out[c].sum)
+                *(long double *) out[c].sum = total[c].sum;
+            if (out[c].sum_square)
+                *(long double *) out[c].sum_square = total[c].sum_square;
+        }
+        else
+        {
+            if (out[c].sum)
+                *(double *) out[c].sum = (double) total[c].sum;
+            if (out[c].sum_square)
+                *(double *) out[c].sum_square = (double) total[c].sum_square;
+        }
+        if (out[c].cnt)
+            *out[c].cnt = (uint32_t) total[c].cnt;
+        if (out[c].finite)
+            *out[c].finite = (total[c].cnt > 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#ifndef ADIOS_STATS_H
+#define ADIOS_STATS_H
+
+#include <stdint.h>
+#include "public/adios_types.h"
+
+struct adios_hist_struct;
+
+/* Arrays with at least this many elements are split among OpenMP threads
+ * (when configured with --enable-openmp-stats). Below it the thread startup
+ * cost is larger than the gain.
+ */
+#ifndef ADIOS_STATS_OMP_MIN_ELEMENTS
+#define ADIOS_STATS_OMP_MIN_ELEMENTS (1024*1024)
+#endif
+
+/* Where to store the statistics of one block of data.
+ * Any pointer may be NULL if that statistic is not wanted.
+ * min/max point to a value of the element type, except for complex
+ * (double) and double complex (long double). sum/sum_square point to a
+ * double, except for double complex (long double).
+ * hist must have num_breaks, breaks and frequencies (zeroed) set up.
+ */
+struct adios_stats_out
+{
+    void * min;
+    void * max;
+    void * sum;
+    void * sum_square;
+    uint32_t * cnt;
+    uint8_t * finite;
+    struct adios_hist_struct * hist;
+};
+
+/* Compute min/max/sum/sum of squares/count/finite (and the histogram if
+ * out->hist is set) of nelems elements in one pass over data.
+ * NaN and infinite values are skipped. For complex types out is an array
+ * of 3 sets: magnitude, real part, imaginary part; histograms are not
+ * supported for those.
+ * Returns 0 on success, 1 if the type has no statistics (e.g. string).
+ */
+int adios_stats_compute (enum ADIOS_DATATYPES type, const void * data,
+                         uint64_t nelems, struct adios_stats_out * out);
+
+#endif
@@ -10,11 +10,16 @@
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include "config.h"
 #include "core/util.h"
 #include "core/common_read.h"
 #include "core/adios_subvolume.h"
 #include "core/adios_internals.h"
 
+#if defined(_OPENMP) && defined(ADIOS_OPENMP_COPY)
+#include <omp.h>
+#endif
+
 void vector_add(int ndim, uint64_t *dst_vec, const uint64_t *vec1, const uint64_t *vec2) {
     while (ndim--)
         *dst_vec++ = *vec1++ + *vec2++;
@@ -259,9 +264,9 @@ static void copy_subvolume_helper_safe(char *dst, const char *src,
     } else {
         int i;
         for (i = 0; i < *next_subv_dim; i++) {
-            copy_subvolume_helper(dst, src, ndim - 1,
-                                  next_subv_dim + 1, next_dst_stride + 1, next_src_stride + 1,
-                                  buftype, swap_endianness);
+            copy_subvolume_helper_safe(dst, src, ndim - 1,
+                                       next_subv_dim + 1, next_dst_stride + 1, next_src_stride + 1,
+                                       buftype, swap_endianness);
 
             src += *next_src_stride;
             dst += *next_dst_stride;
@@ -269,6 +274,135 @@ static void copy_subvolume_helper_safe(char *dst, const char *src,
     }
 }
 
+/*
+ * Copy kernels for the common case (no endianness swap, no overlap). After
+ * the contiguous dimensions are collapsed, a copy is a set of rows of
+ * row_size bytes, so rows of 1 to 8 elements (count 1 along the fastest
+ * dimension of a read, Fortran-ordered blocks, ...) are frequent. Those
+ * get a copy of compile-time size instead of a call to memcpy per row, and
+ * the 1-D, 2-D and 3-D cases are plain loops instead of the recursion.
+ */
+
+// Rows of a fixed size n: the compiler turns the memcpy into loads/stores
+#define COPY_ROWS_FIXED(n) \
+    for (r = 0; r < nrows; r++) { \
+        memcpy(dst, src, n); \
+        dst += dst_stride; \
+        src += src_stride; \
+    } \
+    break;
+
+static void copy_rows(char *dst, const char *src, uint64_t nrows, uint64_t row_size,
+                      uint64_t dst_stride, uint64_t src_stride) {
+    uint64_t r;
+
+    switch (row_size) {
+    case 1:  COPY_ROWS_FIXED(1)
+    case 2:  COPY_ROWS_FIXED(2)
+    case 4:  COPY_ROWS_FIXED(4)
+    case 8:  COPY_ROWS_FIXED(8)
+    case 12: COPY_ROWS_FIXED(12)
+    case 16: COPY_ROWS_FIXED(16)
+    case 24: COPY_ROWS_FIXED(24)
+    case 32: COPY_ROWS_FIXED(32)
+    case 48: COPY_ROWS_FIXED(48)
+    case 64: COPY_ROWS_FIXED(64)
+    default:
+        if (row_size < 64 && row_size % 8 == 0) {
+            // other short rows of 8-byte words
+            uint64_t w, nwords = row_size / 8;
+            for (r = 0; r < nrows; r++) {
+                for (w = 0; w < nwords; w++)
+                    memcpy(dst + 8 * w, src + 8 * w, 8);
+                dst += dst_stride;
+                src += src_stride;
+            }
+        } else {
+            COPY_ROWS_FIXED(row_size)
+        }
+    }
+}
+
+#undef COPY_ROWS_FIXED
+
+/*
+ * Copy a collapsed subvolume of ndim dimensions (the last one in bytes) with
+ * the given strides, see copy_subvolume_helper.
+ */
+static void copy_subvolume_kernel(char *dst, const char *src, int ndim, const uint64_t *subv_dims,
+                                  const uint64_t *dst_strides, const uint64_t *src_strides) {
+    uint64_t i;
+
+    switch (ndim) {
+    case 1:
+        memcpy(dst, src, subv_dims[0]);
+        break;
+    case 2:
+        copy_rows(dst, src, subv_dims[0], subv_dims[1], dst_strides[0], src_strides[0]);
+        break;
+    case 3:
+        for (i = 0; i < subv_dims[0]; i++) {
+            copy_rows(dst, src, subv_dims[1], subv_dims[2], dst_strides[1], src_strides[1]);
+            dst += dst_strides[0];
+            src += src_strides[0];
+        }
+        break;
+    default:
+        for (i = 0; i < subv_dims[0]; i++) {
+            copy_subvolume_kernel(dst, src, ndim - 1, subv_dims + 1, dst_strides + 1, src_strides + 1);
+            dst += dst_strides[0];
+            src += src_strides[0];
+        }
+        break;
+    }
+}
+
+/*
+ * Large copies are split among OpenMP threads (when configured with
+ * --enable-openmp-copy) along
+ * the slowest dimension, or into byte ranges if the copy is one memcpy.
+ */
+static void copy_subvolume_parallel(char *dst, const char *src, int ndim, const uint64_t *subv_dims,
+                                    const uint64_t *dst_strides, const uint64_t *src_strides) {
+#if defined(_OPENMP) && defined(ADIOS_OPENMP_COPY)
+    const uint64_t total_size = compute_volume(ndim, subv_dims);
+    if (total_size >= ADIOS_SUBVOLUME_OMP_MIN_BYTES &&
+        omp_get_max_threads() > 1 && !omp_in_parallel()) {
+
+        const uint64_t len = subv_dims[0];
+        const int nchunks = (uint64_t)omp_get_max_threads() < len ? omp_get_max_threads() : (int)len;
+        int c;
+
+#pragma omp parallel for schedule(static)
+        for (c = 0; c < nchunks; c++) {
+            const uint64_t lo = len / nchunks * c;
+            const uint64_t hi = (c == nchunks - 1 ? len : len / nchunks * (c + 1));
+            uint64_t chunk_dims[32];
+
+            memcpy(chunk_dims, subv_dims, ndim * sizeof(uint64_t));
+            chunk_dims[0] = hi - lo;
+            if (ndim == 1) {
+                memcpy(dst + lo, src + lo, hi - lo);
+            } else {
+                copy_subvolume_kernel(dst + lo * dst_strides[0], src + lo * src_strides[0],
+                                      ndim, chunk_dims, dst_strides, src_strides);
+            }
+        }
+        return;
+    }
+#endif
+    copy_subvolume_kernel(dst, src, ndim, subv_dims, dst_strides, src_strides);
+}
+
+/* Extent in bytes of a collapsed subvolume of ndim dimensions with the given strides */
+static uint64_t subvolume_extent(int ndim, const uint64_t *subv_dims, const uint64_t *strides) {
+    uint64_t extent = subv_dims[ndim - 1];
+    int i;
+    for (i = 0; i < ndim - 1; i++)
+        extent += (subv_dims[i] - 1) * strides[i];
+    return extent;
+}
+
 void copy_subvolume_ragged_offset(void *dst, const void *src, int ndim, const uint64_t *subv_dims,
                                   const uint64_t *dst_dims, const uint64_t *dst_subv_offsets,
                                   uint64_t dst_ragged_offset,
@@ -339,62 +473,59 @@ void copy_subvolume_ragged_offset(void *dst, const void *src, int ndim, const ui
     uint64_t first_contig_dim_value_old = subv_dims[last_noncovering_dim];
     ((uint64_t*)subv_dims)[last_noncovering_dim] = contig_dims_volume;
 
-    // Compute whether the memory regions for the copy overlap
-    // If so, we need to use a safer copy method
-    if (0) { // FOR NOW, DON'T DO THIS, AS WE NEVER USE OVERLAPPING BUFFERS
-        uint64_t dst_end_offset = dst_offset;
-        uint64_t src_end_offset = src_offset;
-        // Match the stride counts as executed by the helper function: all but
-        // the last dimension contribute (length - 1) strides, with the last
-        // dimension contributing instead its length
-        for (i = 0; i < last_noncovering_dim; i++) {
-            src_end_offset += (subv_dims[i] - 1) * src_strides[i];
-            dst_end_offset += (subv_dims[i] - 1) * dst_strides[i];
-        }
-        src_end_offset += subv_dims[last_noncovering_dim];
-        dst_end_offset += subv_dims[last_noncovering_dim];
-
-        buffers_intersect =
-                intersect_segments((uint64_t)dst + dst_offset,
-                                   dst_end_offset - dst_offset,
-                                   (uint64_t)src + src_offset,
-                                   src_end_offset - src_offset,
-                                   NULL, NULL);
+    // Compute whether the memory regions for the copy overlap (only when
+    // compacting a buffer in place); if so, we need to use a safer copy method
+    const int collapsed_ndim = last_noncovering_dim + 1;
+    if (compute_volume(collapsed_ndim, subv_dims) > 0) {
+        const char *dst_begin = (char*)dst + dst_offset;
+        const char *src_begin = (char*)src + src_offset;
+        const char *dst_end = dst_begin + subvolume_extent(collapsed_ndim, subv_dims, dst_strides);
+        const char *src_end = src_begin + subvolume_extent(collapsed_ndim, subv_dims, src_strides);
 
-        buffers_intersect = 0; // Look Ma, no asserts!
+        buffers_intersect = (dst_begin < src_end && src_begin < dst_end);
 
         // Enfoce the safety condition for overlapping buffers here
         if (buffers_intersect) {
-            assert((char*)src + src_offset >= (char*)dst + dst_offset);
-            for (i = 0; i < last_noncovering_dim + 1; i++)
+            assert(src_begin >= dst_begin);
+            for (i = 0; i < last_noncovering_dim; i++)
                 assert(src_strides[i] >= dst_strides[i]);
         }
     }
 
     //printf(">>> copy_subvolume is using %d contiguous dimensions...\n", ndim - first_contig_dim);
 
-    // Finally, delegate to the recursive worker function
+    // Finally, delegate to the copy kernels, or the recursive worker
+    // functions for the uncommon cases
     if (buffers_intersect) {
         copy_subvolume_helper_safe(
                 (char*)dst + dst_offset,            /* Offset dst buffer to the first element */
                 (char*)src + src_offset,            /* Offset src buffer to the first element */
-                last_noncovering_dim + 1,           /* Number of dimensions, modified for collapsed contiguous dimensions */
+                collapsed_ndim,                     /* Number of dimensions, modified for collapsed contiguous dimensions */
                 subv_dims,                          /* Subvolume dimensions (modified to collapse all contiguous dimensions) */
                 dst_strides,                        /* dst buffer dimension strides */
                 src_strides,                        /* src buffer dimension strides */
                 datum_type,                         /* The datatype of the buffer elements */
                 swap_endianness == adios_flag_yes   /* Whether to swap endianness */
         );
-    } else {
+    } else if (swap_endianness == adios_flag_yes) {
         copy_subvolume_helper(
                 (char*)dst + dst_offset,            /* Offset dst buffer to the first element */
                 (char*)src + src_offset,            /* Offset src buffer to the first element */
-                last_noncovering_dim + 1,           /* Number of dimensions, modified for collapsed contiguous dimensions */
+                collapsed_ndim,                     /* Number of dimensions, modified for collapsed contiguous dimensions */
                 subv_dims,                          /* Subvolume dimensions (modified to collapse all contiguous dimensions) */
                 dst_strides,                        /* dst buffer dimension strides */
                 src_strides,                        /* src buffer dimension strides */
                 datum_type,                         /* The datatype of the buffer elements */
-                swap_endianness == adios_flag_yes   /* Whether to swap endianness */
+                1                                   /* Whether to swap endianness */
+        );
+    } else if (compute_volume(collapsed_ndim, subv_dims) > 0) {
+        copy_subvolume_parallel(
+                (char*)dst + dst_offset,            /* Offset dst buffer to the first element */
+                (char*)src + src_offset,            /* Offset src buffer to the first element */
+                collapsed_ndim,                     /* Number of dimensions, modified for collapsed contiguous dimensions */
+                subv_dims,                          /* Subvolume dimensions (modified to collapse all contiguous dimensions) */
+                dst_strides,                        /* dst buffer dimension strides */
+                src_strides                         /* src buffer dimension strides */
         );
     }
 
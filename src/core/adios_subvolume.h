@@ -46,6 +46,14 @@
 #include "public/adios_selection.h"
 #include "core/adios_copyspec.h"
 
+/* Subvolume copies of at least this many bytes are split among OpenMP
+ * threads (when configured with --enable-openmp-copy). Below it the thread
+ * startup cost is larger than the gain.
+ */
+#ifndef ADIOS_SUBVOLUME_OMP_MIN_BYTES
+#define ADIOS_SUBVOLUME_OMP_MIN_BYTES (8*1024*1024)
+#endif
+
 void vector_add(int ndim, uint64_t *dst_vec, const uint64_t *vec1, const uint64_t *vec2);
 void vector_sub(int ndim, uint64_t *dst, const uint64_t *vec1, const uint64_t *vec2);
 
@@ -211,6 +211,11 @@ void adios_write_timing_variables (struct adios_file_struct * fd)
     struct adios_group_struct * g = fd->group;
     int timer_count = g->prev_timing_obj->user_count + g->prev_timing_obj->internal_count;
     
+    // the arrays are freed here, they must be copied to the buffer, not
+    // left to adios_close like deferred user arrays
+    int deferred_threads = fd->deferred_threads;
+    fd->deferred_threads = 0;
+
     int rank=0, i, ct=0;
     if (fd->comm != MPI_COMM_NULL)
     {
@@ -244,7 +249,7 @@ void adios_write_timing_variables (struct adios_file_struct * fd)
 	    }
 
             char * labels = (char*)
-                              malloc ( (max_label_len+1) * timer_count * sizeof (char) );
+                              calloc ( (max_label_len+1) * timer_count, sizeof (char) );
 
 	    for (i = 0; i < g->prev_timing_obj->user_count; i++)
 	    {
@@ -293,6 +298,7 @@ void adios_write_timing_variables (struct adios_file_struct * fd)
 
     free (timers);
 
+    fd->deferred_threads = deferred_threads;
 }
 
 int adios_add_timing_variables (struct adios_file_struct * fd)
@@ -494,6 +500,14 @@ void adios_timing_stop (struct adios_timing_struct * ts, int64_t index)
 }
 
 
+/* Record a value that is not a time (e.g. a memory high-water mark) in
+   a timer slot, so it is reported along with the timers. */
+void adios_timing_set_value (struct adios_timing_struct * ts, int64_t index, double value)
+{
+    ts->times[index] = value;
+}
+
+
 struct adios_timing_struct *  adios_timing_create (int timer_count, char** timer_names)
 {
     int i;
@@ -50,6 +50,7 @@ void adios_timing_destroy (struct adios_timing_struct * timing_obj);
 
 void adios_timing_go (struct adios_timing_struct * ts, int64_t index);
 void adios_timing_stop (struct adios_timing_struct * ts, int64_t index);
+void adios_timing_set_value (struct adios_timing_struct * ts, int64_t index, double value);
 
 
 void adios_timing_declare_user_timers (int64_t fd_p, int user_timer_count, char** user_timer_names);
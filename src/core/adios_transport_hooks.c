@@ -62,6 +62,7 @@ void adios_init_transports (struct adios_transport_struct ** t)
     ASSIGN_FNS(mpi,ADIOS_METHOD_MPI,"MPI")
     ASSIGN_FNS(mpi_lustre,ADIOS_METHOD_MPI_LUSTRE,"MPI_LUSTRE")
     ASSIGN_FNS(mpi_amr,ADIOS_METHOD_MPI_AMR,"MPI_AGGREGATE")
+    ASSIGN_FNS(burst_buffer,ADIOS_METHOD_BURST_BUFFER,"BURST_BUFFER")
 #    if HAVE_BGQ
     ASSIGN_FNS(mpi_bgq,ADIOS_METHOD_MPI_BGQ,"MPI_BGQ")
 #    endif
@@ -131,6 +132,7 @@ int adios_parse_method (const char * buf, enum ADIOS_IO_METHOD * method
     MATCH_STRING_TO_METHOD("MPI",ADIOS_METHOD_MPI,1)
     MATCH_STRING_TO_METHOD("MPI_LUSTRE",ADIOS_METHOD_MPI_LUSTRE,1)
     MATCH_STRING_TO_METHOD("MPI_AMR",ADIOS_METHOD_MPI_AMR,1)
+    MATCH_STRING_TO_METHOD("BURST_BUFFER",ADIOS_METHOD_BURST_BUFFER,1)
 #if HAVE_BGQ
     MATCH_STRING_TO_METHOD("MPI_BGQ",ADIOS_METHOD_MPI_BGQ,1)
 #endif
@@ -197,3 +199,37 @@ int adios_parse_method (const char * buf, enum ADIOS_IO_METHOD * method
 
     return 0;
 }
+
+int adios_method_supports_zero_copy (enum ADIOS_IO_METHOD method)
+{
+    // methods that write fd->buffer through adios_get_zero_copy_iovec_v1 ()
+    switch (method)
+    {
+        case ADIOS_METHOD_NULL:
+        case ADIOS_METHOD_MPI:
+        case ADIOS_METHOD_POSIX:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+int adios_method_supports_deferred_write (enum ADIOS_IO_METHOD method)
+{
+    // methods that only write what is in fd->buffer in shared buffer mode
+    switch (method)
+    {
+        case ADIOS_METHOD_NULL:
+        case ADIOS_METHOD_MPI:
+        case ADIOS_METHOD_MPI_LUSTRE:
+        case ADIOS_METHOD_MPI_AMR:
+        case ADIOS_METHOD_BURST_BUFFER:
+        case ADIOS_METHOD_POSIX:
+        case ADIOS_METHOD_POSIX1:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
@@ -127,7 +127,8 @@ enum ADIOS_IO_METHOD {ADIOS_METHOD_UNKNOWN     = -2
               ,ADIOS_METHOD_VAR_MERGE   = 22
               ,ADIOS_METHOD_MPI_BGQ     = 23
               ,ADIOS_METHOD_ICEE        = 24
-              ,ADIOS_METHOD_COUNT       = 25
+              ,ADIOS_METHOD_BURST_BUFFER = 25
+              ,ADIOS_METHOD_COUNT       = 26
 };
 
 // forward declare the functions (or dummies for internals use)
@@ -139,6 +140,7 @@ enum ADIOS_IO_METHOD {ADIOS_METHOD_UNKNOWN     = -2
      //FORWARD_DECLARE(mpi_stagger)
      //FORWARD_DECLARE(mpi_aggregate)
      FORWARD_DECLARE(mpi_amr)
+     FORWARD_DECLARE(burst_buffer)
 #if HAVE_BGQ
      FORWARD_DECLARE(mpi_bgq)
 #endif
@@ -337,6 +337,13 @@ void FC_FUNC_(adios_write, ADIOS_WRITE)
         }
     }
 
+    if (common_adios_defer_write (fd, v, var))
+    {
+        *err = adios_errno;
+        free (buf1);
+        return;
+    }
+
     *err = common_adios_write (fd, v, var);
     if (fd->mode == adios_mode_write || fd->mode == adios_mode_append)
     {
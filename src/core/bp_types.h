@@ -52,6 +52,16 @@ struct BP_file_handle
 
 typedef struct BP_file_handle BP_file_handle_list;
 
+/* Location of a variable's entry (including its length field) in the
+   variables index of the file */
+struct bp_var_index_ref
+{
+    uint64_t offset;
+    uint32_t length;
+};
+
+struct bpidx;
+
 typedef struct BP_FILE {
     MPI_File mpi_fh;
     char * fname; // Main file name is needed to calculate subfile names
@@ -67,9 +77,20 @@ typedef struct BP_FILE {
     struct BP_GROUP_ATTR * gattr_h;
     uint32_t tidx_start;
     uint32_t tidx_stop;
+    int share_footer; // raw index buffer once per node (MPI-3 shared memory), during open only unless lazy_index
+    int use_bpidx; // build the variable list from the .bpidx sidecar if there is one
+    int lazy_index; // decode a variable's characteristics only when it is used
+    struct bpidx * bpidx; // mapped sidecar index, NULL if not used
+    struct bp_var_index_ref * vars_ref; // variables not decoded yet (characteristics==NULL) are read from here, length 0 once decoded
+    char * vars_index; // variables index of the footer (from mfooter.vars_index_offset) kept for lazy_index while variables are not decoded
+    uint64_t vars_undecoded; // variables whose entry is still to be decoded (vars_ref[].length != 0)
+    void * footer_win; // MPI_Win * of the node-shared footer vars_index points into (share_footer with lazy_index), freed by bp_close()
     void * priv;
 } BP_FILE;
 
+struct bp_read_plan;
+struct bp_prefetch;
+
 // save per proc info
 typedef struct BP_PROC {
     BP_FILE * fh;
@@ -77,6 +98,8 @@ typedef struct BP_PROC {
     int * varid_mapping;
     read_request * local_read_request_list;
     void * b; //internal buffer for chunk reading
+    struct bp_read_plan * read_plan; // data read ahead in perform_reads, see read_bp.c
+    struct bp_prefetch * prefetch; // background reads of the next steps of a stream
     void * priv;
 } BP_PROC;
 
@@ -16,6 +16,7 @@
 #include "public/adios_read.h"
 #include "public/adios_error.h"
 #include "core/bp_utils.h"
+#include "core/bpidx.h"
 #include "core/adios_internals.h"
 #include "core/adios_bp_v1.h"
 #include "core/adios_endianness.h"
@@ -61,6 +62,7 @@ inline BP_FILE * GET_BP_FILE (const ADIOS_FILE * fp)
 /* prototypes */
 void * bp_read_data_from_buffer(struct adios_bp_buffer_struct_v1 *b, enum ADIOS_DATATYPES type);
 int bp_parse_characteristics (struct adios_bp_buffer_struct_v1 * b, struct adios_index_var_struct_v1 ** root, uint64_t j);
+static int bp_read_minifooter_only (BP_FILE * bp_struct);
 
 
 
@@ -193,6 +195,11 @@ int adios_step_to_time (const ADIOS_FILE * fp, int varid, int from_steps)
 
     mapped_varid = p->varid_mapping[varid];
     v = bp_find_var_byid (fh, mapped_varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return -1;
+    }
 
     return _adios_step_to_time (fp, v, from_steps);
 }
@@ -229,61 +236,439 @@ int bp_read_open (const char * filename,
     return 0;
 }
 
-/* This routine does the parallel bp file open and index parsing.
+/* MPI_Bcast takes an int count, so send large buffers in pieces */
+#define BP_BCAST_CHUNK_SIZE (1024*1024*1024)
+
+static void bp_bcast_buffer (char * buf, uint64_t size, int root, MPI_Comm comm)
+{
+    int n;
+
+    while (size > 0)
+    {
+        n = (size > BP_BCAST_CHUNK_SIZE ? BP_BCAST_CHUNK_SIZE : (int) size);
+        MPI_Bcast (buf, n, MPI_BYTE, root, comm);
+        buf += n;
+        size -= n;
+    }
+}
+
+/* Size of the first part of the footer: all of it, or up to the header of
+ * the variables index with a sidecar index (fh->bpidx). The entries of the
+ * variables are then neither read nor broadcast, bp_decode_var() reads the
+ * entry of a variable from the file when it is used.
  */
-int bp_open (const char * fname,
-             MPI_Comm comm,
-             BP_FILE * fh)
+static uint64_t bp_footer_head_size (BP_FILE * fh)
 {
-    int rank;
-    uint64_t header_size;
+    struct bp_minifooter * mh = &fh->mfooter;
 
-    MPI_Comm_rank (comm, &rank);
+    if (!fh->bpidx)
+    {
+        return mh->file_size - mh->pgs_index_offset;
+    }
+    return mh->vars_index_offset - mh->pgs_index_offset +
+           ((mh->version & ADIOS_VERSION_NUM_MASK) > 1 ? 12 : VARS_MINIHEADER_SIZE);
+}
+
+/* Read the footer (from the PG index to the end of the file) into buff,
+ * without the variable entries if there is a sidecar index.
+ */
+static void bp_read_footer (BP_FILE * fh, char * buff)
+{
+    struct bp_minifooter * mh = &fh->mfooter;
+    uint64_t footer_size = mh->file_size - mh->pgs_index_offset;
+    uint64_t head_size = bp_footer_head_size (fh);
+    uint64_t attrs_start = mh->attrs_index_offset - mh->pgs_index_offset;
+    MPI_Status status;
+
+    /* FIXME: including the last 28 bytes read already above and it seems that is not processed anymore */
+    MPI_File_seek (fh->mpi_fh, (MPI_Offset) mh->pgs_index_offset, MPI_SEEK_SET);
+    MPI_File_read (fh->mpi_fh, buff, head_size, MPI_BYTE, &status);
+
+    if (head_size < footer_size)
+    {
+        MPI_File_seek (fh->mpi_fh, (MPI_Offset) mh->attrs_index_offset, MPI_SEEK_SET);
+        MPI_File_read (fh->mpi_fh, buff + attrs_start, footer_size - attrs_start,
+                       MPI_BYTE, &status);
+    }
+}
 
+/* Broadcast what bp_read_footer() has read into buff on root */
+static void bp_bcast_footer (BP_FILE * fh, char * buff, int root, MPI_Comm comm)
+{
+    struct bp_minifooter * mh = &fh->mfooter;
+    uint64_t footer_size = mh->file_size - mh->pgs_index_offset;
+    uint64_t head_size = bp_footer_head_size (fh);
+    uint64_t attrs_start = mh->attrs_index_offset - mh->pgs_index_offset;
+
+    bp_bcast_buffer (buff, head_size, root, comm);
+    if (head_size < footer_size)
+    {
+        bp_bcast_buffer (buff + attrs_start, footer_size - attrs_start, root, comm);
+    }
+}
+
+/* Leave a small private buffer, the data reading routines expect one */
+static void bp_reset_buffer (BP_FILE * fh)
+{
     adios_buffer_struct_init (fh->b);
+    bp_alloc_aligned (fh->b, MINIFOOTER_SIZE);
+}
 
-    if (bp_read_open (fname, comm, fh))
+#if !defined(_NOMPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+/* Place the index buffer in a shared memory window, one copy per node.
+ * Rank 0 reads it into its node's window and sends it to one process on
+ * every node, the others on the node map that copy. fh->b->buff points
+ * into the window on return.
+ * Only the raw buffer is shared: the PG and attribute indices, which every
+ * process parses into linked lists of pointers, stay per process. With
+ * lazy_index the window is kept and the variables are decoded from it
+ * when used, so the variables index is held once per node, plus what each
+ * process has decoded.
+ * Returns the window which must be freed (collectively) with bp_unshare_footer()
+ * or kept with bp_keep_shared_footer().
+ */
+static MPI_Win bp_share_footer (BP_FILE * fh, MPI_Comm comm, uint64_t footer_size)
+{
+    int rank, node_rank, disp_unit;
+    MPI_Comm node_comm, leader_comm;
+    MPI_Win win;
+    MPI_Aint win_size;
+    char * base;
+
+    MPI_Comm_rank (comm, &rank);
+    /* key=rank keeps rank 0 as the first process of its node */
+    MPI_Comm_split_type (comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank (node_comm, &node_rank);
+    MPI_Comm_split (comm, (node_rank == 0 ? 0 : MPI_UNDEFINED), rank, &leader_comm);
+
+    MPI_Win_allocate_shared ((node_rank == 0 ? (MPI_Aint) footer_size : 0), 1,
+                             MPI_INFO_NULL, node_comm, &base, &win);
+    MPI_Win_shared_query (win, 0, &win_size, &disp_unit, &base);
+
+    MPI_Win_lock_all (MPI_MODE_NOCHECK, win);
+    if (node_rank == 0)
+    {
+        if (rank == 0)
+        {
+            bp_read_footer (fh, base);
+        }
+        bp_bcast_footer (fh, base, 0, leader_comm);
+        MPI_Comm_free (&leader_comm);
+    }
+    MPI_Win_sync (win);
+    MPI_Barrier (node_comm);
+    MPI_Win_sync (win);
+    MPI_Win_unlock_all (win);
+    MPI_Comm_free (&node_comm);
+
+    /* parse from the window; the private buffer is not needed anymore */
+    adios_buffer_struct_clear (fh->b);
+    fh->b->buff = base;
+    fh->b->length = footer_size;
+    fh->b->offset = 0;
+
+    return win;
+}
+
+static void bp_unshare_footer (BP_FILE * fh, MPI_Win win)
+{
+    MPI_Win_free (&win);
+    bp_reset_buffer (fh);
+}
+
+/* Keep the shared footer for bp_decode_var() (lazy_index): the variables
+ * are decoded from the node's copy, the window is freed by bp_close().
+ */
+static void bp_keep_shared_footer (BP_FILE * fh, MPI_Win win)
+{
+    struct bp_minifooter * mh = &fh->mfooter;
+
+    fh->vars_index = fh->b->buff + (mh->vars_index_offset - mh->pgs_index_offset);
+    fh->footer_win = malloc (sizeof (MPI_Win));
+    assert (fh->footer_win);
+    * (MPI_Win *) fh->footer_win = win;
+    bp_reset_buffer (fh);
+}
+#endif
+
+/* Keep the variables index of the footer in fh->b for bp_decode_var()
+ * (lazy_index). It is moved to the start of the buffer, which is shrunk
+ * to it and taken from fh->b, so no copy of it is made.
+ */
+static void bp_keep_vars_index (BP_FILE * fh)
+{
+    struct bp_minifooter * mh = &fh->mfooter;
+    uint64_t length = mh->attrs_index_offset - mh->vars_index_offset;
+    char * index = fh->b->allocated_buff_ptr;
+
+    memmove (index, fh->b->buff + (mh->vars_index_offset - mh->pgs_index_offset), length);
+    fh->vars_index = (char *) realloc (index, length);
+    if (!fh->vars_index)
+    {
+        fh->vars_index = index;
+    }
+    fh->b->allocated_buff_ptr = 0;
+    bp_reset_buffer (fh);
+}
+
+/* Rank 0 reads the minifooter and broadcasts it.
+ * All processes return the same value.
+ */
+static int bp_read_and_bcast_minifooter (BP_FILE * fh, MPI_Comm comm)
+{
+    int rank, err = 0;
+
+    MPI_Comm_rank (comm, &rank);
+
+    if (rank == 0)
+    {
+        err = bp_read_minifooter_only (fh);
+    }
+
+    /* Let everyone know if rank 0 failed, so that nobody waits for the footer */
+    MPI_Bcast (&err, 1, MPI_INT, 0, comm);
+    if (err)
     {
         return -1;
     }
 
-    /* Only rank 0 reads the footer and it broadcasts to all other processes */
+    MPI_Bcast (&fh->mfooter, sizeof (struct bp_minifooter), MPI_BYTE, 0, comm);
+
+    return 0;
+}
+
+/* Rank 0 reads the index (footer) into fh->b and broadcasts it to all
+ * other processes in comm. The minifooter must be known everywhere.
+ */
+static void bp_read_and_bcast_index (BP_FILE * fh, MPI_Comm comm)
+{
+    int rank;
+
+    MPI_Comm_rank (comm, &rank);
+
+    bp_realloc_aligned (fh->b, fh->mfooter.file_size - fh->mfooter.pgs_index_offset);
+    assert (fh->b->buff);
+    fh->b->offset = 0;
+
     if (rank == 0)
     {
-        if (bp_read_minifooter (fh))
+        bp_read_footer (fh, fh->b->buff);
+    }
+    bp_bcast_footer (fh, fh->b->buff, 0, comm);
+}
+
+/* Rank 0 reads the minifooter and the index (footer), and broadcasts them
+ * to all other processes in comm. All processes return the same value.
+ */
+int bp_read_and_bcast_footer (BP_FILE * fh, MPI_Comm comm)
+{
+    if (bp_read_and_bcast_minifooter (fh, comm))
+    {
+        return -1;
+    }
+
+    bp_read_and_bcast_index (fh, comm);
+
+    return 0;
+}
+
+/* Number of variables in the header of the variables index in the file */
+static uint64_t bp_read_vars_count (BP_FILE * fh)
+{
+    struct bp_minifooter * mh = &fh->mfooter;
+    uint32_t count32 = 0;
+    uint16_t count16 = 0;
+    MPI_Status status;
+
+    MPI_File_seek (fh->mpi_fh, (MPI_Offset) mh->vars_index_offset, MPI_SEEK_SET);
+    if ((mh->version & ADIOS_VERSION_NUM_MASK) > 1)
+    {
+        MPI_File_read (fh->mpi_fh, &count32, 4, MPI_BYTE, &status);
+        if (mh->change_endianness == adios_flag_yes)
         {
-            return -1;
+            swap_32 (count32);
         }
+        return count32;
+    }
+    MPI_File_read (fh->mpi_fh, &count16, 2, MPI_BYTE, &status);
+    if (mh->change_endianness == adios_flag_yes)
+    {
+        swap_16 (count16);
     }
+    return count16;
+}
 
-    /* Broadcast to all other processors */
-    MPI_Bcast (&fh->mfooter, sizeof (struct bp_minifooter), MPI_BYTE, 0, comm);
+/* Rank 0 opens the index sidecar of the file and broadcasts it to all
+ * other processes in comm, so the file system sees one open, not one per
+ * process. Returns the sidecar on all processes or NULL on all processes.
+ * The footer is read without the variable entries if there is a sidecar,
+ * so it is checked against the variables index here, not when parsed.
+ */
+static struct bpidx * bp_read_and_bcast_bpidx (const char * fname, BP_FILE * fh, MPI_Comm comm)
+{
+    struct bpidx * idx = NULL;
+    uint64_t size = 0;
+    void * buf;
+    int rank;
 
-    header_size = fh->mfooter.file_size-fh->mfooter.pgs_index_offset;
+    MPI_Comm_rank (comm, &rank);
 
-    if (rank != 0)
+    if (rank == 0)
     {
-        if (!fh->b->buff)
+        idx = bpidx_open (fname, &fh->mfooter);
+        if (idx && idx->header->vars_count != bp_read_vars_count (fh))
         {
-            bp_alloc_aligned (fh->b, header_size);
-            assert (fh->b->buff);
-
-            memset (fh->b->buff, 0, header_size);
-            fh->b->offset = 0;
+            log_warn ("Index sidecar of %s has %llu variables instead of %llu, ignored\n",
+                      fname, (unsigned long long) idx->header->vars_count,
+                      (unsigned long long) bp_read_vars_count (fh));
+            bpidx_close (idx);
+            idx = NULL;
+        }
+        if (idx)
+        {
+            size = idx->size;
         }
     }
 
-    MPI_Barrier (comm);
-    MPI_Bcast (fh->b->buff, fh->mfooter.file_size-fh->mfooter.pgs_index_offset, MPI_BYTE, 0, comm);
+    MPI_Bcast (&size, sizeof (uint64_t), MPI_BYTE, 0, comm);
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    if (rank == 0)
+    {
+        bp_bcast_buffer ((char *) idx->map, size, 0, comm);
+    }
+    else
+    {
+        buf = malloc (size);
+        assert (buf);
+        bp_bcast_buffer ((char *) buf, size, 0, comm);
+        idx = bpidx_from_buffer (buf, (size_t) size);
+    }
+
+    return idx;
+}
+
+/* This routine does the parallel bp file open and index parsing.
+ */
+int bp_open (const char * fname,
+             MPI_Comm comm,
+             BP_FILE * fh)
+{
+#if !defined(_NOMPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+    MPI_Win win = MPI_WIN_NULL;
+#endif
+
+    adios_buffer_struct_init (fh->b);
+
+    if (bp_read_open (fname, comm, fh))
+    {
+        return -1;
+    }
+
+    /* Only rank 0 reads the footer and it broadcasts to all other processes */
+    if (bp_read_and_bcast_minifooter (fh, comm))
+    {
+        return -1;
+    }
 
-    /* Everyone parses the index on its own */
+    /* The variables come from the sidecar, their entries are not read now */
+    if (fh->use_bpidx)
+    {
+        fh->bpidx = bp_read_and_bcast_bpidx (fname, fh, comm);
+    }
+
+#if !defined(_NOMPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+    if (fh->share_footer)
+    {
+        win = bp_share_footer (fh, comm, fh->mfooter.file_size - fh->mfooter.pgs_index_offset);
+    }
+    else
+#endif
+    bp_read_and_bcast_index (fh, comm);
+
+    /* Everyone parses the index on its own, also from a shared buffer */
     bp_parse_pgs (fh);
     bp_parse_vars (fh);
     bp_parse_attrs (fh);
 
+    /* lazy_index decodes the variables from the footer when they are used */
+#if !defined(_NOMPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+    if (win != MPI_WIN_NULL)
+    {
+        if (fh->vars_undecoded > 0 && !fh->bpidx)
+        {
+            bp_keep_shared_footer (fh, win);
+        }
+        else
+        {
+            bp_unshare_footer (fh, win);
+        }
+        return 0;
+    }
+#endif
+    if (fh->vars_undecoded > 0 && !fh->bpidx)
+    {
+        bp_keep_vars_index (fh);
+    }
+
     return 0;
 }
 
+/* Open (once) subfile file_index of a file written with subfiles
+ * (fname.dir/fname.<file_index>). Each process opens the subfiles it
+ * reads data from on its own.
+ */
+MPI_File * bp_open_subfile (BP_FILE * fh, uint32_t file_index)
+{
+    MPI_File * sfh;
+    struct BP_file_handle * new_h;
+    char * ch, * name_no_path, * name;
+    int err;
+
+    sfh = get_BP_file_handle (fh->sfh, file_index);
+    if (sfh)
+    {
+        return sfh;
+    }
+
+    new_h = (struct BP_file_handle *) malloc (sizeof (struct BP_file_handle));
+    new_h->file_index = file_index;
+    new_h->next = 0;
+
+    if ( (ch = strrchr (fh->fname, '/')) )
+    {
+        name_no_path = strdup (ch + 1);
+    }
+    else
+    {
+        name_no_path = strdup (fh->fname);
+    }
+
+    name = (char *) malloc (strlen (fh->fname) + 5 + strlen (name_no_path) + 1 + 10 + 1);
+    sprintf (name, "%s.dir/%s.%d", fh->fname, name_no_path, new_h->file_index);
+
+    err = MPI_File_open (MPI_COMM_SELF, name, MPI_MODE_RDONLY,
+                         (MPI_Info) MPI_INFO_NULL, &new_h->fh);
+    if (err != MPI_SUCCESS)
+    {
+        adios_error (err_file_open_error, "can not open file %s\n", name);
+        free (new_h);
+        free (name_no_path);
+        free (name);
+        return 0;
+    }
+
+    add_BP_file_handle (&fh->sfh, new_h);
+
+    free (name_no_path);
+    free (name);
+
+    return &new_h->fh;
+}
+
 ADIOS_VARINFO * bp_inq_var_byid (const ADIOS_FILE * fp, int varid)
 {
     BP_PROC * p = GET_BP_PROC (fp);
@@ -295,6 +680,11 @@ ADIOS_VARINFO * bp_inq_var_byid (const ADIOS_FILE * fp, int varid)
     adios_errno = 0;
 
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return NULL;
+    }
 
     varinfo = (ADIOS_VARINFO *) malloc (sizeof (ADIOS_VARINFO));
     assert (varinfo);
@@ -439,7 +829,7 @@ int bp_close (BP_FILE * fh)
     while (vars_root) {
         vr = vars_root;
         vars_root = vars_root->next;
-        for (j = 0; j < vr->characteristics_count; j++) {
+        for (j = 0; vr->characteristics && j < vr->characteristics_count; j++) {
             // alloc in bp_utils.c:bp_parse_characteristics() <- bp_get_characteristics_data()
             if (vr->characteristics[j].dims.dims)
                 free (vr->characteristics[j].dims.dims);
@@ -498,6 +888,34 @@ int bp_close (BP_FILE * fh)
         fh->vars_table = 0;
     }
 
+    if (fh->vars_ref)
+    {
+        free (fh->vars_ref);
+        fh->vars_ref = 0;
+    }
+
+#if !defined(_NOMPI) && defined(MPI_VERSION) && MPI_VERSION >= 3
+    if (fh->footer_win)
+    {
+        /* vars_index points into the shared footer */
+        MPI_Win_free ((MPI_Win *) fh->footer_win);
+        free (fh->footer_win);
+        fh->footer_win = 0;
+        fh->vars_index = 0;
+    }
+#endif
+    if (fh->vars_index)
+    {
+        free (fh->vars_index);
+        fh->vars_index = 0;
+    }
+
+    if (fh->bpidx)
+    {
+        bpidx_close (fh->bpidx);
+        fh->bpidx = 0;
+    }
+
     /* Free attributes structures */
     /* alloc in bp_utils.c bp_parse_attrs() */
     while (attrs_root) {
@@ -610,12 +1028,12 @@ int bp_close (BP_FILE * fh)
     return 0;
 }
 
-int bp_read_minifooter (BP_FILE * bp_struct)
+/* Read the minifooter only, into bp_struct->b */
+static int bp_read_minifooter_only (BP_FILE * bp_struct)
 {
     struct adios_bp_buffer_struct_v1 * b = bp_struct->b;
     struct bp_minifooter * mh = &bp_struct->mfooter;
     uint64_t attrs_end = b->file_size - MINIFOOTER_SIZE;
-    int r;
 
     MPI_Status status;
 
@@ -700,18 +1118,22 @@ int bp_read_minifooter (BP_FILE * bp_struct)
     b->vars_size = b->attrs_index_offset - b->vars_index_offset;
     b->attrs_size = attrs_end - b->attrs_index_offset;
 
-    /* Read the whole footer */
-    /* FIXME: including the last 28 bytes read already above and it seems that is not processed anymore */
-    /* It will be sent to all processes */
-    uint64_t footer_size = mh->file_size - mh->pgs_index_offset;
-    bp_realloc_aligned (b, footer_size);
-    MPI_File_seek (bp_struct->mpi_fh,
-                        (MPI_Offset)  mh->pgs_index_offset,
-                        MPI_SEEK_SET);
-    MPI_File_read (bp_struct->mpi_fh, b->buff, footer_size,
-            MPI_BYTE, &status);
+    return 0;
+}
+
+int bp_read_minifooter (BP_FILE * bp_struct)
+{
+    struct adios_bp_buffer_struct_v1 * b = bp_struct->b;
+    struct bp_minifooter * mh = &bp_struct->mfooter;
+
+    if (bp_read_minifooter_only (bp_struct))
+    {
+        return 1;
+    }
 
-    MPI_Get_count (&status, MPI_BYTE, &r);
+    /* Read the whole footer */
+    bp_realloc_aligned (b, mh->file_size - mh->pgs_index_offset);
+    bp_read_footer (bp_struct, b->buff);
 
     // reset the pointer to the beginning of buffer
     b->offset = 0;
@@ -1206,6 +1628,202 @@ int bp_parse_attrs (BP_FILE * fh)
 /*******************/
 /* Parse VARIABLES */
 /*******************/
+/* Parse the characteristics sets of one variable entry.
+ * b is at the first set of the entry.
+ */
+static void bp_parse_var_characteristics (BP_FILE * fh,
+                                          struct adios_bp_buffer_struct_v1 * b,
+                                          struct adios_index_var_struct_v1 ** root,
+                                          uint64_t characteristics_sets_count)
+{
+    struct bp_minifooter * mh = &(fh->mfooter);
+
+    // validate remaining length: offsets_count *
+    // (8 + 2 * (size of type))
+    (*root)->characteristics = malloc (characteristics_sets_count
+        * sizeof (struct adios_index_characteristic_struct_v1)
+        );
+    memset ((*root)->characteristics, 0
+        ,  characteristics_sets_count
+        * sizeof (struct adios_index_characteristic_struct_v1)
+           );
+    // NOTE: Above memset assumes that all 0's is a valid initialization.
+    //       This is true, currently, but be careful in the future.
+
+    uint64_t j;
+    for (j = 0; j < characteristics_sets_count; j++)
+    {
+        uint8_t characteristic_set_count;
+        uint32_t characteristic_set_length;
+        uint8_t item = 0;
+
+        BUFREAD8(b, characteristic_set_count)
+        BUFREAD32(b, characteristic_set_length)
+
+        while (item < characteristic_set_count) {
+            bp_parse_characteristics (b, root, j);
+            item++;
+        }
+
+        /* Old BP files do not have time_index characteristics, so we
+           set it here automatically: j div # of pgs per timestep
+           Assumed that in old BP files, all pgs write each variable in each timestep.*/
+        if ((*root)->characteristics [j].time_index == 0) {
+            (*root)->characteristics [j].time_index =
+                 j / (mh->pgs_count / (fh->tidx_stop - fh->tidx_start + 1)) + 1;
+            /*printf("OldBP: var %s time_index set to %d\n",
+                    (*root)->var_name,
+                    (*root)->characteristics [j].time_index);*/
+        }
+    }
+}
+
+/* Create the variable list from the sidecar index without decoding
+ * anything from the file. bp_read_and_bcast_bpidx() has checked that it
+ * matches the file.
+ */
+static void bp_parse_vars_from_bpidx (BP_FILE * fh)
+{
+    const struct bpidx * idx = fh->bpidx;
+    struct adios_index_var_struct_v1 ** root = &(fh->vars_root);
+    const struct bpidx_var * r;
+    uint32_t i;
+
+    for (i = 0; i < fh->mfooter.vars_count; i++)
+    {
+        r = &idx->vars [i];
+
+        *root = (struct adios_index_var_struct_v1 *)
+            malloc (sizeof (struct adios_index_var_struct_v1));
+        (*root)->id = r->id;
+        (*root)->group_name = strdup (idx->strings + r->group_name);
+        (*root)->var_name = strdup (idx->strings + r->var_name);
+        (*root)->var_path = strdup (idx->strings + r->var_path);
+        (*root)->type = (enum ADIOS_DATATYPES) r->type;
+        (*root)->characteristics_count = r->characteristics_count;
+        (*root)->characteristics_allocated = 0;
+        (*root)->characteristics = 0;
+        (*root)->next = 0;
+
+        fh->vars_ref[i].offset = r->entry_offset;
+        fh->vars_ref[i].length = r->entry_length;
+        fh->vars_table[i] = *root;
+
+        root = &(*root)->next;
+    }
+}
+
+/* Decode the characteristics of v from its entry at the start of b */
+static void bp_decode_var_entry (BP_FILE * fh, struct adios_bp_buffer_struct_v1 * b,
+                                 struct adios_index_var_struct_v1 * v, int varid)
+{
+    int bpversion = fh->mfooter.version & ADIOS_VERSION_NUM_MASK;
+    uint64_t characteristics_sets_count, j;
+    uint16_t len;
+    int i;
+
+    /* skip what is already known: length, id, group, name, path, type */
+    b->offset = 4 + (bpversion > 1 ? 4 : 2);
+    for (i = 0; i < 3; i++)
+    {
+        BUFREAD16(b, len)
+        b->offset += len;
+    }
+    b->offset += 1;
+    BUFREAD64(b, characteristics_sets_count)
+
+    bp_parse_var_characteristics (fh, b, &v, characteristics_sets_count);
+    v->characteristics_count = characteristics_sets_count;
+    v->characteristics_allocated = characteristics_sets_count;
+
+    if (fh->gvar_h && fh->gvar_h->var_offsets)
+    {
+        fh->gvar_h->var_offsets[varid] = (uint64_t *) malloc (
+                sizeof(uint64_t) * characteristics_sets_count);
+        for (j = 0; j < characteristics_sets_count; j++)
+        {
+            fh->gvar_h->var_offsets[varid][j] = v->characteristics [j].offset;
+        }
+    }
+}
+
+/* Mark the entry of a variable decoded. The private variables index is
+ * dropped with the last variable that needed it, a shared one is kept
+ * until bp_close().
+ */
+static void bp_var_decoded (BP_FILE * fh, struct bp_var_index_ref * ref)
+{
+    ref->length = 0;
+    if (fh->vars_undecoded > 0 && --fh->vars_undecoded == 0 && fh->vars_index && !fh->footer_win)
+    {
+        free (fh->vars_index);
+        fh->vars_index = 0;
+    }
+}
+
+/* Decode the characteristics of variable varid if only its name is known
+ * so far (lazy_index or bp_parse_vars_from_bpidx()). With lazy_index the
+ * entry is taken from the variables index kept by bp_open(), private or
+ * node-shared. With a sidecar it is read from the file.
+ */
+int bp_decode_var (BP_FILE * fh, int varid)
+{
+    struct adios_index_var_struct_v1 * v = fh->vars_table [varid];
+    struct bp_var_index_ref * ref;
+    struct adios_bp_buffer_struct_v1 buf, * b = &buf;
+    int count = 0, err;
+    MPI_Status status;
+
+    ref = fh->vars_ref ? &fh->vars_ref [varid] : NULL;
+    if (v->characteristics || !ref || !ref->length)
+    {
+        return 0;
+    }
+
+    if (fh->vars_index)
+    {
+        /* b only points into the copy */
+        adios_buffer_struct_init (b);
+        b->buff = fh->vars_index + (ref->offset - fh->mfooter.vars_index_offset);
+        b->length = ref->length;
+        b->change_endianness = (enum ADIOS_FLAG) fh->mfooter.change_endianness;
+        bp_decode_var_entry (fh, b, v, varid);
+        bp_var_decoded (fh, ref);
+        return 0;
+    }
+
+    adios_buffer_struct_init (b);
+    bp_alloc_aligned (b, ref->length);
+    if (!b->buff)
+    {
+        adios_error (err_no_memory, "Could not allocate %u bytes for the index of variable %s\n",
+                     ref->length, v->var_name);
+        return err_no_memory;
+    }
+    b->change_endianness = (enum ADIOS_FLAG) fh->mfooter.change_endianness;
+
+    MPI_File_seek (fh->mpi_fh, (MPI_Offset) ref->offset, MPI_SEEK_SET);
+    err = MPI_File_read (fh->mpi_fh, b->buff, (int) ref->length, MPI_BYTE, &status);
+    if (err == MPI_SUCCESS)
+    {
+        MPI_Get_count (&status, MPI_BYTE, &count);
+    }
+    if (err != MPI_SUCCESS || count != (int) ref->length)
+    {
+        adios_error (err_invalid_buffer_vars,
+                     "Could not read the index of variable %s (%u bytes at offset %llu)\n",
+                     v->var_name, ref->length, (unsigned long long) ref->offset);
+        adios_buffer_struct_clear (b);
+        return err_invalid_buffer_vars;
+    }
+
+    bp_decode_var_entry (fh, b, v, varid);
+    adios_buffer_struct_clear (b);
+    bp_var_decoded (fh, ref);
+
+    return 0;
+}
+
 int bp_parse_vars (BP_FILE * fh)
 {
     struct adios_bp_buffer_struct_v1 * b = fh->b;
@@ -1236,9 +1854,18 @@ int bp_parse_vars (BP_FILE * fh)
 
     // To speed find_var_byid(). Q. Liu, 11-2013.
     fh->vars_table = (struct adios_index_var_struct_v1 **) malloc (8*(size_t)mh->vars_count);
+    fh->vars_ref = (struct bp_var_index_ref *) malloc (sizeof (struct bp_var_index_ref) * (size_t)mh->vars_count);
+
+    if (fh->bpidx)
+    {
+        bp_parse_vars_from_bpidx (fh);
+        /* entries are decoded when the variable is used, skip them */
+        b->offset = mh->attrs_index_offset - mh->pgs_index_offset;
+    }
+
     // validate remaining length
     int i;
-    for (i = 0; i < mh->vars_count; i++) {
+    for (i = 0; !fh->bpidx && i < mh->vars_count; i++) {
         if (!*root) {
             *root = (struct adios_index_var_struct_v1 *)
                 malloc (sizeof (struct adios_index_var_struct_v1));
@@ -1250,7 +1877,9 @@ int bp_parse_vars (BP_FILE * fh)
         uint16_t len;
         uint64_t characteristics_sets_count;
 
+        fh->vars_ref[i].offset = mh->pgs_index_offset + b->offset;
         BUFREAD32(b, var_entry_length)
+        fh->vars_ref[i].length = var_entry_length + 4;
         if (bpversion > 1) {
             BUFREAD32(b, (*root)->id)
         } else {
@@ -1282,47 +1911,28 @@ int bp_parse_vars (BP_FILE * fh)
         (*root)->characteristics_count = characteristics_sets_count;
         (*root)->characteristics_allocated = characteristics_sets_count;
 
-        // validate remaining length: offsets_count *
-        // (8 + 2 * (size of type))
-        (*root)->characteristics = malloc (characteristics_sets_count
-            * sizeof (struct adios_index_characteristic_struct_v1)
-            );
-        memset ((*root)->characteristics, 0
-            ,  characteristics_sets_count
-            * sizeof (struct adios_index_characteristic_struct_v1)
-               );
-        // NOTE: Above memset assumes that all 0's is a valid initialization.
-        //       This is true, currently, but be careful in the future.
-
-        uint64_t j;
-        for (j = 0; j < characteristics_sets_count; j++)
+        if (fh->lazy_index)
         {
-            uint8_t characteristic_set_count;
-            uint32_t characteristic_set_length;
-            uint8_t item = 0;
-
-            BUFREAD8(b, characteristic_set_count)
-            BUFREAD32(b, characteristic_set_length)
-
-            while (item < characteristic_set_count) {
-                bp_parse_characteristics (b, root, j);
-                item++;
-            }
-
-            /* Old BP files do not have time_index characteristics, so we
-               set it here automatically: j div # of pgs per timestep
-               Assumed that in old BP files, all pgs write each variable in each timestep.*/
-            if ((*root)->characteristics [j].time_index == 0) {
-                (*root)->characteristics [j].time_index =
-                     j / (mh->pgs_count / (fh->tidx_stop - fh->tidx_start + 1)) + 1;
-                /*printf("OldBP: var %s time_index set to %d\n",
-                        (*root)->var_name,
-                        (*root)->characteristics [j].time_index);*/
-            }
+            /* bp_decode_var() reads the entry again when the variable is used */
+            (*root)->characteristics_allocated = 0;
+            (*root)->characteristics = 0;
+            b->offset = fh->vars_ref[i].offset + fh->vars_ref[i].length - mh->pgs_index_offset;
+        }
+        else
+        {
+            bp_parse_var_characteristics (fh, b, root, characteristics_sets_count);
         }
         root = &(*root)->next;
     }
 
+    /* bp_open() keeps the variables index for bp_decode_var() until the
+       last variable has been decoded. With a sidecar the entries have not
+       been read, they are read from the file when decoded. */
+    if (fh->lazy_index && !fh->bpidx)
+    {
+        fh->vars_undecoded = mh->vars_count;
+    }
+
     root = vars_root;
     uint32_t * var_counts_per_group;
     uint16_t *  var_gids;
@@ -1387,10 +1997,13 @@ int bp_parse_vars (BP_FILE * fh)
         }
         //printf ("Variable %d full path is [%s]\n", i, var_namelist[i]);
 
-        var_offsets[i] = (uint64_t *) malloc (
-                sizeof(uint64_t)*(*root)->characteristics_count);
-        for (j=0;j < (*root)->characteristics_count;j++) {
-            var_offsets[i][j] = (*root)->characteristics [j].offset;
+        // not decoded variables get theirs in bp_decode_var()
+        if ((*root)->characteristics) {
+            var_offsets[i] = (uint64_t *) malloc (
+                    sizeof(uint64_t)*(*root)->characteristics_count);
+            for (j=0;j < (*root)->characteristics_count;j++) {
+                var_offsets[i][j] = (*root)->characteristics [j].offset;
+            }
         }
 
         //struct adios_index_characteristic_dims_struct_v1 * pdims;
@@ -1820,6 +2433,31 @@ int64_t get_var_stop_index (struct adios_index_var_struct_v1 * v, int t)
  * current_step in ADIOS_FILE.
  * Note: in file mode, tostep should be given -1.
  */
+/* Does variable varid have a block at time t? Variables not decoded yet
+ * are looked up in the sidecar index.
+ */
+static int bp_var_has_time (BP_FILE * fh, int varid, int t)
+{
+    struct adios_index_var_struct_v1 * v = fh->vars_table [varid];
+    uint64_t i;
+
+    if (!v->characteristics && fh->bpidx)
+    {
+        return bpidx_var_has_time (fh->bpidx, varid, (uint32_t) t);
+    }
+
+    bp_decode_var (fh, varid);
+    for (i = 0; v->characteristics && i < v->characteristics_count; i++)
+    {
+        if (v->characteristics[i].time_index == t)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 int bp_seek_to_step (ADIOS_FILE * fp, int tostep, int show_hidden_attrs)
 {
     BP_PROC * p = GET_BP_PROC (fp);
@@ -1841,6 +2479,10 @@ int bp_seek_to_step (ADIOS_FILE * fp, int tostep, int show_hidden_attrs)
     else
     {
         allstep = 0;
+        if (var_root)
+        {
+            bp_decode_var (fh, 0);
+        }
         t = get_time (var_root, tostep);
     }
 
@@ -1848,17 +2490,16 @@ int bp_seek_to_step (ADIOS_FILE * fp, int tostep, int show_hidden_attrs)
     fp->nvars = 0;
 //    var_root = fh->vars_root;
 
+    k = 0;
     while (var_root)
     {
-        for (i = 0; i < var_root->characteristics_count; i++)
+        if (var_root->characteristics_count > 0
+            && (allstep || bp_var_has_time (fh, k, t)))
         {
-            if (allstep || (!allstep && var_root->characteristics[i].time_index == t))
-            {
-                fp->nvars++;
-                break;
-            }
+            fp->nvars++;
         }
 
+        k++;
         var_root = var_root->next;
     }
 
@@ -1871,56 +2512,52 @@ int bp_seek_to_step (ADIOS_FILE * fp, int tostep, int show_hidden_attrs)
     k = 0;
     while (var_root)
     {
-        for (i = 0; i < var_root->characteristics_count; i++)
+        if (var_root->characteristics_count > 0
+            && (allstep || bp_var_has_time (fh, k, t)))
         {
-            if (allstep || (!allstep && var_root->characteristics[i].time_index == t))
+            /* Up to 1.5, we always put a / to the beginning */
+            /*
+            if (strcmp (var_root->var_path,"/"))
             {
-                /* Up to 1.5, we always put a / to the beginning */
-                /*
-                if (strcmp (var_root->var_path,"/"))
-                {
-                    fp->var_namelist[j] = (char *)malloc (strlen((var_root)->var_name)
-                                          + strlen (var_root->var_path) + 1 + 1   // extra / and ending \0
-                                          );
-                    strcpy (fp->var_namelist[j], var_root->var_path);
-                }
-                else
-                {
-                    fp->var_namelist[j] = (char *) malloc (strlen (var_root->var_name) + 1 + 1);
-                    fp->var_namelist[j][0] = '\0';
-                }
-
-                strcat (fp->var_namelist[j], "/");
-                strcat (fp->var_namelist[j], var_root->var_name);
-                */
+                fp->var_namelist[j] = (char *)malloc (strlen((var_root)->var_name)
+                                      + strlen (var_root->var_path) + 1 + 1   // extra / and ending \0
+                                      );
+                strcpy (fp->var_namelist[j], var_root->var_path);
+            }
+            else
+            {
+                fp->var_namelist[j] = (char *) malloc (strlen (var_root->var_name) + 1 + 1);
+                fp->var_namelist[j][0] = '\0';
+            }
 
-                /* From 1.6, relative and full path (starts with /) are handled separately in search */
-                // Full name of variable: concatenate var_path and var_name
-                lenpath = strlen(var_root->var_path);
-                lenname = strlen(var_root->var_name);
-                if (lenpath > 0) {
-                    fp->var_namelist [j] = (char *) malloc (lenname + lenpath + 1 + 1);
-                                                                    // extra / and ending \0
-                    strcpy(fp->var_namelist[j], var_root->var_path);
-                    if (var_root->var_path[lenpath-1] != '/') {
-                        fp->var_namelist[j][lenpath] = '/';
-                        lenpath++;
-                    }
-                    strcpy(&(fp->var_namelist[j][lenpath]), var_root->var_name);
-                }
-                else {
-                    fp->var_namelist[j] = (char *) malloc (lenname+1); 
-                    strcpy(fp->var_namelist[j], var_root->var_name);
+            strcat (fp->var_namelist[j], "/");
+            strcat (fp->var_namelist[j], var_root->var_name);
+            */
+
+            /* From 1.6, relative and full path (starts with /) are handled separately in search */
+            // Full name of variable: concatenate var_path and var_name
+            lenpath = strlen(var_root->var_path);
+            lenname = strlen(var_root->var_name);
+            if (lenpath > 0) {
+                fp->var_namelist [j] = (char *) malloc (lenname + lenpath + 1 + 1);
+                                                                // extra / and ending \0
+                strcpy(fp->var_namelist[j], var_root->var_path);
+                if (var_root->var_path[lenpath-1] != '/') {
+                    fp->var_namelist[j][lenpath] = '/';
+                    lenpath++;
                 }
-                //printf ("Seek to step: Variable %d full path is [%s]\n", j, fp->var_namelist[j]);
-
+                strcpy(&(fp->var_namelist[j][lenpath]), var_root->var_name);
+            }
+            else {
+                fp->var_namelist[j] = (char *) malloc (lenname+1); 
+                strcpy(fp->var_namelist[j], var_root->var_name);
+            }
+            //printf ("Seek to step: Variable %d full path is [%s]\n", j, fp->var_namelist[j]);
 
-                p->varid_mapping[j] = k;
 
-                j++;
+            p->varid_mapping[j] = k;
 
-                break;
-            }
+            j++;
         }
 
         k++;
@@ -2951,6 +3588,8 @@ int has_subfiles (BP_FILE * fh)
 
 /****************************************************
   Find the var associated with the given variable id
+  Returns NULL if varid is out of range or its entry
+  cannot be decoded.
 *****************************************************/
 struct adios_index_var_struct_v1 * bp_find_var_byid (BP_FILE * fh, int varid)
 {
@@ -2971,6 +3610,16 @@ struct adios_index_var_struct_v1 * bp_find_var_byid (BP_FILE * fh, int varid)
         return NULL;
     }
 */
+    if (varid < 0 || (uint64_t) varid >= fh->mfooter.vars_count)
+    {
+        return NULL;
+    }
+
+    if (bp_decode_var (fh, varid))
+    {
+        return NULL;
+    }
+
     return fh->vars_table[varid];
  //   return var_root;
 }
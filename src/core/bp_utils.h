@@ -37,12 +37,15 @@ int get_time (struct adios_index_var_struct_v1 * v, int step);
 int bp_open (const char * fname,
              MPI_Comm comm,
              BP_FILE * fh);
+int bp_read_and_bcast_footer (BP_FILE * fh, MPI_Comm comm);
+MPI_File * bp_open_subfile (BP_FILE * fh, uint32_t file_index);
 ADIOS_VARINFO * bp_inq_var_byid (const ADIOS_FILE * fp, int varid);
 int bp_close (BP_FILE * fh);
 int bp_read_minifooter (BP_FILE * bp_struct);
 int bp_parse_pgs (BP_FILE * fh);
 int bp_parse_attrs (BP_FILE * fh);
 int bp_parse_vars (BP_FILE * fh);
+int bp_decode_var (BP_FILE * fh, int varid);
 int bp_seek_to_step (ADIOS_FILE * fp, int tostep, int show_hidden_attrs);
 int64_t get_var_start_index (struct adios_index_var_struct_v1 * v, int t);
 int64_t get_var_stop_index (struct adios_index_var_struct_v1 * v, int t);
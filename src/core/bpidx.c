@@ -0,0 +1,410 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "public/adios_error.h"
+#include "core/bpidx.h"
+#include "core/bp_utils.h"
+#include "core/adios_logger.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+char * bpidx_filename (const char * bp_fname)
+{
+    size_t len = strlen (bp_fname);
+    char * name = (char *) malloc (len + 6 + 1);
+
+    strcpy (name, bp_fname);
+    if (len > 3 && !strcmp (bp_fname + len - 3, ".bp"))
+    {
+        len -= 3;
+    }
+    strcpy (name + len, ".bpidx");
+
+    return name;
+}
+
+/* Check what the reader takes from the sidecar without further checks:
+ * the steps and strings of each variable are inside their sections, every
+ * string ends inside the string table, the steps of a variable are sorted
+ * and the entries are inside the variable index of the BP file.
+ * Returns 0 if the sidecar is usable.
+ */
+static int bpidx_check (const struct bpidx_header * h, const char * map,
+                        const struct bp_minifooter * mh)
+{
+    const struct bpidx_var * vars = (const struct bpidx_var *) (map + h->vars_offset);
+    const struct bpidx_step * steps = (const struct bpidx_step *) (map + h->steps_offset);
+    const char * strings = map + h->strings_offset;
+    uint64_t i, j;
+
+    /* then every offset inside the table starts a terminated string */
+    if (h->strings_length && strings [h->strings_length - 1] != '\0')
+    {
+        return 1;
+    }
+
+    for (i = 0; i < h->vars_count; i++)
+    {
+        const struct bpidx_var * v = &vars [i];
+
+        if (v->group_name >= h->strings_length
+            || v->var_name >= h->strings_length
+            || v->var_path >= h->strings_length)
+        {
+            return 1;
+        }
+
+        if (v->steps_start > h->steps_count
+            || v->steps_count > h->steps_count - v->steps_start)
+        {
+            return 1;
+        }
+
+        for (j = 1; j < v->steps_count; j++)
+        {
+            if (steps [v->steps_start + j].time_index < steps [v->steps_start + j - 1].time_index)
+            {
+                return 1;
+            }
+        }
+
+        if (v->entry_offset < mh->vars_index_offset
+            || v->entry_offset > mh->attrs_index_offset
+            || v->entry_length > mh->attrs_index_offset - v->entry_offset)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+struct bpidx * bpidx_from_buffer (void * buf, size_t size)
+{
+    struct bpidx * idx = (struct bpidx *) malloc (sizeof (struct bpidx));
+    const struct bpidx_header * h = (const struct bpidx_header *) buf;
+
+    idx->map = buf;
+    idx->size = size;
+    idx->is_mapped = 0;
+    idx->header = h;
+    idx->vars = (const struct bpidx_var *) ((const char *) buf + h->vars_offset);
+    idx->steps = (const struct bpidx_step *) ((const char *) buf + h->steps_offset);
+    idx->strings = (const char *) buf + h->strings_offset;
+
+    return idx;
+}
+
+struct bpidx * bpidx_open (const char * bp_fname, const struct bp_minifooter * mh)
+{
+    struct bpidx * idx;
+    const struct bpidx_header * h;
+    struct stat st;
+    uint64_t size;
+    char * name;
+    void * map;
+    int f;
+
+    name = bpidx_filename (bp_fname);
+    f = open (name, O_RDONLY);
+    if (f == -1)
+    {
+        log_debug ("No index sidecar %s\n", name);
+        free (name);
+        return NULL;
+    }
+
+    if (fstat (f, &st) || (uint64_t) st.st_size < sizeof (struct bpidx_header))
+    {
+        log_warn ("Index sidecar %s is too short, ignored\n", name);
+        close (f);
+        free (name);
+        return NULL;
+    }
+
+    size = (uint64_t) st.st_size;
+    map = mmap (NULL, (size_t) size, PROT_READ, MAP_SHARED, f, 0);
+    close (f);
+    if (map == MAP_FAILED)
+    {
+        log_warn ("Could not map index sidecar %s: %s\n", name, strerror (errno));
+        free (name);
+        return NULL;
+    }
+
+    h = (const struct bpidx_header *) map;
+    if (memcmp (h->magic, BPIDX_MAGIC, sizeof (h->magic))
+        || h->version != BPIDX_VERSION
+        || h->endianness != BPIDX_ENDIANNESS)
+    {
+        log_warn ("%s is not an index sidecar of this version and byte order, ignored\n", name);
+        munmap (map, (size_t) size);
+        free (name);
+        return NULL;
+    }
+
+    if (h->bp_file_size != mh->file_size
+        || h->vars_index_offset != mh->vars_index_offset)
+    {
+        log_warn ("Index sidecar %s does not match %s (was the file appended to?), ignored\n",
+                  name, bp_fname);
+        munmap (map, (size_t) size);
+        free (name);
+        return NULL;
+    }
+
+    if (h->vars_offset + h->vars_count * sizeof (struct bpidx_var) > size
+        || h->steps_offset + h->steps_count * sizeof (struct bpidx_step) > size
+        || h->strings_offset + h->strings_length > size)
+    {
+        log_warn ("Index sidecar %s is truncated, ignored\n", name);
+        munmap (map, (size_t) size);
+        free (name);
+        return NULL;
+    }
+
+    if (bpidx_check (h, (const char *) map, mh))
+    {
+        log_warn ("Index sidecar %s is corrupt, ignored\n", name);
+        munmap (map, (size_t) size);
+        free (name);
+        return NULL;
+    }
+
+    idx = bpidx_from_buffer (map, (size_t) size);
+    idx->is_mapped = 1;
+
+    log_debug ("Using index sidecar %s with %llu variables\n",
+               name, (unsigned long long) h->vars_count);
+    free (name);
+
+    return idx;
+}
+
+void bpidx_close (struct bpidx * idx)
+{
+    if (idx)
+    {
+        if (idx->is_mapped)
+        {
+            munmap (idx->map, idx->size);
+        }
+        else
+        {
+            free (idx->map);
+        }
+        free (idx);
+    }
+}
+
+int bpidx_var_has_time (const struct bpidx * idx, int varid, uint32_t t)
+{
+    const struct bpidx_var * v = &idx->vars [varid];
+    const struct bpidx_step * s = &idx->steps [v->steps_start];
+    uint32_t lo = 0, hi = v->steps_count, mid;
+
+    /* the steps of a variable are sorted by time index */
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (s[mid].time_index < t)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return (lo < v->steps_count && s[lo].time_index == t);
+}
+
+static int cmp_step (const void * a, const void * b)
+{
+    const struct bpidx_step * x = (const struct bpidx_step *) a;
+    const struct bpidx_step * y = (const struct bpidx_step *) b;
+
+    if (x->time_index != y->time_index)
+        return (x->time_index < y->time_index ? -1 : 1);
+    return (x->first_block < y->first_block ? -1 : (x->first_block > y->first_block));
+}
+
+/* Append a \0 terminated string to the string table, return its offset */
+static uint64_t add_string (char ** strings, uint64_t * length, uint64_t * allocated,
+                            const char * s)
+{
+    uint64_t offset = *length;
+    size_t len = strlen (s) + 1;
+
+    if (*length + len > *allocated)
+    {
+        *allocated = 2 * (*allocated) + len;
+        *strings = (char *) realloc (*strings, *allocated);
+    }
+    memcpy (*strings + *length, s, len);
+    *length += len;
+
+    return offset;
+}
+
+static int write_all (int f, const void * buf, uint64_t size)
+{
+    const char * p = (const char *) buf;
+    ssize_t n;
+
+    while (size > 0)
+    {
+        n = write (f, p, (size > 0x40000000 ? 0x40000000 : (size_t) size));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+int bpidx_write (BP_FILE * fh, const char * bp_fname)
+{
+    struct bpidx_header h;
+    struct bpidx_var * vars;
+    struct bpidx_step * steps = NULL;
+    uint64_t steps_count = 0, steps_allocated = 0;
+    char * strings = NULL;
+    uint64_t strings_length = 0, strings_allocated = 0;
+    struct adios_index_var_struct_v1 * v;
+    uint64_t i, j;
+    char * name;
+    int f, err = 0;
+
+    if (!fh->vars_ref)
+    {
+        adios_error (err_invalid_argument,
+                     "Cannot write the index sidecar of %s: "
+                     "the locations of the variable entries are not known\n",
+                     bp_fname);
+        return 1;
+    }
+
+    vars = (struct bpidx_var *) calloc (fh->mfooter.vars_count, sizeof (struct bpidx_var));
+    if (!vars && fh->mfooter.vars_count)
+    {
+        adios_error (err_no_memory, "Cannot allocate the index sidecar of %s\n", bp_fname);
+        return 1;
+    }
+
+    for (i = 0; i < fh->mfooter.vars_count; i++)
+    {
+        v = bp_find_var_byid (fh, (int) i);  // decodes the entry if needed
+        if (!v)
+        {
+            adios_error (err_invalid_varid, "Cannot write the index sidecar of %s: "
+                         "variable id %d cannot be decoded\n", bp_fname, (int) i);
+            free (strings);
+            free (steps);
+            free (vars);
+            return 1;
+        }
+
+        vars[i].entry_offset = fh->vars_ref[i].offset;
+        vars[i].entry_length = fh->vars_ref[i].length;
+        vars[i].id = v->id;
+        vars[i].characteristics_count = v->characteristics_count;
+        vars[i].type = (uint32_t) v->type;
+        vars[i].group_name = add_string (&strings, &strings_length, &strings_allocated, v->group_name);
+        vars[i].var_name = add_string (&strings, &strings_length, &strings_allocated, v->var_name);
+        vars[i].var_path = add_string (&strings, &strings_length, &strings_allocated, v->var_path);
+        vars[i].steps_start = steps_count;
+
+        for (j = 0; j < v->characteristics_count; j++)
+        {
+            if (j > 0 && v->characteristics[j].time_index == steps[steps_count-1].time_index)
+            {
+                steps[steps_count-1].nblocks++;
+                continue;
+            }
+
+            if (steps_count == steps_allocated)
+            {
+                steps_allocated = 2 * steps_allocated + 64;
+                steps = (struct bpidx_step *) realloc (steps, steps_allocated * sizeof (struct bpidx_step));
+            }
+            steps[steps_count].time_index = v->characteristics[j].time_index;
+            steps[steps_count].reserved = 0;
+            steps[steps_count].first_block = j;
+            steps[steps_count].nblocks = 1;
+            steps_count++;
+            vars[i].steps_count++;
+        }
+
+        /* blocks of appended steps need not be in time order */
+        qsort (steps + vars[i].steps_start, vars[i].steps_count,
+               sizeof (struct bpidx_step), cmp_step);
+    }
+
+    memset (&h, 0, sizeof (h));
+    memcpy (h.magic, BPIDX_MAGIC, sizeof (h.magic));
+    h.version = BPIDX_VERSION;
+    h.endianness = BPIDX_ENDIANNESS;
+    h.bp_file_size = fh->mfooter.file_size;
+    h.vars_index_offset = fh->mfooter.vars_index_offset;
+    h.vars_count = fh->mfooter.vars_count;
+    h.steps_count = steps_count;
+    h.vars_offset = sizeof (h);
+    h.steps_offset = h.vars_offset + h.vars_count * sizeof (struct bpidx_var);
+    h.strings_offset = h.steps_offset + steps_count * sizeof (struct bpidx_step);
+    h.strings_length = strings_length;
+
+    name = bpidx_filename (bp_fname);
+    f = open (name, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (f == -1)
+    {
+        adios_error (err_file_open_error, "Cannot create index sidecar %s: %s\n",
+                     name, strerror (errno));
+        err = 1;
+    }
+    else
+    {
+        if (write_all (f, &h, sizeof (h))
+            || write_all (f, vars, h.vars_count * sizeof (struct bpidx_var))
+            || write_all (f, steps, steps_count * sizeof (struct bpidx_step))
+            || write_all (f, strings, strings_length))
+        {
+            adios_error (err_write_error, "Cannot write index sidecar %s: %s\n",
+                         name, strerror (errno));
+            err = 1;
+        }
+        close (f);
+        if (err)
+        {
+            unlink (name);
+        }
+    }
+
+    free (name);
+    free (strings);
+    free (steps);
+    free (vars);
+
+    return err;
+}
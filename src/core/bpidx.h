@@ -0,0 +1,109 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#ifndef __BPIDX_H__
+#define __BPIDX_H__
+
+/* Sidecar variable index of a BP file (<name>.bpidx for <name>.bp).
+ *
+ * The BP footer has to be decoded entirely before a single variable can be
+ * looked at. The sidecar lists every variable with the location of its
+ * entry in the footer and the blocks it has per step, in a flat layout
+ * that is mapped into memory as is. A reader builds its variable list from
+ * it and decodes a variable's entry in the footer only when it is used.
+ *
+ * Layout (integers in the byte order of the writer, checked at open):
+ *
+ *   struct bpidx_header
+ *   struct bpidx_var  [vars_count]   in the order of the BP variable index,
+ *                                    so record i belongs to variable id i
+ *   struct bpidx_step [steps_count]  the steps of each variable, one per
+ *                                    run of blocks with the same time index,
+ *                                    sorted by time index (version 2)
+ *   strings                          \0 terminated names
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "core/bp_types.h"
+
+#define BPIDX_MAGIC      "BPIDX\0\0"
+#define BPIDX_VERSION    2
+#define BPIDX_ENDIANNESS 0x01020304
+
+struct bpidx_header
+{
+    char     magic [8];
+    uint32_t version;
+    uint32_t endianness;         /* BPIDX_ENDIANNESS as written */
+    uint64_t bp_file_size;       /* the BP file it was made for, */
+    uint64_t vars_index_offset;  /* to detect a stale sidecar */
+    uint64_t vars_count;
+    uint64_t steps_count;
+    uint64_t vars_offset;        /* offsets of the sections in the sidecar */
+    uint64_t steps_offset;
+    uint64_t strings_offset;
+    uint64_t strings_length;
+};
+
+struct bpidx_var
+{
+    uint64_t entry_offset;           /* the variable's entry in the BP file */
+    uint32_t entry_length;
+    uint32_t id;
+    uint64_t characteristics_count;  /* blocks over all steps */
+    uint64_t steps_start;            /* first bpidx_step of this variable */
+    uint32_t steps_count;
+    uint32_t type;                   /* enum ADIOS_DATATYPES */
+    uint64_t group_name;             /* offsets into the strings */
+    uint64_t var_name;
+    uint64_t var_path;
+};
+
+struct bpidx_step
+{
+    uint32_t time_index;
+    uint32_t reserved;
+    uint64_t first_block;  /* index into the variable's characteristics */
+    uint64_t nblocks;
+};
+
+/* An opened sidecar, memory mapped on the process that opened it,
+   a malloc'd copy on the processes it was broadcast to */
+struct bpidx
+{
+    void * map;
+    size_t size;
+    int is_mapped;
+    const struct bpidx_header * header;
+    const struct bpidx_var * vars;
+    const struct bpidx_step * steps;
+    const char * strings;
+};
+
+/* Name of the sidecar of a BP file: .bp is replaced by .bpidx,
+   other names get .bpidx appended. Returns a malloc'd string. */
+char * bpidx_filename (const char * bp_fname);
+
+/* Map the sidecar of a BP file whose minifooter has been read.
+   Returns NULL if there is no sidecar or it does not match the file. */
+struct bpidx * bpidx_open (const char * bp_fname, const struct bp_minifooter * mh);
+void bpidx_close (struct bpidx * idx);
+
+/* A sidecar from the malloc'd copy of one bpidx_open() accepted. The
+   buffer is owned (and freed at close) by the returned sidecar. */
+struct bpidx * bpidx_from_buffer (void * buf, size_t size);
+
+/* Write the sidecar of an opened BP file. Every variable's entry is
+   decoded for this. Returns 0 on success. */
+int bpidx_write (BP_FILE * fh, const char * bp_fname);
+
+/* Variable varid has a block at time index t? (varid < vars_count)
+   Binary search in the variable's steps. */
+int bpidx_var_has_time (const struct bpidx * idx, int varid, uint32_t t);
+
+#endif
@@ -8,7 +8,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>   /* _SC_PAGE_SIZE, _SC_AVPHYS_PAGES */
+#include <sys/mman.h> /* madvise */
+#include <pthread.h>
 
 #if defined(__APPLE__)
 #    include <mach/mach.h>
@@ -25,6 +28,8 @@ static uint64_t adios_buffer_size_max = 0;
 static uint64_t adios_buffer_size_remaining = 0;
 static int adios_buffer_alloc_percentage = 0;  // 1 = yes, 0 = no
 static enum ADIOS_BUFFER_ALLOC_WHEN adios_buffer_alloc_when = ADIOS_BUFFER_ALLOC_UNKNOWN;
+static uint64_t adios_buffer_zero_copy_threshold = 0;  // 0 = always copy
+static int adios_buffer_deferred_write_threads = 0;    // 0 = write in adios_write
 
 void      adios_buffer_size_requested_set (uint64_t v)  { adios_buffer_size_requested = v; }
 uint64_t  adios_buffer_size_requested_get (void)        { return adios_buffer_size_requested; }
@@ -33,6 +38,37 @@ void      adios_buffer_size_remaining_set (uint64_t v)  { adios_buffer_size_rema
 void      adios_buffer_alloc_percentage_set (int v)     { adios_buffer_alloc_percentage = v; }
 void      adios_buffer_alloc_when_set (enum ADIOS_BUFFER_ALLOC_WHEN v)   { adios_buffer_alloc_when = v; }
 enum ADIOS_BUFFER_ALLOC_WHEN adios_buffer_alloc_when_get (void)   { return adios_buffer_alloc_when; }
+void      adios_buffer_zero_copy_threshold_set (uint64_t v)  { adios_buffer_zero_copy_threshold = v; }
+uint64_t  adios_buffer_zero_copy_threshold_get (void)        { return adios_buffer_zero_copy_threshold; }
+void      adios_buffer_deferred_write_threads_set (int v)    { adios_buffer_deferred_write_threads = v; }
+int       adios_buffer_deferred_write_threads_get (void)     { return adios_buffer_deferred_write_threads; }
+
+// pooled output buffers
+#define ADIOS_BUFFER_POOL_SLOTS 4                  // buffers kept at most
+#define ADIOS_BUFFER_HUGEPAGE_SIZE (2*1024*1024)
+
+// Buffers kept in the pool are charged to the budget of
+// adios_method_buffer_alloc()/adios_method_buffer_free() while they are
+// not in use, so the pool does not hold memory beyond the <buffer> size.
+struct adios_buffer_pool_slot
+{
+    void * buffer;
+    uint64_t capacity;
+    int charged;    // capacity is taken from adios_buffer_size_remaining
+};
+
+static struct adios_buffer_pool_slot adios_buffer_pool [ADIOS_BUFFER_POOL_SLOTS];
+// The write-behind and deferred write threads get and put buffers too.
+// The lock covers the slots and adios_buffer_size_remaining, which the
+// pool charges.
+static pthread_mutex_t adios_buffer_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static int adios_buffer_pool_hugepages = 0;  // 1 = yes, 0 = no
+static int adios_buffer_pool_prefault = 0;   // 1 = yes, 0 = no
+
+void      adios_buffer_pool_hugepages_set (int v)       { adios_buffer_pool_hugepages = v; }
+void      adios_buffer_pool_prefault_set (int v)        { adios_buffer_pool_prefault = v; }
+
+static void adios_buffer_pool_make_room (uint64_t size);
 
 #if defined (__APPLE__)
 // See e.g. http://www.opensource.apple.com/source/system_cmds/system_cmds-496/vm_stat.tproj/vm_stat.c
@@ -124,39 +160,284 @@ int adios_set_buffer_size ()
 
 uint64_t adios_method_buffer_alloc (uint64_t size)
 {
+    uint64_t allowed;
+
+    pthread_mutex_lock (&adios_buffer_pool_lock);
+    if (adios_buffer_size_remaining < size)
+    {
+        adios_buffer_pool_make_room (size);
+    }
+
     if (adios_buffer_size_remaining >= size)
     {
         adios_buffer_size_remaining -= size;
 
-        return size;
+        allowed = size;
     }
     else
     {
-        uint64_t remaining = adios_buffer_size_remaining;
+        allowed = adios_buffer_size_remaining;
 
         adios_buffer_size_remaining = 0;
-
-        return remaining;
     }
+    pthread_mutex_unlock (&adios_buffer_pool_lock);
+
+    return allowed;
 }
 
 int adios_method_buffer_free (uint64_t size)
 {
+    int ok = 1;
+
+    pthread_mutex_lock (&adios_buffer_pool_lock);
     if (size + adios_buffer_size_remaining > adios_buffer_size_max)
+    {
+        adios_buffer_size_remaining = adios_buffer_size_max;
+        ok = 0;
+    }
+    else
+    {
+        adios_buffer_size_remaining += size;
+    }
+    pthread_mutex_unlock (&adios_buffer_pool_lock);
+
+    if (!ok)
     {
         adios_error (err_invalid_buffer, 
                      "ERROR: attempt to return more bytes to buffer "
                      "pool than were originally available\n");
+    }
 
-        adios_buffer_size_remaining = adios_buffer_size_max;
+    return ok;
+}
+
+
+static uint64_t adios_buffer_pool_alignment (void)
+{
+    if (adios_buffer_pool_hugepages)
+        return ADIOS_BUFFER_HUGEPAGE_SIZE;
+    else
+        return (uint64_t) sysconf (_SC_PAGE_SIZE);
+}
+
+// the smallest kept buffer that fits, unless it is more than twice
+// the size asked for, -1 if there is none
+static int adios_buffer_pool_find (uint64_t size)
+{
+    int best = -1;
+    int i;
+
+    for (i = 0; i < ADIOS_BUFFER_POOL_SLOTS; i++)
+    {
+        if (   adios_buffer_pool [i].buffer
+            && adios_buffer_pool [i].capacity >= size
+            && adios_buffer_pool [i].capacity / 2 <= size
+            && (   best == -1
+                || adios_buffer_pool [i].capacity < adios_buffer_pool [best].capacity
+               )
+           )
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+static void adios_buffer_pool_free_slot (int i)
+{
+    if (adios_buffer_pool [i].charged)
+    {
+        adios_buffer_size_remaining += adios_buffer_pool [i].capacity;
+    }
+    free (adios_buffer_pool [i].buffer);
+    adios_buffer_pool [i].buffer = 0;
+    adios_buffer_pool [i].capacity = 0;
+    adios_buffer_pool [i].charged = 0;
+}
+
+// The budget is short of size bytes: a kept buffer that fits is lent to
+// the request (it is charged by the caller from now on), the other kept
+// buffers are freed until the request fits.
+static void adios_buffer_pool_make_room (uint64_t size)
+{
+    int fit = adios_buffer_pool_find (size);
+    int i;
+
+    if (fit != -1 && adios_buffer_pool [fit].charged)
+    {
+        adios_buffer_size_remaining += adios_buffer_pool [fit].capacity;
+        adios_buffer_pool [fit].charged = 0;
+    }
+
+    for (i = 0; i < ADIOS_BUFFER_POOL_SLOTS && adios_buffer_size_remaining < size; i++)
+    {
+        if (i != fit && adios_buffer_pool [i].buffer && adios_buffer_pool [i].charged)
+        {
+            log_debug ("adios_buffer_pool: free a kept buffer of %llu bytes, "
+                       "the buffer budget is used up\n",
+                       adios_buffer_pool [i].capacity);
+            adios_buffer_pool_free_slot (i);
+        }
+    }
+
+    if (fit != -1 && adios_buffer_size_remaining < size)
+    {
+        // no use, charge it again
+        adios_buffer_size_remaining -= adios_buffer_pool [fit].capacity;
+        adios_buffer_pool [fit].charged = 1;
+    }
+}
+
+void * adios_buffer_pool_get (uint64_t size, uint64_t * capacity)
+{
+    uint64_t align = adios_buffer_pool_alignment ();
+    uint64_t pagesize = (uint64_t) sysconf (_SC_PAGE_SIZE);
+    void * buffer = 0;
+    int best;
+
+    pthread_mutex_lock (&adios_buffer_pool_lock);
+    best = adios_buffer_pool_find (size);
+    if (best != -1)
+    {
+        buffer = adios_buffer_pool [best].buffer;
+        *capacity = adios_buffer_pool [best].capacity;
+        if (adios_buffer_pool [best].charged)
+        {
+            adios_buffer_size_remaining += *capacity;
+        }
+        adios_buffer_pool [best].buffer = 0;
+        adios_buffer_pool [best].capacity = 0;
+        adios_buffer_pool [best].charged = 0;
+    }
+    pthread_mutex_unlock (&adios_buffer_pool_lock);
+
+    if (buffer)
+    {
+        log_debug ("adios_buffer_pool_get (): reuse a buffer of %llu bytes "
+                   "for %llu bytes\n", *capacity, size);
+
+        return buffer;
+    }
 
+    // round up so that a slowly growing size can still reuse the buffer
+    *capacity = (size + align - 1) / align * align;
+    if (*capacity == 0)
+        *capacity = align;
+
+    if (posix_memalign (&buffer, align, *capacity))
+    {
+        *capacity = 0;
         return 0;
     }
-    else
+
+#ifdef MADV_HUGEPAGE
+    if (adios_buffer_pool_hugepages)
     {
-        adios_buffer_size_remaining += size;
+        if (madvise (buffer, *capacity, MADV_HUGEPAGE))
+        {
+            log_debug ("adios_buffer_pool_get (): madvise(MADV_HUGEPAGE) "
+                       "failed, using normal pages\n");
+        }
+    }
+#endif
 
-        return 1;
+    if (adios_buffer_pool_prefault)
+    {
+        // touch every page now rather than during the first write
+        char * p = (char *) buffer;
+        uint64_t off;
+        for (off = 0; off < *capacity; off += pagesize)
+        {
+            p [off] = 0;
+        }
+    }
+
+    log_debug ("adios_buffer_pool_get (): new buffer of %llu bytes "
+               "for %llu bytes\n", *capacity, size);
+
+    return buffer;
+}
+
+// Keep buffer in a slot, 0 if it is not kept. The caller holds the lock.
+static int adios_buffer_pool_keep (void * buffer, uint64_t capacity)
+{
+    int slot = -1;
+    int i;
+
+    // take a free slot, or replace the smallest kept buffer
+    for (i = 0; i < ADIOS_BUFFER_POOL_SLOTS; i++)
+    {
+        if (!adios_buffer_pool [i].buffer)
+        {
+            slot = i;
+            break;
+        }
+        if (slot == -1 || adios_buffer_pool [i].capacity < adios_buffer_pool [slot].capacity)
+        {
+            slot = i;
+        }
+    }
+
+    if (adios_buffer_pool [slot].buffer)
+    {
+        if (adios_buffer_pool [slot].capacity > capacity)
+        {
+            return 0;
+        }
+        adios_buffer_pool_free_slot (slot);
+    }
+
+    // an idle buffer is charged to the buffer budget
+    if (adios_buffer_size_remaining < capacity)
+    {
+        log_debug ("adios_buffer_pool_put (): free a buffer of %llu bytes, "
+                   "the buffer budget is used up\n", capacity);
+        return 0;
+    }
+    adios_buffer_size_remaining -= capacity;
+
+    adios_buffer_pool [slot].buffer = buffer;
+    adios_buffer_pool [slot].capacity = capacity;
+    adios_buffer_pool [slot].charged = 1;
+
+    return 1;
+}
+
+void adios_buffer_pool_put (void * buffer, uint64_t capacity)
+{
+    int kept;
+
+    if (!buffer)
+        return;
+
+    // a buffer that was realloc()'d may have lost the alignment, and
+    // slow growth by realloc() is fine for it, but it should not be
+    // handed out again as an aligned buffer
+    if ((uintptr_t) buffer % adios_buffer_pool_alignment () || !capacity)
+    {
+        free (buffer);
+        return;
+    }
+
+    pthread_mutex_lock (&adios_buffer_pool_lock);
+    kept = adios_buffer_pool_keep (buffer, capacity);
+    pthread_mutex_unlock (&adios_buffer_pool_lock);
+
+    if (!kept)
+    {
+        free (buffer);
     }
 }
 
+void adios_buffer_pool_release (void)
+{
+    int i;
+
+    pthread_mutex_lock (&adios_buffer_pool_lock);
+    for (i = 0; i < ADIOS_BUFFER_POOL_SLOTS; i++)
+    {
+        adios_buffer_pool_free_slot (i);
+    }
+    pthread_mutex_unlock (&adios_buffer_pool_lock);
+}
@@ -16,6 +16,12 @@ void      adios_buffer_size_max_set (uint64_t v);
 void      adios_buffer_size_remaining_set (uint64_t v);
 void      adios_buffer_alloc_percentage_set (int v);
 void      adios_buffer_alloc_when_set (enum ADIOS_BUFFER_ALLOC_WHEN v);
+void      adios_buffer_zero_copy_threshold_set (uint64_t v);
+uint64_t  adios_buffer_zero_copy_threshold_get (void);
+/* Threads computing the deferred statistics and transforms in adios_close,
+ * 0 = adios_write does them */
+void      adios_buffer_deferred_write_threads_set (int v);
+int       adios_buffer_deferred_write_threads_get (void);
 
 enum ADIOS_BUFFER_ALLOC_WHEN adios_buffer_alloc_when_get (void);
 
@@ -23,4 +29,23 @@ int adios_set_buffer_size (void);
 uint64_t adios_method_buffer_alloc (uint64_t size);
 int adios_method_buffer_free (uint64_t size);
 
+/* Pool of output buffers reused across adios_open/adios_close cycles.
+ * Buffers are page aligned (hugepage aligned and advised with
+ * MADV_HUGEPAGE if hugepages are on) and optionally pre-faulted when they
+ * are first allocated, so the pages of a multi-GB buffer are not faulted in
+ * again at every step. A buffer from the pool can be realloc()'d and
+ * free()'d like any malloc'd memory; handing it back to the pool is
+ * optional. Buffers kept in the pool are charged to the budget of
+ * adios_method_buffer_alloc(), and are freed when a request needs the
+ * room. The pool and the budget can be used from several threads. */
+void      adios_buffer_pool_hugepages_set (int v);
+void      adios_buffer_pool_prefault_set (int v);
+
+/* Return a buffer of at least size bytes, its real size in *capacity */
+void *    adios_buffer_pool_get (uint64_t size, uint64_t * capacity);
+/* Give back a buffer of capacity bytes (NULL is ignored) */
+void      adios_buffer_pool_put (void * buffer, uint64_t capacity);
+/* Free all buffers kept by the pool */
+void      adios_buffer_pool_release (void);
+
 #endif
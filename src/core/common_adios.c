@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <sys/time.h> // gettimeofday
 #include <assert.h>
+#include <pthread.h>
 
 // xml parser
 #include <mxml.h>
@@ -81,6 +82,7 @@ int common_adios_finalize (int mype)
     }
 
     adios_cleanup ();
+    adios_buffer_pool_release ();
 
 #if defined(WITH_NCSU_TIMER) && defined(TIMER_LEVEL) && (TIMER_LEVEL <= 0)
     timer_finalize ();
@@ -165,6 +167,15 @@ int common_adios_open (int64_t * fd, const char * group_name
     fd_p->write_size_bytes = 0;
     fd_p->base_offset = 0;
     fd_p->pg_start_in_file = 0;
+    fd_p->zero_copy_threshold = 0;
+    fd_p->zero_copy = 0;
+    fd_p->zero_copy_count = 0;
+    fd_p->zero_copy_size = 0;
+    fd_p->zero_copy_bytes = 0;
+    fd_p->deferred_threads = 0;
+    fd_p->deferred = 0;
+    fd_p->deferred_count = 0;
+    fd_p->deferred_size = 0;
     if (comm != MPI_COMM_NULL)
         MPI_Comm_dup(comm, &fd_p->comm);
     else
@@ -390,6 +401,36 @@ int common_adios_group_size (int64_t fd_p
     if (pinned_timestep != 0)
         fd->group->time_index = pinned_timestep;
 
+    // large payloads can stay in user memory if every transport writes
+    // the buffer with adios_get_zero_copy_iovec_v1 ()
+    if (fd->shared_buffer == adios_flag_yes)
+    {
+        fd->zero_copy_threshold = adios_buffer_zero_copy_threshold_get ();
+        for (m = fd->group->methods; m && fd->zero_copy_threshold; m = m->next)
+        {
+            if (!adios_method_supports_zero_copy (m->method->m))
+            {
+                fd->zero_copy_threshold = 0;
+            }
+        }
+    }
+
+    // adios_write can leave the statistics and transforms of arrays to
+    // adios_close if every transport only writes the buffer
+    if (   fd->shared_buffer == adios_flag_yes
+        && (fd->mode == adios_mode_write || fd->mode == adios_mode_append)
+       )
+    {
+        fd->deferred_threads = adios_buffer_deferred_write_threads_get ();
+        for (m = fd->group->methods; m && fd->deferred_threads; m = m->next)
+        {
+            if (!adios_method_supports_deferred_write (m->method->m))
+            {
+                fd->deferred_threads = 0;
+            }
+        }
+    }
+
     if (fd->shared_buffer == adios_flag_no)
     {
         adios_method_buffer_free (allocated);
@@ -399,8 +440,9 @@ int common_adios_group_size (int64_t fd_p
     }
     else
     {
-        fd->buffer = malloc (fd->write_size_bytes);
-        fd->buffer_size = fd->write_size_bytes;
+        fd->buffer = adios_buffer_pool_get (fd->write_size_bytes
+                                           ,&fd->buffer_size
+                                           );
         fd->offset = 0;
         fd->bytes_written = 0;
         if (!fd->buffer)
@@ -434,6 +476,76 @@ int common_adios_group_size (int64_t fd_p
     return adios_errno;
 }
 
+// the statistics copied from the last write of the variable are computed
+// again in adios_close
+static void deferred_clear_stats (struct adios_var_struct * v)
+{
+    enum ADIOS_DATATYPES original_var_type = adios_transform_get_var_original_type_var (v);
+    uint8_t count = adios_get_stat_set_count (original_var_type);
+    uint8_t c, i, nstats = 0;
+    uint32_t b;
+
+    if (!v->stats)
+        return;
+
+    for (b = v->bitmap; b; b >>= 1)
+    {
+        nstats += (b & 1);
+    }
+    for (c = 0; c < count; c++)
+    {
+        for (i = 0; i < nstats; i++)
+        {
+            free (v->stats[c][i].data);
+            v->stats[c][i].data = 0;
+        }
+    }
+}
+
+int common_adios_defer_write (struct adios_file_struct * fd, struct adios_var_struct * v, void * var)
+{
+    struct adios_var_struct * w;
+
+    // only arrays, scalars are copied by adios_write anyway. The histogram
+    // breaks are kept by the definition of the variable only.
+    if (   !fd->deferred_threads
+        || !v->dimensions
+        || v->type == adios_string
+        || v->got_buffer == adios_flag_yes
+        || ((v->bitmap >> adios_statistic_hist) & 1)
+       )
+    {
+        return 0;
+    }
+
+    if (fd->deferred_count == fd->deferred_size)
+    {
+        uint32_t n = fd->deferred_size ? 2 * fd->deferred_size : 16;
+        struct adios_var_struct ** d = realloc (fd->deferred, n * sizeof (struct adios_var_struct *));
+        if (!d)
+        {
+            return 0;
+        }
+        fd->deferred = d;
+        fd->deferred_size = n;
+    }
+
+    // the copy has the dimensions as they are now, the dimension variables
+    // can be written again before adios_close
+    v->data = var;
+    v->write_count++;
+    adios_copy_var_written (fd->group, v);
+    v->data = 0;
+
+    w = fd->group->vars_written_tail;
+    deferred_clear_stats (w);
+    w->data = var;
+    w->free_data = adios_flag_no;
+    fd->deferred [fd->deferred_count++] = w;
+
+    return 1;
+}
+
 int common_adios_write_byid (struct adios_file_struct * fd, struct adios_var_struct * v, void * var)
 {
     struct adios_method_list_struct * m = fd->group->methods;
@@ -504,6 +616,11 @@ int common_adios_write_byid (struct adios_file_struct * fd, struct adios_var_str
         }
     }
 
+    if (common_adios_defer_write (fd, v, var))
+    {
+        return adios_errno;
+    }
+
     common_adios_write (fd, v, var);
     // v->data is set to NULL in the above call
 
@@ -618,7 +735,17 @@ int common_adios_write (struct adios_file_struct * fd, struct adios_var_struct *
             adios_write_var_header_v1 (fd, v);
 
             // write payload
-            adios_write_var_payload_v1 (fd, v);
+            if (   fd->zero_copy_threshold
+                && v->dimensions
+                && adios_get_var_size (v, v->data) >= fd->zero_copy_threshold
+               )
+            {
+                adios_write_var_payload_zero_copy_v1 (fd, v);
+            }
+            else
+            {
+                adios_write_var_payload_v1 (fd, v);
+            }
         }
     }
     // Else, do a transform
@@ -964,6 +1091,192 @@ int common_adios_stop_calculation ()
     return adios_errno;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+#define ADIOS_DEFERRED_WRITE_MAX_THREADS 256
+
+/* The deferred arrays of a file, handed out to the threads one variable at a
+ * time. The blocks of a variable are done in order by the same thread, as a
+ * transform can keep state across the blocks of a variable. */
+struct deferred_item
+{
+    uintptr_t var;              // the definition of the variable
+    uint32_t index;             // in fd->deferred
+};
+
+struct deferred_job
+{
+    pthread_mutex_t lock;
+    struct adios_file_struct * fd;
+    struct deferred_item * items; // grouped by variable
+    uint32_t * runs;            // start of each group in items, nruns+1
+    uint32_t nruns;
+    uint32_t next;
+    char * failed;              // for each of fd->deferred
+};
+
+static int compare_deferred_items (const void * a, const void * b)
+{
+    const struct deferred_item * x = (const struct deferred_item *) a;
+    const struct deferred_item * y = (const struct deferred_item *) b;
+
+    if (x->var != y->var)
+        return (x->var < y->var ? -1 : 1);
+    return (x->index < y->index ? -1 : (x->index > y->index));
+}
+
+// statistics, then transform, the data is left in v->data
+static int deferred_prepare (struct adios_file_struct * fd, struct adios_var_struct * v)
+{
+    int wrote_to_shared_buffer = 0;
+
+    adios_generate_var_characteristics_v1 (fd, v);
+    if (v->transform_type == adios_transform_none)
+        return 1;
+
+    return adios_transform_variable_data (fd, v, 0, &wrote_to_shared_buffer);
+}
+
+static void * deferred_worker (void * arg)
+{
+    struct deferred_job * job = (struct deferred_job *) arg;
+    uint32_t r, i;
+
+    for (;;)
+    {
+        pthread_mutex_lock (&job->lock);
+        r = job->next++;
+        pthread_mutex_unlock (&job->lock);
+        if (r >= job->nruns)
+            break;
+
+        for (i = job->runs [r]; i < job->runs [r + 1]; i++)
+        {
+            uint32_t k = job->items [i].index;
+            if (!deferred_prepare (job->fd, job->fd->deferred [k]))
+                job->failed [k] = 1;
+        }
+    }
+    return NULL;
+}
+
+/* Statistics and transforms of the deferred arrays on fd->deferred_threads
+ * threads (the calling one included), then write them to the buffer and to
+ * the transports in the order of the adios_write calls */
+static void common_adios_write_deferred (struct adios_file_struct * fd)
+{
+    struct deferred_job job;
+    pthread_t threads [ADIOS_DEFERRED_WRITE_MAX_THREADS];
+    int nthreads = fd->deferred_threads, nstarted = 0, t;
+    uint32_t k;
+
+    job.fd = fd;
+    job.nruns = 0;
+    job.next = 0;
+    job.items = (struct deferred_item *) malloc (fd->deferred_count * sizeof (struct deferred_item));
+    job.runs = (uint32_t *) malloc ((fd->deferred_count + 1) * sizeof (uint32_t));
+    job.failed = (char *) calloc (fd->deferred_count, 1);
+
+    if (job.items && job.runs && job.failed)
+    {
+        for (k = 0; k < fd->deferred_count; k++)
+        {
+            job.items [k].var = (uintptr_t) fd->deferred [k]->parent_var;
+            job.items [k].index = k;
+        }
+        qsort (job.items, fd->deferred_count, sizeof (struct deferred_item),
+               compare_deferred_items);
+        for (k = 0; k < fd->deferred_count; k++)
+        {
+            if (!k || job.items [k].var != job.items [k - 1].var)
+                job.runs [job.nruns++] = k;
+        }
+        job.runs [job.nruns] = fd->deferred_count;
+
+        if (nthreads > ADIOS_DEFERRED_WRITE_MAX_THREADS)
+            nthreads = ADIOS_DEFERRED_WRITE_MAX_THREADS;
+        if ((uint32_t) nthreads > job.nruns)
+            nthreads = (int) job.nruns;
+
+        pthread_mutex_init (&job.lock, NULL);
+        for (t = 1; t < nthreads; t++)
+        {
+            if (pthread_create (&threads [nstarted], NULL, deferred_worker, &job))
+            {
+                log_warn ("Cannot start a deferred write thread, continuing with %d\n",
+                          nstarted + 1);
+                break;
+            }
+            nstarted++;
+        }
+
+        deferred_worker (&job);
+
+        for (t = 0; t < nstarted; t++)
+        {
+            pthread_join (threads [t], NULL);
+        }
+        pthread_mutex_destroy (&job.lock);
+    }
+    else
+    {
+        free (job.failed);
+        job.failed = 0;
+    }
+
+    for (k = 0; k < fd->deferred_count; k++)
+    {
+        struct adios_var_struct * v = fd->deferred [k];
+        struct adios_method_list_struct * m;
+        int ok;
+
+        if (job.failed)
+            ok = !job.failed [k];
+        else
+            ok = deferred_prepare (fd, v);
+
+        if (ok)
+        {
+            adios_write_var_written_header_v1 (fd, v);
+            if (   v->transform_type == adios_transform_none
+                && fd->zero_copy_threshold
+                && adios_get_var_size (v, v->data) >= fd->zero_copy_threshold
+               )
+            {
+                adios_write_var_payload_zero_copy_v1 (fd, v);
+            }
+            else
+            {
+                adios_write_var_payload_v1 (fd, v);
+            }
+        }
+        else
+        {
+            log_error("Error: unable to apply transform %s to variable %s; likely ran out of memory, check previous error messages\n", adios_transform_plugin_primary_xml_alias(v->transform_type), v->name);
+        }
+
+        for (m = fd->group->methods; m; m = m->next)
+        {
+            if (   m->method->m != ADIOS_METHOD_UNKNOWN
+                && m->method->m != ADIOS_METHOD_NULL
+                && adios_transports [m->method->m].adios_write_fn
+               )
+            {
+                adios_transports [m->method->m].adios_write_fn
+                                       (fd, v, v->data, m->method);
+            }
+        }
+
+        if (v->transform_type != adios_transform_none && v->free_data == adios_flag_yes && v->data)
+            free (v->data);
+        v->data = 0;
+    }
+
+    free (job.items);
+    free (job.runs);
+    free (job.failed);
+    fd->deferred_count = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 int common_adios_close (int64_t fd_p)
 {
@@ -995,6 +1308,11 @@ int common_adios_close (int64_t fd_p)
 
     if (fd->shared_buffer == adios_flag_yes)
     {
+        if (fd->deferred_count)
+        {
+            common_adios_write_deferred (fd);
+        }
+
         adios_write_close_vars_v1 (fd);
 
         /* FIXME: this strategy writes all attributes defined in time step 0
@@ -1036,12 +1354,22 @@ int common_adios_close (int64_t fd_p)
     if (fd->shared_buffer == adios_flag_yes)
     {
         adios_method_buffer_free (fd->write_size_bytes);
-        free (fd->buffer);
+        adios_buffer_pool_put (fd->buffer, fd->buffer_size);
         fd->buffer_size = 0;
         fd->buffer = 0;
         fd->offset = 0;
     }
 
+    free (fd->zero_copy);
+    fd->zero_copy = 0;
+    fd->zero_copy_count = 0;
+    fd->zero_copy_size = 0;
+    fd->zero_copy_bytes = 0;
+
+    free (fd->deferred);
+    fd->deferred = 0;
+    fd->deferred_size = 0;
+
     while (v)
     {
         v->write_offset = 0;
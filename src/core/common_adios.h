@@ -43,6 +43,10 @@ int common_adios_group_size (int64_t fd_p, uint64_t data_size
 //int common_adios_write (int64_t fd_p, const char * name, void * var);
 int common_adios_write (struct adios_file_struct * fd, struct adios_var_struct * v, void * var);
 int common_adios_write_byid (struct adios_file_struct * fd, struct adios_var_struct * v, void * var);
+/* With deferred writes on, record the write of array v from var (and its
+ * copy in vars_written), its statistics and transform are done in
+ * adios_close. Returns 1 if deferred, 0 if the write is to be done now. */
+int common_adios_defer_write (struct adios_file_struct * fd, struct adios_var_struct * v, void * var);
 
 int common_adios_get_write_buffer (int64_t fd_p, const char * name
                            ,uint64_t * size
@@ -3253,6 +3253,46 @@ int common_read_schedule_read (const ADIOS_FILE      * fp,
     return retval;
 }
 
+// Schedule the raw read requests of a transform read request group that have
+// not been posed to the read layer yet: all of them for a new group, or the
+// follow-up requests its transform method appended while processing reads.
+// *nscheduled is increased by the number of requests scheduled.
+static int schedule_transform_subreqs (const ADIOS_FILE *fp, adios_transform_read_request *reqgroup, int *nscheduled)
+{
+    struct common_read_internals_struct * internals = (struct common_read_internals_struct *) fp->internal_data;
+    adios_transform_pg_read_request *pg_reqgroup;
+    adios_transform_raw_read_request *subreq;
+    int retval = 0;
+
+    for (pg_reqgroup = reqgroup->pg_reqgroups; pg_reqgroup; pg_reqgroup = pg_reqgroup->next) {
+        for (subreq = pg_reqgroup->subreqs; subreq; subreq = subreq->next) {
+            if (subreq->scheduled)
+                continue;
+            retval |= internals->read_hooks[internals->method].adios_schedule_read_byid_fn(
+                    fp, subreq->raw_sel, reqgroup->raw_varinfo->varid + internals->group_varid_offset,
+                    pg_reqgroup->timestep, 1, subreq->data);
+            subreq->scheduled = 1;
+            (*nscheduled)++;
+        }
+    }
+    reqgroup->num_followup_subreqs = 0;
+    return retval;
+}
+
+// Schedule the follow-up raw read requests of all transform read request groups
+static int schedule_transform_followups (const ADIOS_FILE *fp, int *nscheduled)
+{
+    struct common_read_internals_struct * internals = (struct common_read_internals_struct *) fp->internal_data;
+    adios_transform_read_request *reqgroup;
+    int retval = 0;
+
+    for (reqgroup = internals->transform_reqgroups; reqgroup; reqgroup = reqgroup->next) {
+        if (reqgroup->num_followup_subreqs > 0)
+            retval |= schedule_transform_subreqs (fp, reqgroup, nscheduled);
+    }
+    return retval;
+}
+
 // NCSU ALACRITY-ADIOS - Modified to delegate to transform method when called
 //   on a transformed variable
 int common_read_schedule_read_byid (const ADIOS_FILE      * fp,
@@ -3289,8 +3329,6 @@ int common_read_schedule_read_byid (const ADIOS_FILE      * fp,
             	// delegate to the transform method to generate subrequests
             	// Else, do the normal thing
             	if (internals->data_view == LOGICAL_DATA_VIEW && transinfo && transinfo->transform_type != adios_transform_none) {
-            		adios_transform_raw_read_request *subreq;
-            		adios_transform_pg_read_request *pg_reqgroup;
             		adios_transform_read_request *new_reqgroup;
 
             		// Generate the read request group and append it to the list
@@ -3300,16 +3338,11 @@ int common_read_schedule_read_byid (const ADIOS_FILE      * fp,
             		// read requests ONLY IF a non-NULL reqgroup was returned (i.e., the user's
             		// selection intersected at least one PG).
             		if (new_reqgroup) {
+            			int nscheduled = 0;
             			adios_transform_read_request_append(&internals->transform_reqgroups, new_reqgroup);
 
             			// Now schedule all of the new subrequests
-            			retval = 0;
-            			for (pg_reqgroup = new_reqgroup->pg_reqgroups; pg_reqgroup; pg_reqgroup = pg_reqgroup->next) {
-            				for (subreq = pg_reqgroup->subreqs; subreq; subreq = subreq->next) {
-            					retval |= internals->read_hooks[internals->method].adios_schedule_read_byid_fn(
-            							fp, subreq->raw_sel, varid+internals->group_varid_offset, pg_reqgroup->timestep, 1, subreq->data);
-            				}
-            			}
+            			retval = schedule_transform_subreqs(fp, new_reqgroup, &nscheduled);
             		}
             	} else {
             		// Old functionality
@@ -3355,7 +3388,27 @@ int common_read_perform_reads (const ADIOS_FILE *fp, int blocking)
         //   request groups completed, and reassemble via the transform method.
         //   Otherwise, do nothing.
         if (blocking) {
-            adios_transform_process_all_reads(&internals->transform_reqgroups);
+            // A transform method may learn what else to read from the data
+            // read so far (e.g., an offset table), read until it has all
+            while (adios_transform_process_all_reads(&internals->transform_reqgroups) && !retval) {
+                int nscheduled = 0;
+                retval = schedule_transform_followups (fp, &nscheduled);
+                // Perform what was scheduled even if scheduling failed part way,
+                // so no raw request is left pointing into a buffer freed below
+                if (nscheduled) {
+                    int rv = internals->read_hooks[internals->method].adios_perform_reads_fn (fp, blocking);
+                    if (!retval)
+                        retval = rv;
+                }
+                if (retval) {
+                    // The request groups waiting for follow-up reads will never
+                    // complete, drop them and their buffers
+                    clean_up_read_reqgroups(&internals->transform_reqgroups);
+                    break;
+                }
+                if (!nscheduled)
+                    break;
+            }
         } else {
             // Do nothing; reads will be performed by check_reads
         }
@@ -3394,6 +3447,13 @@ int common_read_check_reads (const ADIOS_FILE * fp, ADIOS_VARCHUNK ** chunk)
             // If it does contain transformed data, it will be replaced with a
             // new, de-transformed chunk
             adios_transform_process_read_chunk(&internals->transform_reqgroups, chunk);
+
+            // Schedule the follow-up reads the transform method may have
+            // appended, they are returned by the next check_reads calls
+            if (!*chunk) {
+                int nscheduled = 0;
+                schedule_transform_followups (fp, &nscheduled);
+            }
         } while (!*chunk); // Keep reading until we have a chunk to return
     } else {
         adios_error (err_invalid_file_pointer, "Null pointer passed as file to adios_check_reads()\n");
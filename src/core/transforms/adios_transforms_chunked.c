@@ -0,0 +1,371 @@
+/*
+ * adios_transforms_chunked.c
+ *
+ * Sub-chunk (de)compression shared by the compression transforms, see
+ * adios_transforms_chunked.h for the layout of the transformed data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "core/adios_logger.h"
+#include "core/adios_endianness.h"
+#include "core/transforms/adios_transforms_chunked.h"
+#include "core/transforms/adios_transforms_specparse.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+void adios_transform_chunked_parse_spec (const struct adios_transform_spec * spec,
+                                         uint64_t * chunk_size, int * nthreads)
+{
+    int i;
+
+    *chunk_size = 0;
+    *nthreads = 1;
+    if (!spec) {
+        return;
+    }
+
+    for (i = 0; i < spec->param_count; i++) {
+        const struct adios_transform_spec_kv_pair * param = &spec->params[i];
+        if (!param->value) {
+            continue;
+        }
+
+        if (!strcasecmp (param->key, "chunk")) {
+            long long kb = atoll (param->value);
+            if (kb > 0) {
+                *chunk_size = (uint64_t) kb * 1024;
+            } else {
+                log_warn ("Transform %s: invalid chunk size '%s' KB, the data is not chunked\n",
+                          spec->transform_type_str, param->value);
+            }
+        } else if (!strcasecmp (param->key, "threads")) {
+            int n = atoi (param->value);
+            if (n >= 1 && n <= ADIOS_TRANSFORM_CHUNKED_MAX_THREADS) {
+                *nthreads = n;
+            } else {
+                log_warn ("Transform %s: invalid number of threads '%s', using 1\n",
+                          spec->transform_type_str, param->value);
+            }
+        }
+    }
+}
+
+int adios_transform_chunked_read_threads (void)
+{
+    const char * env = getenv ("ADIOS_TRANSFORM_READ_THREADS");
+    long n;
+
+    if (env) {
+        n = atol (env);
+        if (n >= 1 && n <= ADIOS_TRANSFORM_CHUNKED_MAX_THREADS) {
+            return (int) n;
+        }
+        log_warn ("Invalid ADIOS_TRANSFORM_READ_THREADS '%s', using the default\n", env);
+    }
+
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+    if (n < 1) {
+        return 1;
+    }
+    return (n < ADIOS_TRANSFORM_CHUNKED_READ_THREADS ? (int) n : ADIOS_TRANSFORM_CHUNKED_READ_THREADS);
+}
+
+void adios_transform_chunked_swap_table (uint64_t * offsets, uint64_t count)
+{
+    const uint16_t one = 1;
+    uint64_t i;
+
+    if (*(const uint8_t *) &one) {
+        return; // little-endian host, nothing to do
+    }
+    for (i = 0; i < count; i++) {
+        swap_64 (offsets[i]);
+    }
+}
+
+uint64_t adios_transform_chunked_count (uint64_t size, uint64_t chunk_size)
+{
+    return (size + chunk_size - 1) / chunk_size;
+}
+
+uint64_t adios_transform_chunked_table_size (uint64_t size, uint64_t chunk_size)
+{
+    return (adios_transform_chunked_count (size, chunk_size) + 1) * sizeof (uint64_t);
+}
+
+uint64_t adios_transform_chunked_bound (uint64_t size, uint64_t chunk_size)
+{
+    return adios_transform_chunked_table_size (size, chunk_size) + size;
+}
+
+/* The sub-chunks of one call, handed out to the threads one at a time */
+struct chunked_job
+{
+    pthread_mutex_t lock;
+    uint64_t next;
+    uint64_t end;               // one past the last sub-chunk to process
+    uint64_t first;             // sub-chunk at the start of the output (decompress)
+    uint64_t nchunks;
+    int compress;
+    int error;
+
+    const char * input;
+    uint64_t input_len;
+    uint64_t input_base;        // decompress: offset of input in the chunked data
+    char * output;
+    uint64_t output_len;
+    uint64_t data_len;          // length of the uncompressed data
+    uint64_t chunk_size;
+    adios_transform_chunk_fn fn;
+    void * arg;
+
+    uint64_t table_size;
+    const uint64_t * offsets;   // decompress: the table of the input
+    uint64_t * sizes;           // compress: stored length of each sub-chunk
+};
+
+static uint64_t chunk_length (const struct chunked_job * job, uint64_t i)
+{
+    if (i == job->nchunks - 1) {
+        return job->data_len - i * job->chunk_size;
+    }
+    return job->chunk_size;
+}
+
+static int compress_chunk (struct chunked_job * job, uint64_t i)
+{
+    const char * in = job->input + i * job->chunk_size;
+    uint64_t len = chunk_length (job, i);
+    // the slot of a sub-chunk is its size, the output is compacted afterwards
+    char * out = job->output + job->table_size + i * job->chunk_size;
+    uint64_t out_len = len;
+
+    if (job->fn (in, len, out, &out_len, job->arg) || out_len >= len) {
+        memcpy (out, in, len);
+        out_len = len;
+    }
+    job->sizes[i] = out_len;
+    return 0;
+}
+
+static int decompress_chunk (struct chunked_job * job, uint64_t i)
+{
+    const char * in = job->input + (job->offsets[i] - job->input_base);
+    uint64_t in_len = job->offsets[i+1] - job->offsets[i];
+    char * out = job->output + (i - job->first) * job->chunk_size;
+    uint64_t len = chunk_length (job, i);
+    uint64_t out_len = len;
+
+    if (in_len == len) {
+        memcpy (out, in, len);
+        return 0;
+    }
+    if (job->fn (in, in_len, out, &out_len, job->arg) || out_len != len) {
+        log_error ("Cannot decompress sub-chunk %llu (%llu bytes)\n",
+                   (unsigned long long) i, (unsigned long long) in_len);
+        return 1;
+    }
+    return 0;
+}
+
+static void * chunked_worker (void * arg)
+{
+    struct chunked_job * job = (struct chunked_job *) arg;
+    uint64_t i;
+    int err;
+
+    for (;;) {
+        pthread_mutex_lock (&job->lock);
+        i = job->next++;
+        pthread_mutex_unlock (&job->lock);
+        if (i >= job->end) {
+            break;
+        }
+
+        err = (job->compress ? compress_chunk (job, i) : decompress_chunk (job, i));
+        if (err) {
+            pthread_mutex_lock (&job->lock);
+            job->error = 1;
+            pthread_mutex_unlock (&job->lock);
+        }
+    }
+    return NULL;
+}
+
+/* Run the job on nthreads threads, the calling one included */
+static void run_job (struct chunked_job * job, int nthreads)
+{
+    pthread_t threads [ADIOS_TRANSFORM_CHUNKED_MAX_THREADS];
+    int nstarted = 0, t;
+
+    if ((uint64_t) nthreads > job->end - job->next) {
+        nthreads = (int) (job->end - job->next);
+    }
+
+    pthread_mutex_init (&job->lock, NULL);
+    for (t = 1; t < nthreads; t++) {
+        if (pthread_create (&threads[nstarted], NULL, chunked_worker, job)) {
+            log_warn ("Cannot start a transform thread, continuing with %d\n", nstarted + 1);
+            break;
+        }
+        nstarted++;
+    }
+
+    chunked_worker (job);
+
+    for (t = 0; t < nstarted; t++) {
+        pthread_join (threads[t], NULL);
+    }
+    pthread_mutex_destroy (&job->lock);
+}
+
+int adios_transform_chunked_compress (const void * input, uint64_t input_len,
+                                      uint64_t chunk_size, int nthreads,
+                                      adios_transform_chunk_fn compress, void * arg,
+                                      void * output, uint64_t * output_len)
+{
+    struct chunked_job job;
+    uint64_t * offsets;
+    uint64_t i, pos;
+
+    memset (&job, 0, sizeof (job));
+    job.compress = 1;
+    job.input = (const char *) input;
+    job.input_len = input_len;
+    job.output = (char *) output;
+    job.data_len = input_len;
+    job.chunk_size = chunk_size;
+    job.fn = compress;
+    job.arg = arg;
+    job.nchunks = adios_transform_chunked_count (input_len, chunk_size);
+    job.end = job.nchunks;
+    job.table_size = adios_transform_chunked_table_size (input_len, chunk_size);
+    job.sizes = (uint64_t *) malloc (job.nchunks * sizeof (uint64_t));
+    offsets = (uint64_t *) malloc ((job.nchunks + 1) * sizeof (uint64_t));
+    if (!job.sizes || !offsets) {
+        free (job.sizes);
+        free (offsets);
+        return 1;
+    }
+
+    run_job (&job, nthreads);
+
+    // move the sub-chunks from their slots next to each other
+    pos = job.table_size;
+    for (i = 0; i < job.nchunks; i++) {
+        char * slot = job.output + job.table_size + i * chunk_size;
+        if (slot != job.output + pos) {
+            memmove (job.output + pos, slot, job.sizes[i]);
+        }
+        offsets[i] = pos;
+        pos += job.sizes[i];
+    }
+    offsets[job.nchunks] = pos;
+    adios_transform_chunked_swap_table (offsets, job.nchunks + 1);
+    memcpy (job.output, offsets, job.table_size);
+
+    log_debug ("Compressed %llu bytes in %llu sub-chunks to %llu bytes\n",
+               (unsigned long long) input_len, (unsigned long long) job.nchunks,
+               (unsigned long long) pos);
+
+    *output_len = pos;
+    free (offsets);
+    free (job.sizes);
+    return 0;
+}
+
+int adios_transform_chunked_decompress (const void * input, uint64_t input_len,
+                                        uint64_t chunk_size, int nthreads,
+                                        adios_transform_chunk_fn decompress, void * arg,
+                                        void * output, uint64_t output_len)
+{
+    uint64_t nchunks = adios_transform_chunked_count (output_len, chunk_size);
+    uint64_t table_size = adios_transform_chunked_table_size (output_len, chunk_size);
+    uint64_t * offsets;
+    int rc;
+
+    if (input_len < table_size) {
+        log_error ("Chunked data of %llu bytes is shorter than its offset table\n",
+                   (unsigned long long) input_len);
+        return 1;
+    }
+
+    // copy, the table is not aligned in the read buffer
+    offsets = (uint64_t *) malloc (table_size);
+    if (!offsets) {
+        return 1;
+    }
+    memcpy (offsets, input, table_size);
+    adios_transform_chunked_swap_table (offsets, nchunks + 1);
+
+    rc = adios_transform_chunked_check_table (offsets, output_len, input_len, chunk_size, 0, nchunks - 1);
+    if (!rc) {
+        rc = adios_transform_chunked_decompress_range (offsets, (const char *) input + offsets[0],
+                                                       output_len, chunk_size, 0, nchunks - 1, nthreads,
+                                                       decompress, arg, output);
+    }
+    free (offsets);
+    return rc;
+}
+
+int adios_transform_chunked_check_table (const uint64_t * offsets,
+                                         uint64_t data_len, uint64_t total_len, uint64_t chunk_size,
+                                         uint64_t first, uint64_t last)
+{
+    uint64_t nchunks = adios_transform_chunked_count (data_len, chunk_size);
+    uint64_t table_size = adios_transform_chunked_table_size (data_len, chunk_size);
+    uint64_t i;
+
+    if (first > last || last >= nchunks) {
+        log_error ("Sub-chunks %llu..%llu out of the %llu of chunked data\n",
+                   (unsigned long long) first, (unsigned long long) last,
+                   (unsigned long long) nchunks);
+        return 1;
+    }
+    for (i = first; i <= last; i++) {
+        if (offsets[i] < table_size || offsets[i] > offsets[i+1] || offsets[i+1] > total_len) {
+            log_error ("Corrupted offset table of chunked data at sub-chunk %llu\n",
+                       (unsigned long long) i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int adios_transform_chunked_decompress_range (const uint64_t * offsets, const void * input,
+                                              uint64_t data_len, uint64_t chunk_size,
+                                              uint64_t first, uint64_t last, int nthreads,
+                                              adios_transform_chunk_fn decompress, void * arg,
+                                              void * output)
+{
+    struct chunked_job job;
+
+    memset (&job, 0, sizeof (job));
+    job.compress = 0;
+    job.input = (const char *) input;
+    job.input_len = offsets[last+1] - offsets[first];
+    job.input_base = offsets[first];
+    job.output = (char *) output;
+    job.data_len = data_len;
+    job.chunk_size = chunk_size;
+    job.fn = decompress;
+    job.arg = arg;
+    job.nchunks = adios_transform_chunked_count (data_len, chunk_size);
+    job.table_size = adios_transform_chunked_table_size (data_len, chunk_size);
+    job.offsets = offsets;
+    job.first = first;
+    job.next = first;
+    job.end = last + 1;
+
+    run_job (&job, nthreads);
+    return job.error;
+}
@@ -0,0 +1,103 @@
+/*
+ * adios_transforms_chunked.h
+ *
+ * Chunked mode of the compression transforms.
+ *
+ * A large block is split into sub-chunks of a fixed size, which are
+ * compressed independently, on several threads if asked for. The
+ * transformed data starts with a table of nchunks+1 offsets (little-endian
+ * uint64_t, relative to the start of the transformed data) followed by the compressed
+ * sub-chunks in order, so sub-chunk i is [offsets[i], offsets[i+1]).
+ * A sub-chunk that does not get smaller is stored as is. Its stored length
+ * then equals its original length, which tells the reader to copy it.
+ *
+ * Transform spec parameters: chunk=<KB> turns the mode on (e.g.
+ * transform="zlib:5,chunk=4096,threads=16"), threads=<n> sets the number
+ * of threads compressing the sub-chunks of a block (default 1).
+ * Readers decompress the sub-chunks of a block on
+ * adios_transform_chunked_read_threads() threads.
+ */
+
+#ifndef ADIOS_TRANSFORMS_CHUNKED_H_
+#define ADIOS_TRANSFORMS_CHUNKED_H_
+
+#include <stdint.h>
+
+#define ADIOS_TRANSFORM_CHUNKED_MAX_THREADS 256
+
+/* default limit of the decompression threads of a reader */
+#define ADIOS_TRANSFORM_CHUNKED_READ_THREADS 8
+
+struct adios_transform_spec;
+
+/*
+ * (De)compress input_len bytes of input into output. *output_len is the
+ * space available on entry and the bytes written on return.
+ * Returns 0 on success.
+ */
+typedef int (* adios_transform_chunk_fn) (const void * input, uint64_t input_len,
+                                          void * output, uint64_t * output_len,
+                                          void * arg);
+
+/* chunk and threads parameters of a spec, chunk_size is 0 if not chunked */
+void adios_transform_chunked_parse_spec (const struct adios_transform_spec * spec,
+                                         uint64_t * chunk_size, int * nthreads);
+
+/*
+ * Threads decompressing the sub-chunks of a block: ADIOS_TRANSFORM_READ_THREADS
+ * from the environment, or else the online processors, at most
+ * ADIOS_TRANSFORM_CHUNKED_READ_THREADS.
+ */
+int adios_transform_chunked_read_threads (void);
+
+/* Convert count table offsets between little-endian and host order */
+void adios_transform_chunked_swap_table (uint64_t * offsets, uint64_t count);
+
+uint64_t adios_transform_chunked_count (uint64_t size, uint64_t chunk_size);
+
+/* Size of the offset table of size bytes of data */
+uint64_t adios_transform_chunked_table_size (uint64_t size, uint64_t chunk_size);
+
+/* Largest transformed size of size bytes of data: the data and its table */
+uint64_t adios_transform_chunked_bound (uint64_t size, uint64_t chunk_size);
+
+/*
+ * Compress input into output, which has adios_transform_chunked_bound()
+ * bytes. Returns 0 and the transformed length in *output_len.
+ */
+int adios_transform_chunked_compress (const void * input, uint64_t input_len,
+                                      uint64_t chunk_size, int nthreads,
+                                      adios_transform_chunk_fn compress, void * arg,
+                                      void * output, uint64_t * output_len);
+
+/*
+ * Decompress the transformed input into output_len bytes of output.
+ * Returns 0 on success.
+ */
+int adios_transform_chunked_decompress (const void * input, uint64_t input_len,
+                                        uint64_t chunk_size, int nthreads,
+                                        adios_transform_chunk_fn decompress, void * arg,
+                                        void * output, uint64_t output_len);
+
+/*
+ * Check sub-chunks first..last of the offset table (in host order) of chunked data of
+ * data_len bytes (data_len before the transform, total_len after it).
+ * Returns 0 if they lie in order inside the data, after the table.
+ */
+int adios_transform_chunked_check_table (const uint64_t * offsets,
+                                         uint64_t data_len, uint64_t total_len, uint64_t chunk_size,
+                                         uint64_t first, uint64_t last);
+
+/*
+ * Decompress sub-chunks first..last of chunked data of data_len bytes into
+ * output, which starts with the data of sub-chunk first. offsets is the
+ * (checked) offset table of the data and input holds its bytes
+ * [offsets[first], offsets[last+1]) only. Returns 0 on success.
+ */
+int adios_transform_chunked_decompress_range (const uint64_t * offsets, const void * input,
+                                              uint64_t data_len, uint64_t chunk_size,
+                                              uint64_t first, uint64_t last, int nthreads,
+                                              adios_transform_chunk_fn decompress, void * arg,
+                                              void * output);
+
+#endif /* ADIOS_TRANSFORMS_CHUNKED_H_ */
@@ -0,0 +1,217 @@
+/*
+ * adios_transforms_chunked_read.c
+ *
+ * Partial reads of chunked PGs: the selection is mapped to the range of
+ * elements it spans in the PG (as in sieving, see
+ * compute_sieving_offsets_for_pg_selection()), then to the sub-chunks
+ * holding that range.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "core/adios_logger.h"
+#include "public/adios_error.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+#include "core/adios_subvolume.h"
+#include "core/transforms/adios_transforms_chunked_read.h"
+#include "transforms/adios_transform_identity_read.h"
+
+// Kept in the transform_internal of the PG read request
+typedef struct {
+    uint64_t start_elem;    // element range of the selection in the PG
+    uint64_t end_elem;
+    uint64_t first_chunk;   // sub-chunks holding that range
+    uint64_t last_chunk;
+    uint64_t data_offset;   // start of the chunked data in the PG
+    int whole;              // all sub-chunks are needed, read with the table
+    int failed;             // the PG cannot be read, no data is returned for it
+    adios_transform_raw_read_request *table_subreq; // the offset table, or all of the chunked data
+    adios_transform_raw_read_request *data_subreq;  // the needed sub-chunks, once the table is read
+} chunked_read_range;
+
+static uint64_t pg_data_size(const adios_transform_read_request *reqgroup,
+                             const adios_transform_pg_read_request *pg_reqgroup)
+{
+    uint64_t size = adios_get_type_size(reqgroup->transinfo->orig_type, NULL);
+    int d;
+    for (d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+        size *= pg_reqgroup->orig_varblock->count[d];
+    return size;
+}
+
+int adios_transform_chunked_generate_read_subrequests(
+        adios_transform_read_request *reqgroup,
+        adios_transform_pg_read_request *pg_reqgroup,
+        uint64_t data_offset, uint64_t chunk_size)
+{
+    const int datum_size = adios_get_type_size(reqgroup->transinfo->orig_type, NULL);
+    const uint64_t data_len = pg_data_size(reqgroup, pg_reqgroup);
+    const uint64_t nchunks = adios_transform_chunked_count(data_len, chunk_size);
+    uint64_t read_len;
+    void *buf;
+
+    chunked_read_range *range = (chunked_read_range *)calloc(1, sizeof(chunked_read_range));
+    if (!range) {
+        adios_error(err_no_memory, "Cannot allocate the read state of a chunked PG\n");
+        return -1;
+    }
+
+    compute_sieving_offsets_for_pg_selection(pg_reqgroup->pg_intersection_sel,
+                                             &pg_reqgroup->pg_bounds_sel->u.bb,
+                                             &range->start_elem, &range->end_elem);
+
+    range->first_chunk = range->start_elem * datum_size / chunk_size;
+    range->last_chunk = (range->end_elem * datum_size - 1) / chunk_size;
+    range->data_offset = data_offset;
+
+    // Read the offset table first, then only the sub-chunks it points to.
+    // If all of them are needed, read the table with them in one go.
+    range->whole = (range->first_chunk == 0 && range->last_chunk == nchunks - 1);
+    if (range->whole)
+        read_len = pg_reqgroup->raw_var_length - data_offset;
+    else
+        read_len = adios_transform_chunked_table_size(data_len, chunk_size);
+
+    buf = malloc(read_len);
+    if (!buf) {
+        adios_error(err_no_memory, "Cannot allocate %llu bytes to read a chunked PG\n",
+                    (unsigned long long)read_len);
+        free(range);
+        return -1;
+    }
+
+    range->table_subreq = adios_transform_raw_read_request_new_byte_segment(pg_reqgroup, data_offset, read_len, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, range->table_subreq);
+    pg_reqgroup->transform_internal = range;
+    return 0;
+}
+
+/*
+ * The offset table has been read: check it and append the read of exactly
+ * the bytes of the needed sub-chunks. Returns 0 on success.
+ */
+static int read_chunks_from_table(adios_transform_read_request *reqgroup,
+                                  adios_transform_pg_read_request *pg_reqgroup,
+                                  chunked_read_range *range,
+                                  uint64_t data_len, uint64_t chunk_size)
+{
+    uint64_t *offsets = (uint64_t *)range->table_subreq->data;
+    const uint64_t total_len = pg_reqgroup->raw_var_length - range->data_offset;
+    uint64_t start, len;
+    void *buf;
+
+    // the read buffer holds just the table, convert it in place
+    adios_transform_chunked_swap_table(offsets, adios_transform_chunked_count(data_len, chunk_size) + 1);
+    if (adios_transform_chunked_check_table(offsets, data_len, total_len, chunk_size,
+                                            range->first_chunk, range->last_chunk))
+        return 1;
+
+    start = offsets[range->first_chunk];
+    len = offsets[range->last_chunk + 1] - start;
+    buf = malloc(len > 0 ? len : 1);
+    if (!buf) {
+        adios_error(err_no_memory, "Cannot allocate %llu bytes to read the sub-chunks of a chunked PG\n",
+                    (unsigned long long)len);
+        return 1;
+    }
+
+    range->data_subreq = adios_transform_raw_read_request_new_byte_segment(pg_reqgroup, range->data_offset + start, len, buf);
+    adios_transform_raw_read_request_append_followup(reqgroup, pg_reqgroup, range->data_subreq);
+    return 0;
+}
+
+adios_datablock * adios_transform_chunked_pg_reqgroup_completed(
+        adios_transform_read_request *reqgroup,
+        adios_transform_pg_read_request *completed_pg_reqgroup,
+        uint64_t chunk_size,
+        adios_transform_chunk_fn decompress, void *arg)
+{
+    chunked_read_range *range = (chunked_read_range *)completed_pg_reqgroup->transform_internal;
+    const int datum_size = adios_get_type_size(reqgroup->transinfo->orig_type, NULL);
+    const uint64_t data_len = pg_data_size(reqgroup, completed_pg_reqgroup);
+    const uint64_t table_size = adios_transform_chunked_table_size(data_len, chunk_size);
+    const uint64_t first_byte = range->first_chunk * chunk_size;
+    const uint64_t *offsets;
+    const char *input;
+    uint64_t *table_copy = NULL;
+    uint64_t end_byte = (range->last_chunk + 1) * chunk_size;
+    if (end_byte > data_len)
+        end_byte = data_len;
+
+    if (range->failed)
+        return NULL;
+
+    if (!range->whole && !range->data_subreq) {
+        // Only the table was read so far
+        if (read_chunks_from_table(reqgroup, completed_pg_reqgroup, range, data_len, chunk_size)) {
+            // no follow-up read was appended, the PG stays completed without data
+            range->failed = 1;
+            adios_error(err_corrupted_variable,
+                        "Cannot read the sub-chunks of block %d of a chunked variable\n",
+                        completed_pg_reqgroup->blockidx);
+        }
+        return NULL;
+    }
+
+    if (range->whole) {
+        // All of the chunked data was read, table included. Copy the
+        // table, it is not aligned in the read buffer.
+        const uint64_t total_len = completed_pg_reqgroup->raw_var_length - range->data_offset;
+        if (total_len < table_size) {
+            log_error("Chunked data of %llu bytes is shorter than its offset table\n",
+                      (unsigned long long)total_len);
+            return NULL;
+        }
+        table_copy = (uint64_t *)malloc(table_size);
+        if (!table_copy)
+            return NULL;
+        memcpy(table_copy, range->table_subreq->data, table_size);
+        adios_transform_chunked_swap_table(table_copy, table_size / sizeof(uint64_t));
+        if (adios_transform_chunked_check_table(table_copy, data_len, total_len, chunk_size,
+                                                range->first_chunk, range->last_chunk))
+        {
+            free(table_copy);
+            return NULL;
+        }
+        offsets = table_copy;
+        input = (const char *)range->table_subreq->data + offsets[0];
+    } else {
+        offsets = (const uint64_t *)range->table_subreq->data;
+        input = (const char *)range->data_subreq->data;
+    }
+
+    void *data = malloc(end_byte - first_byte);
+    if (!data) {
+        free(table_copy);
+        return NULL;
+    }
+
+    if (adios_transform_chunked_decompress_range(offsets, input, data_len, chunk_size,
+                                                 range->first_chunk, range->last_chunk,
+                                                 adios_transform_chunked_read_threads(),
+                                                 decompress, arg, data))
+    {
+        free(table_copy);
+        free(data);
+        return NULL;
+    }
+    free(table_copy);
+
+    log_debug("Decompressed sub-chunks %llu..%llu of a PG for elements %llu..%llu\n",
+              (unsigned long long)range->first_chunk, (unsigned long long)range->last_chunk,
+              (unsigned long long)range->start_elem, (unsigned long long)range->end_elem);
+
+    // Sub-chunks are not aligned to elements: move the first selected
+    // element to the start of the buffer
+    const uint64_t skip = range->start_elem * datum_size - first_byte;
+    if (skip)
+        memmove(data, (char *)data + skip, (range->end_elem - range->start_elem) * datum_size);
+
+    return adios_datablock_new_ragged_offset(reqgroup->transinfo->orig_type,
+                                             completed_pg_reqgroup->timestep,
+                                             completed_pg_reqgroup->pg_writeblock_sel,
+                                             range->start_elem,
+                                             data);
+}
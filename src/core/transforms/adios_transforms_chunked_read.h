@@ -0,0 +1,42 @@
+/*
+ * adios_transforms_chunked_read.h
+ *
+ * Read side of the chunked mode of the compression transforms (see
+ * adios_transforms_chunked.h). Only the sub-chunks that intersect the read
+ * selection are fetched and decompressed, after reading the offset table.
+ */
+
+#ifndef ADIOS_TRANSFORMS_CHUNKED_READ_H_
+#define ADIOS_TRANSFORMS_CHUNKED_READ_H_
+
+#include <stdint.h>
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/transforms/adios_transforms_datablock.h"
+#include "core/transforms/adios_transforms_chunked.h"
+
+/*
+ * Schedules the raw read of the offset table of a chunked PG. Once it has
+ * been read, adios_transform_chunked_pg_reqgroup_completed() appends the
+ * read of exactly the sub-chunks intersecting pg_reqgroup->pg_intersection_sel
+ * (if the selection needs all of them, they are read with the table in one
+ * request). The chunked data starts data_offset bytes into the PG. Uses the
+ * transform_internal of the PG read request. Returns 0, or -1 on error.
+ */
+int adios_transform_chunked_generate_read_subrequests(
+        adios_transform_read_request *reqgroup,
+        adios_transform_pg_read_request *pg_reqgroup,
+        uint64_t data_offset, uint64_t chunk_size);
+
+/*
+ * To be called from the pg_reqgroup_completed callback. Returns NULL after
+ * the offset table was read (the PG is then incomplete again, waiting for
+ * its sub-chunks), and after that the sub-chunks decompressed as a ragged
+ * datablock over the PG, or NULL on error.
+ */
+adios_datablock * adios_transform_chunked_pg_reqgroup_completed(
+        adios_transform_read_request *reqgroup,
+        adios_transform_pg_read_request *completed_pg_reqgroup,
+        uint64_t chunk_size,
+        adios_transform_chunk_fn decompress, void *arg);
+
+#endif /* ADIOS_TRANSFORMS_CHUNKED_READ_H_ */
@@ -60,6 +60,9 @@ typedef struct {
             adios_transform_read_request *completed_reqgroup);
 } adios_transform_read_method;
 
+// The registry, indexed by transform type (for transforms delegating to others)
+extern adios_transform_read_method TRANSFORM_READ_METHODS[];
+
 //
 // Every transform plugin has a set of functions that must go through three stages:
 // * Declaration: as with a C header
@@ -50,6 +50,14 @@ void adios_transform_init() {
     adios_transforms_initialized = 1;
 }
 
+void adios_transform_finalize() {
+    int i;
+    for (i = 0; i < num_adios_transform_types; i++) {
+        if (TRANSFORM_WRITE_METHODS[i].transform_finalize)
+            TRANSFORM_WRITE_METHODS[i].transform_finalize();
+    }
+}
+
 // Delegate functions
 
 uint16_t adios_transform_get_metadata_size(struct adios_transform_spec *transform_spec) {
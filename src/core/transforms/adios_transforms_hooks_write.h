@@ -17,6 +17,9 @@
 // Initialize the transform system for adios read/write libraries
 void adios_transform_init();
 
+// Release what the transform methods keep across writes (at adios_finalize)
+void adios_transform_finalize();
+
 // Delegation functions
 uint16_t adios_transform_get_metadata_size(struct adios_transform_spec *transform_spec);
 void adios_transform_transformed_size_growth(
@@ -70,8 +73,16 @@ typedef struct {
     int (*transform_apply)(
             struct adios_file_struct *fd, struct adios_var_struct *var,
             uint64_t *transformed_len, int use_shared_buffer, int *wrote_to_shared_buffer);
+
+    // Expected behavior: frees any state this data transform keeps from one transform_apply call to the
+    // next (e.g., per-variable dictionaries reused across steps). Called once, at adios_finalize. Transforms
+    // keeping no such state can define it with DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE.
+    void (*transform_finalize)();
 } adios_transform_write_method;
 
+// The registry, indexed by transform type (for transforms delegating to others)
+extern adios_transform_write_method TRANSFORM_WRITE_METHODS[];
+
 //
 // Every transform plugin has a set of functions that must go through three stages:
 // * Declaration: as with a C header
@@ -91,13 +102,15 @@ typedef struct {
     														 uint64_t *capped_linear_cap); \
     int adios_transform_##tmethod##_apply(struct adios_file_struct *fd, struct adios_var_struct *var, \
                                           uint64_t *transformed_len,                                     \
-                                          int use_shared_buffer, int *wrote_to_shared_buffer);
+                                          int use_shared_buffer, int *wrote_to_shared_buffer); \
+    void adios_transform_##tmethod##_finalize();
 
 // Transform method function registration
 #define TRANSFORM_WRITE_METHOD_HOOK_LIST(tmethod) \
     adios_transform_##tmethod##_get_metadata_size, \
     adios_transform_##tmethod##_transformed_size_growth, \
-    adios_transform_##tmethod##_apply
+    adios_transform_##tmethod##_apply, \
+    adios_transform_##tmethod##_finalize
 
 #define REGISTER_TRANSFORM_WRITE_METHOD_HOOKS(ttable, tmethod, method_type) \
     ttable[method_type] = (adios_transform_write_method){ TRANSFORM_WRITE_METHOD_HOOK_LIST(tmethod) };
@@ -127,6 +140,12 @@ typedef struct {
                                               int use_shared_buffer, int *wrote_to_shared_buffer) {  \
             UNIMPL_TRANSFORM_WRITE_FN(tmethod, __FUNCTION__);                                \
             return 0;                                                                        \
-        }
+        }                                                                                    \
+        DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(tmethod)
+
+// Definition of the finalize function of a transform method that keeps no
+// state across writes
+#define DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(tmethod)                                  \
+        void adios_transform_##tmethod##_finalize() {}
 
 #endif /* ADIOS_TRANSFORMS_HOOKS_WRITE_H_ */
@@ -228,7 +228,12 @@ static int generate_read_request_for_pg(
                                                               transinfo->transform_metadatas[blockidx].content,
                                                               (uint16_t)transinfo->transform_metadatas[blockidx].length);
 
-        adios_transform_generate_read_subrequests(readreq, new_pg_readreq);
+        // A PG the transform method could not make any request for (the
+        // error is reported) would never complete, leave it out
+        if (adios_transform_generate_read_subrequests(readreq, new_pg_readreq) && !new_pg_readreq->num_subreqs) {
+            adios_transform_pg_read_request_free(&new_pg_readreq);
+            return 0;
+        }
         adios_transform_pg_read_request_append(readreq, new_pg_readreq);
 
         // Don't free pg_bounds_sel or pg_intersection_sel, since they are now
@@ -728,6 +733,9 @@ static ADIOS_VARCHUNK * apply_datablock_to_chunk_and_free(adios_datablock *datab
 
     ADIOS_SELECTION *chunk_sel = NULL;
     void *chunk_data = NULL;
+    // Kept aside, the datablock is freed below
+    const enum ADIOS_DATATYPES elem_type = datablock->elem_type;
+    const int timestep = datablock->timestep;
     uint64_t used_count =
     	apply_datablock_to_buffer_and_free(
 			reqgroup->raw_varinfo, reqgroup->transinfo,
@@ -743,9 +751,9 @@ static ADIOS_VARCHUNK * apply_datablock_to_chunk_and_free(adios_datablock *datab
         *chunk = (ADIOS_VARCHUNK) {
         	.varid = reqgroup->raw_varinfo->varid,
         	.data = chunk_data,
-        	.type = datablock->elem_type,
+        	.type = elem_type,
         	.sel = chunk_sel,
-        	.from_steps = datablock->timestep,
+        	.from_steps = timestep,
         	.nsteps = 1,
         };
 
@@ -866,17 +874,19 @@ void adios_transform_process_read_chunk(adios_transform_read_request **reqgroups
 }
 
 /*
- * Process all read reqgroups, assuming they have been fully completed,
- * producing all required results based on the raw data read.
+ * Process all read reqgroups, assuming all of their scheduled raw reads have
+ * been completed, producing all required results based on the raw data read.
  * (This function is called after a blocking perform_reads completes)
  */
-void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head) {
+int adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head) {
     // Mark all subrequests, PG request groups and read request groups
     // as completed, calling callbacks as needed
     adios_transform_read_request *reqgroup;
     adios_transform_pg_read_request *pg_reqgroup;
     adios_transform_raw_read_request *subreq;
     adios_datablock *result;
+    adios_transform_read_request *pending = NULL; // waiting for follow-up reads
+    int npending = 0;
 
     // Complete each read reqgroup in turn
     while ((reqgroup = adios_transform_read_request_pop(reqgroups_head)) != NULL) {
@@ -893,8 +903,8 @@ void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_
 
             // Complete every child subreq
             for (subreq = pg_reqgroup->subreqs; subreq; subreq = subreq->next) {
-                // Skip completed subreqs
-                if (subreq->completed) continue;
+                // Skip completed subreqs, and follow-ups that have not been read yet
+                if (subreq->completed || !subreq->scheduled) continue;
 
                 // Mark the subreq as completed
                 adios_transform_raw_read_request_mark_complete(reqgroup, pg_reqgroup, subreq);
@@ -904,13 +914,21 @@ void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_
                 result = adios_transform_subrequest_completed(reqgroup, pg_reqgroup, subreq);
                 if (result) apply_datablock_to_result_and_free(result, reqgroup);
             }
-            assert(pg_reqgroup->completed);
 
             // Make the required call to the transform method to apply the results
-            result = adios_transform_pg_reqgroup_completed(reqgroup, pg_reqgroup);
-            if (result) apply_datablock_to_result_and_free(result, reqgroup);
+            if (pg_reqgroup->completed) {
+                result = adios_transform_pg_reqgroup_completed(reqgroup, pg_reqgroup);
+                if (result) apply_datablock_to_result_and_free(result, reqgroup);
+            }
+        }
+
+        // Keep the reqgroup until its follow-up reads are done
+        if (!reqgroup->completed) {
+            assert(reqgroup->num_followup_subreqs > 0);
+            adios_transform_read_request_append(&pending, reqgroup);
+            npending++;
+            continue;
         }
-        assert(reqgroup->completed);
 
         // Make the required call to the transform method to apply the results
         result = adios_transform_read_reqgroup_completed(reqgroup);
@@ -919,4 +937,7 @@ void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_
         // Now that the read reqgroup has been processed, free it (which also frees all children)
         adios_transform_read_request_free(&reqgroup);
     }
+
+    *reqgroups_head = pending;
+    return npending;
 }
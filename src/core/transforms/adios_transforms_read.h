@@ -72,8 +72,10 @@ void adios_transform_process_read_chunk(adios_transform_read_request **reqgroups
 
 /*
  * Processes all data after a blocking read that has serviced all read requests,
- * completing all transform read requests.
+ * completing all transform read requests. Returns the number of read request
+ * groups left on the list because their transform method appended follow-up
+ * raw read requests, which must be scheduled and read before calling this again.
  */
-void adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head);
+int adios_transform_process_all_reads(adios_transform_read_request **reqgroups_head);
 
 #endif /* ADIOS_TRANSFORMS_READ_H_ */
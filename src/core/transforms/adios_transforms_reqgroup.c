@@ -144,6 +144,7 @@ adios_transform_raw_read_request * adios_transform_raw_read_request_new(ADIOS_SE
     new_subreq->raw_sel = sel;
     new_subreq->data = data;
     new_subreq->completed = 0;
+    new_subreq->scheduled = 0;
     new_subreq->transform_internal = 0;
     new_subreq->next = 0;
     return new_subreq;
@@ -293,6 +294,20 @@ void adios_transform_raw_read_request_append(adios_transform_pg_read_request *pg
     pg_reqgroup->num_subreqs++;
 }
 
+void adios_transform_raw_read_request_append_followup(adios_transform_read_request *reqgroup,
+                                                      adios_transform_pg_read_request *pg_reqgroup,
+                                                      adios_transform_raw_read_request *subreq) {
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    reqgroup->num_followup_subreqs++;
+
+    // Reopen the PG and the read request group if they were just completed
+    if (pg_reqgroup->completed) {
+        pg_reqgroup->completed = 0;
+        reqgroup->num_completed_pg_reqgroups--;
+    }
+    reqgroup->completed = 0;
+}
+
 int adios_transform_raw_read_request_remove(adios_transform_pg_read_request *pg_reqgroup, adios_transform_raw_read_request *subreq) {
     adios_transform_raw_read_request *removed;
     LIST_REMOVE(pg_reqgroup->subreqs, subreq, adios_transform_raw_read_request, removed);
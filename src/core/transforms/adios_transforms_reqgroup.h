@@ -24,6 +24,7 @@
 
 typedef struct _adios_transform_raw_read_request {
     int             completed; // Whether this request has been completed
+    int             scheduled; // Whether this request has been posed to the read layer
 
     ADIOS_SELECTION *raw_sel; // The raw selection to pose to the read layer
     void            *data;
@@ -94,6 +95,10 @@ typedef struct _adios_transform_read_request {
     int num_completed_pg_reqgroups;
     adios_transform_pg_read_request *pg_reqgroups;
 
+    // Raw read requests appended after the others were scheduled, see
+    // adios_transform_raw_read_request_append_followup()
+    int num_followup_subreqs;
+
     void *transform_internal; // Transform plugin private
 
     // Linked list
@@ -113,6 +118,17 @@ void adios_transform_raw_read_request_mark_complete(adios_transform_read_request
                                                     adios_transform_raw_read_request *subreq);
 
 void adios_transform_raw_read_request_append(adios_transform_pg_read_request *pg_reqgroup, adios_transform_raw_read_request *subreq);
+
+/*
+ * Appends a raw read request from a subrequest_completed or
+ * pg_reqgroup_completed callback, for a transform method that learns what
+ * else to read from the data read so far. The PG read request (and its read
+ * request group) become incomplete again until the new request is served;
+ * the read layer schedules it once the current reads are processed.
+ */
+void adios_transform_raw_read_request_append_followup(adios_transform_read_request *reqgroup,
+                                                      adios_transform_pg_read_request *pg_reqgroup,
+                                                      adios_transform_raw_read_request *subreq);
 int adios_transform_raw_read_request_remove(adios_transform_pg_read_request *pg_reqgroup, adios_transform_raw_read_request *subreq);
 adios_transform_raw_read_request * adios_transform_raw_read_request_pop(adios_transform_pg_read_request *pg_reqgroup);
 
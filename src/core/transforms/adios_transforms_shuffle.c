@@ -0,0 +1,322 @@
+/*
+ * adios_transforms_shuffle.c
+ *
+ * Byte and bit shuffle stage of the compression transforms, see
+ * adios_transforms_shuffle.h for the layout of the shuffled data.
+ *
+ * On x86-64 the byte shuffle of 2, 4, 8 and 16 byte elements transposes
+ * blocks of 16 elements in SSE2 registers, and the bit shuffle takes the
+ * bit planes of 16 bytes at a time with movemask. SSE2 is part of x86-64,
+ * so no runtime check is needed. Elsewhere, plain C does the same.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_shuffle.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHUFFLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+enum ADIOS_TRANSFORM_SHUFFLE adios_transform_shuffle_find_by_name (const char * name)
+{
+    if (!strcasecmp (name, "shuffle")) {
+        return adios_transform_shuffle_byte;
+    }
+    if (!strcasecmp (name, "bitshuffle")) {
+        return adios_transform_shuffle_bit;
+    }
+    return adios_transform_shuffle_none;
+}
+
+#ifdef SHUFFLE_SSE2
+/*
+ * One round takes the vectors in pairs (k, k + nvec/2) and interleaves
+ * their bytes. Seen as bits of the byte address in the nvec*16 bytes, a
+ * round rotates the address left by one bit, so 4 rounds turn 16 elements
+ * of nvec bytes into nvec planes of 16 bytes, and log2(nvec) rounds turn
+ * them back.
+ */
+static void sse2_interleave (__m128i * v, int nvec, int rounds)
+{
+    __m128i t [16];
+    int r, k, half = nvec / 2;
+
+    for (r = 0; r < rounds; r++) {
+        for (k = 0; k < half; k++) {
+            t[2*k]   = _mm_unpacklo_epi8 (v[k], v[k + half]);
+            t[2*k+1] = _mm_unpackhi_epi8 (v[k], v[k + half]);
+        }
+        memcpy (v, t, nvec * sizeof (__m128i));
+    }
+}
+
+static int sse2_log2 (int elem_size)
+{
+    switch (elem_size) {
+        case 2:  return 1;
+        case 4:  return 2;
+        case 8:  return 3;
+        case 16: return 4;
+        default: return 0;
+    }
+}
+#endif
+
+/* Byte shuffle of the first n elements, out has elem_size planes of n bytes */
+static void byte_shuffle (int elem_size, const uint8_t * in, uint64_t n, uint8_t * out)
+{
+    uint64_t i = 0;
+    int j;
+
+#ifdef SHUFFLE_SSE2
+    if (sse2_log2 (elem_size)) {
+        __m128i v [16];
+        for (; i + 16 <= n; i += 16) {
+            for (j = 0; j < elem_size; j++) {
+                v[j] = _mm_loadu_si128 ((const __m128i *) (in + i * elem_size + j * 16));
+            }
+            sse2_interleave (v, elem_size, 4);
+            for (j = 0; j < elem_size; j++) {
+                _mm_storeu_si128 ((__m128i *) (out + j * n + i), v[j]);
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        for (j = 0; j < elem_size; j++) {
+            out[j * n + i] = in[i * elem_size + j];
+        }
+    }
+}
+
+static void byte_unshuffle (int elem_size, const uint8_t * in, uint64_t n, uint8_t * out)
+{
+    uint64_t i = 0;
+    int j;
+
+#ifdef SHUFFLE_SSE2
+    int rounds = sse2_log2 (elem_size);
+    if (rounds) {
+        __m128i v [16];
+        for (; i + 16 <= n; i += 16) {
+            for (j = 0; j < elem_size; j++) {
+                v[j] = _mm_loadu_si128 ((const __m128i *) (in + j * n + i));
+            }
+            sse2_interleave (v, elem_size, rounds);
+            for (j = 0; j < elem_size; j++) {
+                _mm_storeu_si128 ((__m128i *) (out + i * elem_size + j * 16), v[j]);
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        for (j = 0; j < elem_size; j++) {
+            out[i * elem_size + j] = in[j * n + i];
+        }
+    }
+}
+
+/* Transpose an 8x8 bit matrix, bit b of byte k goes to bit k of byte b */
+static uint64_t transpose8 (uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+/*
+ * Split the n bytes of a byte plane (n a multiple of 8) into 8 bit planes
+ * of n/8 bytes, bit plane b at out + b*n/8. Bit i of a bit plane is the
+ * bit of byte i.
+ */
+static void bit_planes (const uint8_t * in, uint64_t n, uint8_t * out)
+{
+    uint64_t nbytes = n / 8, i = 0, x;
+    int b, k;
+
+#ifdef SHUFFLE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128 ((const __m128i *) (in + i));
+        for (b = 7; b >= 0; b--) {
+            int mask = _mm_movemask_epi8 (v);
+            out[b * nbytes + i / 8]     = (uint8_t) mask;
+            out[b * nbytes + i / 8 + 1] = (uint8_t) (mask >> 8);
+            v = _mm_add_epi8 (v, v);
+        }
+    }
+#endif
+
+    for (; i < n; i += 8) {
+        x = 0;
+        for (k = 0; k < 8; k++) {
+            x |= (uint64_t) in[i + k] << (8 * k);
+        }
+        x = transpose8 (x);
+        for (b = 0; b < 8; b++) {
+            out[b * nbytes + i / 8] = (uint8_t) (x >> (8 * b));
+        }
+    }
+}
+
+static void bit_unplanes (const uint8_t * in, uint64_t n, uint8_t * out)
+{
+    uint64_t nbytes = n / 8, i, x;
+    int b, k;
+
+    for (i = 0; i < n; i += 8) {
+        x = 0;
+        for (b = 0; b < 8; b++) {
+            x |= (uint64_t) in[b * nbytes + i / 8] << (8 * b);
+        }
+        x = transpose8 (x);
+        for (k = 0; k < 8; k++) {
+            out[i + k] = (uint8_t) (x >> (8 * k));
+        }
+    }
+}
+
+void adios_transform_shuffle (enum ADIOS_TRANSFORM_SHUFFLE kind, int elem_size,
+                              const void * in, uint64_t len, void * out, void * tmp)
+{
+    const uint8_t * src = (const uint8_t *) in;
+    uint8_t * dst = (uint8_t *) out;
+    uint64_t n = len / elem_size;
+    int j;
+
+    if (kind == adios_transform_shuffle_bit) {
+        n &= ~(uint64_t) 7;
+        byte_shuffle (elem_size, src, n, (uint8_t *) tmp);
+        for (j = 0; j < elem_size; j++) {
+            bit_planes ((uint8_t *) tmp + j * n, n, dst + j * n);
+        }
+    } else if (kind == adios_transform_shuffle_byte && elem_size > 1) {
+        byte_shuffle (elem_size, src, n, dst);
+    } else {
+        n = 0;
+    }
+    memcpy (dst + n * elem_size, src + n * elem_size, len - n * elem_size);
+}
+
+void adios_transform_unshuffle (enum ADIOS_TRANSFORM_SHUFFLE kind, int elem_size,
+                                const void * in, uint64_t len, void * out, void * tmp)
+{
+    const uint8_t * src = (const uint8_t *) in;
+    uint8_t * dst = (uint8_t *) out;
+    uint64_t n = len / elem_size;
+    int j;
+
+    if (kind == adios_transform_shuffle_bit) {
+        n &= ~(uint64_t) 7;
+        for (j = 0; j < elem_size; j++) {
+            bit_unplanes (src + j * n, n, (uint8_t *) tmp + j * n);
+        }
+        byte_unshuffle (elem_size, (uint8_t *) tmp, n, dst);
+    } else if (kind == adios_transform_shuffle_byte && elem_size > 1) {
+        byte_unshuffle (elem_size, src, n, dst);
+    } else {
+        n = 0;
+    }
+    memcpy (dst + n * elem_size, src + n * elem_size, len - n * elem_size);
+}
+
+uint64_t adios_transform_shuffle_align_chunk (const struct adios_transform_shuffle_stage * stage,
+                                              uint64_t chunk_size)
+{
+    uint64_t group = 8 * (uint64_t) stage->elem_size;
+
+    if (stage->kind == adios_transform_shuffle_none || chunk_size == 0) {
+        return chunk_size;
+    }
+    // round up, so the growth bound computed from the spec's size still holds
+    return (chunk_size + group - 1) / group * group;
+}
+
+int adios_transform_shuffle_compress (const void * input, uint64_t input_len,
+                                      void * output, uint64_t * output_len, void * arg)
+{
+    struct adios_transform_shuffle_stage * stage = (struct adios_transform_shuffle_stage *) arg;
+    char * tmp;
+    int rtn;
+
+    if (stage->kind == adios_transform_shuffle_none) {
+        return stage->fn (input, input_len, output, output_len, stage->arg);
+    }
+
+    tmp = (char *) malloc (stage->kind == adios_transform_shuffle_bit ? 2 * input_len : input_len);
+    if (!tmp) {
+        log_error ("Out of memory allocating %llu bytes to shuffle\n", (unsigned long long) input_len);
+        return -1;
+    }
+    adios_transform_shuffle (stage->kind, stage->elem_size, input, input_len, tmp, tmp + input_len);
+    rtn = stage->fn (tmp, input_len, output, output_len, stage->arg);
+    free (tmp);
+    return rtn;
+}
+
+int adios_transform_shuffle_decompress (const void * input, uint64_t input_len,
+                                        void * output, uint64_t * output_len, void * arg)
+{
+    struct adios_transform_shuffle_stage * stage = (struct adios_transform_shuffle_stage *) arg;
+    uint64_t len;
+    char * tmp;
+
+    if (stage->fn (input, input_len, output, output_len, stage->arg)) {
+        return -1;
+    }
+    if (stage->kind == adios_transform_shuffle_none) {
+        return 0;
+    }
+
+    len = *output_len;
+    tmp = (char *) malloc (stage->kind == adios_transform_shuffle_bit ? 2 * len : len);
+    if (!tmp) {
+        log_error ("Out of memory allocating %llu bytes to unshuffle\n", (unsigned long long) len);
+        return -1;
+    }
+    adios_transform_unshuffle (stage->kind, stage->elem_size, output, len, tmp, tmp + len);
+    memcpy (output, tmp, len);
+    free (tmp);
+    return 0;
+}
+
+void adios_transform_shuffle_write_metadata (const struct adios_transform_shuffle_stage * stage,
+                                             void * metadata, uint16_t offset)
+{
+    uint8_t * p = (uint8_t *) metadata + offset;
+
+    p[0] = (uint8_t) stage->kind;
+    p[1] = (uint8_t) stage->elem_size;
+}
+
+void adios_transform_shuffle_read_metadata (struct adios_transform_shuffle_stage * stage,
+                                            const void * metadata, uint16_t metadata_len,
+                                            uint16_t offset)
+{
+    const uint8_t * p = (const uint8_t *) metadata + offset;
+
+    stage->kind = adios_transform_shuffle_none;
+    stage->elem_size = 1;
+    if (metadata_len >= offset + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE && p[1] > 0) {
+        stage->kind = (enum ADIOS_TRANSFORM_SHUFFLE) p[0];
+        stage->elem_size = p[1];
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * adios_transforms_shuffle.h
+ *
+ * Shuffle stage of the compression transforms.
+ *
+ * A transform spec may put a stage in front of the compressor, e.g.
+ * transform="shuffle+zstd:5". The byte shuffle stores byte 0 of all
+ * elements, then byte 1 of all elements, and so on, which brings the
+ * slowly varying sign/exponent bytes of floating-point data together. The
+ * bit shuffle ("bitshuffle+...") goes further and stores each bit of the
+ * elements as its own plane. Bytes after the last whole element (and, for
+ * the bit shuffle, the elements after the last group of 8) are kept as is.
+ *
+ * The stage is applied to each sub-chunk of a chunked block separately, so
+ * partial reads still only decompress the sub-chunks they need.
+ */
+
+#ifndef ADIOS_TRANSFORMS_SHUFFLE_H_
+#define ADIOS_TRANSFORMS_SHUFFLE_H_
+
+#include <stdint.h>
+#include "core/transforms/adios_transforms_chunked.h"
+
+enum ADIOS_TRANSFORM_SHUFFLE {
+    adios_transform_shuffle_none = 0,
+    adios_transform_shuffle_byte = 1,
+    adios_transform_shuffle_bit  = 2
+};
+
+/* Bytes a compressor adds to its metadata for the stage: the kind and the element size */
+#define ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE 2
+
+/*
+ * A compressor behind a shuffle stage. Passed as the arg of
+ * adios_transform_shuffle_compress/decompress, which call fn with arg
+ * on the shuffled data.
+ */
+struct adios_transform_shuffle_stage {
+    enum ADIOS_TRANSFORM_SHUFFLE kind;
+    int elem_size;
+    adios_transform_chunk_fn fn;
+    void * arg;
+};
+
+/* Stage name in a transform spec ("shuffle", "bitshuffle"), none if unknown */
+enum ADIOS_TRANSFORM_SHUFFLE adios_transform_shuffle_find_by_name (const char * name);
+
+/*
+ * Shuffle len bytes of elements of elem_size bytes from in to out.
+ * tmp is scratch space of len bytes, used by the bit shuffle only.
+ */
+void adios_transform_shuffle (enum ADIOS_TRANSFORM_SHUFFLE kind, int elem_size,
+                              const void * in, uint64_t len, void * out, void * tmp);
+
+/* Undo adios_transform_shuffle */
+void adios_transform_unshuffle (enum ADIOS_TRANSFORM_SHUFFLE kind, int elem_size,
+                                const void * in, uint64_t len, void * out, void * tmp);
+
+/*
+ * Sub-chunk size to use with the stage: a multiple of 8 elements, so that
+ * every sub-chunk but the last is shuffled without a tail.
+ */
+uint64_t adios_transform_shuffle_align_chunk (const struct adios_transform_shuffle_stage * stage,
+                                              uint64_t chunk_size);
+
+/* adios_transform_chunk_fn shuffling the input, then compressing it with stage->fn */
+int adios_transform_shuffle_compress (const void * input, uint64_t input_len,
+                                      void * output, uint64_t * output_len, void * stage);
+
+/* adios_transform_chunk_fn decompressing with stage->fn, then unshuffling the output */
+int adios_transform_shuffle_decompress (const void * input, uint64_t input_len,
+                                        void * output, uint64_t * output_len, void * stage);
+
+/*
+ * Write the stage at metadata + offset. Read it back from metadata of
+ * metadata_len bytes, kind is none if the metadata has no stage.
+ */
+void adios_transform_shuffle_write_metadata (const struct adios_transform_shuffle_stage * stage,
+                                             void * metadata, uint16_t offset);
+void adios_transform_shuffle_read_metadata (struct adios_transform_shuffle_stage * stage,
+                                            const void * metadata, uint16_t metadata_len,
+                                            uint16_t offset);
+
+#endif /* ADIOS_TRANSFORMS_SHUFFLE_H_ */
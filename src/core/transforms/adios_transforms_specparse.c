@@ -52,6 +52,7 @@ struct adios_transform_spec * adios_transform_parse_spec(const char *spec_str,
     *spec = (struct adios_transform_spec){
         .transform_type = adios_transform_none,
         .transform_type_str = NULL,
+        .shuffle = adios_transform_shuffle_none,
         .param_count = 0,
         .params = NULL,
         .backing_str = NULL,
@@ -74,6 +75,21 @@ struct adios_transform_spec * adios_transform_parse_spec(const char *spec_str,
     // Split off the parameters if present
     char *param_list = strsplit(new_spec_str, ':');
 
+    // Split off a shuffle stage if present (i.e. "shuffle+zstd")
+    char *stage_str = new_spec_str;
+    char *type_str = strsplit(stage_str, '+');
+    if (type_str) {
+        spec->shuffle = adios_transform_shuffle_find_by_name(stage_str);
+        if (spec->shuffle == adios_transform_shuffle_none || strchr(type_str, '+')) {
+            // Unknown stage, or more than one: restore the string for the error message
+            type_str[-1] = '+';
+            spec->shuffle = adios_transform_shuffle_none;
+            spec->transform_type = adios_transform_unknown;
+            return spec;
+        }
+        spec->transform_type_str = type_str;
+    }
+
     // Parse the transform method string
     spec->transform_type = adios_transform_find_type_by_xml_alias(spec->transform_type_str);
 
@@ -114,6 +130,7 @@ void adios_transform_spec_copy(struct adios_transform_spec *dst, const struct ad
 
 	// Copy some non-pointer fields
 	dst->transform_type = src->transform_type;
+	dst->shuffle = src->shuffle;
 	dst->backing_str_len = src->backing_str_len;
 
 	// If there is a "backing string" field, copy it according to its recorded length
@@ -161,6 +178,7 @@ void adios_transform_spec_copy(struct adios_transform_spec *dst, const struct ad
 #define FREE(x) {if(x)free((void*)(x));(x)=NULL;}
 void adios_transform_clear_spec(struct adios_transform_spec *spec) {
 	spec->transform_type = adios_transform_none;
+	spec->shuffle = adios_transform_shuffle_none;
 
 	if (!spec->backing_str) {
     	int i;
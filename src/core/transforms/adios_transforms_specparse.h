@@ -9,6 +9,7 @@
 #define ADIOS_TRANSFORMS_SPECPARSE_H_
 
 #include "core/transforms/plugindetect/detect_plugin_types.h"
+#include "core/transforms/adios_transforms_shuffle.h"
 
 struct adios_transform_spec_kv_pair{
     const char *key;
@@ -19,6 +20,9 @@ struct adios_transform_spec {
     enum ADIOS_TRANSFORM_TYPE transform_type;
     const char *transform_type_str;
 
+    // Stage applied before the transform (i.e. transform="shuffle+zstd")
+    enum ADIOS_TRANSFORM_SHUFFLE shuffle;
+
     int param_count;
     struct adios_transform_spec_kv_pair * params;
 
@@ -29,7 +33,8 @@ struct adios_transform_spec {
 
 /*
  * Parses the transform spec string (i.e. transform="zlib:5"), returning a struct
- * describing the result
+ * describing the result. A shuffle stage may precede the transform type, separated
+ * by a '+' (i.e. transform="shuffle+zstd:5" or transform="bitshuffle+lz4").
  * @param transform_spec_str the transform spec string
  * @param pre-allocated struct to fill in; if null this func allocates the memory
  * @return the parsed transform spec
@@ -299,6 +299,14 @@ static int is_timed_scalar(const struct adios_var_struct *var) {
            is_dimension_item_zero(&var->dimensions->global_dimension); // It's not a global array
 }
 
+static int supports_shuffle(enum ADIOS_TRANSFORM_TYPE transform_type) {
+    return transform_type == adios_transform_zlib ||
+           transform_type == adios_transform_bzip2 ||
+           transform_type == adios_transform_lz4 ||
+           transform_type == adios_transform_zstd ||
+           transform_type == adios_transform_auto;   // passed on to the codec it picks
+}
+
 /*
  * Modifies the given variable's metadata to support the data transform specified by
  * orig_var->transform_spec. Also handles error conditions, such as the variable
@@ -332,6 +340,14 @@ struct adios_var_struct * adios_transform_define_var(struct adios_var_struct *or
     if (transform_spec->transform_type == adios_transform_none)
         return orig_var;
 
+    // The shuffle stage is done by the compressors that know about it
+    if (transform_spec->shuffle != adios_transform_shuffle_none &&
+        !supports_shuffle(transform_spec->transform_type)) {
+        log_warn("Transform \"%s\" of variable %s/%s cannot be preceded by a shuffle stage; not shuffling the data.\n",
+                 transform_spec->transform_type_str, orig_var->path, orig_var->name);
+        transform_spec->shuffle = adios_transform_shuffle_none;
+    }
+
     // If we get here, transform_type is an actual transformation, so prepare
     // the variable. This entails 1) adding a new dimension variable for
     // the variable (it will become a 1D byte array), and 2) making the
@@ -16,7 +16,8 @@ enum ADIOS_QUERY_METHOD
     ADIOS_QUERY_METHOD_FASTBIT = 0,
     ADIOS_QUERY_METHOD_ALACRITY = 1,
     ADIOS_QUERY_METHOD_UNKNOWN = 2,
-    ADIOS_QUERY_METHOD_COUNT = ADIOS_QUERY_METHOD_UNKNOWN
+    ADIOS_QUERY_METHOD_MINMAX = 3,   // keep UNKNOWN at 2, new methods go after it
+    ADIOS_QUERY_METHOD_COUNT = 4     // size of the method table, UNKNOWN has no hooks
 };
     
 
@@ -92,6 +93,16 @@ ADIOS_QUERY* adios_query_combine (ADIOS_QUERY* q1,
 */
 void adios_query_set_method (ADIOS_QUERY* q, enum ADIOS_QUERY_METHOD method);
 
+/*
+ *  ADIOS_QUERY_METHOD_MINMAX only. The method prunes the blocks of the
+ *  variables with their min/max statistics. With refine=1 (default), it reads
+ *  the remaining blocks and returns the points that satisfy the query like the
+ *  other methods. With refine=0, evaluate returns the candidate blocks without
+ *  reading any data, one writeblock selection per call, and estimate returns
+ *  the number of elements in them.
+*/
+void adios_query_minmax_set_refine (ADIOS_QUERY* q, int refine);
+
 
 /*
  * Estimate the number of hits of the query at "timestep"
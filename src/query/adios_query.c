@@ -1,5 +1,6 @@
 #include "public/adios_read.h"
 #include "common_query.h"
+#include "adios_query_hooks.h"
 
 int adios_query_is_method_available(enum ADIOS_QUERY_METHOD method) {
 	return common_query_is_method_available(method);
@@ -27,6 +28,11 @@ void adios_query_set_method (ADIOS_QUERY* q, enum ADIOS_QUERY_METHOD method)
      common_query_set_method (q, method);
 }
 
+void adios_query_minmax_set_refine (ADIOS_QUERY* q, int refine)
+{
+     query_minmax_set_refine (q, refine);
+}
+
 int64_t adios_query_estimate(ADIOS_QUERY* q, int timestep)
 {
   return common_query_estimate(q, timestep);
@@ -41,6 +41,7 @@ void adios_query_hooks_init (struct adios_query_hooks_struct ** t)
 #ifdef FASTBIT
     ASSIGN_FNS(fastbit, ADIOS_QUERY_METHOD_FASTBIT);
 #endif
+    ASSIGN_FNS(minmax, ADIOS_QUERY_METHOD_MINMAX);
 }
 
 #undef ASSIGN_FNS
@@ -13,6 +13,9 @@
 
 FORWARD_DECLARE(fastbit)
 FORWARD_DECLARE(alac)
+FORWARD_DECLARE(minmax)
+
+void query_minmax_set_refine (ADIOS_QUERY* q, int refine);
 
 typedef int      (* ADIOS_QUERY_FREE_FN) (ADIOS_QUERY* q);
 typedef int      (* ADIOS_QUERY_FINALIZE_FN) ();
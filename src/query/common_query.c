@@ -110,10 +110,16 @@ static enum ADIOS_QUERY_METHOD detect_and_set_query_method(ADIOS_QUERY* q)
 		  return m;
 		}
 	}
-	// return default that always works
-	//q->method = ADIOS_QUERY_METHOD_FASTBIT;
-	common_query_set_method(q, ADIOS_QUERY_METHOD_FASTBIT);
-	return ADIOS_QUERY_METHOD_FASTBIT;
+	// return default that always works, MINMAX is always built
+	if (common_query_is_method_available(ADIOS_QUERY_METHOD_FASTBIT)) {
+		m = ADIOS_QUERY_METHOD_FASTBIT;
+	} else if (common_query_is_method_available(ADIOS_QUERY_METHOD_ALACRITY)) {
+		m = ADIOS_QUERY_METHOD_ALACRITY;
+	} else {
+		m = ADIOS_QUERY_METHOD_MINMAX;
+	}
+	common_query_set_method(q, m);
+	return m;
 }
 
 int adios_get_actual_timestep(ADIOS_QUERY* q, int timeStep)
@@ -176,6 +182,7 @@ static int adios_check_query_at_timestep(ADIOS_QUERY* q, int timeStep)
       q->varinfo = v;
 
       free(q->dataSlice);
+      q->dataSlice = NULL; // see allocateDataSlice()
 
       uint64_t total_byte_size, dataSize;
 
@@ -185,7 +192,6 @@ static int adios_check_query_at_timestep(ADIOS_QUERY* q, int timeStep)
       }
 
       log_debug("%s, raw data size=%ld\n", q->condition, dataSize);
-      q->dataSlice = malloc(total_byte_size);
       q->rawDataSize = dataSize;
 
       return timeStep;
@@ -206,6 +212,23 @@ static int adios_check_query_at_timestep(ADIOS_QUERY* q, int timeStep)
     }
 }
 
+// Allocate the buffer each leaf reads its selection into. The MINMAX method
+// works block by block and never needs the whole selection in memory.
+static void allocateDataSlice(ADIOS_QUERY* q)
+{
+    if (q == NULL) {
+      return;
+    }
+
+    if ((q->left == NULL) && (q->right == NULL)) {
+      free(q->dataSlice);
+      q->dataSlice = malloc(q->rawDataSize * common_read_type_size(q->varinfo->type, q->varinfo->value));
+    } else {
+      allocateDataSlice(q->left);
+      allocateDataSlice(q->right);
+    }
+}
+
 void freeQuery(ADIOS_QUERY* query) {
   log_debug("common_free() query: %s \n", query->condition);
 
@@ -562,6 +585,9 @@ int64_t common_query_estimate(ADIOS_QUERY* q, int timestep)
       if (actualTimeStep == -1) {
 	return -1;
       }
+      if (m != ADIOS_QUERY_METHOD_MINMAX) {
+	allocateDataSlice(q);
+      }
 
       return query_hooks[m].adios_query_estimate_fn(q, timestep);
     }		
@@ -812,6 +838,9 @@ int common_query_evaluate(ADIOS_QUERY* q,
     }
 
     enum ADIOS_QUERY_METHOD m = detect_and_set_query_method (q);
+    if (m != ADIOS_QUERY_METHOD_MINMAX) {
+      allocateDataSlice(q);
+    }
 
     if (query_hooks[m].adios_query_evaluate_fn != NULL) {
       int retval = query_hooks[m].adios_query_evaluate_fn(q, timeStep, batchSize, outputBoundary, result);	      
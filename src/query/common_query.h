@@ -12,7 +12,7 @@ extern "C" {
 // called from Read init only; it does NOT call methods' init
 void common_query_init();
 
-//void common_query_set_method(enum ADIOS_QUERY_METHOD method);
+void common_query_set_method(ADIOS_QUERY* q, enum ADIOS_QUERY_METHOD method);
 
 int common_query_is_method_available(enum ADIOS_QUERY_METHOD method);
 
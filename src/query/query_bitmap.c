@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "query_bitmap.h"
+#include "core/adios_logger.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define bitmap_popcount(x) ((uint32_t) __builtin_popcountll (x))
+#define bitmap_ctz(x)      ((uint32_t) __builtin_ctzll (x))
+#else
+static uint32_t bitmap_popcount (uint64_t x)
+{
+    uint32_t n = 0;
+    for (; x; x &= x - 1) n++;
+    return n;
+}
+
+static uint32_t bitmap_ctz (uint64_t x)
+{
+    uint32_t n = 0;
+    for (; !(x & 1); x >>= 1) n++;
+    return n;
+}
+#endif
+
+static void chunk_clear (QUERY_BITMAP_CHUNK * c)
+{
+    free (c->array);
+    free (c->words);
+    c->array = NULL;
+    c->words = NULL;
+    c->cardinality = 0;
+}
+
+// build chunk c from the first nwords words of its bitmap
+static void chunk_from_words (QUERY_BITMAP_CHUNK * c, const uint64_t * w, uint32_t nwords)
+{
+    uint32_t card = 0, i, k = 0;
+
+    for (i = 0; i < nwords; i++) {
+        card += bitmap_popcount (w[i]);
+    }
+
+    c->cardinality = card;
+    c->array = NULL;
+    c->words = NULL;
+    if (card == 0) {
+        return;
+    }
+
+    if (card <= QUERY_BITMAP_ARRAY_MAX) {
+        c->array = (uint16_t *) malloc (card * sizeof (uint16_t));
+        for (i = 0; i < nwords; i++) {
+            uint64_t x = w[i];
+            while (x) {
+                c->array[k++] = (uint16_t) (i * 64 + bitmap_ctz (x));
+                x &= x - 1;
+            }
+        }
+    } else {
+        c->words = (uint64_t *) calloc (QUERY_BITMAP_CHUNK_WORDS, sizeof (uint64_t));
+        memcpy (c->words, w, nwords * sizeof (uint64_t));
+    }
+}
+
+static void chunk_to_words (const QUERY_BITMAP_CHUNK * c, uint64_t * w)
+{
+    uint32_t i;
+
+    if (c->words) {
+        memcpy (w, c->words, QUERY_BITMAP_CHUNK_WORDS * sizeof (uint64_t));
+        return;
+    }
+    memset (w, 0, QUERY_BITMAP_CHUNK_WORDS * sizeof (uint64_t));
+    for (i = 0; i < c->cardinality; i++) {
+        w [c->array[i] >> 6] |= (uint64_t) 1 << (c->array[i] & 63);
+    }
+}
+
+QUERY_BITMAP * query_bitmap_new (uint64_t nbits)
+{
+    QUERY_BITMAP * b = (QUERY_BITMAP *) malloc (sizeof (QUERY_BITMAP));
+
+    if (!b) {
+        return NULL;
+    }
+    b->nbits = nbits;
+    b->nchunks = (nbits + QUERY_BITMAP_CHUNK_SIZE - 1) >> QUERY_BITMAP_CHUNK_BITS;
+    b->chunks = (QUERY_BITMAP_CHUNK *) calloc (b->nchunks + 1, sizeof (QUERY_BITMAP_CHUNK));
+    b->open = b->nchunks;
+    b->open_words = NULL;
+    if (!b->chunks) {
+        free (b);
+        return NULL;
+    }
+    return b;
+}
+
+void query_bitmap_seal (QUERY_BITMAP * b)
+{
+    if (b->open < b->nchunks) {
+        chunk_from_words (&b->chunks[b->open], b->open_words, QUERY_BITMAP_CHUNK_WORDS);
+        b->open = b->nchunks;
+    }
+}
+
+void query_bitmap_set_bits (QUERY_BITMAP * b, uint64_t pos,
+                            const uint64_t * src, uint64_t sp, uint64_t n)
+{
+    uint64_t k, take, end;
+    uint64_t * w;
+    uint32_t off;
+
+    while (n > 0) {
+        k = pos >> QUERY_BITMAP_CHUNK_BITS;
+        if (k != b->open) {
+            query_bitmap_seal (b);
+            if (!b->open_words) {
+                b->open_words = (uint64_t *) malloc (QUERY_BITMAP_CHUNK_WORDS * sizeof (uint64_t));
+            }
+            chunk_to_words (&b->chunks[k], b->open_words);
+            chunk_clear (&b->chunks[k]);
+            b->open = k;
+        }
+
+        off = (uint32_t) (pos & (QUERY_BITMAP_CHUNK_SIZE - 1));
+        take = QUERY_BITMAP_CHUNK_SIZE - off;
+        if (take > n) {
+            take = n;
+        }
+
+        w = b->open_words;
+        for (end = sp + take; sp < end; sp++, off++) {
+            if (sp % 64 == 0 && end - sp >= 64 && src[sp / 64] == 0) {
+                // skip a word without hits
+                sp += 63;
+                off += 63;
+                continue;
+            }
+            if ((src[sp / 64] >> (sp % 64)) & 1) {
+                w[off >> 6] |= (uint64_t) 1 << (off & 63);
+            }
+        }
+
+        pos += take;
+        n -= take;
+    }
+}
+
+void query_bitmap_free (QUERY_BITMAP * b)
+{
+    uint64_t k;
+
+    if (!b) {
+        return;
+    }
+    for (k = 0; k < b->nchunks; k++) {
+        chunk_clear (&b->chunks[k]);
+    }
+    free (b->chunks);
+    free (b->open_words);
+    free (b);
+}
+
+// a = a AND b for two sparse chunks, in place in a
+static void chunk_and_arrays (QUERY_BITMAP_CHUNK * a, const QUERY_BITMAP_CHUNK * b)
+{
+    uint32_t i = 0, j = 0, k = 0;
+
+    while (i < a->cardinality && j < b->cardinality) {
+        if (a->array[i] < b->array[j]) {
+            i++;
+        } else if (a->array[i] > b->array[j]) {
+            j++;
+        } else {
+            a->array[k++] = a->array[i];
+            i++;
+            j++;
+        }
+    }
+    a->cardinality = k;
+    if (k == 0) {
+        chunk_clear (a);
+    }
+}
+
+static int bitmap_combine (QUERY_BITMAP * a, const QUERY_BITMAP * b, int is_and)
+{
+    uint64_t * wa, * wb;
+    uint64_t k;
+    uint32_t i;
+
+    if (a->nbits != b->nbits) {
+        log_error ("Cannot combine query bitmaps of %" PRIu64 " and %" PRIu64 " bits\n",
+                   a->nbits, b->nbits);
+        return -1;
+    }
+
+    wa = (uint64_t *) malloc (2 * QUERY_BITMAP_CHUNK_WORDS * sizeof (uint64_t));
+    wb = wa + QUERY_BITMAP_CHUNK_WORDS;
+
+    for (k = 0; k < a->nchunks; k++) {
+        QUERY_BITMAP_CHUNK * ca = &a->chunks[k];
+        const QUERY_BITMAP_CHUNK * cb = &b->chunks[k];
+
+        if (is_and) {
+            if (ca->cardinality == 0) {
+                continue;
+            }
+            if (cb->cardinality == 0) {
+                chunk_clear (ca);
+                continue;
+            }
+            if (ca->array && cb->array) {
+                chunk_and_arrays (ca, cb);
+                continue;
+            }
+        } else if (cb->cardinality == 0) {
+            continue;
+        }
+
+        chunk_to_words (ca, wa);
+        chunk_to_words (cb, wb);
+        if (is_and) {
+            for (i = 0; i < QUERY_BITMAP_CHUNK_WORDS; i++) wa[i] &= wb[i];
+        } else {
+            for (i = 0; i < QUERY_BITMAP_CHUNK_WORDS; i++) wa[i] |= wb[i];
+        }
+        chunk_clear (ca);
+        chunk_from_words (ca, wa, QUERY_BITMAP_CHUNK_WORDS);
+    }
+
+    free (wa);
+    return 0;
+}
+
+int query_bitmap_and (QUERY_BITMAP * a, const QUERY_BITMAP * b)
+{
+    return bitmap_combine (a, b, 1);
+}
+
+int query_bitmap_or (QUERY_BITMAP * a, const QUERY_BITMAP * b)
+{
+    return bitmap_combine (a, b, 0);
+}
+
+uint64_t query_bitmap_count (const QUERY_BITMAP * b)
+{
+    uint64_t k, n = 0;
+
+    for (k = 0; k < b->nchunks; k++) {
+        n += b->chunks[k].cardinality;
+    }
+    return n;
+}
+
+uint64_t query_bitmap_next (const QUERY_BITMAP * b, uint64_t pos)
+{
+    uint64_t k;
+
+    for (k = pos >> QUERY_BITMAP_CHUNK_BITS; k < b->nchunks; k++) {
+        const QUERY_BITMAP_CHUNK * c = &b->chunks[k];
+        uint64_t base = k << QUERY_BITMAP_CHUNK_BITS;
+        uint32_t off = (pos > base ? (uint32_t) (pos - base) : 0);
+
+        if (c->cardinality == 0) {
+            continue;
+        }
+
+        if (c->array) {
+            // first position >= off
+            uint32_t lo = 0, hi = c->cardinality;
+            while (lo < hi) {
+                uint32_t mid = (lo + hi) / 2;
+                if (c->array[mid] < off) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            if (lo < c->cardinality) {
+                return base + c->array[lo];
+            }
+        } else {
+            uint32_t i = off >> 6;
+            uint64_t x = c->words[i] & (~(uint64_t) 0 << (off & 63));
+            for (;;) {
+                if (x) {
+                    return base + i * 64 + bitmap_ctz (x);
+                }
+                if (++i == QUERY_BITMAP_CHUNK_WORDS) {
+                    break;
+                }
+                x = c->words[i];
+            }
+        }
+    }
+    return b->nbits;
+}
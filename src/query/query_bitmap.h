@@ -0,0 +1,58 @@
+#ifndef QUERY_BITMAP_H
+#define QUERY_BITMAP_H
+
+/*
+ * Compressed bitmap of the hits of a query in a block (roaring style).
+ *
+ * The bits are split in chunks of 2^16. A chunk with few set bits keeps
+ * them as a sorted array of 16-bit positions, a denser chunk keeps the
+ * 1024 words of its bitmap. Empty chunks take no memory.
+ *
+ * A bitmap can be filled bit run by bit run in any order, then only the
+ * chunk being filled is kept uncompressed.
+ */
+
+#include <stdint.h>
+
+#define QUERY_BITMAP_CHUNK_BITS  16
+#define QUERY_BITMAP_CHUNK_SIZE  (1 << QUERY_BITMAP_CHUNK_BITS)
+#define QUERY_BITMAP_CHUNK_WORDS (QUERY_BITMAP_CHUNK_SIZE / 64)
+#define QUERY_BITMAP_ARRAY_MAX   4096  // above this an array is larger than the bitmap
+
+typedef struct {
+    uint32_t cardinality;
+    uint16_t * array;    // sorted positions of a sparse chunk, or NULL
+    uint64_t * words;    // bitmap of a dense chunk, or NULL
+} QUERY_BITMAP_CHUNK;
+
+typedef struct {
+    uint64_t nbits;
+    uint64_t nchunks;
+    QUERY_BITMAP_CHUNK * chunks;
+    uint64_t open;           // chunk being filled, nchunks if none
+    uint64_t * open_words;   // its bitmap while it is filled
+} QUERY_BITMAP;
+
+/* An empty bitmap of nbits bits */
+QUERY_BITMAP * query_bitmap_new (uint64_t nbits);
+
+/* Set bit pos+i if bit sp+i of src is set, for i < n. The chunk of the
+   bits is uncompressed until bits of another chunk are set. */
+void query_bitmap_set_bits (QUERY_BITMAP * b, uint64_t pos,
+                            const uint64_t * src, uint64_t sp, uint64_t n);
+
+/* Compress the chunk being filled. The functions below need this first. */
+void query_bitmap_seal (QUERY_BITMAP * b);
+
+void query_bitmap_free (QUERY_BITMAP * b);
+
+/* a = a AND b, a = a OR b. Both must have the same number of bits. */
+int query_bitmap_and (QUERY_BITMAP * a, const QUERY_BITMAP * b);
+int query_bitmap_or (QUERY_BITMAP * a, const QUERY_BITMAP * b);
+
+uint64_t query_bitmap_count (const QUERY_BITMAP * b);
+
+/* Position of the first set bit at or after pos, nbits if there is none */
+uint64_t query_bitmap_next (const QUERY_BITMAP * b, uint64_t pos);
+
+#endif
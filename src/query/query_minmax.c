@@ -0,0 +1,979 @@
+/*
+ * query_minmax.c
+ *
+ * Query method that needs no index library. The min/max statistics the
+ * writers store with every block prune the blocks that cannot hold a hit.
+ * The remaining blocks are read one at a time and scanned, so no more than
+ * a block of data is in memory at once.
+ *
+ * The scan kernels write one bit per element of a block. Like with the
+ * other methods, the clauses of a query are combined element by element of
+ * their selections: each clause sets the bits of its hits at their
+ * positions in its selection in a compressed bitmap (only the 2^16 bits
+ * being set are uncompressed), the bitmaps of the clauses are combined
+ * with AND/OR chunk by chunk, and the hits are turned into coordinates of
+ * the output boundary only as many as a batch asks for.
+ *
+ * The predicate value and the data are compared as double.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "public/adios_error.h"
+#include "public/adios_query.h"
+#include "public/adios_selection.h"
+#include "core/common_read.h"
+#include "core/bp_utils.h"
+#include "core/futils.h"
+#include "core/adios_logger.h"
+#include "common_query.h"
+#include "query_utils.h"
+#include "adios_query_hooks.h"
+#include "query_bitmap.h"
+
+#if defined(__x86_64__) && !defined(__INTEL_COMPILER) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define MINMAX_X86 1
+#include <immintrin.h>
+#define MINMAX_AVX2 __attribute__((target("avx2")))
+#endif
+
+typedef struct {
+    int refine;             // scan the candidate blocks (1) or return them (0)
+    int timestep;           // step the candidates were found for, -1 if none
+    int * blocks;           // candidate blocks, index relative to the step
+    int nblocks;
+    int next;               // next candidate to return
+    int ndim;
+    QUERY_BITMAP * hits;    // hits of the step, a bit per element of the selection
+    uint64_t cursor;        // next bit of hits to look at
+    uint64_t nhits;
+    uint64_t hitsReturned;
+    uint64_t * outStart;    // box the hits are returned in, C order
+    uint64_t * outCount;
+} MINMAX_INTERNAL;
+
+
+static ADIOS_QUERY * getFirstLeaf (ADIOS_QUERY * q)
+{
+    while (q->left) {
+        q = (ADIOS_QUERY *) q->left;
+    }
+    return q;
+}
+
+static MINMAX_INTERNAL * minmax_internal (ADIOS_QUERY * q)
+{
+    MINMAX_INTERNAL * mi = (MINMAX_INTERNAL *) q->queryInternal;
+    if (!mi) {
+        mi = (MINMAX_INTERNAL *) calloc (1, sizeof (MINMAX_INTERNAL));
+        mi->refine = 1;
+        mi->timestep = -1;
+        q->queryInternal = mi;
+    }
+    return mi;
+}
+
+// forget the candidates, the next evaluate starts over
+static void minmax_reset (MINMAX_INTERNAL * mi)
+{
+    free (mi->blocks);
+    query_bitmap_free (mi->hits);
+    free (mi->outStart);
+    mi->blocks = NULL;
+    mi->hits = NULL;
+    mi->outStart = NULL;
+    mi->outCount = NULL;
+    mi->nblocks = 0;
+    mi->next = 0;
+    mi->cursor = 0;
+    mi->nhits = 0;
+    mi->hitsReturned = 0;
+    mi->timestep = -1;
+}
+
+void query_minmax_set_refine (ADIOS_QUERY * q, int refine)
+{
+    common_query_set_method (q, ADIOS_QUERY_METHOD_MINMAX);
+    MINMAX_INTERNAL * mi = minmax_internal (q);
+    minmax_reset (mi);
+    mi->refine = (refine != 0);
+}
+
+static int minmax_type_supported (enum ADIOS_DATATYPES type)
+{
+    switch (type) {
+        case adios_byte:
+        case adios_unsigned_byte:
+        case adios_short:
+        case adios_unsigned_short:
+        case adios_integer:
+        case adios_unsigned_integer:
+        case adios_long:
+        case adios_unsigned_long:
+        case adios_real:
+        case adios_double:
+        case adios_long_double:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// index of block b of 'timestep' in the block arrays of the varinfo
+static int minmax_block_index (ADIOS_VARINFO * v, int b, int timestep)
+{
+    if (v->nsteps > 1) { // varinfo of all steps, not a stream
+        return query_utils_getGlobalWriteBlockId (b, timestep, v);
+    }
+    return b;
+}
+
+static int minmax_nblocks (ADIOS_VARINFO * v, int timestep)
+{
+    return v->nblocks [(v->nsteps > 1 ? timestep : 0)];
+}
+
+// Can a block of 'type' with values in [min, max] satisfy 'op value'?
+static int minmax_block_may_match (enum ADIOS_DATATYPES type, enum ADIOS_PREDICATE_MODE op,
+                                   double value, double min, double max)
+{
+    switch (op) {
+        case ADIOS_LT:   return (min <  value);
+        case ADIOS_LTEQ: return (min <= value);
+        case ADIOS_GT:   return (max >  value);
+        case ADIOS_GTEQ: return (max >= value);
+        case ADIOS_EQ:   return (min <= value && value <= max);
+        case ADIOS_NE:
+            // the statistics skip NaNs, which are != any value
+            if (type == adios_real || type == adios_double || type == adios_long_double) {
+                return 1;
+            }
+            return !(min == value && max == value);
+    }
+    return 1;
+}
+
+// b is the block's index in the step, abs its index among all steps
+static int minmax_block_in_selection (ADIOS_SELECTION * sel, const ADIOS_VARBLOCK * vb,
+                                      int ndim, int b, int abs)
+{
+    int d;
+
+    if (!sel) {
+        return 1;
+    }
+
+    if (sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        return (sel->u.block.index == (sel->u.block.is_absolute_index ? abs : b));
+    }
+
+    if (sel->type == ADIOS_SELECTION_BOUNDINGBOX) {
+        const ADIOS_SELECTION_BOUNDINGBOX_STRUCT * bb = &(sel->u.bb);
+        for (d = 0; d < ndim; d++) {
+            if (vb->start[d] >= bb->start[d] + bb->count[d] ||
+                bb->start[d] >= vb->start[d] + vb->count[d]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int minmax_predicate_value (ADIOS_QUERY * q, double * value)
+{
+    char * end;
+
+    *value = strtod (q->predicateValue, &end);
+    if (end == q->predicateValue) {
+        adios_error (err_invalid_query_value,
+                     "Query %s: value '%s' is not a number\n",
+                     q->condition, q->predicateValue);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Mark the blocks of the step that may hold a hit of the query.
+ * cand has nblocks elements.
+ */
+static int minmax_prune (ADIOS_QUERY * q, int timestep, int nblocks, char * cand)
+{
+    int b;
+
+    if (!q->left && !q->right) {
+        ADIOS_VARINFO * v = q->varinfo;
+        double value;
+
+        if (minmax_nblocks (v, timestep) != nblocks) {
+            adios_error (err_incompatible_queries,
+                         "Query %s: variable %s has %d blocks instead of %d, "
+                         "the MINMAX method needs the same decomposition for all variables\n",
+                         q->condition, q->varName, minmax_nblocks (v, timestep), nblocks);
+            return -1;
+        }
+        if (minmax_predicate_value (q, &value) < 0) {
+            return -1;
+        }
+
+        for (b = 0; b < nblocks; b++) {
+            int abs = minmax_block_index (v, b, timestep);
+
+            cand[b] = (char) minmax_block_in_selection (q->sel, &v->blockinfo[abs], v->ndim, b, abs);
+            if (cand[b] && v->statistics && v->statistics->blocks &&
+                v->statistics->blocks->mins[abs] && v->statistics->blocks->maxs[abs])
+            {
+                // blocks without statistics cannot be pruned
+                cand[b] = (char) minmax_block_may_match (v->type, q->predicateOp, value,
+                                  bp_value_to_double (v->type, v->statistics->blocks->mins[abs]),
+                                  bp_value_to_double (v->type, v->statistics->blocks->maxs[abs]));
+            }
+        }
+        return 0;
+    }
+
+    char * right = (char *) malloc (nblocks);
+    if (minmax_prune ((ADIOS_QUERY *) q->left, timestep, nblocks, cand) < 0 ||
+        minmax_prune ((ADIOS_QUERY *) q->right, timestep, nblocks, right) < 0)
+    {
+        free (right);
+        return -1;
+    }
+
+    for (b = 0; b < nblocks; b++) {
+        if (q->combineOp == ADIOS_QUERY_OP_AND) {
+            cand[b] = cand[b] && right[b];
+        } else {
+            cand[b] = cand[b] || right[b];
+        }
+    }
+    free (right);
+    return 0;
+}
+
+/*
+ * Load the block info and statistics of every leaf's variable.
+ * adios_check_query_at_timestep replaces q->varinfo on every estimate and
+ * evaluate call, so this is needed on every call that looks at blocks.
+ */
+static void minmax_inq_blocks (ADIOS_QUERY * q)
+{
+    if (!q->left && !q->right) {
+        ADIOS_VARINFO * v = q->varinfo;
+        if (!v->blockinfo) {
+            common_read_inq_var_blockinfo (q->file, v);
+        }
+        // the BP reader's block statistics span all steps of the file, not
+        // the current step of a stream: streams are pruned by selection only
+        if (!v->statistics && !q->file->is_streaming) {
+            common_read_inq_var_stat (q->file, v, 0, 1);
+        }
+        return;
+    }
+    minmax_inq_blocks ((ADIOS_QUERY *) q->left);
+    minmax_inq_blocks ((ADIOS_QUERY *) q->right);
+}
+
+static int minmax_actual_step (ADIOS_QUERY * q, int timestep)
+{
+    ADIOS_QUERY * leaf = getFirstLeaf (q);
+    return (leaf->file->is_streaming ? leaf->file->current_step : timestep);
+}
+
+static int minmax_check_variable (ADIOS_QUERY * q)
+{
+    ADIOS_QUERY * leaf = getFirstLeaf (q);
+    ADIOS_VARINFO * v = leaf->varinfo;
+
+    if (!minmax_type_supported (v->type)) {
+        adios_error (err_invalid_query_value,
+                     "Query %s: the MINMAX method does not support the type of %s\n",
+                     q->condition, leaf->varName);
+        return -1;
+    }
+    if (v->ndim == 0) {
+        adios_error (err_invalid_query_value,
+                     "Query %s: the MINMAX method needs an array, %s is a scalar\n",
+                     q->condition, leaf->varName);
+        return -1;
+    }
+    return 0;
+}
+
+// Find the candidate blocks of the step (refine=0), unless already known
+static int minmax_prepare (ADIOS_QUERY * q, MINMAX_INTERNAL * mi, int timestep)
+{
+    ADIOS_QUERY * leaf = getFirstLeaf (q);
+    ADIOS_VARINFO * v = leaf->varinfo;
+    int actualstep = minmax_actual_step (q, timestep);
+    int nblocks, b;
+    char * cand;
+
+    if (mi->timestep == actualstep) {
+        return 0;
+    }
+    minmax_reset (mi);
+
+    if (minmax_check_variable (q) < 0) {
+        return -1;
+    }
+    minmax_inq_blocks (q);
+
+    nblocks = minmax_nblocks (v, timestep);
+    cand = (char *) malloc (nblocks);
+    if (minmax_prune (q, timestep, nblocks, cand) < 0) {
+        free (cand);
+        return -1;
+    }
+
+    mi->blocks = (int *) malloc (nblocks * sizeof (int));
+    for (b = 0; b < nblocks; b++) {
+        if (cand[b]) {
+            mi->blocks [mi->nblocks++] = b;
+        }
+    }
+    free (cand);
+
+    log_debug ("%s: %d of %d blocks may hold hits at step %d\n",
+               q->condition, mi->nblocks, nblocks, actualstep);
+
+    mi->ndim = v->ndim;
+    mi->timestep = actualstep;
+    return 0;
+}
+
+/*
+ * Scan kernels: bit i of words is set if data[i] op value. Each 64-bit word
+ * is built from a fixed number of branch free comparisons, which the
+ * compiler vectorizes. On x86-64 the AVX2 variants for float, double and
+ * int are picked at runtime if the CPU supports them.
+ */
+#define MINMAX_SCAN_OP(T, OP) \
+    { \
+        const T * d = (const T *) data; \
+        uint64_t nfull = n / 64, k, w; \
+        int j; \
+        for (k = 0; k < nfull; k++, d += 64) { \
+            w = 0; \
+            for (j = 0; j < 64; j++) w |= (uint64_t) ((double) d[j] OP value) << j; \
+            words[k] = w; \
+        } \
+        if (n % 64) { \
+            w = 0; \
+            for (j = 0; j < (int) (n % 64); j++) w |= (uint64_t) ((double) d[j] OP value) << j; \
+            words[nfull] = w; \
+        } \
+    }
+
+#define MINMAX_SCAN(T) \
+    switch (op) { \
+        case ADIOS_LT:   MINMAX_SCAN_OP(T, < ); break; \
+        case ADIOS_LTEQ: MINMAX_SCAN_OP(T, <=); break; \
+        case ADIOS_GT:   MINMAX_SCAN_OP(T, > ); break; \
+        case ADIOS_GTEQ: MINMAX_SCAN_OP(T, >=); break; \
+        case ADIOS_EQ:   MINMAX_SCAN_OP(T, ==); break; \
+        case ADIOS_NE:   MINMAX_SCAN_OP(T, !=); break; \
+    }
+
+#ifdef MINMAX_X86
+
+/* LOAD4(i) yields the 4 elements from i on as doubles, so every type is
+   compared exactly like the scalar kernels do */
+#define MINMAX_SCAN_AVX2_OP(LOAD4, PRED) \
+    { \
+        const __m256d v = _mm256_set1_pd (value); \
+        uint64_t nfull = n / 64, k, w, i = 0; \
+        int j; \
+        for (k = 0; k < nfull; k++) { \
+            w = 0; \
+            for (j = 0; j < 64; j += 4, i += 4) { \
+                __m256d x = LOAD4(i); \
+                w |= (uint64_t) _mm256_movemask_pd (_mm256_cmp_pd (x, v, PRED)) << j; \
+            } \
+            words[k] = w; \
+        } \
+    }
+
+#define MINMAX_SCAN_AVX2(LOAD4) \
+    switch (op) { \
+        case ADIOS_LT:   MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_LT_OQ); break; \
+        case ADIOS_LTEQ: MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_LE_OQ); break; \
+        case ADIOS_GT:   MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_GT_OQ); break; \
+        case ADIOS_GTEQ: MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_GE_OQ); break; \
+        case ADIOS_EQ:   MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_EQ_OQ); break; \
+        case ADIOS_NE:   MINMAX_SCAN_AVX2_OP(LOAD4, _CMP_NEQ_UQ); break; \
+    }
+
+#define LOAD4_DOUBLE(i) _mm256_loadu_pd (d + (i))
+#define LOAD4_FLOAT(i)  _mm256_cvtps_pd (_mm_loadu_ps (f + (i)))
+#define LOAD4_INT(i)    _mm256_cvtepi32_pd (_mm_loadu_si128 ((const __m128i *) (l + (i))))
+
+// full words only, the caller scans the rest
+MINMAX_AVX2 static void minmax_scan_avx2 (enum ADIOS_DATATYPES type, const void * data, uint64_t n,
+                                          enum ADIOS_PREDICATE_MODE op, double value,
+                                          uint64_t * words)
+{
+    const double * d = (const double *) data;
+    const float * f = (const float *) data;
+    const int32_t * l = (const int32_t *) data;
+
+    switch (type) {
+        case adios_double:  MINMAX_SCAN_AVX2(LOAD4_DOUBLE); break;
+        case adios_real:    MINMAX_SCAN_AVX2(LOAD4_FLOAT); break;
+        case adios_integer: MINMAX_SCAN_AVX2(LOAD4_INT); break;
+        default: break;
+    }
+}
+
+#undef LOAD4_DOUBLE
+#undef LOAD4_FLOAT
+#undef LOAD4_INT
+#undef MINMAX_SCAN_AVX2
+#undef MINMAX_SCAN_AVX2_OP
+
+static int minmax_have_avx2 (void)
+{
+    static int have_avx2 = -1;
+
+    if (have_avx2 < 0) {
+        __builtin_cpu_init ();
+        have_avx2 = __builtin_cpu_supports ("avx2") ? 1 : 0;
+    }
+    return have_avx2;
+}
+
+#endif /* MINMAX_X86 */
+
+static void minmax_scan (enum ADIOS_DATATYPES type, const void * data, uint64_t n,
+                         enum ADIOS_PREDICATE_MODE op, double value, uint64_t * words)
+{
+#ifdef MINMAX_X86
+    if ((type == adios_double || type == adios_real || type == adios_integer) &&
+        n >= 64 && minmax_have_avx2 ())
+    {
+        uint64_t nfull = n / 64;
+        int size = common_read_type_size (type, NULL);
+
+        minmax_scan_avx2 (type, data, n, op, value, words);
+        data = (const char *) data + nfull * 64 * size;
+        words += nfull;
+        n -= nfull * 64;
+    }
+#endif
+
+    switch (type) {
+        case adios_byte:             MINMAX_SCAN(int8_t); break;
+        case adios_unsigned_byte:    MINMAX_SCAN(uint8_t); break;
+        case adios_short:            MINMAX_SCAN(int16_t); break;
+        case adios_unsigned_short:   MINMAX_SCAN(uint16_t); break;
+        case adios_integer:          MINMAX_SCAN(int32_t); break;
+        case adios_unsigned_integer: MINMAX_SCAN(uint32_t); break;
+        case adios_long:             MINMAX_SCAN(int64_t); break;
+        case adios_unsigned_long:    MINMAX_SCAN(uint64_t); break;
+        case adios_real:             MINMAX_SCAN(float); break;
+        case adios_double:           MINMAX_SCAN(double); break;
+        case adios_long_double:      MINMAX_SCAN(long double); break;
+        default:                     memset (words, 0, (n + 63) / 64 * sizeof (uint64_t)); break;
+    }
+}
+
+#undef MINMAX_SCAN
+#undef MINMAX_SCAN_OP
+
+// Reorder a start or count between the caller's order and C order
+static void minmax_c_order (int ndim, int fortran_order, const uint64_t * in, uint64_t * out)
+{
+    int d;
+    for (d = 0; d < ndim; d++) {
+        out[d] = in[(fortran_order ? ndim-1-d : d)];
+    }
+}
+
+// start/count of a block in C order
+static void minmax_block_bounds (const ADIOS_VARBLOCK * vb, int ndim, int fortran_order,
+                                 uint64_t * start, uint64_t * count)
+{
+    minmax_c_order (ndim, fortran_order, vb->start, start);
+    minmax_c_order (ndim, fortran_order, vb->count, count);
+}
+
+static uint64_t minmax_box_size (int ndim, const uint64_t * count)
+{
+    uint64_t n = 1;
+    int d;
+    for (d = 0; d < ndim; d++) {
+        n *= count[d];
+    }
+    return n;
+}
+
+/*
+ * The box (C order) a clause is evaluated on: its bounding box, its
+ * writeblock, or the whole variable.
+ */
+static int minmax_leaf_box (ADIOS_QUERY * q, int timestep, int fortran_order,
+                            uint64_t * start, uint64_t * count)
+{
+    ADIOS_VARINFO * v = q->varinfo;
+
+    if (!q->sel) {
+        memset (start, 0, v->ndim * sizeof (uint64_t));
+        minmax_c_order (v->ndim, fortran_order, v->dims, count);
+        return 0;
+    }
+
+    if (q->sel->type == ADIOS_SELECTION_BOUNDINGBOX && q->sel->u.bb.ndim == v->ndim) {
+        minmax_c_order (v->ndim, fortran_order, q->sel->u.bb.start, start);
+        minmax_c_order (v->ndim, fortran_order, q->sel->u.bb.count, count);
+        return 0;
+    }
+
+    if (q->sel->type == ADIOS_SELECTION_WRITEBLOCK) {
+        const ADIOS_SELECTION_WRITEBLOCK_STRUCT * wb = &(q->sel->u.block);
+        int abs = (wb->is_absolute_index ? wb->index : minmax_block_index (v, wb->index, timestep));
+        if (abs < 0 || abs >= v->sum_nblocks) {
+            adios_error (err_invalid_query_value,
+                         "Query %s: writeblock %d of %s does not exist\n",
+                         q->condition, wb->index, q->varName);
+            return -1;
+        }
+        minmax_block_bounds (&v->blockinfo[abs], v->ndim, fortran_order, start, count);
+        return 0;
+    }
+
+    adios_error (err_invalid_query_value,
+                 "Query %s: the MINMAX method does not support the selection of %s\n",
+                 q->condition, q->varName);
+    return -1;
+}
+
+/*
+ * The part of block b of the step inside the box, in start/count (C order).
+ * Returns its number of elements, 0 if the block cannot hold a hit.
+ */
+static uint64_t minmax_leaf_block (ADIOS_QUERY * q, int timestep, int b, double value,
+                                   int fortran_order,
+                                   const uint64_t * boxStart, const uint64_t * boxCount,
+                                   uint64_t * start, uint64_t * count)
+{
+    ADIOS_VARINFO * v = q->varinfo;
+    ADIOS_VARSTAT * stat = v->statistics;
+    int abs = minmax_block_index (v, b, timestep);
+    int d;
+
+    minmax_block_bounds (&v->blockinfo[abs], v->ndim, fortran_order, start, count);
+    for (d = 0; d < v->ndim; d++) {
+        uint64_t lo = (start[d] > boxStart[d] ? start[d] : boxStart[d]);
+        uint64_t hi = start[d] + count[d];
+        if (hi > boxStart[d] + boxCount[d]) {
+            hi = boxStart[d] + boxCount[d];
+        }
+        if (hi <= lo) {
+            return 0;
+        }
+        start[d] = lo;
+        count[d] = hi - lo;
+    }
+
+    // blocks without statistics cannot be pruned
+    if (stat && stat->blocks && stat->blocks->mins[abs] && stat->blocks->maxs[abs] &&
+        !minmax_block_may_match (v->type, q->predicateOp, value,
+                                 bp_value_to_double (v->type, stat->blocks->mins[abs]),
+                                 bp_value_to_double (v->type, stat->blocks->maxs[abs])))
+    {
+        return 0;
+    }
+    return minmax_box_size (v->ndim, count);
+}
+
+/*
+ * Read the part start/count (C order, n elements) of a block, scan it and
+ * set the bits of its hits in the hits of the clause's box.
+ */
+static int minmax_scan_part (ADIOS_QUERY * q, int timestep, double value, int fortran_order,
+                             const uint64_t * start, const uint64_t * count, uint64_t n,
+                             const uint64_t * boxStart, const uint64_t * boxCount,
+                             QUERY_BITMAP * hits)
+{
+    ADIOS_VARINFO * v = q->varinfo;
+    int ndim = v->ndim;
+    void * data = malloc (n * common_read_type_size (v->type, v->value));
+    uint64_t * words = (uint64_t *) malloc ((n + 63) / 64 * sizeof (uint64_t));
+    uint64_t * sel = (uint64_t *) malloc (3 * ndim * sizeof (uint64_t));
+    uint64_t * pos = sel + 2 * ndim;
+    uint64_t rowlen = count[ndim-1], row, at;
+    int d, err;
+
+    if (!data || !words || !sel) {
+        adios_error (err_no_memory, "Query %s: cannot allocate %" PRIu64
+                     " elements to scan a block of %s\n", q->condition, n, q->varName);
+        free (data);
+        free (words);
+        free (sel);
+        return -1;
+    }
+
+    minmax_c_order (ndim, fortran_order, start, sel);
+    minmax_c_order (ndim, fortran_order, count, sel + ndim);
+    ADIOS_SELECTION * bb = common_read_selection_boundingbox (ndim, sel, sel + ndim);
+    err = common_read_schedule_read_byid (q->file, bb, v->varid, timestep, 1, NULL, data);
+    if (!err) {
+        err = common_read_perform_reads (q->file, 1);
+    }
+    common_read_selection_delete (bb);
+    if (err) {
+        // adios_errno is set by the read method, do not scan what is not there
+        log_error ("Query %s: reading a block of %s failed\n", q->condition, q->varName);
+        free (data);
+        free (words);
+        free (sel);
+        return -1;
+    }
+
+    minmax_scan (v->type, data, n, q->predicateOp, value, words);
+    free (data);
+
+    // each row of the part (along the fastest dimension) is contiguous in the box
+    memset (pos, 0, ndim * sizeof (uint64_t));
+    for (row = 0; row < n / rowlen; row++) {
+        at = 0;
+        for (d = 0; d < ndim; d++) {
+            at = at * boxCount[d] + (start[d] - boxStart[d] + pos[d]);
+        }
+        query_bitmap_set_bits (hits, at, words, row * rowlen, rowlen);
+
+        for (d = ndim-2; d >= 0; d--) {
+            if (++pos[d] < count[d]) {
+                break;
+            }
+            pos[d] = 0;
+        }
+    }
+
+    free (words);
+    free (sel);
+    return 0;
+}
+
+/*
+ * Hits of a clause, bit i for element i (C order) of its box. The candidate
+ * blocks are read and scanned one at a time, their hits go straight into
+ * the compressed bitmap. Returns NULL on error.
+ */
+static QUERY_BITMAP * minmax_leaf_hits (ADIOS_QUERY * q, int timestep, uint64_t nelems)
+{
+    ADIOS_VARINFO * v = q->varinfo;
+    int fortran_order = futils_is_called_from_fortran ();
+    int ndim = v->ndim;
+    int nblocks = minmax_nblocks (v, timestep);
+    uint64_t * box = (uint64_t *) malloc (4 * ndim * sizeof (uint64_t));
+    QUERY_BITMAP * hits = query_bitmap_new (nelems);
+    uint64_t * boxStart = box, * boxCount = box + ndim;
+    uint64_t * start = box + 2 * ndim, * count = box + 3 * ndim;
+    uint64_t n;
+    double value;
+    int b, err = -1;
+
+    if (!box || !hits) {
+        adios_error (err_no_memory, "Query %s: cannot allocate the hits of %" PRIu64
+                     " elements\n", q->condition, nelems);
+    } else if (minmax_leaf_box (q, timestep, fortran_order, boxStart, boxCount) == 0 &&
+               minmax_predicate_value (q, &value) == 0)
+    {
+        n = minmax_box_size (ndim, boxCount);
+        if (n != nelems) {
+            adios_error (err_incompatible_queries,
+                         "Query %s: the selection of %s has %" PRIu64 " elements instead of %" PRIu64 "\n",
+                         q->condition, q->varName, n, nelems);
+        } else {
+            err = 0;
+            for (b = 0; b < nblocks && !err; b++) {
+                n = minmax_leaf_block (q, timestep, b, value, fortran_order,
+                                       boxStart, boxCount, start, count);
+                if (n > 0) {
+                    err = minmax_scan_part (q, timestep, value, fortran_order,
+                                            start, count, n, boxStart, boxCount, hits);
+                }
+            }
+        }
+    }
+
+    free (box);
+    if (err) {
+        query_bitmap_free (hits);
+        return NULL;
+    }
+    query_bitmap_seal (hits);
+    return hits;
+}
+
+// Hits of the query, bit i for element i of the clauses' boxes
+static QUERY_BITMAP * minmax_hits (ADIOS_QUERY * q, int timestep, uint64_t nelems)
+{
+    QUERY_BITMAP * hits, * right;
+    int err;
+
+    if (!q->left && !q->right) {
+        return minmax_leaf_hits (q, timestep, nelems);
+    }
+
+    hits = minmax_hits ((ADIOS_QUERY *) q->left, timestep, nelems);
+    if (!hits) {
+        return NULL;
+    }
+
+    // a clause cannot change an empty AND or a full OR
+    if (q->combineOp == ADIOS_QUERY_OP_AND && query_bitmap_count (hits) == 0) {
+        return hits;
+    }
+    if (q->combineOp == ADIOS_QUERY_OP_OR && query_bitmap_count (hits) == nelems) {
+        return hits;
+    }
+
+    right = minmax_hits ((ADIOS_QUERY *) q->right, timestep, nelems);
+    if (!right) {
+        query_bitmap_free (hits);
+        return NULL;
+    }
+
+    if (q->combineOp == ADIOS_QUERY_OP_AND) {
+        err = query_bitmap_and (hits, right);
+    } else {
+        err = query_bitmap_or (hits, right);
+    }
+    query_bitmap_free (right);
+    if (err) {
+        query_bitmap_free (hits);
+        return NULL;
+    }
+    return hits;
+}
+
+// Upper bound of the hits of the query: the elements of the candidate blocks
+static int64_t minmax_estimate_hits (ADIOS_QUERY * q, int timestep, uint64_t nelems)
+{
+    int64_t left, right;
+
+    if (!q->left && !q->right) {
+        ADIOS_VARINFO * v = q->varinfo;
+        int fortran_order = futils_is_called_from_fortran ();
+        uint64_t * box = (uint64_t *) malloc (4 * v->ndim * sizeof (uint64_t));
+        int64_t n = -1;
+        double value;
+        int b;
+
+        if (minmax_leaf_box (q, timestep, fortran_order, box, box + v->ndim) == 0 &&
+            minmax_predicate_value (q, &value) == 0)
+        {
+            n = 0;
+            for (b = 0; b < minmax_nblocks (v, timestep); b++) {
+                n += minmax_leaf_block (q, timestep, b, value, fortran_order, box, box + v->ndim,
+                                        box + 2 * v->ndim, box + 3 * v->ndim);
+            }
+        }
+        free (box);
+        return n;
+    }
+
+    left = minmax_estimate_hits ((ADIOS_QUERY *) q->left, timestep, nelems);
+    right = minmax_estimate_hits ((ADIOS_QUERY *) q->right, timestep, nelems);
+    if (left < 0 || right < 0) {
+        return -1;
+    }
+    if (q->combineOp == ADIOS_QUERY_OP_AND) {
+        return (left < right ? left : right);
+    }
+    return (left + right < (int64_t) nelems ? left + right : (int64_t) nelems);
+}
+
+/*
+ * Evaluate the query at the step and set the box (C order) the hits are
+ * returned in: the output boundary, or the selection of the first clause.
+ */
+static int minmax_find_hits (ADIOS_QUERY * q, MINMAX_INTERNAL * mi, int timestep,
+                             ADIOS_SELECTION * outputBoundary)
+{
+    ADIOS_QUERY * leaf = getFirstLeaf (q);
+    int ndim = leaf->varinfo->ndim;
+    int fortran_order = futils_is_called_from_fortran ();
+    uint64_t nelems;
+
+    minmax_reset (mi);
+    if (minmax_check_variable (q) < 0) {
+        return -1;
+    }
+    minmax_inq_blocks (q);
+
+    mi->ndim = ndim;
+    mi->outStart = (uint64_t *) malloc (2 * ndim * sizeof (uint64_t));
+    mi->outCount = mi->outStart + ndim;
+    if (minmax_leaf_box (leaf, timestep, fortran_order, mi->outStart, mi->outCount) < 0) {
+        return -1;
+    }
+    nelems = minmax_box_size (ndim, mi->outCount);
+
+    if (outputBoundary && outputBoundary->type == ADIOS_SELECTION_BOUNDINGBOX) {
+        const ADIOS_SELECTION_BOUNDINGBOX_STRUCT * bb = &(outputBoundary->u.bb);
+        if (bb->ndim != ndim || minmax_box_size (ndim, bb->count) != nelems) {
+            adios_error (err_incompatible_queries,
+                         "Query %s: the output boundary does not have the %" PRIu64
+                         " elements of the query's selection\n", q->condition, nelems);
+            return -1;
+        }
+        minmax_c_order (ndim, fortran_order, bb->start, mi->outStart);
+        minmax_c_order (ndim, fortran_order, bb->count, mi->outCount);
+    } else if (outputBoundary) {
+        log_warn ("Query %s: the MINMAX method ignores points as output boundary\n", q->condition);
+    }
+
+    mi->hits = minmax_hits (q, timestep, nelems);
+    if (!mi->hits) {
+        return -1;
+    }
+    mi->nhits = query_bitmap_count (mi->hits);
+    mi->timestep = minmax_actual_step (q, timestep);
+
+    log_debug ("%s: %" PRIu64 " hits of %" PRIu64 " elements at step %d\n",
+               q->condition, mi->nhits, nelems, mi->timestep);
+    return 0;
+}
+
+// Coordinates of the next hits in the output box, in the caller's order
+static void minmax_next_points (MINMAX_INTERNAL * mi, uint64_t npoints, uint64_t * points)
+{
+    int fortran_order = futils_is_called_from_fortran ();
+    int ndim = mi->ndim;
+    uint64_t i, pos;
+    int d;
+
+    for (i = 0; i < npoints; i++) {
+        uint64_t * p = points + i * ndim;
+
+        pos = query_bitmap_next (mi->hits, mi->cursor);
+        mi->cursor = pos + 1;
+        for (d = ndim-1; d >= 0; d--) {
+            p [(fortran_order ? ndim-1-d : d)] = mi->outStart[d] + pos % mi->outCount[d];
+            pos /= mi->outCount[d];
+        }
+    }
+    mi->hitsReturned += npoints;
+}
+
+static int minmax_can_evaluate_leaves (ADIOS_QUERY * q)
+{
+    if (!q->left && !q->right) {
+        if (q->sel && q->sel->type == ADIOS_SELECTION_POINTS) {
+            return 0;
+        }
+        // varinfo is not known yet when estimate() picks the method
+        return (!q->varinfo || minmax_type_supported (q->varinfo->type));
+    }
+    return minmax_can_evaluate_leaves ((ADIOS_QUERY *) q->left) &&
+           minmax_can_evaluate_leaves ((ADIOS_QUERY *) q->right);
+}
+
+int adios_query_minmax_can_evaluate (ADIOS_QUERY * q)
+{
+    return minmax_can_evaluate_leaves (q);
+}
+
+int64_t adios_query_minmax_estimate (ADIOS_QUERY * q, int timeStep)
+{
+    MINMAX_INTERNAL * mi = minmax_internal (q);
+    ADIOS_QUERY * leaf = getFirstLeaf (q);
+    ADIOS_VARINFO * v = leaf->varinfo;
+    int64_t nelems = 0;
+    int i, d;
+
+    if (mi->refine) {
+        uint64_t * box;
+
+        if (minmax_check_variable (q) < 0) {
+            return -1;
+        }
+        minmax_inq_blocks (q);
+        box = (uint64_t *) malloc (2 * v->ndim * sizeof (uint64_t));
+        if (minmax_leaf_box (leaf, timeStep, futils_is_called_from_fortran (), box, box + v->ndim) == 0) {
+            nelems = minmax_estimate_hits (q, timeStep, minmax_box_size (v->ndim, box + v->ndim));
+        } else {
+            nelems = -1;
+        }
+        free (box);
+        return nelems;
+    }
+
+    if (minmax_prepare (q, mi, timeStep) < 0) {
+        return -1;
+    }
+    minmax_inq_blocks (q);
+
+    // every element of the candidate blocks is a possible hit
+    for (i = 0; i < mi->nblocks; i++) {
+        const ADIOS_VARBLOCK * vb = &v->blockinfo [minmax_block_index (v, mi->blocks[i], timeStep)];
+        int64_t n = 1;
+        for (d = 0; d < v->ndim; d++) {
+            n *= vb->count[d];
+        }
+        nelems += n;
+    }
+    return nelems;
+}
+
+int adios_query_minmax_evaluate (ADIOS_QUERY * q, int timeStep, uint64_t batchSize,
+                                 ADIOS_SELECTION * outputBoundary, ADIOS_SELECTION ** result)
+{
+    MINMAX_INTERNAL * mi = minmax_internal (q);
+    uint64_t * points;
+    uint64_t take;
+
+    *result = NULL;
+
+    if (!mi->refine) {
+        if (minmax_prepare (q, mi, timeStep) < 0) {
+            return -1;
+        }
+        // one candidate block per call
+        if (mi->next < mi->nblocks) {
+            *result = common_read_selection_writeblock (mi->blocks [mi->next++]);
+        }
+        return (mi->next < mi->nblocks);
+    }
+
+    if (mi->timestep != minmax_actual_step (q, timeStep) &&
+        minmax_find_hits (q, mi, timeStep, outputBoundary) < 0)
+    {
+        minmax_reset (mi);
+        return -1;
+    }
+
+    take = mi->nhits - mi->hitsReturned;
+    if (batchSize > 0 && take > batchSize) {
+        take = batchSize;
+    }
+    if (take > 0) {
+        points = (uint64_t *) malloc (take * mi->ndim * sizeof (uint64_t));
+        minmax_next_points (mi, take, points);
+        *result = common_read_selection_points (mi->ndim, take, points);
+    }
+
+    // like the other methods, further calls on the step return no points
+    return (mi->hitsReturned < mi->nhits);
+}
+
+int adios_query_minmax_free (ADIOS_QUERY * q)
+{
+    MINMAX_INTERNAL * mi = (MINMAX_INTERNAL *) q->queryInternal;
+    if (mi) {
+        minmax_reset (mi);
+        free (mi);
+        q->queryInternal = NULL;
+    }
+    return 1;
+}
+
+int adios_query_minmax_finalize ()
+{
+    return 1;
+}
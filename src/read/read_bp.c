@@ -15,6 +15,9 @@
 #include <math.h>
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "public/adios_read.h"
 #include "public/adios_error.h"
 #include "public/adios_types.h"
@@ -36,11 +39,23 @@
 static int chunk_buffer_size = 1024*1024*16;
 static int poll_interval_msec = 10000; // 10 secs by default
 static int show_hidden_attrs = 0; // don't show hidden attr by default
+static int share_footer = 0; // one copy of the raw index buffer per node, kept open for lazy_index
+static int use_bpidx = 0; // list variables from the .bpidx sidecar and decode them when used
+static int lazy_index = 0; // decode a variable's index entry when it is first used
+static int64_t coalesce_gap = 64*1024; // merge reads closer than this in perform_reads, <0: don't
+static uint64_t coalesce_max_size = 256*1024*1024; // data read ahead at once in perform_reads
+static int prefetch_depth = 0; // steps of a stream read ahead in the background, 0: none
+static uint64_t prefetch_max_size = 512*1024*1024; // data queued for prefetching at once
 
 static ADIOS_VARCHUNK * read_var_bb (const ADIOS_FILE * fp, read_request * r);
+static ADIOS_VARCHUNK * read_var_points (const ADIOS_FILE * fp, read_request * r);
 static ADIOS_VARCHUNK * read_var_wb (const ADIOS_FILE * fp, read_request * r);
 
 static int map_req_varid (const ADIOS_FILE * fp, int varid);
+static int read_from_plan (BP_PROC * p, uint32_t file_index, uint64_t offset,
+                           uint64_t size, char * buf);
+static void free_read_plan (BP_PROC * p);
+static void prefetch_stop (BP_PROC * p);
 static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int step_offset);
 
 // NCSU - For custom memory allocation
@@ -66,6 +81,8 @@ static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int st
         bp_realloc_aligned(fh->b, slice_size);      \
         fh->b->offset = 0;                          \
                                                     \
+        if (!read_from_plan (p, 0, slice_offset, slice_size, fh->b->buff)) \
+        {                                           \
         MPI_File_seek (fh->mpi_fh                   \
                       ,(MPI_Offset)slice_offset     \
                       ,MPI_SEEK_SET                 \
@@ -77,6 +94,7 @@ static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int st
                       ,MPI_BYTE                     \
                       ,&status                      \
                       );                            \
+        }                                           \
         fh->b->offset = 0;                          \
 
 // To read subfiles
@@ -85,50 +103,13 @@ static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int st
         fh->b->offset = 0;                                                                  \
                                                                                             \
         MPI_File * sfh;                                                                     \
-        sfh = get_BP_file_handle (fh->sfh                                                   \
-                                 ,v->characteristics[start_idx + idx].file_index            \
-                                 );                                                         \
+        if (!read_from_plan (p, v->characteristics[start_idx + idx].file_index,             \
+                             slice_offset, slice_size, fh->b->buff))                        \
+        {                                                                                   \
+        sfh = bp_open_subfile (fh, v->characteristics[start_idx + idx].file_index);         \
         if (!sfh)                                                                           \
         {                                                                                   \
-            int err;                                                                        \
-            char * ch, * name_no_path, * name;                                              \
-            MPI_Info info = MPI_INFO_NULL;                                                  \
-            struct BP_file_handle * new_h =                                                 \
-                  (struct BP_file_handle *) malloc (sizeof (struct BP_file_handle));        \
-            new_h->file_index = v->characteristics[start_idx + idx].file_index;             \
-            new_h->next = 0;                                                                \
-            if ( (ch = strrchr (fh->fname, '/')) )                                          \
-            {                                                                               \
-                name_no_path = (char *) malloc (strlen (ch + 1) + 1);                       \
-                strcpy (name_no_path, ch + 1);                                              \
-            }                                                                               \
-            else                                                                            \
-            {                                                                               \
-                name_no_path = (char *) malloc (strlen (fh->fname) + 1);                    \
-                strcpy (name_no_path, fh->fname);                                           \
-            }                                                                               \
-                                                                                            \
-            name = (char *) malloc (strlen (fh->fname) + 5 + strlen (name_no_path) + 1 + 10 + 1); \
-            sprintf (name, "%s.dir/%s.%d", fh->fname, name_no_path, new_h->file_index);     \
-            err = MPI_File_open (MPI_COMM_SELF                                                   \
-                                ,name                                                       \
-                                ,MPI_MODE_RDONLY                                            \
-                                ,info                                                       \
-                                ,&new_h->fh                                                 \
-                                );                                                          \
-                                                                                            \
-           if (err)                                                                         \
-           {                                                                                \
-               fprintf (stderr, "can not open file %s\n", name);                            \
-               return 0;                                                                    \
-           }                                                                                \
-           add_BP_file_handle (&fh->sfh                                                     \
-                              ,new_h                                                        \
-                              );                                                            \
-           sfh = &new_h->fh;                                                                \
-                                                                                            \
-           free (name_no_path);                                                             \
-           free (name);                                                                     \
+            return 0;                                                                       \
         }                                                                                   \
                                                                                             \
         MPI_File_seek (*sfh                                                                 \
@@ -141,6 +122,7 @@ static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int st
                       ,MPI_BYTE                                                             \
                       ,&status                                                              \
                       );                                                                    \
+        }                                                                                   \
         fh->b->offset = 0;                                                                  \
 
 //We also need to be able to read old .bp which doesn't have 'payload_offset'
@@ -179,50 +161,10 @@ static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int st
 // To read subfiles
 #define MPI_FILE_READ_OPS2_BUF(buf)                                                         \
         MPI_File * sfh;                                                                     \
-        sfh = get_BP_file_handle (fh->sfh                                                   \
-                                 ,v->characteristics[start_idx + idx].file_index            \
-                                 );                                                         \
+        sfh = bp_open_subfile (fh, v->characteristics[start_idx + idx].file_index);         \
         if (!sfh)                                                                           \
         {                                                                                   \
-            int err;                                                                        \
-            char * ch, * name_no_path, * name;                                              \
-            MPI_Info info = MPI_INFO_NULL;                                                  \
-            struct BP_file_handle * new_h =                                                 \
-                  (struct BP_file_handle *) malloc (sizeof (struct BP_file_handle));        \
-            new_h->file_index = v->characteristics[start_idx + idx].file_index;             \
-            new_h->next = 0;                                                                \
-            if ((ch = strrchr (fh->fname, '/')))                                              \
-            {                                                                               \
-                name_no_path = (char *) malloc (strlen (ch + 1) + 1);                       \
-                strcpy (name_no_path, ch + 1);                                              \
-            }                                                                               \
-            else                                                                            \
-            {                                                                               \
-                name_no_path = (char *) malloc (strlen (fh->fname) + 1);                    \
-                strcpy (name_no_path, fh->fname);                                           \
-            }                                                                               \
-                                                                                            \
-            name = (char *) malloc (strlen (fh->fname) + 5 + strlen (name_no_path) + 1 + 10 + 1); \
-            sprintf (name, "%s.dir/%s.%d", fh->fname, name_no_path, new_h->file_index);     \
-            err = MPI_File_open (MPI_COMM_SELF                                                   \
-                                ,name                                                       \
-                                ,MPI_MODE_RDONLY                                            \
-                                ,info                                                       \
-                                ,&new_h->fh                                                 \
-                                );                                                          \
-                                                                                            \
-           if (err)                                                                         \
-           {                                                                                \
-               fprintf (stderr, "can not open file %s\n", name);                            \
-               return 0;                                                                    \
-           }                                                                                \
-           add_BP_file_handle (&fh->sfh                                                     \
-                              ,new_h                                                        \
-                              );                                                            \
-           sfh = &new_h->fh;                                                                \
-                                                                                            \
-           free (name_no_path);                                                             \
-           free (name);                                                                     \
+            return 0;                                                                       \
         }                                                                                   \
                                                                                             \
         MPI_File_seek (*sfh                                                                 \
@@ -263,6 +205,34 @@ static void release_step (ADIOS_FILE *fp)
     }
 }
 
+/* Allocate a BP_FILE for bp_open(). */
+static BP_FILE * alloc_bp_file (const char * fname, MPI_Comm comm)
+{
+    BP_FILE * fh = (BP_FILE *) malloc (sizeof (BP_FILE));
+    assert (fh);
+
+    fh->fname = (fname ? strdup (fname) : 0L);
+    fh->sfh = 0;
+    fh->comm = comm;
+    fh->gvar_h = 0;
+    fh->pgs_root = 0;
+    fh->vars_root = 0;
+    fh->attrs_root = 0;
+    fh->vars_table = 0;
+    fh->share_footer = share_footer;
+    fh->use_bpidx = use_bpidx;
+    fh->lazy_index = lazy_index;
+    fh->bpidx = 0;
+    fh->vars_ref = 0;
+    fh->vars_index = 0;
+    fh->vars_undecoded = 0;
+    fh->footer_win = 0;
+    fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
+    assert (fh->b);
+
+    return fh;
+}
+
 /* This routin open a ADIOS-BP file with no timeout.
  * It first checks whether this is a valid BP file. This is done by
  * checking the validity on rank 0 and communicating to other ranks (avoiding
@@ -292,19 +262,7 @@ static BP_FILE * open_file (const char * fname, MPI_Comm comm)
         return 0;
     }
 
-    fh = (BP_FILE *) malloc (sizeof (BP_FILE));
-    assert (fh);
-
-    fh->fname = (fname ? strdup (fname) : 0L);
-    fh->sfh = 0;
-    fh->comm = comm;
-    fh->gvar_h = 0;
-    fh->pgs_root = 0;
-    fh->vars_root = 0;
-    fh->attrs_root = 0;
-    fh->vars_table = 0;
-    fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
-    assert (fh->b);
+    fh = alloc_bp_file (fname, comm);
 
     bp_open (fname, comm, fh);
 
@@ -328,6 +286,8 @@ void build_ADIOS_FILE_struct (ADIOS_FILE * fp, BP_FILE * fh)
     p->varid_mapping = 0;
     p->local_read_request_list = 0;
     p->b = 0;
+    p->read_plan = 0;
+    p->prefetch = 0;
     p->priv = 0;
 
     fp->fh = (uint64_t) p;
@@ -414,24 +374,19 @@ static int get_new_step (ADIOS_FILE * fp, const char * fname, MPI_Comm comm, int
 }
 
 /* This routine processes a read request and returns data in ADIOS_VARCHUNK.
-   If the selection type is not bounding box, convert it. The basic file reading
-   functionality is implemented in read_var_bb() routine.
+   The basic file reading functionality is implemented in read_var_bb(),
+   read_var_points() and read_var_wb() routines.
 */
 static ADIOS_VARCHUNK * read_var (const ADIOS_FILE * fp, read_request * r)
 {
     BP_PROC * p = GET_BP_PROC (fp);
     BP_FILE * fh = GET_BP_FILE (fp);
 
-    int size_of_type;
-    struct adios_index_var_struct_v1 * v;
-    uint64_t i;
-    read_request * nr;
-    ADIOS_SELECTION * sel, * nsel;
+    ADIOS_SELECTION * sel;
     ADIOS_VARCHUNK * chunk;
 
     log_debug ("read_var()\n");
     sel = r->sel;
-    v = bp_find_var_byid (fh, r->varid);
 
     switch (sel->type)
     {
@@ -439,57 +394,7 @@ static ADIOS_VARCHUNK * read_var (const ADIOS_FILE * fp, read_request * r)
             chunk = read_var_bb (fp, r);
             break;
         case ADIOS_SELECTION_POINTS:
-            /* The idea is we convert a point selection to bounding box section. */
-            size_of_type = bp_get_type_size (v->type, v->characteristics [0].value);
-            nr = (read_request *) malloc (sizeof (read_request));
-            assert (nr);
-
-            nr->varid = r->varid;
-            nr->from_steps = r->from_steps;
-            nr->nsteps = r->nsteps;
-            nr->data = r->data;
-            nr->datasize  = size_of_type;
-            nr->priv = r->priv;
-
-            nsel = (ADIOS_SELECTION *) malloc (sizeof (ADIOS_SELECTION));
-            nr->sel = nsel;
-            assert (nsel);
-
-            nsel->type = ADIOS_SELECTION_BOUNDINGBOX;
-            nsel->u.bb.ndim = sel->u.points.ndim;
-            nsel->u.bb.start = (uint64_t *) malloc (nsel->u.bb.ndim * 8);
-            nsel->u.bb.count = (uint64_t *) malloc (nsel->u.bb.ndim * 8);
-            assert (nsel->u.bb.start && nsel->u.bb.count);
-
-            for (i = 0; i < nsel->u.bb.ndim; i++)
-            {
-                nsel->u.bb.count[i] = 1;
-            }
-
-            for (i = 0; i < sel->u.points.npoints; i++)
-            {
-                memcpy (nsel->u.bb.start, sel->u.points.points + i * sel->u.points.ndim, sel->u.points.ndim * 8);
-
-                chunk = read_var_bb (fp, nr);
-                nr->data = (char *) nr->data + size_of_type; // NCSU ALACRITY-ADIOS - Potential bug here; what if nsteps > 1? Shouldn't the buffer advance by size_of_type * nsteps?
-
-                common_read_free_chunk (chunk);
-            }
-
-            free_selection (nsel);
-            free (nr);
-
-            chunk = (ADIOS_VARCHUNK *) malloc (sizeof (ADIOS_VARCHUNK));
-            assert (chunk);
-
-            chunk->varid = r->varid;
-            chunk->type = v->type;
-            // NCSU ALACRITY-ADIOS - Added timestep information into varchunks
-            chunk->from_steps = r->from_steps;
-            chunk->nsteps = r->nsteps;
-            chunk->sel = copy_selection (r->sel);
-            chunk->data = r->data;
-
+            chunk = read_var_points (fp, r);
             break;
         case ADIOS_SELECTION_WRITEBLOCK:
             chunk = read_var_wb (fp, r);
@@ -540,6 +445,11 @@ static ADIOS_VARCHUNK * read_var_bb (const ADIOS_FILE *fp, read_request * r)
     data = r->data;
 
     v = bp_find_var_byid (fh, r->varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", r->varid);
+        return NULL;
+    }
 
     /* Get dimensions and flip if caller != writer language */
     /* Note: ndim below doesn't include time if there is any */
@@ -1037,6 +947,85 @@ int adios_read_bp_init_method (MPI_Comm comm, PairStruct * params)
 
             log_debug ("show_hidden_attrs is set\n");
         }
+        else if (!strcasecmp (p->name, "share_footer"))
+        {
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+            share_footer = 1;
+
+            log_debug ("share_footer is set\n");
+#else
+            log_warn ("'share_footer' parameter of the READ_BP read method "
+                      "needs MPI-3 shared memory, ignored\n");
+#endif
+        }
+        else if (!strcasecmp (p->name, "use_bpidx"))
+        {
+            use_bpidx = 1;
+
+            log_debug ("use_bpidx is set\n");
+        }
+        else if (!strcasecmp (p->name, "lazy_index"))
+        {
+            lazy_index = 1;
+
+            log_debug ("lazy_index is set\n");
+        }
+        else if (!strcasecmp (p->name, "coalesce_gap"))
+        {
+            errno = 0;
+            int64_t gap = strtoll (p->value, NULL, 10);
+            if (!errno)
+            {
+                coalesce_gap = gap;
+                log_debug ("coalesce_gap set to %lld bytes for the read method\n", (long long) gap);
+            }
+            else
+            {
+                log_error ("Invalid 'coalesce_gap' parameter given to the read method: '%s'\n", p->value);
+            }
+        }
+        else if (!strcasecmp (p->name, "coalesce_max_size"))
+        {
+            errno = 0;
+            int64_t mb = strtoll (p->value, NULL, 10);
+            if (mb > 0 && !errno)
+            {
+                coalesce_max_size = (uint64_t) mb * 1024 * 1024;
+                log_debug ("coalesce_max_size set to %lldMB for the read method\n", (long long) mb);
+            }
+            else
+            {
+                log_error ("Invalid 'coalesce_max_size' parameter given to the read method: '%s'\n", p->value);
+            }
+        }
+        else if (!strcasecmp (p->name, "prefetch_depth"))
+        {
+            errno = 0;
+            int depth = strtol (p->value, NULL, 10);
+            if (depth >= 0 && !errno)
+            {
+                prefetch_depth = depth;
+                log_debug ("prefetch_depth set to %d steps for the read method\n", depth);
+            }
+            else
+            {
+                log_error ("Invalid 'prefetch_depth' parameter given to the read method: '%s'\n", p->value);
+            }
+        }
+        else if (!strcasecmp (p->name, "prefetch_max_size"))
+        {
+            errno = 0;
+            int64_t mb = strtoll (p->value, NULL, 10);
+            if (mb > 0 && !errno)
+            {
+                prefetch_max_size = (uint64_t) mb * 1024 * 1024;
+                log_debug ("prefetch_max_size set to %lldMB for the read method\n", (long long) mb);
+            }
+            else
+            {
+                log_error ("Invalid 'prefetch_max_size' parameter given to the read method: '%s'\n", p->value);
+            }
+        }
 
         p = p->next;
     }
@@ -1050,6 +1039,13 @@ int adios_read_bp_finalize_method ()
     chunk_buffer_size = 1024*1024*16;
     poll_interval_msec = 10000; // 10 secs by default
     show_hidden_attrs = 0; // don't show hidden attr by default
+    share_footer = 0;
+    use_bpidx = 0;
+    lazy_index = 0;
+    coalesce_gap = 64*1024;
+    coalesce_max_size = 256*1024*1024;
+    prefetch_depth = 0;
+    prefetch_max_size = 512*1024*1024;
 
     return 0;
 }
@@ -1137,19 +1133,7 @@ static int open_stream (ADIOS_FILE * fp, const char * fname,
         return err_file_not_found;
     }
 
-    fh = (BP_FILE *) malloc (sizeof (BP_FILE));
-    assert (fh);
-
-    fh->fname = (fname ? strdup (fname) : 0L);
-    fh->sfh = 0;
-    fh->comm = comm;
-    fh->gvar_h = 0;
-    fh->pgs_root = 0;
-    fh->vars_root = 0;
-    fh->attrs_root = 0;
-    fh->vars_table = 0;
-    fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
-    assert (fh->b);
+    fh = alloc_bp_file (fname, comm);
 
     p = (BP_PROC *) malloc (sizeof (BP_PROC));
     assert (p);
@@ -1158,6 +1142,8 @@ static int open_stream (ADIOS_FILE * fp, const char * fname,
     p->varid_mapping = 0;
     p->local_read_request_list = 0;
     p->b = 0;
+    p->read_plan = 0;
+    p->prefetch = 0;
     p->priv = 0;
 
     /* BP file open and gp/var/att parsing */
@@ -1209,19 +1195,7 @@ ADIOS_FILE * adios_read_bp_open_file (const char * fname, MPI_Comm comm)
 
     MPI_Comm_rank (comm, &rank);
 
-    fh = (BP_FILE *) malloc (sizeof (BP_FILE));
-    assert (fh);
-
-    fh->fname = (fname ? strdup (fname) : 0L);
-    fh->sfh = 0;
-    fh->comm = comm;
-    fh->gvar_h = 0;
-    fh->pgs_root = 0;
-    fh->vars_root = 0;
-    fh->attrs_root = 0;
-    fh->vars_table = 0;
-    fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
-    assert (fh->b);
+    fh = alloc_bp_file (fname, comm);
 
     p = (BP_PROC *) malloc (sizeof (BP_PROC));
     assert (p);
@@ -1230,6 +1204,8 @@ ADIOS_FILE * adios_read_bp_open_file (const char * fname, MPI_Comm comm)
     p->varid_mapping = 0; // maps perceived id to real id
     p->local_read_request_list = 0;
     p->b = 0;
+    p->read_plan = 0;
+    p->prefetch = 0;
     p->priv = 0;
 
     /* The ADIOS_FILE struct looks like the following */
@@ -1314,6 +1290,8 @@ int adios_read_bp_close (ADIOS_FILE * fp)
         p->local_read_request_list = 0;
     }
 
+    prefetch_stop (p);
+    free_read_plan (p);
     free (p);
 
     if (fp->var_namelist)
@@ -1508,6 +1486,13 @@ typedef struct {
 
     assert (varinfo);
 
+    var_root = bp_find_var_byid (fh, varinfo->varid);
+    if (!var_root)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varinfo->varid);
+        return adios_errno;
+    }
+
     varinfo->statistics = vs = (ADIOS_VARSTAT *) malloc (sizeof (ADIOS_VARSTAT));
     assert (vs);
 
@@ -1550,8 +1535,6 @@ typedef struct {
     int16_t map[32];
     memset (map, -1, sizeof(map));
 
-    var_root = bp_find_var_byid (fh, varinfo->varid);
-
     // Bitmap shows which statistical information has been calculated
     i = j = 0;
     while (var_root->characteristics[0].bitmap >> j)
@@ -2302,6 +2285,11 @@ static ADIOS_VARBLOCK * inq_var_blockinfo(const ADIOS_FILE * fp, const ADIOS_VAR
     // Perform variable ID mapping, since the input to this function is user-perceived
     int mapped_id = map_req_varid (fp, varinfo->varid);
     var_root = bp_find_var_byid (fh, mapped_id);
+    if (!var_root)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varinfo->varid);
+        return NULL;
+    }
 
     blockinfo = (ADIOS_VARBLOCK *) malloc (nblks * sizeof (ADIOS_VARBLOCK));
     assert (blockinfo);
@@ -2425,7 +2413,11 @@ ADIOS_TRANSINFO * adios_read_bp_inq_var_transinfo(const ADIOS_FILE *fp, const AD
     // Perform variable ID mapping, since the input to this function is user-perceived
     int mapped_id = map_req_varid (fp, vi->varid);
     var_root = bp_find_var_byid(fh, mapped_id);
-    assert(var_root);
+    if (!var_root)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", vi->varid);
+        return NULL;
+    }
 
     transinfo = malloc(sizeof(ADIOS_TRANSINFO));
 
@@ -2476,6 +2468,11 @@ int adios_read_bp_inq_var_trans_blockinfo(const ADIOS_FILE *fp, const ADIOS_VARI
     // Perform variable ID mapping, since the input to this function is user-perceived
     int mapped_id = map_req_varid (fp, vi->varid);
     var_root = bp_find_var_byid (fh, mapped_id);
+    if (!var_root)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", vi->varid);
+        return adios_errno;
+    }
 
     ti->orig_blockinfo = inq_var_blockinfo(fp, vi, 1); // 1 -> use original, pretransform dimensions
     assert(ti->orig_blockinfo);
@@ -2608,6 +2605,11 @@ int adios_read_bp_schedule_read_byid (const ADIOS_FILE * fp, const ADIOS_SELECTI
 
     mapped_varid = p->varid_mapping[varid];
     v = bp_find_var_byid (fh, mapped_varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return adios_errno;
+    }
     file_is_fortran = is_fortran_file (fh);
 
     r = (read_request *) malloc (sizeof (read_request));
@@ -2665,114 +2667,901 @@ int adios_read_bp_schedule_read_byid (const ADIOS_FILE * fp, const ADIOS_SELECTI
     return 0;
 }
 
-int adios_read_bp_perform_reads (const ADIOS_FILE *fp, int blocking)
-{
-    BP_PROC * p = GET_BP_PROC (fp);
-    read_request * r;
-    ADIOS_VARCHUNK * chunk;
+/* Coalescing of the reads in adios_read_bp_perform_reads().
+ * Before serving a group of scheduled bounding box reads, the byte ranges
+ * they need from the file are collected, sorted by offset and merged if
+ * they are closer than coalesce_gap bytes. Each merged extent is read with
+ * one call, and read_var_bb() copies its slices from these extents
+ * (read_from_plan()) instead of reading every block on its own.
+ */
+#define PLAN_MAX_EXTENT_SIZE (1024*1024*1024) // MPI_File_read takes an int count
 
-    /* 1. prepare all reads */
-    // check if all user memory is provided for blocking read
-    if (blocking)
-    {
-        r = p->local_read_request_list;
-        while (r)
-        {
-            if (!r->data)
-            {
-                adios_error (err_operation_not_supported,
-                    "Blocking mode at adios_perform_reads() requires that user "
-                    "provides the memory for each read request. Request for "
-                    "variable %d was scheduled without user-allocated memory\n",
-                    r->varid);
-                return err_operation_not_supported;
-            }
+struct read_extent
+{
+    uint32_t file_index;  // subfile index, 0 for the main file
+    uint64_t offset;
+    uint64_t size;
+    char * data;          // NULL if it could not be read
+};
 
-            r = r->next;
-        }
-    }
-    else
+struct bp_read_plan
+{
+    int nrequests;        // requests left that this plan was made for
+    int nextents;
+    int allocated;
+    struct read_extent * extents;
+};
+
+/* Add a range to the plan, unless it is too big to be read with one call;
+   read_var_bb() reads those blocks itself. Returns the bytes added. */
+static uint64_t plan_add_range (struct bp_read_plan * plan, uint32_t file_index,
+                                uint64_t offset, uint64_t size)
+{
+    if (size > PLAN_MAX_EXTENT_SIZE)
     {
         return 0;
     }
 
-    while (p->local_read_request_list)
+    if (plan->nextents == plan->allocated)
     {
-        chunk = read_var (fp, p->local_read_request_list);
-
-        // remove head from list
-        r = p->local_read_request_list;
-        p->local_read_request_list = p->local_read_request_list->next;
-        free_selection (r->sel); //common_read_selection_delete (r->sel);
-        r->sel = NULL;
-        free(r);
-
-        common_read_free_chunk (chunk);
+        plan->allocated = 2 * plan->allocated + 64;
+        plan->extents = (struct read_extent *) realloc (plan->extents,
+                            plan->allocated * sizeof (struct read_extent));
+        assert (plan->extents);
     }
 
-    return 0;
+    plan->extents[plan->nextents].file_index = file_index;
+    plan->extents[plan->nextents].offset = offset;
+    plan->extents[plan->nextents].size = size;
+    plan->extents[plan->nextents].data = 0;
+    plan->nextents++;
+
+    return size;
 }
 
-/* This routine split a 'big' request into smaller ones which can be fit into
- * buffer_size bytes of memory.
- */
-static read_request * split_req (const ADIOS_FILE * fp, const read_request * r, int buffer_size)
+/* Collect the ranges read_var_bb() will read for request r.
+   Blocks that are not in the file's index with a payload offset
+   (very old BP files) are left to read_var_bb(). Returns the bytes
+   of the ranges, which can be more than r->datasize since a range spans
+   from the first to the last byte needed from a block. */
+static uint64_t plan_request_bb (const ADIOS_FILE * fp, read_request * r, int step,
+                                 struct bp_read_plan * plan)
 {
     BP_PROC * p = GET_BP_PROC (fp);
     BP_FILE * fh = GET_BP_FILE (fp);
-
-    read_request * h = 0;
-    ADIOS_SELECTION * sel = r->sel;
     struct adios_index_var_struct_v1 * v;
-    int type_size, n_elements, ndim;
-    int i, j, varid, remain, done;
-    uint64_t pos[32], subbb[32], start[32], count[32];
+    struct adios_index_characteristic_struct_v1 * ch;
+    uint64_t start[32], count[32], ldims[32], gdims[32], offsets[32];
+    uint64_t offset_in_dset[32], size_in_dset[32];
+    uint64_t first, last, stride, lo, hi, bytes = 0;
+    int64_t start_idx, stop_idx, idx;
+    int i, t, time, ndim, dummy = -1, is_global, size_of_type, file_is_fortran;
+    uint32_t file_index;
 
-    log_debug ("split_req()\n");
-    varid = r->varid; //map_req_varid (fp, r->varid); // NCSU ALACRITY-ADIOS: Bugfix: r->varid has already been mapped
-    v = bp_find_var_byid (fh, varid);
-    type_size = bp_get_type_size (v->type, "");
-    assert (type_size);
+    v = bp_find_var_byid (fh, r->varid);
+    ndim = r->sel->u.bb.ndim;
+    if (!v || ndim > 32)
+    {
+        return 0;
+    }
 
-    n_elements = buffer_size / type_size;
+    file_is_fortran = is_fortran_file (fh);
+    size_of_type = bp_get_type_size (v->type, v->characteristics [0].value);
 
-    printf ("n_elements = %d\n", n_elements);
-    //TODO: handle string
-    if (sel->type == ADIOS_SELECTION_BOUNDINGBOX)
+    /* read_var_bb() swaps these in the selection itself, we work on a copy */
+    memcpy (start, r->sel->u.bb.start, ndim * sizeof (uint64_t));
+    memcpy (count, r->sel->u.bb.count, ndim * sizeof (uint64_t));
+    if (futils_is_called_from_fortran ())
     {
-        ndim = sel->u.bb.ndim;
-        // convert chunk size to position within the bounding box
-        for (i = ndim - 1; i > -1; i--)
-        {
-            pos[i] = n_elements % sel->u.bb.count[i];
-            assert (sel->u.bb.count[i]);
-            n_elements /= sel->u.bb.count[i];
-        }
+        swap_order (ndim, start, &dummy);
+        swap_order (ndim, count, &dummy);
+    }
 
-        log_debug ("pos = ");
-        for (i = 0; i < ndim; i++)
+    for (t = step + r->from_steps; t < step + r->from_steps + r->nsteps; t++)
+    {
+        time = (!p->streaming ? get_time (v, t) : fh->tidx_start + t);
+        start_idx = get_var_start_index (v, time);
+        stop_idx = get_var_stop_index (v, time);
+        if (start_idx < 0 || stop_idx < 0)
         {
-            log_debug_cont ("%llu ", pos[i]);
+            continue;
         }
-        log_debug_cont ("\n");
 
-        // calculate sub-bounding-box
-        for (i = ndim - 1; i > -1; i--)
+        for (idx = start_idx; idx <= stop_idx; idx++)
         {
-            if (pos[i] != sel->u.bb.count[i] - 1)
+            ch = &v->characteristics [idx];
+            if (ch->payload_offset == 0)
             {
-                j = 0;
-                while (j <= i && pos[j] == 0)
+                continue;
+            }
+            file_index = (has_subfiles (fh) ? ch->file_index : 0);
+
+            if (ndim == 0)
+            {
+                bytes += plan_add_range (plan, file_index, ch->payload_offset, size_of_type);
+                break;
+            }
+
+            is_global = bp_get_dimension_characteristics_notime (ch, ldims, gdims, offsets,
+                                                                 file_is_fortran);
+
+            /* intersection of the block and the selection */
+            for (i = 0; i < ndim; i++)
+            {
+                lo = (start[i] > offsets[i] ? start[i] : offsets[i]);
+                hi = (start[i] + count[i] < offsets[i] + ldims[i] ?
+                      start[i] + count[i] : offsets[i] + ldims[i]);
+                if (lo >= hi)
                 {
-                    subbb[j] = 0;
-                    j++;
+                    break;
                 }
+                offset_in_dset[i] = lo - offsets[i];
+                size_in_dset[i] = hi - lo;
+            }
 
-                if (j <= i)
+            if (i == ndim)
+            {
+                /* from the first to the last element needed in the block */
+                first = last = 0;
+                stride = size_of_type;
+                for (i = ndim - 1; i > -1; i--)
                 {
-                    subbb[j] = pos[j];
-                    j++;
-                    while (j <= i)
+                    first += stride * offset_in_dset[i];
+                    last += stride * (offset_in_dset[i] + size_in_dset[i] - 1);
+                    stride *= ldims[i];
+                }
+                bytes += plan_add_range (plan, file_index, ch->payload_offset + first,
+                                         last - first + size_of_type);
+            }
+
+            if (!is_global)
+            {
+                break; // read_var_bb() reads only the first block of a local array
+            }
+        }
+    }
+
+    return bytes;
+}
+
+static int compare_extents (const void * a, const void * b)
+{
+    const struct read_extent * x = (const struct read_extent *) a;
+    const struct read_extent * y = (const struct read_extent *) b;
+
+    if (x->file_index != y->file_index)
+        return (x->file_index < y->file_index ? -1 : 1);
+    if (x->offset != y->offset)
+        return (x->offset < y->offset ? -1 : 1);
+    return 0;
+}
+
+/* Plan the reads of the requests starting at r for the given step, as many
+   of them as fit into coalesce_max_size, and merge the ranges. Nothing is
+   read yet. A request is charged with the bytes of its ranges. */
+static struct bp_read_plan * collect_read_plan (const ADIOS_FILE * fp, read_request * r, int step)
+{
+    struct bp_read_plan * plan;
+    struct read_extent * e, * m;
+    uint64_t total = 0, bytes, end;
+    int i, n;
+
+    plan = (struct bp_read_plan *) calloc (1, sizeof (struct bp_read_plan));
+    assert (plan);
+
+    while (r)
+    {
+        n = plan->nextents;
+        bytes = 0;
+        if (r->sel->type == ADIOS_SELECTION_BOUNDINGBOX)
+        {
+            bytes = plan_request_bb (fp, r, step, plan);
+        }
+
+        if (total + bytes > coalesce_max_size)
+        {
+            plan->nextents = n; // drop its ranges
+            if (plan->nrequests > 0)
+            {
+                break;
+            }
+            /* a request bigger than the limit alone is read as before */
+        }
+        else
+        {
+            total += bytes;
+        }
+
+        plan->nrequests++;
+        r = r->next;
+    }
+
+    if (plan->nextents < 2)
+    {
+        return plan;
+    }
+
+    qsort (plan->extents, plan->nextents, sizeof (struct read_extent), compare_extents);
+
+    /* merge ranges in place */
+    n = 0;
+    for (i = 1; i < plan->nextents; i++)
+    {
+        m = &plan->extents[n];
+        e = &plan->extents[i];
+        end = m->offset + m->size;
+        if (e->file_index == m->file_index
+            && e->offset <= end + coalesce_gap
+            && (e->offset + e->size > end ? e->offset + e->size : end) - m->offset <= PLAN_MAX_EXTENT_SIZE)
+        {
+            if (e->offset + e->size > end)
+            {
+                m->size = e->offset + e->size - m->offset;
+            }
+        }
+        else
+        {
+            plan->extents[++n] = *e;
+        }
+    }
+    plan->nextents = n + 1;
+
+    return plan;
+}
+
+/* Plan the reads of the requests starting at r in the current step
+   and read the merged extents. */
+static struct bp_read_plan * make_read_plan (const ADIOS_FILE * fp, read_request * r)
+{
+    BP_FILE * fh = GET_BP_FILE (fp);
+    struct bp_read_plan * plan;
+    struct read_extent * e;
+    MPI_File * mfh;
+    MPI_Status status;
+    int i, count, err;
+
+    plan = collect_read_plan (fp, r, fp->current_step);
+    if (plan->nextents < 2)
+    {
+        /* nothing to merge */
+        plan->nextents = 0;
+        return plan;
+    }
+
+    log_debug ("perform_reads: %d requests read in %d extents\n",
+               plan->nrequests, plan->nextents);
+
+    for (i = 0; i < plan->nextents; i++)
+    {
+        e = &plan->extents[i];
+        mfh = (has_subfiles (fh) ? bp_open_subfile (fh, e->file_index) : &fh->mpi_fh);
+        if (!mfh)
+        {
+            continue;
+        }
+
+        e->data = (char *) malloc (e->size);
+        if (!e->data)
+        {
+            continue;
+        }
+
+        /* e->size <= PLAN_MAX_EXTENT_SIZE fits into the int count */
+        MPI_File_seek (*mfh, (MPI_Offset) e->offset, MPI_SEEK_SET);
+        err = MPI_File_read (*mfh, e->data, (int) e->size, MPI_BYTE, &status);
+        count = 0;
+        if (err == MPI_SUCCESS)
+        {
+            MPI_Get_count (&status, MPI_BYTE, &count);
+        }
+        if (err != MPI_SUCCESS || count != (int) e->size)
+        {
+            /* leave these blocks to read_var_bb() */
+            free (e->data);
+            e->data = 0;
+        }
+    }
+
+    return plan;
+}
+
+/* Copy [offset, offset+size) of a file from the read plan into buf.
+   Returns 1 if the plan has all of it, 0 if it has to be read. */
+static int read_from_plan (BP_PROC * p, uint32_t file_index, uint64_t offset,
+                           uint64_t size, char * buf)
+{
+    struct bp_read_plan * plan = p->read_plan;
+    struct read_extent key, * e;
+    int lo, hi, mid;
+
+    if (!plan || !plan->nextents)
+    {
+        return 0;
+    }
+
+    if (!has_subfiles (p->fh))
+    {
+        file_index = 0;
+    }
+
+    /* last extent starting at or before offset */
+    key.file_index = file_index;
+    key.offset = offset;
+    lo = 0;
+    hi = plan->nextents;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (compare_extents (&plan->extents[mid], &key) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+    {
+        return 0;
+    }
+
+    e = &plan->extents[lo - 1];
+    if (e->file_index != file_index || !e->data
+        || offset + size > e->offset + e->size)
+    {
+        return 0;
+    }
+
+    memcpy (buf, e->data + (offset - e->offset), size);
+    return 1;
+}
+
+static void free_plan (struct bp_read_plan * plan)
+{
+    int i;
+
+    for (i = 0; i < plan->nextents; i++)
+    {
+        free (plan->extents[i].data);
+    }
+    free (plan->extents);
+    free (plan);
+}
+
+static void free_read_plan (BP_PROC * p)
+{
+    if (p->read_plan)
+    {
+        free_plan (p->read_plan);
+        p->read_plan = 0;
+    }
+}
+
+/* Prefetching of the next steps of a stream.
+ * After the reads of a step are served in a blocking perform_reads(), the
+ * same requests are planned for the next prefetch_depth steps that are
+ * already in the file, and a background thread reads these plans' extents
+ * while the application works on the current step. When the application
+ * asks for the next step, its plan is taken over as the read plan, and
+ * the blocks it covers are copied from memory. Requests that are not the
+ * same as in the previous step simply miss the plan and are read as usual.
+ * Fewer steps are planned if their extents would make more than
+ * prefetch_max_size bytes in the queue.
+ *
+ * The thread reads with pread() on its own file descriptors so the MPI
+ * library does not need to be thread safe. Plans are identified by the
+ * time index of their step, which stays the same when the stream is
+ * re-opened to see new steps.
+ */
+struct prefetch_slot
+{
+    uint32_t time;                 // tidx_start + step the plan was made for
+    struct bp_read_plan * plan;
+    uint64_t bytes;                // size of the plan's extents
+    int state;                     // PREFETCH_QUEUED, _READING or _DONE
+    int discard;                   // free it when read, nobody wants it
+    struct prefetch_slot * next;
+};
+
+#define PREFETCH_QUEUED  0
+#define PREFETCH_READING 1
+#define PREFETCH_DONE    2
+
+struct bp_prefetch
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    char * fname;                  // to open the file and subfiles on our own
+    int has_subfiles;
+    int stop;
+    struct prefetch_slot * slots;  // in the order of their steps
+    uint64_t bytes;                // of all slots
+};
+
+/* Open the file or subfile of an extent for pread(). */
+static int prefetch_open (struct bp_prefetch * pf, uint32_t file_index)
+{
+    char * ch, * name;
+    const char * name_no_path;
+    int f;
+
+    if (!pf->has_subfiles)
+    {
+        return open (pf->fname, O_RDONLY);
+    }
+
+    /* same naming as bp_open_subfile() */
+    ch = strrchr (pf->fname, '/');
+    name_no_path = (ch ? ch + 1 : pf->fname);
+    name = (char *) malloc (strlen (pf->fname) + 5 + strlen (name_no_path) + 1 + 10 + 1);
+    sprintf (name, "%s.dir/%s.%u", pf->fname, name_no_path, file_index);
+    f = open (name, O_RDONLY);
+    free (name);
+
+    return f;
+}
+
+static void prefetch_read_plan (struct bp_prefetch * pf, struct bp_read_plan * plan)
+{
+    struct read_extent * e;
+    uint64_t done;
+    uint32_t file_index = 0;
+    ssize_t n;
+    int i, f = -1;
+
+    for (i = 0; i < plan->nextents; i++)
+    {
+        e = &plan->extents[i];
+        if (f == -1 || e->file_index != file_index)
+        {
+            if (f != -1)
+            {
+                close (f);
+            }
+            file_index = e->file_index;
+            f = prefetch_open (pf, file_index);
+        }
+        if (f == -1)
+        {
+            continue;
+        }
+
+        e->data = (char *) malloc (e->size);
+        if (!e->data)
+        {
+            continue;
+        }
+
+        done = 0;
+        while (done < e->size)
+        {
+            n = pread (f, e->data + done, e->size - done, (off_t) (e->offset + done));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            done += n;
+        }
+        if (done < e->size)
+        {
+            /* leave these blocks to read_var_bb() */
+            free (e->data);
+            e->data = 0;
+        }
+    }
+
+    if (f != -1)
+    {
+        close (f);
+    }
+}
+
+static void * prefetch_thread (void * arg)
+{
+    struct bp_prefetch * pf = (struct bp_prefetch *) arg;
+    struct prefetch_slot * s, ** prev;
+
+    pthread_mutex_lock (&pf->lock);
+    while (!pf->stop)
+    {
+        for (s = pf->slots; s && s->state != PREFETCH_QUEUED; s = s->next)
+            ;
+        if (!s)
+        {
+            pthread_cond_wait (&pf->cond, &pf->lock);
+            continue;
+        }
+
+        s->state = PREFETCH_READING;
+        pthread_mutex_unlock (&pf->lock);
+
+        prefetch_read_plan (pf, s->plan);
+
+        pthread_mutex_lock (&pf->lock);
+        s->state = PREFETCH_DONE;
+        if (s->discard)
+        {
+            for (prev = &pf->slots; *prev != s; prev = &(*prev)->next)
+                ;
+            *prev = s->next;
+            pf->bytes -= s->bytes;
+            free_plan (s->plan);
+            free (s);
+        }
+        pthread_cond_broadcast (&pf->cond);
+    }
+    pthread_mutex_unlock (&pf->lock);
+
+    return NULL;
+}
+
+static struct bp_prefetch * prefetch_start (BP_FILE * fh)
+{
+    struct bp_prefetch * pf;
+
+    pf = (struct bp_prefetch *) calloc (1, sizeof (struct bp_prefetch));
+    assert (pf);
+    pf->fname = strdup (fh->fname);
+    pf->has_subfiles = has_subfiles (fh);
+    pthread_mutex_init (&pf->lock, NULL);
+    pthread_cond_init (&pf->cond, NULL);
+
+    if (pthread_create (&pf->thread, NULL, prefetch_thread, pf))
+    {
+        log_warn ("Could not start the prefetch thread of the read method, "
+                  "steps are not prefetched\n");
+        pthread_mutex_destroy (&pf->lock);
+        pthread_cond_destroy (&pf->cond);
+        free (pf->fname);
+        free (pf);
+        return NULL;
+    }
+
+    return pf;
+}
+
+static void prefetch_stop (BP_PROC * p)
+{
+    struct bp_prefetch * pf = p->prefetch;
+    struct prefetch_slot * s;
+
+    if (!pf)
+    {
+        return;
+    }
+
+    pthread_mutex_lock (&pf->lock);
+    pf->stop = 1;
+    pthread_cond_broadcast (&pf->cond);
+    pthread_mutex_unlock (&pf->lock);
+    pthread_join (pf->thread, NULL);
+
+    while (pf->slots)
+    {
+        s = pf->slots;
+        pf->slots = s->next;
+        free_plan (s->plan);
+        free (s);
+    }
+
+    pthread_mutex_destroy (&pf->lock);
+    pthread_cond_destroy (&pf->cond);
+    free (pf->fname);
+    free (pf);
+    p->prefetch = 0;
+}
+
+/* Take the prefetched plan of the step with the given time index, waiting
+   for it to be read. Plans of earlier steps are dropped. The prefetch
+   thread frees discarded slots while we wait, so the list is scanned again
+   after each wakeup. */
+static struct bp_read_plan * prefetch_take (struct bp_prefetch * pf, uint32_t time)
+{
+    struct prefetch_slot * s, ** prev;
+    struct bp_read_plan * plan = 0;
+
+    pthread_mutex_lock (&pf->lock);
+    for (;;)
+    {
+        prev = &pf->slots;
+        while ((s = *prev) && s->time < time)
+        {
+            if (s->state == PREFETCH_READING)
+            {
+                // the prefetch thread frees it when done
+                s->discard = 1;
+                prev = &s->next;
+                continue;
+            }
+            *prev = s->next;
+            pf->bytes -= s->bytes;
+            free_plan (s->plan);
+            free (s);
+        }
+
+        if (!s || s->time != time)
+        {
+            break; // not queued
+        }
+        if (s->state == PREFETCH_DONE)
+        {
+            plan = s->plan;
+            *prev = s->next;
+            pf->bytes -= s->bytes;
+            free (s);
+            break;
+        }
+        pthread_cond_wait (&pf->cond, &pf->lock);
+    }
+    pthread_mutex_unlock (&pf->lock);
+
+    return plan;
+}
+
+/* Where the slot of a time index is or would be inserted in the list.
+   Call with the lock held. */
+static struct prefetch_slot ** prefetch_find (struct bp_prefetch * pf, uint32_t time)
+{
+    struct prefetch_slot ** prev;
+
+    for (prev = &pf->slots; *prev && (*prev)->time < time; prev = &(*prev)->next)
+        ;
+
+    return prev;
+}
+
+/* Plan the requests in list for the steps after the current one that are
+   not queued yet. The plans are returned in a list for prefetch_queue(),
+   to be queued after the requests of the current step have been served. */
+static struct prefetch_slot * prefetch_plan_next_steps (const ADIOS_FILE * fp, read_request * list)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+    BP_FILE * fh = GET_BP_FILE (fp);
+    struct bp_prefetch * pf;
+    struct prefetch_slot * s, * head = 0, ** tail = &head, ** prev;
+    struct bp_read_plan * plan;
+    uint64_t bytes, queued_bytes;
+    uint32_t time;
+    int i, step, last, queued;
+
+    if (!p->prefetch)
+    {
+        p->prefetch = prefetch_start (fh);
+        if (!p->prefetch)
+        {
+            return 0;
+        }
+    }
+    pf = p->prefetch;
+
+    last = fp->current_step + prefetch_depth;
+    if (last > fp->last_step)
+    {
+        last = fp->last_step;
+    }
+
+    for (step = fp->current_step + 1; step <= last; step++)
+    {
+        time = fh->tidx_start + step;
+
+        pthread_mutex_lock (&pf->lock);
+        prev = prefetch_find (pf, time);
+        queued = (*prev && (*prev)->time == time);
+        queued_bytes = pf->bytes;
+        pthread_mutex_unlock (&pf->lock);
+        if (queued)
+        {
+            continue;
+        }
+
+        plan = collect_read_plan (fp, list, step);
+        if (!plan->nextents)
+        {
+            free_plan (plan);
+            continue;
+        }
+
+        bytes = 0;
+        for (i = 0; i < plan->nextents; i++)
+        {
+            bytes += plan->extents[i].size;
+        }
+        for (s = head; s; s = s->next)
+        {
+            queued_bytes += s->bytes;
+        }
+        if (queued_bytes + bytes > prefetch_max_size)
+        {
+            /* the queue is full, later steps would be even further away */
+            free_plan (plan);
+            break;
+        }
+
+        s = (struct prefetch_slot *) malloc (sizeof (struct prefetch_slot));
+        assert (s);
+        s->time = time;
+        s->plan = plan;
+        s->bytes = bytes;
+        s->state = PREFETCH_QUEUED;
+        s->discard = 0;
+        s->next = 0;
+        *tail = s;
+        tail = &s->next;
+
+        log_debug ("perform_reads: prefetching %d extents of step %d\n",
+                   plan->nextents, step);
+    }
+
+    return head;
+}
+
+static void prefetch_queue (struct bp_prefetch * pf, struct prefetch_slot * slots)
+{
+    struct prefetch_slot * s, ** prev;
+
+    if (!slots)
+    {
+        return;
+    }
+
+    pthread_mutex_lock (&pf->lock);
+    while (slots)
+    {
+        s = slots;
+        slots = s->next;
+        prev = prefetch_find (pf, s->time);
+        s->next = *prev;
+        *prev = s;
+        pf->bytes += s->bytes;
+    }
+    pthread_cond_broadcast (&pf->cond);
+    pthread_mutex_unlock (&pf->lock);
+}
+
+int adios_read_bp_perform_reads (const ADIOS_FILE *fp, int blocking)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+    BP_FILE * fh = GET_BP_FILE (fp);
+    read_request * r;
+    ADIOS_VARCHUNK * chunk;
+    struct prefetch_slot * prefetched = 0;
+
+    /* 1. prepare all reads */
+    // check if all user memory is provided for blocking read
+    if (blocking)
+    {
+        r = p->local_read_request_list;
+        while (r)
+        {
+            if (!r->data)
+            {
+                adios_error (err_operation_not_supported,
+                    "Blocking mode at adios_perform_reads() requires that user "
+                    "provides the memory for each read request. Request for "
+                    "variable %d was scheduled without user-allocated memory\n",
+                    r->varid);
+                return err_operation_not_supported;
+            }
+
+            r = r->next;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (p->streaming && prefetch_depth > 0 && coalesce_gap >= 0)
+    {
+        if (p->prefetch && !p->read_plan)
+        {
+            p->read_plan = prefetch_take (p->prefetch, fh->tidx_start + fp->current_step);
+        }
+        prefetched = prefetch_plan_next_steps (fp, p->local_read_request_list);
+    }
+
+    while (p->local_read_request_list)
+    {
+        if (coalesce_gap >= 0 && !p->read_plan)
+        {
+            p->read_plan = make_read_plan (fp, p->local_read_request_list);
+        }
+
+        chunk = read_var (fp, p->local_read_request_list);
+
+        // remove head from list
+        r = p->local_read_request_list;
+        p->local_read_request_list = p->local_read_request_list->next;
+        free_selection (r->sel); //common_read_selection_delete (r->sel);
+        r->sel = NULL;
+        free(r);
+
+        common_read_free_chunk (chunk);
+
+        if (p->read_plan && --p->read_plan->nrequests == 0)
+        {
+            free_read_plan (p);
+        }
+    }
+
+    /* a prefetched plan may have been made for more requests */
+    free_read_plan (p);
+
+    if (prefetched)
+    {
+        prefetch_queue (p->prefetch, prefetched);
+    }
+
+    return 0;
+}
+
+/* This routine split a 'big' request into smaller ones which can be fit into
+ * buffer_size bytes of memory.
+ */
+static read_request * split_req (const ADIOS_FILE * fp, const read_request * r, int buffer_size)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+    BP_FILE * fh = GET_BP_FILE (fp);
+
+    read_request * h = 0;
+    ADIOS_SELECTION * sel = r->sel;
+    struct adios_index_var_struct_v1 * v;
+    int type_size, n_elements, ndim;
+    int i, j, varid, remain, done;
+    uint64_t pos[32], subbb[32], start[32], count[32];
+
+    log_debug ("split_req()\n");
+    varid = r->varid; //map_req_varid (fp, r->varid); // NCSU ALACRITY-ADIOS: Bugfix: r->varid has already been mapped
+    v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return NULL;
+    }
+    type_size = bp_get_type_size (v->type, "");
+    assert (type_size);
+
+    n_elements = buffer_size / type_size;
+
+    printf ("n_elements = %d\n", n_elements);
+    //TODO: handle string
+    if (sel->type == ADIOS_SELECTION_BOUNDINGBOX)
+    {
+        ndim = sel->u.bb.ndim;
+        // convert chunk size to position within the bounding box
+        for (i = ndim - 1; i > -1; i--)
+        {
+            pos[i] = n_elements % sel->u.bb.count[i];
+            assert (sel->u.bb.count[i]);
+            n_elements /= sel->u.bb.count[i];
+        }
+
+        log_debug ("pos = ");
+        for (i = 0; i < ndim; i++)
+        {
+            log_debug_cont ("%llu ", pos[i]);
+        }
+        log_debug_cont ("\n");
+
+        // calculate sub-bounding-box
+        for (i = ndim - 1; i > -1; i--)
+        {
+            if (pos[i] != sel->u.bb.count[i] - 1)
+            {
+                j = 0;
+                while (j <= i && pos[j] == 0)
+                {
+                    subbb[j] = 0;
+                    j++;
+                }
+
+                if (j <= i)
+                {
+                    subbb[j] = pos[j];
+                    j++;
+                    while (j <= i)
                     {
                         subbb[j] = sel->u.bb.count[j];
                         j++;
@@ -2951,6 +3740,7 @@ int adios_read_bp_check_reads (const ADIOS_FILE * fp, ADIOS_VARCHUNK ** chunk)
  */
     log_debug ("adios_read_bp_check_reads()\n");
 
+    * chunk = NULL;
     if (!p->local_read_request_list)
     {
         return 0;
@@ -3015,7 +3805,10 @@ int adios_read_bp_check_reads (const ADIOS_FILE * fp, ADIOS_VARCHUNK ** chunk)
             log_debug ("adios_read_bp_check_reads(): memory is not large enough to contain the data (%llu)\n",
                        p->local_read_request_list->datasize);
             read_request * subreqs = split_req (fp, p->local_read_request_list, chunk_buffer_size);
-            assert (subreqs);
+            if (!subreqs)
+            {
+                return adios_errno;
+            }
 
             // remove head from list
             r = p->local_read_request_list;
@@ -3206,6 +3999,14 @@ int adios_read_bp_get_attr_byid (const ADIOS_FILE * fp, int attrid, enum ADIOS_D
             return adios_errno;
         }
 
+        /* the variable may not be decoded yet (use_bpidx) */
+        i = 0;
+        for (v1 = fh->vars_root; v1 != var_root; v1 = v1->next)
+        {
+            i++;
+        }
+        bp_decode_var (fh, i);
+
         /* default values in case of error */
         *data = NULL;
         *size = 0;
@@ -3404,146 +4205,715 @@ void adios_read_bp_get_groupinfo (const ADIOS_FILE *fp, int *ngroups, char ***gr
             offset += fh->gattr_h->attr_counts_per_group[j];
         }
 
-        (* nattrs_per_group)[i] = 0;
-        for (j = 0; j < fh->gattr_h->attr_counts_per_group[i]; j++)
+        (* nattrs_per_group)[i] = 0;
+        for (j = 0; j < fh->gattr_h->attr_counts_per_group[i]; j++)
+        {
+            if (!show_hidden_attrs && strstr (fh->gattr_h->attr_namelist[offset + j], "__adios__"))
+            {
+            }
+            else
+            {
+                (* nattrs_per_group)[i] ++;
+            }
+        }
+    }
+
+    return;
+}
+
+/* Check if a variable is timed. This is solely done by checking whether
+ * a variable is tagged with time in XML.
+ */
+int adios_read_bp_is_var_timed (const ADIOS_FILE *fp, int varid)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+    BP_FILE * fh = GET_BP_FILE (fp);
+
+    struct adios_index_var_struct_v1 * v;
+    //struct adios_index_characteristic_struct_v1 ch;
+    int retval = 0, ndim, k;
+    uint64_t gdims[32];
+
+    v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return 0;
+    }
+    //ch = v->characteristics[0];
+    //ndim = ch.dims.count; //ndim possibly has 'time' dimension
+    // NCSU ALACRITY-ADIOS - An optimization. Not sure why it was originally added, but it works
+    struct adios_index_characteristic_dims_struct_v1 *dims = &v->characteristics[0].dims;
+    ndim = dims->count; //ndim possibly has 'time' dimension
+
+    log_debug ("adios_read_bp_is_var_timed: varid = %d, ndim = %d\n", varid, ndim);
+
+    if (ndim == 0)
+    {
+        return 0;
+    }
+
+    for (k = 0; k < ndim; k++)
+    {
+        // NCSU ALACRITY-ADIOS - An optimization
+        gdims[k] = dims->dims[k * 3 + 1]; //ch.dims.dims[k * 3 + 1];
+    }
+/*
+    if (is_fortran_file (fh))
+    {
+        swap_order (ndim, gdims, &dummy);
+    }
+*/
+    if (gdims[ndim - 1] == 0) // with time
+    {
+        if (v->characteristics_count <= 1) {
+            // a local array written once
+            retval = 0;
+        } else {
+            retval = 1;
+        }
+        /* FIXME: This last test tests if the last l:g:o is only an 'l'.
+           This is true for a variable over time but also
+           true for a 1D local array (which has no global dimension)
+           The characteristics_count is 1 only if the local array is written
+           from one process and only at one timestep.
+           How do we identify local arrays written from many processes?
+           And local arrays written several times?
+        */
+    }
+
+    log_debug ("%s is_var_timed: = %d\n", v->var_name, retval);
+
+    return retval;
+}
+
+static int map_req_varid (const ADIOS_FILE * fp, int varid)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+
+    return p->varid_mapping[varid];
+}
+
+/* This routine converts the write block index, which is of a particular step,
+ * to the adios internal PG index.
+ */
+static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int step_offset)
+{
+    BP_PROC * p = GET_BP_PROC (fp);
+    BP_FILE * fh = GET_BP_FILE (fp);
+
+    int time, start_idx, stop_idx, c, idx;
+    int mapped_varid, ridx;
+    struct adios_index_var_struct_v1* v;
+
+    if (r->sel->type != ADIOS_SELECTION_WRITEBLOCK)
+    {
+        return -1;
+    }
+
+    time = adios_step_to_time (fp, r->varid, r->from_steps + step_offset);
+    mapped_varid = r->varid; //map_req_varid (fp, r->varid); // NCSU ALACRITY-ADIOS: Bugfix: r->varid has already been mapped
+    v = bp_find_var_byid (fh, mapped_varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", mapped_varid);
+        return -1;
+    }
+
+    start_idx = get_var_start_index (v, time);
+    stop_idx = get_var_stop_index (v, time);
+    if (start_idx < 0 || stop_idx < 0)
+    {
+        adios_error (err_no_data_at_timestep,
+                     "No data at step %d\n",
+                     r->from_steps);
+    }
+
+    ridx =  r->sel->u.block.index;
+    c = -1;
+    idx = start_idx;
+    while (idx <= stop_idx)
+    {
+        if (v->characteristics[idx].time_index == time)
+        {
+            c++;
+        }
+
+        if (c < ridx)
+        {
+            idx++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (c != ridx)
+    {
+        log_debug ("Error in adios_wbidx_to_pgidx().\n");
+    }
+
+    return idx;
+}
+
+/* A point of a point selection while it is looked up and read: the block
+   holding it, its element offset in the block (its coordinate in the
+   slowest dimension while the points are searched), and its position
+   in the selection.
+ */
+struct point_ref
+{
+    uint64_t block;
+    uint64_t key;
+    uint64_t n;
+};
+
+#define POINT_NO_BLOCK ((uint64_t) -1)
+
+static int compare_point_refs (const void * a, const void * b)
+{
+    const struct point_ref * x = (const struct point_ref *) a;
+    const struct point_ref * y = (const struct point_ref *) b;
+
+    if (x->block != y->block)
+        return (x->block < y->block ? -1 : 1);
+    if (x->key != y->key)
+        return (x->key < y->key ? -1 : 1);
+    if (x->n != y->n)
+        return (x->n < y->n ? -1 : 1);
+    return 0;
+}
+
+/* First sorted point with a key not less than key */
+static uint64_t lower_point_ref (const struct point_ref * refs, uint64_t n, uint64_t key)
+{
+    uint64_t lo = 0, hi = n, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (refs[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The grid made by the distinct start and end offsets of the blocks of a
+   step along each dimension. Each block covers whole cells of it, so the
+   block of a point is found with one binary search per dimension. A cell
+   covered by overlapping blocks belongs to the last one, as in read_var_bb().
+ */
+struct point_grid
+{
+    int ndim;
+    uint64_t nbounds[32];
+    uint64_t * bounds[32];
+    uint64_t * cells;       // block of each cell, POINT_NO_BLOCK if none
+};
+
+static int compare_uint64 (const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+/* First of n sorted values greater than x */
+static uint64_t upper_uint64 (const uint64_t * values, uint64_t n, uint64_t x)
+{
+    uint64_t lo = 0, hi = n, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (values[mid] <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void point_grid_free (struct point_grid * g)
+{
+    int j;
+
+    for (j = 0; j < g->ndim; j++)
+    {
+        free (g->bounds[j]);
+    }
+    free (g->cells);
+}
+
+/* Build the grid of nblocks blocks (offsets and counts, ndim values each).
+   Returns 1 if it would have more than max_cells cells, which irregular
+   decompositions can have, or on memory allocation failure.
+ */
+static int point_grid_build (struct point_grid * g, int ndim, uint64_t nblocks,
+                             const uint64_t * boffsets, const uint64_t * bcounts,
+                             uint64_t max_cells)
+{
+    uint64_t ncells = 1, b, c, n, lin;
+    uint64_t lo[32], hi[32], pos[32];
+    int j;
+
+    memset (g, 0, sizeof (struct point_grid));
+    g->ndim = ndim;
+
+    for (j = 0; j < ndim; j++)
+    {
+        g->bounds[j] = (uint64_t *) malloc (2 * nblocks * sizeof (uint64_t));
+        if (!g->bounds[j])
+        {
+            point_grid_free (g);
+            return 1;
+        }
+        for (b = 0; b < nblocks; b++)
+        {
+            g->bounds[j][2*b] = boffsets[b*ndim + j];
+            g->bounds[j][2*b+1] = boffsets[b*ndim + j] + bcounts[b*ndim + j];
+        }
+        qsort (g->bounds[j], 2 * nblocks, sizeof (uint64_t), compare_uint64);
+        for (n = 1, c = 1; c < 2 * nblocks; c++)
+        {
+            if (g->bounds[j][c] != g->bounds[j][n-1])
+            {
+                g->bounds[j][n++] = g->bounds[j][c];
+            }
+        }
+        g->nbounds[j] = n;
+
+        if (n < 2 || ncells * (n - 1) > max_cells)
+        {
+            point_grid_free (g);
+            return 1;
+        }
+        ncells *= n - 1;
+    }
+
+    g->cells = (uint64_t *) malloc (ncells * sizeof (uint64_t));
+    if (!g->cells)
+    {
+        point_grid_free (g);
+        return 1;
+    }
+    for (c = 0; c < ncells; c++)
+    {
+        g->cells[c] = POINT_NO_BLOCK;
+    }
+
+    for (b = 0; b < nblocks; b++)
+    {
+        /* the cells [lo, hi) of the block in each dimension */
+        for (j = 0; j < ndim; j++)
+        {
+            lo[j] = upper_uint64 (g->bounds[j], g->nbounds[j], boffsets[b*ndim + j]) - 1;
+            hi[j] = upper_uint64 (g->bounds[j], g->nbounds[j],
+                                  boffsets[b*ndim + j] + bcounts[b*ndim + j]) - 1;
+            if (lo[j] >= hi[j])
+            {
+                break;
+            }
+            pos[j] = lo[j];
+        }
+        if (j < ndim)
+        {
+            continue; // empty block
+        }
+
+        for (;;)
         {
-            if (!show_hidden_attrs && strstr (fh->gattr_h->attr_namelist[offset + j], "__adios__"))
+            lin = 0;
+            for (j = 0; j < ndim; j++)
             {
+                lin = lin * (g->nbounds[j] - 1) + pos[j];
             }
-            else
+            g->cells[lin] = b;
+
+            for (j = ndim - 1; j >= 0; j--)
             {
-                (* nattrs_per_group)[i] ++;
+                if (++pos[j] < hi[j])
+                {
+                    break;
+                }
+                pos[j] = lo[j];
+            }
+            if (j < 0)
+            {
+                break;
             }
         }
     }
+    return 0;
+}
 
-    return;
+/* Element offset of a point in a block */
+static uint64_t point_offset_in_block (int ndim, const uint64_t * pt,
+                                       const uint64_t * boffsets, const uint64_t * bcounts)
+{
+    uint64_t elem = 0;
+    int j;
+
+    for (j = 0; j < ndim; j++)
+    {
+        elem = elem * bcounts[j] + (pt[j] - boffsets[j]);
+    }
+    return elem;
 }
 
-/* Check if a variable is timed. This is solely done by checking whether
- * a variable is tagged with time in XML.
+static uint64_t point_grid_find (const struct point_grid * g, const uint64_t * pt)
+{
+    uint64_t lin = 0, c;
+    int j;
+
+    for (j = 0; j < g->ndim; j++)
+    {
+        c = upper_uint64 (g->bounds[j], g->nbounds[j], pt[j]);
+        if (c == 0 || c == g->nbounds[j])
+        {
+            return POINT_NO_BLOCK;
+        }
+        lin = lin * (g->nbounds[j] - 1) + (c - 1);
+    }
+    return g->cells[lin];
+}
+
+/* This routine reads in data for point selection.
+   The points are looked up in the blocks of a step at once (in the grid of
+   the block boundaries, see struct point_grid), grouped by
+   block and sorted by their offset in the block, and points close to each
+   other in the file are read with one read (see coalesce_gap). Points in
+   no block are left untouched, and if blocks overlap the last one is read,
+   as in read_var_bb(). The data of each step holds the points in the order
+   of the selection, one step after the other.
  */
-int adios_read_bp_is_var_timed (const ADIOS_FILE *fp, int varid)
+static ADIOS_VARCHUNK * read_var_points (const ADIOS_FILE * fp, read_request * r)
 {
     BP_PROC * p = GET_BP_PROC (fp);
     BP_FILE * fh = GET_BP_FILE (fp);
 
+    ADIOS_SELECTION * sel;
     struct adios_index_var_struct_v1 * v;
-    //struct adios_index_characteristic_struct_v1 ch;
-    int retval = 0, ndim, k;
-    uint64_t gdims[32];
+    int j, t, time, nsteps;
+    int64_t start_idx, stop_idx, idx;
+    int ndim, has_subfile, file_is_fortran, is_global, size_of_type;
+    int dummy = -1;
+    uint64_t * dims, * points, * pt, tmpcount;
+    uint64_t ldims[32], gdims[32], offsets[32];
+    uint64_t npoints, k, m, lo, hi, first, nfound, base, gap, max_slice, nblocks, b;
+    uint64_t slice_offset, slice_size;
+    uint64_t * boffsets, * bcounts;
+    struct point_grid grid;
+    struct point_ref * sorted, * found;
+    char * data;
+    MPI_Status status;
+    ADIOS_VARCHUNK * chunk;
+    struct adios_var_header_struct_v1 var_header;
 
-    v = bp_find_var_byid (fh, varid);
-    //ch = v->characteristics[0];
-    //ndim = ch.dims.count; //ndim possibly has 'time' dimension
-    // NCSU ALACRITY-ADIOS - An optimization. Not sure why it was originally added, but it works
-    struct adios_index_characteristic_dims_struct_v1 *dims = &v->characteristics[0].dims;
-    ndim = dims->count; //ndim possibly has 'time' dimension
+    file_is_fortran = is_fortran_file (fh);
+    has_subfile = has_subfiles (fh);
 
-    log_debug ("adios_read_bp_is_var_timed: varid = %d, ndim = %d\n", varid, ndim);
+    sel = r->sel;
+    npoints = sel->u.points.npoints;
+    data = (char *) r->data;
+    gap = (coalesce_gap > 0 ? (uint64_t) coalesce_gap : 0);
+    // MPI_File_read takes an int count
+    max_slice = (coalesce_max_size < PLAN_MAX_EXTENT_SIZE ? coalesce_max_size : PLAN_MAX_EXTENT_SIZE);
 
-    if (ndim == 0)
+    v = bp_find_var_byid (fh, r->varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", r->varid);
+        return NULL;
+    }
+
+    /* Note: ndim below doesn't include time if there is any */
+    bp_get_and_swap_dimensions (fp, v, file_is_fortran, &ndim, &dims, &nsteps, file_is_fortran);
+    free (dims);
+
+    assert (ndim == sel->u.points.ndim);
+
+    size_of_type = bp_get_type_size (v->type, v->characteristics [0].value);
+
+    points = (uint64_t *) malloc (npoints * ndim * sizeof (uint64_t) + 1);
+    sorted = (struct point_ref *) malloc (npoints * sizeof (struct point_ref) + 1);
+    found = (struct point_ref *) malloc (npoints * sizeof (struct point_ref) + 1);
+    if (!points || !sorted || !found)
     {
+        adios_error (err_no_memory, "Could not allocate memory for reading %llu points "
+                     "of variable %s\n", npoints, v->var_name);
+        free (points);
+        free (sorted);
+        free (found);
         return 0;
     }
 
-    for (k = 0; k < ndim; k++)
+    /* Fortran reader gives the coordinates in Fortran order, swap them
+       in a copy to keep the selection of the caller intact */
+    memcpy (points, sel->u.points.points, npoints * ndim * sizeof (uint64_t));
+    if (futils_is_called_from_fortran ())
     {
-        // NCSU ALACRITY-ADIOS - An optimization
-        gdims[k] = dims->dims[k * 3 + 1]; //ch.dims.dims[k * 3 + 1];
+        for (k = 0; k < npoints; k++)
+        {
+            swap_order (ndim, points + k * ndim, &dummy);
+        }
     }
-/*
-    if (is_fortran_file (fh))
+
+    /* sorted by the slowest dimension to find the points of a block quickly */
+    for (k = 0; k < npoints; k++)
     {
-        swap_order (ndim, gdims, &dummy);
+        sorted[k].block = 0;
+        sorted[k].key = (ndim > 0 ? points[k * ndim] : 0);
+        sorted[k].n = k;
     }
-*/
-    if (gdims[ndim - 1] == 0) // with time
+    qsort (sorted, npoints, sizeof (struct point_ref), compare_point_refs);
+
+    /* Note fp->current_step is always 0 for file mode. */
+    for (t = fp->current_step + r->from_steps; t < fp->current_step + r->from_steps + r->nsteps; t++)
     {
-        if (v->characteristics_count <= 1) {
-            // a local array written once
-            retval = 0;
-        } else {
-            retval = 1;
+        if (!p->streaming)
+        {
+            time = get_time (v, t);
+        }
+        else
+        {
+            time = fh->tidx_start + t;
         }
-        /* FIXME: This last test tests if the last l:g:o is only an 'l'.
-           This is true for a variable over time but also
-           true for a 1D local array (which has no global dimension)
-           The characteristics_count is 1 only if the local array is written
-           from one process and only at one timestep.
-           How do we identify local arrays written from many processes?
-           And local arrays written several times?
-        */
-    }
 
-    log_debug ("%s is_var_timed: = %d\n", v->var_name, retval);
+        start_idx = get_var_start_index (v, time);
+        stop_idx = get_var_stop_index (v, time);
 
-    return retval;
-}
+        if (start_idx < 0 || stop_idx < 0)
+        {
+            adios_error (err_no_data_at_timestep,"Variable %s has no data at %d time step\n",
+                         v->var_name, t);
+            data += npoints * size_of_type;
+            continue;
+        }
 
-static int map_req_varid (const ADIOS_FILE * fp, int varid)
-{
-    BP_PROC * p = GET_BP_PROC (fp);
+        /* dimensions of the blocks of the step */
+        nblocks = stop_idx - start_idx + 1;
+        boffsets = (uint64_t *) malloc (nblocks * ndim * sizeof (uint64_t) + 1);
+        bcounts = (uint64_t *) malloc (nblocks * ndim * sizeof (uint64_t) + 1);
+        if (!boffsets || !bcounts)
+        {
+            adios_error (err_no_memory, "Could not allocate memory for reading %llu points "
+                         "of variable %s\n", npoints, v->var_name);
+            free (boffsets);
+            free (bcounts);
+            free (points);
+            free (sorted);
+            free (found);
+            return 0;
+        }
 
-    return p->varid_mapping[varid];
-}
+        for (idx = 0; idx < nblocks; idx++)
+        {
+            is_global = bp_get_dimension_characteristics_notime (&(v->characteristics[start_idx + idx]),
+                                                                 ldims, gdims, offsets, file_is_fortran);
+            if (!is_global)
+            {
+                // we use gdims below, which is 0 for a local array; set to ldims here
+                for (j = 0; j < ndim; j++)
+                {
+                    gdims[j] = ldims[j];
+                }
+                // we need to read only the first PG, not all
+                nblocks = 1;
+            }
+            memcpy (boffsets + idx * ndim, offsets, ndim * sizeof (uint64_t));
+            memcpy (bcounts + idx * ndim, ldims, ndim * sizeof (uint64_t));
 
-/* This routine converts the write block index, which is of a particular step,
- * to the adios internal PG index.
- */
-static int adios_wbidx_to_pgidx (const ADIOS_FILE * fp, read_request * r, int step_offset)
-{
-    BP_PROC * p = GET_BP_PROC (fp);
-    BP_FILE * fh = GET_BP_FILE (fp);
+            if (idx == 0)
+            {
+                for (k = 0; k < npoints; k++)
+                {
+                    pt = points + k * ndim;
+                    for (j = 0; j < ndim; j++)
+                    {
+                        if (pt[j] >= gdims[j])
+                        {
+                            adios_error (err_out_of_bound, "Error: Variable (id=%d) out of bound ("
+                                "point %llu is at index %llu in dimension %d"
+                                " but the actual data is [0,%llu])\n",
+                                r->varid, k, pt[j], j + 1, gdims[j] - 1);
+                            free (boffsets);
+                            free (bcounts);
+                            free (points);
+                            free (sorted);
+                            free (found);
+                            return 0;
+                        }
+                    }
+                }
+            }
+        }
 
-    int time, start_idx, stop_idx, c, idx;
-    int mapped_varid, ridx;
-    struct adios_index_var_struct_v1* v;
+        /* find the block of each point */
+        for (k = 0; k < npoints; k++)
+        {
+            found[k].block = POINT_NO_BLOCK;
+        }
 
-    if (r->sel->type != ADIOS_SELECTION_WRITEBLOCK)
-    {
-        return -1;
-    }
+        if (ndim > 0 && !point_grid_build (&grid, ndim, nblocks, boffsets, bcounts,
+                                           16 * nblocks + npoints))
+        {
+            for (k = 0; k < npoints; k++)
+            {
+                pt = points + k * ndim;
+                b = point_grid_find (&grid, pt);
+                if (b != POINT_NO_BLOCK)
+                {
+                    found[k].block = b;
+                    found[k].key = point_offset_in_block (ndim, pt, boffsets + b * ndim,
+                                                          bcounts + b * ndim);
+                }
+            }
+            point_grid_free (&grid);
+        }
+        else
+        {
+            /* too irregular for a grid: search the points of each block
+               among the ones sorted by the slowest dimension */
+            for (idx = 0; idx < nblocks; idx++)
+            {
+                const uint64_t * boff = boffsets + idx * ndim;
+                const uint64_t * bcnt = bcounts + idx * ndim;
 
-    time = adios_step_to_time (fp, r->varid, r->from_steps + step_offset);
-    mapped_varid = r->varid; //map_req_varid (fp, r->varid); // NCSU ALACRITY-ADIOS: Bugfix: r->varid has already been mapped
-    v = bp_find_var_byid (fh, mapped_varid);
+                if (ndim > 0)
+                {
+                    lo = lower_point_ref (sorted, npoints, boff[0]);
+                    hi = lower_point_ref (sorted, npoints, boff[0] + bcnt[0]);
+                }
+                else
+                {
+                    lo = 0;
+                    hi = npoints;
+                }
 
-    start_idx = get_var_start_index (v, time);
-    stop_idx = get_var_stop_index (v, time);
-    if (start_idx < 0 || stop_idx < 0)
-    {
-        adios_error (err_no_data_at_timestep,
-                     "No data at step %d\n",
-                     r->from_steps);
-    }
+                for (k = lo; k < hi; k++)
+                {
+                    pt = points + sorted[k].n * ndim;
+                    for (j = 0; j < ndim; j++)
+                    {
+                        if (pt[j] < boff[j] || pt[j] >= boff[j] + bcnt[j])
+                        {
+                            break;
+                        }
+                    }
 
-    ridx =  r->sel->u.block.index;
-    c = -1;
-    idx = start_idx;
-    while (idx <= stop_idx)
-    {
-        if (v->characteristics[idx].time_index == time)
-        {
-            c++;
+                    if (j == ndim)
+                    {
+                        found[sorted[k].n].block = idx;
+                        found[sorted[k].n].key = point_offset_in_block (ndim, pt, boff, bcnt);
+                    }
+                }
+            }
         }
+        free (boffsets);
+        free (bcounts);
 
-        if (c < ridx)
+        /* group the points by block, in the order of the data in the block */
+        nfound = 0;
+        for (k = 0; k < npoints; k++)
         {
-            idx++;
+            if (found[k].block != POINT_NO_BLOCK)
+            {
+                found[nfound].block = found[k].block;
+                found[nfound].key = found[k].key;
+                found[nfound].n = k;
+                nfound++;
+            }
         }
-        else
+        qsort (found, nfound, sizeof (struct point_ref), compare_point_refs);
+
+        k = 0;
+        while (k < nfound)
         {
-            break;
+            idx = found[k].block;
+
+            if (v->characteristics[start_idx + idx].payload_offset > 0)
+            {
+                /* read the points close to each other at once */
+                first = k;
+                base = found[k].key;
+                for (m = k + 1; m < nfound && found[m].block == idx; m++)
+                {
+                    if ((found[m].key - found[m - 1].key) * size_of_type > gap + size_of_type
+                        || (found[m].key - base + 1) * size_of_type > max_slice)
+                    {
+                        break;
+                    }
+                }
+
+                slice_offset = v->characteristics[start_idx + idx].payload_offset
+                             + base * size_of_type;
+                slice_size = (found[m - 1].key - base + 1) * size_of_type;
+
+                if (!has_subfile)
+                {
+                    MPI_FILE_READ_OPS1
+                }
+                else
+                {
+                    MPI_FILE_READ_OPS2
+                }
+
+                for (; k < m; k++)
+                {
+                    memcpy (data + found[k].n * size_of_type,
+                            fh->b->buff + (found[k].key - base) * size_of_type,
+                            size_of_type);
+                }
+                k = first;
+            }
+            else
+            {
+                /* old file without payload offsets, the whole block is read */
+                slice_offset = 0;
+                MPI_FILE_READ_OPS3
+
+                for (m = k; m < nfound && found[m].block == idx; m++)
+                {
+                    memcpy (data + found[m].n * size_of_type,
+                            fh->b->buff + fh->b->offset + found[m].key * size_of_type,
+                            size_of_type);
+                }
+            }
+
+            if (fh->mfooter.change_endianness == adios_flag_yes)
+            {
+                for (; k < m; k++)
+                {
+                    change_endianness (data + found[k].n * size_of_type, size_of_type, v->type);
+                }
+            }
+            k = m;
         }
-    }
 
-    if (c != ridx)
-    {
-        log_debug ("Error in adios_wbidx_to_pgidx().\n");
+        data += npoints * size_of_type;
     }
 
-    return idx;
+    free (points);
+    free (sorted);
+    free (found);
+
+    chunk = (ADIOS_VARCHUNK *) malloc (sizeof (ADIOS_VARCHUNK));
+    assert (chunk);
+
+    chunk->varid = r->varid;
+    chunk->type = v->type;
+    // NCSU ALACRITY-ADIOS - Added timestep information into varchunks
+    chunk->from_steps = r->from_steps;
+    chunk->nsteps = r->nsteps;
+    chunk->sel = copy_selection (r->sel);
+    chunk->data = r->data;
+
+    return chunk;
 }
 
 /* This routine reads a write block. The 'index' value in the selection is
@@ -3572,6 +4942,11 @@ static ADIOS_VARCHUNK * read_var_wb (const ADIOS_FILE * fp, read_request * r)
     data = r->data;
     varid = r->varid; //varid = map_req_varid (fp, r->varid); // NCSU ALACRITY-ADIOS: Bugfix: r->varid has already been mapped
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return NULL;
+    }
 
     // NCSU ALACRITY-ADIOS: Add support for absolute PG index for efficiency
     //time = adios_step_to_time (fp, r->varid, r->from_steps);
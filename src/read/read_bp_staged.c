@@ -218,6 +218,12 @@ static void get_data_addr (const ADIOS_FILE * fp, int varid,
 
     file_is_fortran = is_fortran_file (fh);
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        * payload_size = 0;
+        return;
+    }
 
     /* Get dimensions and flip if caller != writer language */
     bp_get_and_swap_dimensions (fp, v, file_is_fortran,
@@ -643,6 +649,11 @@ static read_request * split_read_requests (const ADIOS_FILE * fp, read_request *
     count = r->sel->u.bb.count;
     file_is_fortran = is_fortran_file (fh);
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return NULL;
+    }
 
     bp_get_and_swap_dimensions (fp, v, file_is_fortran,
                                 &ndim, &dims, &nsteps,
@@ -1149,6 +1160,11 @@ static void read_buffer (const ADIOS_FILE * fp,
 
     varid = r->varid;
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return;
+    }
     data = r->data;
     start = r->sel->u.bb.start;
     count = r->sel->u.bb.count;
@@ -2152,6 +2168,14 @@ ADIOS_FILE * adios_read_bp_staged_open_file (const char * fname, MPI_Comm comm)
     fh->vars_root = 0;
     fh->attrs_root = 0;
     fh->vars_table = 0;
+    fh->share_footer = 0;
+    fh->use_bpidx = 0;
+    fh->lazy_index = 0;
+    fh->bpidx = 0;
+    fh->vars_ref = 0;
+    fh->vars_index = 0;
+    fh->vars_undecoded = 0;
+    fh->footer_win = 0;
     fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
     assert (fh->b);
     adios_buffer_struct_init (fh->b);
@@ -2163,6 +2187,8 @@ ADIOS_FILE * adios_read_bp_staged_open_file (const char * fname, MPI_Comm comm)
     p->varid_mapping = 0; // maps perceived id to real id
     p->local_read_request_list = 0;
     p->b = 0;
+    p->read_plan = 0;
+    p->prefetch = 0;
     p->priv = 0;
     init_read (p);
 
@@ -2543,6 +2569,11 @@ int adios_read_bp_staged_is_var_timed (const ADIOS_FILE *fp, int varid)
     fh = (BP_FILE *) p->fh;
 
     v = bp_find_var_byid (fh, varid);
+    if (!v)
+    {
+        adios_error (err_invalid_varid, "Invalid variable id %d\n", varid);
+        return 0;
+    }
     ch = v->characteristics[0];
     ndim = ch.dims.count; //ndim possibly has 'time' dimension
 
@@ -4073,6 +4073,13 @@ ADIOS_FILE * adios_read_bp_staged1_fopen (const char * fname, MPI_Comm comm)
     fh->pgs_root = 0;
     fh->vars_root = 0;
     fh->attrs_root = 0;
+    fh->use_bpidx = 0;
+    fh->lazy_index = 0;
+    fh->bpidx = 0;
+    fh->vars_ref = 0;
+    fh->vars_index = 0;
+    fh->vars_undecoded = 0;
+    fh->footer_win = 0;
     fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
     assert (fh->b);
 
@@ -4286,6 +4293,9 @@ int adios_read_bp_staged1_fclose (ADIOS_FILE *fp)
         free(vr);
     }
 
+    if (fh->vars_ref)
+        free (fh->vars_ref);
+
     /* Free attributes structures */
     /* alloc in bp_utils.c bp_parse_attrs() */
 
@@ -295,6 +295,8 @@ int adios_transform_alacrity_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(alacrity)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(alacrity)
@@ -191,6 +191,8 @@ int adios_transform_aplod_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(aplod)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(aplod)
@@ -0,0 +1,54 @@
+/*
+ * adios_transform_auto_common.h
+ *
+ * Layout of the "auto" transform, shared by both sides.
+ *
+ * The auto transform picks a codec for each block: it compresses a sample
+ * of the block with every candidate codec and keeps the one giving the
+ * smallest output at the required throughput, or stores the block as is
+ * when no codec is worth it. The chosen codec and its own metadata are
+ * kept in the metadata of the block, and the codec's plugin does the
+ * actual work on both sides.
+ *
+ * Metadata:
+ *   uint8_t  codec (AUTO_CODEC_*)
+ *   uint16_t length of the codec's metadata
+ *   the codec's metadata
+ */
+
+#ifndef ADIOS_TRANSFORM_AUTO_COMMON_H_
+#define ADIOS_TRANSFORM_AUTO_COMMON_H_
+
+#include <stdint.h>
+#include "core/transforms/plugindetect/detect_plugin_types.h"
+
+// metadata offsets
+#define AUTO_META_CODEC      0
+#define AUTO_META_INNER_LEN  1
+#define AUTO_META_HDR_SIZE   3
+
+// codec numbers stored in the metadata, do not renumber
+enum AUTO_CODEC {
+    AUTO_CODEC_RAW   = 0,
+    AUTO_CODEC_LZ4   = 1,
+    AUTO_CODEC_ZSTD  = 2,
+    AUTO_CODEC_ZLIB  = 3,
+    AUTO_CODEC_BZIP2 = 4,
+    AUTO_NCODECS
+};
+
+/* Transform plugin doing the work of a codec, the raw data is read as is */
+static inline enum ADIOS_TRANSFORM_TYPE auto_codec_transform_type (int codec)
+{
+    switch (codec)
+    {
+        case AUTO_CODEC_RAW:   return adios_transform_identity;
+        case AUTO_CODEC_LZ4:   return adios_transform_lz4;
+        case AUTO_CODEC_ZSTD:  return adios_transform_zstd;
+        case AUTO_CODEC_ZLIB:  return adios_transform_zlib;
+        case AUTO_CODEC_BZIP2: return adios_transform_bzip2;
+        default:               return adios_transform_unknown;
+    }
+}
+
+#endif /* ADIOS_TRANSFORM_AUTO_COMMON_H_ */
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "adios_transform_auto_common.h"
+
+int adios_transform_auto_is_implemented (void) {return 1;}
+
+/*
+ * The metadata of a block as the chosen codec wrote it, in place of the
+ * auto metadata while the codec's plugin works on the block.
+ */
+struct codec_view
+{
+    enum ADIOS_TRANSFORM_TYPE type;
+    const void *auto_meta;
+    uint16_t auto_meta_len;
+};
+
+static int enter_codec(adios_transform_pg_read_request *pg_reqgroup, struct codec_view *view)
+{
+    const char *meta = (const char *)pg_reqgroup->transform_metadata;
+    uint8_t codec;
+    uint16_t inner_len;
+
+    if (!meta || pg_reqgroup->transform_metadata_len < AUTO_META_HDR_SIZE)
+    {
+        adios_error(err_invalid_transform_type, "auto transform: block %d has no codec recorded\n",
+                    pg_reqgroup->blockidx);
+        return 0;
+    }
+    memcpy(&codec, meta + AUTO_META_CODEC, sizeof(uint8_t));
+    memcpy(&inner_len, meta + AUTO_META_INNER_LEN, sizeof(uint16_t));
+
+    view->type = auto_codec_transform_type(codec);
+    if (view->type == adios_transform_unknown ||
+        AUTO_META_HDR_SIZE + inner_len > pg_reqgroup->transform_metadata_len)
+    {
+        adios_error(err_invalid_transform_type, "auto transform: block %d has an unknown codec (%d)\n",
+                    pg_reqgroup->blockidx, (int)codec);
+        return 0;
+    }
+
+    view->auto_meta = pg_reqgroup->transform_metadata;
+    view->auto_meta_len = pg_reqgroup->transform_metadata_len;
+    pg_reqgroup->transform_metadata = meta + AUTO_META_HDR_SIZE;
+    pg_reqgroup->transform_metadata_len = inner_len;
+    return 1;
+}
+
+static void leave_codec(adios_transform_pg_read_request *pg_reqgroup, const struct codec_view *view)
+{
+    pg_reqgroup->transform_metadata = view->auto_meta;
+    pg_reqgroup->transform_metadata_len = view->auto_meta_len;
+}
+
+int adios_transform_auto_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                   adios_transform_pg_read_request *pg_reqgroup)
+{
+    struct codec_view view;
+    int rtn;
+
+    if (!enter_codec(pg_reqgroup, &view))
+        return adios_errno;
+    rtn = TRANSFORM_READ_METHODS[view.type].transform_generate_read_subrequests(reqgroup, pg_reqgroup);
+    leave_codec(pg_reqgroup, &view);
+    return rtn;
+}
+
+adios_datablock * adios_transform_auto_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                            adios_transform_pg_read_request *pg_reqgroup,
+                                                            adios_transform_raw_read_request *completed_subreq)
+{
+    struct codec_view view;
+    adios_datablock *db;
+
+    if (!enter_codec(pg_reqgroup, &view))
+        return NULL;
+    db = TRANSFORM_READ_METHODS[view.type].transform_subrequest_completed(reqgroup, pg_reqgroup, completed_subreq);
+    leave_codec(pg_reqgroup, &view);
+    return db;
+}
+
+adios_datablock * adios_transform_auto_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                             adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    struct codec_view view;
+    adios_datablock *db;
+
+    if (!enter_codec(completed_pg_reqgroup, &view))
+        return NULL;
+    db = TRANSFORM_READ_METHODS[view.type].transform_pg_reqgroup_completed(reqgroup, completed_pg_reqgroup);
+    leave_codec(completed_pg_reqgroup, &view);
+    return db;
+}
+
+// The codecs return each block when its PG read completes, nothing is left at the end
+adios_datablock * adios_transform_auto_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+
+#include "core/adios_logger.h"
+#include "core/util.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_specparse.h"
+#include "adios_transform_auto_common.h"
+
+#define AUTO_DEFAULT_SAMPLE_SIZE (64 * 1024)  // bytes compressed with each candidate
+#define AUTO_SAMPLE_SLICES       8            // taken from this many places of the block
+#define AUTO_DEFAULT_MIN_RATIO   1.1          // below this, the block is stored as is
+
+static const char *codec_names[AUTO_NCODECS] = { "raw", "lz4", "zstd", "zlib", "bzip2" };
+
+/* Codecs compiled in, only these can be candidates */
+static int codec_available(int codec)
+{
+    switch (codec)
+    {
+#ifdef LZ4
+        case AUTO_CODEC_LZ4: return 1;
+#endif
+#ifdef ZSTD
+        case AUTO_CODEC_ZSTD: return 1;
+#endif
+#ifdef ZLIB
+        case AUTO_CODEC_ZLIB: return 1;
+#endif
+#ifdef BZIP2
+        case AUTO_CODEC_BZIP2: return 1;
+#endif
+        default: return 0;
+    }
+}
+
+struct auto_params
+{
+    int candidate[AUTO_NCODECS];
+    const char *level[AUTO_NCODECS];    // NULL for the codec's default
+    double min_rate;                    // MB/s a codec must reach on the sample, 0 for any
+    double min_ratio;                   // compression ratio a codec must reach on the sample
+    uint64_t sample_size;
+    const char *chunk;                  // passed on to the codecs
+    const char *threads;
+};
+
+/*
+ * Parameters: the candidate codecs, optionally with a level (e.g.
+ * transform="auto:zstd=5,lz4"), all available codecs if none is listed;
+ * rate=<MB/s>, the compression throughput a codec must reach;
+ * minratio=<r>, the ratio a codec must reach to be used at all;
+ * sample=<KB>, the size of the sample tried; chunk and threads, passed on.
+ * Problems are reported if warn is set, once per variable rather than per block.
+ */
+static void parse_params(const struct adios_transform_spec *spec, struct auto_params *p, int warn)
+{
+    int i, c, listed = 0;
+
+    memset(p, 0, sizeof(struct auto_params));
+    p->min_ratio = AUTO_DEFAULT_MIN_RATIO;
+    p->sample_size = AUTO_DEFAULT_SAMPLE_SIZE;
+
+    for (i = 0; i < spec->param_count; i++)
+    {
+        const struct adios_transform_spec_kv_pair *param = &spec->params[i];
+
+        for (c = AUTO_CODEC_RAW + 1; c < AUTO_NCODECS; c++)
+        {
+            if (!strcasecmp(param->key, codec_names[c]))
+                break;
+        }
+
+        if (c < AUTO_NCODECS)
+        {
+            listed = 1;
+            if (codec_available(c))
+            {
+                p->candidate[c] = 1;
+                p->level[c] = param->value;
+            }
+            else if (warn)
+            {
+                log_warn("auto transform: %s is not available in this build of ADIOS, not trying it\n", param->key);
+            }
+        }
+        else if (!strcasecmp(param->key, "rate") && param->value)
+        {
+            p->min_rate = atof(param->value);
+        }
+        else if (!strcasecmp(param->key, "minratio") && param->value)
+        {
+            p->min_ratio = atof(param->value);
+        }
+        else if (!strcasecmp(param->key, "sample") && param->value)
+        {
+            long long kb = atoll(param->value);
+            if (kb > 0)
+                p->sample_size = (uint64_t)kb * 1024;
+            else if (warn)
+                log_warn("auto transform: invalid sample size '%s' KB, using the default\n", param->value);
+        }
+        else if (!strcasecmp(param->key, "chunk"))
+        {
+            p->chunk = param->value;
+        }
+        else if (!strcasecmp(param->key, "threads"))
+        {
+            p->threads = param->value;
+        }
+        else if (warn)
+        {
+            log_warn("auto transform: unknown parameter '%s'\n", param->key);
+        }
+    }
+
+    if (!listed)
+    {
+        for (c = AUTO_CODEC_RAW + 1; c < AUTO_NCODECS; c++)
+            p->candidate[c] = codec_available(c);
+    }
+}
+
+/*
+ * Spec of a candidate codec, with the shuffle stage of the auto spec. Level
+ * 0 is the default level of all the codecs, and it has to be there for the
+ * codecs taking the first parameter as the level.
+ */
+static void codec_spec(const struct auto_params *p, int codec,
+                       const struct adios_transform_spec *auto_spec,
+                       struct adios_transform_spec *spec)
+{
+    char str[256];
+    int n;
+
+    n = snprintf(str, sizeof(str), "%s:%s", codec_names[codec], p->level[codec] ? p->level[codec] : "0");
+    if (p->chunk && n < (int)sizeof(str))
+        n += snprintf(str + n, sizeof(str) - n, ",chunk=%s", p->chunk);
+    if (p->threads && n < (int)sizeof(str))
+        n += snprintf(str + n, sizeof(str) - n, ",threads=%s", p->threads);
+
+    memset(spec, 0, sizeof(struct adios_transform_spec));
+    adios_transform_parse_spec(str, spec);
+    spec->shuffle = auto_spec->shuffle;
+}
+
+uint16_t adios_transform_auto_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    // metadata: codec (uint8_t) + length of the codec's metadata (uint16_t)
+    //           + room for the largest metadata of the candidates
+    struct auto_params params;
+    struct adios_transform_spec spec;
+    uint16_t max_len = 0;
+    int c;
+
+    parse_params(transform_spec, &params, 1);
+    for (c = AUTO_CODEC_RAW + 1; c < AUTO_NCODECS; c++)
+    {
+        if (!params.candidate[c])
+            continue;
+        codec_spec(&params, c, transform_spec, &spec);
+        uint16_t len = TRANSFORM_WRITE_METHODS[auto_codec_transform_type(c)].transform_get_metadata_size(&spec);
+        if (len > max_len)
+            max_len = len;
+        adios_transform_clear_spec(&spec);
+    }
+    return AUTO_META_HDR_SIZE + max_len;
+}
+
+void adios_transform_auto_transformed_size_growth(
+		const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+		uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    // The worst of the candidates, the raw data does not grow
+    struct auto_params params;
+    struct adios_transform_spec spec;
+    int c;
+
+    parse_params(transform_spec, &params, 0);
+    for (c = AUTO_CODEC_RAW + 1; c < AUTO_NCODECS; c++)
+    {
+        uint64_t cf = 0, cap = 0;
+        double lf = 1, clf = 0;
+
+        if (!params.candidate[c])
+            continue;
+        codec_spec(&params, c, transform_spec, &spec);
+        TRANSFORM_WRITE_METHODS[auto_codec_transform_type(c)].transform_transformed_size_growth(
+                var, &spec, &cf, &lf, &clf, &cap);
+        adios_transform_clear_spec(&spec);
+
+        if (cf > *constant_factor) *constant_factor = cf;
+        if (lf > *linear_factor) *linear_factor = lf;
+        if (clf > *capped_linear_factor) *capped_linear_factor = clf;
+        if (cap > *capped_linear_cap) *capped_linear_cap = cap;
+    }
+}
+
+/*
+ * Copy the sample of the block to compress with the candidates: the whole
+ * block if it is small, else AUTO_SAMPLE_SLICES slices spread over it, each
+ * a multiple of 8 elements so that the shuffle stage sees whole groups.
+ */
+static uint64_t take_sample(const char *data, uint64_t size, int elem_size,
+                            uint64_t sample_size, char *sample)
+{
+    uint64_t group = 8 * (uint64_t)elem_size;
+    uint64_t slice, stride, i;
+
+    if (size <= sample_size)
+    {
+        memcpy(sample, data, size);
+        return size;
+    }
+    slice = sample_size / AUTO_SAMPLE_SLICES / group * group;
+    if (slice == 0)
+    {
+        memcpy(sample, data, sample_size);
+        return sample_size;
+    }
+
+    stride = (size - slice) / (AUTO_SAMPLE_SLICES - 1) / elem_size * elem_size;
+    for (i = 0; i < AUTO_SAMPLE_SLICES; i++)
+        memcpy(sample + i * slice, data + i * stride, slice);
+    return AUTO_SAMPLE_SLICES * slice;
+}
+
+/* Compress the sample with a codec, the compressed length and the time it took */
+static int try_codec(struct adios_file_struct *fd, const struct adios_var_struct *var,
+                     enum ADIOS_TRANSFORM_TYPE type, struct adios_transform_spec *spec,
+                     char *sample, uint64_t sample_len, int elem_size,
+                     uint64_t *compressed_len, double *seconds)
+{
+    struct adios_var_struct tmp = *var;
+    struct adios_dimension_struct dim;
+    int wrote_to_shared_buffer = 0;
+    double start;
+    int rtn;
+
+    memset(&dim, 0, sizeof(dim));
+    dim.dimension.rank = sample_len / elem_size;
+
+    tmp.transform_type = type;
+    tmp.transform_spec = spec;
+    tmp.pre_transform_dimensions = &dim;
+    tmp.data = sample;
+    tmp.transform_metadata_len = TRANSFORM_WRITE_METHODS[type].transform_get_metadata_size(spec);
+    tmp.transform_metadata = malloc(tmp.transform_metadata_len + 1);
+    if (!tmp.transform_metadata)
+        return 0;
+
+    start = adios_gettime();
+    rtn = TRANSFORM_WRITE_METHODS[type].transform_apply(fd, &tmp, compressed_len, 0, &wrote_to_shared_buffer);
+    *seconds = adios_gettime() - start;
+
+    if (tmp.data != sample)
+        free(tmp.data);
+    free(tmp.transform_metadata);
+    return rtn;
+}
+
+int adios_transform_auto_apply(struct adios_file_struct *fd,
+                               struct adios_var_struct *var,
+                               uint64_t *transformed_len,
+                               int use_shared_buffer,
+                               int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for the auto transform type
+    assert(var->transform_type == adios_transform_auto);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    int elem_size = (int)adios_get_type_size(var->pre_transform_type, NULL);
+    if (elem_size < 1)
+        elem_size = 1;
+
+    struct auto_params params;
+    parse_params(var->transform_spec, &params, 0);
+
+    // compress a sample with each candidate, keep the smallest output of the
+    // ones fast enough, if it is small enough to be worth it
+    int best = AUTO_CODEC_RAW;
+    uint64_t sample_len = 0;
+    char *sample = NULL;
+    if (input_size > 0)
+        sample = malloc(input_size < params.sample_size ? input_size : params.sample_size);
+    if (sample)
+    {
+        sample_len = take_sample((const char *)var->data, input_size, elem_size, params.sample_size, sample);
+
+        double best_len = sample_len / params.min_ratio;
+        int c;
+        for (c = AUTO_CODEC_RAW + 1; c < AUTO_NCODECS; c++)
+        {
+            struct adios_transform_spec spec;
+            uint64_t compressed_len = 0;
+            double seconds = 0, rate;
+
+            if (!params.candidate[c])
+                continue;
+            codec_spec(&params, c, var->transform_spec, &spec);
+            if (try_codec(fd, var, auto_codec_transform_type(c), &spec, sample, sample_len, elem_size,
+                          &compressed_len, &seconds))
+            {
+                rate = seconds > 0 ? sample_len / seconds / (1024 * 1024) : 0;
+                log_debug("auto transform: %s: sample of %llu bytes to %llu, %.1f MB/s\n",
+                          codec_names[c], (unsigned long long)sample_len, (unsigned long long)compressed_len, rate);
+                if ((params.min_rate <= 0 || seconds <= 0 || rate >= params.min_rate) &&
+                    compressed_len < best_len)
+                {
+                    best = c;
+                    best_len = compressed_len;
+                }
+            }
+            adios_transform_clear_spec(&spec);
+        }
+        free(sample);
+    }
+    log_debug("auto transform: %s for block of %s (%llu bytes)\n",
+              codec_names[best], var->name, (unsigned long long)input_size);
+
+    char *meta = (char *)var->transform_metadata;
+    uint16_t inner_len = 0;
+    int rtn = 1;
+
+    if (best == AUTO_CODEC_RAW)
+    {
+        // Just use what is already in var->data, as the identity transform
+        *transformed_len = input_size;
+        *wrote_to_shared_buffer = 0;
+    }
+    else
+    {
+        // let the codec do the block, with its metadata after ours
+        struct adios_transform_spec spec;
+        enum ADIOS_TRANSFORM_TYPE type = auto_codec_transform_type(best);
+        enum ADIOS_TRANSFORM_TYPE auto_type = var->transform_type;
+        struct adios_transform_spec *auto_spec = var->transform_spec;
+        void *auto_meta = var->transform_metadata;
+        uint16_t auto_meta_len = var->transform_metadata_len;
+
+        codec_spec(&params, best, auto_spec, &spec);
+        inner_len = TRANSFORM_WRITE_METHODS[type].transform_get_metadata_size(&spec);
+        assert(AUTO_META_HDR_SIZE + inner_len <= auto_meta_len);
+
+        var->transform_type = type;
+        var->transform_spec = &spec;
+        var->transform_metadata = meta + AUTO_META_HDR_SIZE;
+        var->transform_metadata_len = inner_len;
+
+        rtn = TRANSFORM_WRITE_METHODS[type].transform_apply(fd, var, transformed_len, use_shared_buffer, wrote_to_shared_buffer);
+
+        var->transform_type = auto_type;
+        var->transform_spec = auto_spec;
+        var->transform_metadata = auto_meta;
+        var->transform_metadata_len = auto_meta_len;
+        adios_transform_clear_spec(&spec);
+    }
+
+    // record the choice
+    if (meta && var->transform_metadata_len >= AUTO_META_HDR_SIZE)
+    {
+        uint8_t codec = (uint8_t)best;
+        memcpy(meta + AUTO_META_CODEC, &codec, sizeof(uint8_t));
+        memcpy(meta + AUTO_META_INNER_LEN, &inner_len, sizeof(uint16_t));
+        memset(meta + AUTO_META_HDR_SIZE + inner_len, 0,
+               var->transform_metadata_len - AUTO_META_HDR_SIZE - inner_len);
+    }
+
+    return rtn;
+}
+
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(auto)
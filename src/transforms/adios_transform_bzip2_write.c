@@ -9,6 +9,8 @@
 #include "core/transforms/adios_transforms_write.h"
 #include "core/transforms/adios_transforms_hooks_write.h"
 #include "core/transforms/adios_transforms_util.h"
+#include "core/transforms/adios_transforms_chunked.h"
+#include "core/transforms/adios_transforms_shuffle.h"
 
 #ifdef BZIP2
 
@@ -42,16 +44,39 @@ int compress_bzip2_pre_allocated(const void* input_data,
     return 0;
 }
 
+static int compress_bzip2_chunk(const void* input_data, uint64_t input_len,
+                                void* output_data, uint64_t* output_len, void* arg)
+{
+    return compress_bzip2_pre_allocated(input_data, input_len, output_data, output_len, *(int*)arg);
+}
+
 uint16_t adios_transform_bzip2_get_metadata_size(struct adios_transform_spec *transform_spec)
 {
-    return (sizeof(uint64_t) + sizeof(char));    // metadata: original data size (uint64_t) + compression succ flag (char)
+    uint64_t chunk_size;
+    int nthreads;
+    adios_transform_chunked_parse_spec(transform_spec, &chunk_size, &nthreads);
+
+    // metadata: original data size (uint64_t) + compression succ flag (char)
+    // [+ sub-chunk size (uint64_t), 0 if the block was compressed as one stream]
+    // [+ shuffle stage (ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE)]
+    if (transform_spec->shuffle != adios_transform_shuffle_none)
+        return (2 * sizeof(uint64_t) + sizeof(char) + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE);
+    return (sizeof(uint64_t) + sizeof(char) + (chunk_size ? sizeof(uint64_t) : 0));
 }
 
 void adios_transform_bzip2_transformed_size_growth(
 		const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
 		uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
 {
-	// Do nothing (defaults to "no transform effect on data size")
+    uint64_t chunk_size;
+    int nthreads;
+    adios_transform_chunked_parse_spec(transform_spec, &chunk_size, &nthreads);
+
+    // Chunked data may grow by its offset table, otherwise no effect on data size
+    if (chunk_size) {
+        *constant_factor = sizeof(uint64_t);
+        *linear_factor = 1.0 + (double)sizeof(uint64_t) / chunk_size;
+    }
 }
 
 int adios_transform_bzip2_apply(struct adios_file_struct *fd,
@@ -85,8 +110,24 @@ int adios_transform_bzip2_apply(struct adios_file_struct *fd,
     }
 
 
+    // large blocks are compressed in sub-chunks if the spec asks for it
+    uint64_t chunk_size;
+    int nthreads;
+    adios_transform_chunked_parse_spec(var->transform_spec, &chunk_size, &nthreads);
+
+    // shuffle the data (each sub-chunk on its own) before compressing it if asked for
+    struct adios_transform_shuffle_stage shuffle = {
+        var->transform_spec->shuffle, adios_get_type_size(var->pre_transform_type, NULL),
+        compress_bzip2_chunk, &compress_level
+    };
+    chunk_size = adios_transform_shuffle_align_chunk(&shuffle, chunk_size);
+    if (input_size <= chunk_size)
+        chunk_size = 0;
+
     // decide the output buffer
     uint64_t output_size = input_size; //adios_transform_bzip2_calc_vars_transformed_size(adios_transform_bzip2, input_size, 1);
+    if (chunk_size)
+        output_size = adios_transform_chunked_bound(input_size, chunk_size); // and the offset table
     void* output_buff = NULL;
 
     if (use_shared_buffer)    // If shared buffer is permitted, serialize to there
@@ -115,7 +156,13 @@ int adios_transform_bzip2_apply(struct adios_file_struct *fd,
     uint64_t actual_output_size = output_size;
     char compress_ok = 1;
 
-    int rtn = compress_bzip2_pre_allocated(input_buff, input_size, output_buff, &actual_output_size, compress_level);
+    int rtn;
+    if (chunk_size)
+        rtn = adios_transform_chunked_compress(input_buff, input_size, chunk_size, nthreads,
+                                               adios_transform_shuffle_compress, &shuffle,
+                                               output_buff, &actual_output_size);
+    else
+        rtn = adios_transform_shuffle_compress(input_buff, input_size, output_buff, &actual_output_size, &shuffle);
 
     if(0 != rtn                     // compression failed for some reason, then just copy the buffer
         || actual_output_size > input_size)  // or size after compression is even larger (not likely to happen since compression lib will return non-zero in this case)
@@ -143,6 +190,10 @@ int adios_transform_bzip2_apply(struct adios_file_struct *fd,
     {
         memcpy((char*)var->transform_metadata, &input_size, sizeof(uint64_t));
         memcpy((char*)var->transform_metadata + sizeof(uint64_t), &compress_ok, sizeof(char));
+        if (var->transform_metadata_len >= 2 * sizeof(uint64_t) + sizeof(char))
+            memcpy((char*)var->transform_metadata + sizeof(uint64_t) + sizeof(char), &chunk_size, sizeof(uint64_t));
+        if (var->transform_metadata_len >= 2 * sizeof(uint64_t) + sizeof(char) + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE)
+            adios_transform_shuffle_write_metadata(&shuffle, var->transform_metadata, 2 * sizeof(uint64_t) + sizeof(char));
     }
 
     *transformed_len = actual_output_size; // Return the size of the data buffer
@@ -150,6 +201,8 @@ int adios_transform_bzip2_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(bzip2)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(bzip2)
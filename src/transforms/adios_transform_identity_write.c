@@ -35,3 +35,5 @@ int adios_transform_identity_apply(struct adios_file_struct *fd, struct adios_va
     *wrote_to_shared_buffer = 0;
     return 1;
 }
+
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(identity)
@@ -184,6 +184,8 @@ int adios_transform_isobar_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(isobar)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(isobar)
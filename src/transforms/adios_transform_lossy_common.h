@@ -0,0 +1,77 @@
+/*
+ * adios_transform_lossy_common.h
+ *
+ * Layout and predictor of the error-bounded lossy transform, shared by
+ * both sides.
+ *
+ * Each value of a float or double block is predicted from its already
+ * decoded neighbors (Lorenzo predictor over the last 3 dimensions), and
+ * the prediction error is quantized in steps of 2*eb, so the decoded value
+ * is within eb of the original. Values that cannot be quantized this way
+ * (too far from the prediction, NaN, Inf) get code 0 and are stored as is.
+ * The codes are Huffman coded.
+ *
+ * Transformed data:
+ *   header (LOSSY_HDR_SIZE bytes, offsets below)
+ *   nsyms x (uint16_t symbol, uint8_t code length), canonical code order
+ *   Huffman coded codes, nbits bits, MSB first
+ *   noutliers unpredictable values, in order
+ */
+
+#ifndef ADIOS_TRANSFORM_LOSSY_COMMON_H_
+#define ADIOS_TRANSFORM_LOSSY_COMMON_H_
+
+#include <stdint.h>
+
+// metadata offsets
+#define LOSSY_META_ORIG_SIZE 0   // uint64_t, original data size
+#define LOSSY_META_OK        8   // char, compression succeeded
+#define LOSSY_META_EB        9   // double, absolute error bound used
+#define LOSSY_META_SIZE      17
+
+// data header offsets
+#define LOSSY_HDR_DIMS       0   // 3 x uint64_t, prediction dimensions, slowest first
+#define LOSSY_HDR_EB         24  // double, absolute error bound
+#define LOSSY_HDR_NOUTLIERS  32  // uint64_t, number of unpredictable values
+#define LOSSY_HDR_NBITS      40  // uint64_t, length of the coded codes in bits
+#define LOSSY_HDR_NSYMS      48  // uint32_t, entries in the code table
+#define LOSSY_HDR_SIZE       52
+
+#define LOSSY_SYM_ENTRY_SIZE 3
+
+#define LOSSY_RADIUS         32768   // codes are 1 .. 2*radius-1
+#define LOSSY_NSYMS          (2 * LOSSY_RADIUS)
+#define LOSSY_MAX_CODE_LEN   24
+
+/*
+ * Lorenzo prediction of r[i][j][k] from its decoded neighbors, the ones
+ * outside the block count as 0. si and sj are the strides of i and j.
+ */
+#define LOSSY_DEFINE_PREDICT(T) \
+static inline double lossy_predict_##T (const T * r, uint64_t i, uint64_t j, uint64_t k, \
+                                        uint64_t si, uint64_t sj) \
+{ \
+    const T * p = r + i * si + j * sj + k; \
+    double pred = 0; \
+    if (k) pred += p[-1]; \
+    if (j) pred += p[-(int64_t) sj]; \
+    if (i) pred += p[-(int64_t) si]; \
+    if (j && k) pred -= p[-(int64_t) sj - 1]; \
+    if (i && k) pred -= p[-(int64_t) si - 1]; \
+    if (i && j) pred -= p[-(int64_t) (si + sj)]; \
+    if (i && j && k) pred += p[-(int64_t) (si + sj) - 1]; \
+    return pred; \
+}
+
+LOSSY_DEFINE_PREDICT(float)
+LOSSY_DEFINE_PREDICT(double)
+
+#undef LOSSY_DEFINE_PREDICT
+
+/* Decoded value of code (1 .. 2*radius-1) */
+static inline double lossy_reconstruct (double pred, double eb, uint16_t code)
+{
+    return pred + 2 * eb * (double) ((int) code - LOSSY_RADIUS);
+}
+
+#endif /* ADIOS_TRANSFORM_LOSSY_COMMON_H_ */
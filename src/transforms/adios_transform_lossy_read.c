@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "core/util.h"
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+#include "adios_transform_lossy_common.h"
+
+int adios_transform_lossy_is_implemented (void) {return 1;}
+
+// Canonical Huffman decoding table
+struct huffman_table
+{
+    uint32_t count[LOSSY_MAX_CODE_LEN + 1];   // codes of each length
+    uint16_t syms[LOSSY_NSYMS];               // symbols in canonical order
+};
+
+// Bit reader, MSB first
+struct bit_reader
+{
+    const unsigned char *in;
+    uint64_t pos;       // in bits
+    uint64_t nbits;
+};
+
+/* Next symbol, or -1 if the stream is corrupted */
+static int decode_symbol(const struct huffman_table *h, struct bit_reader *r)
+{
+    int64_t code = 0, first = 0, index = 0;
+    int len;
+
+    for (len = 1; len <= LOSSY_MAX_CODE_LEN; len++)
+    {
+        int64_t count = h->count[len];
+        if (r->pos >= r->nbits)
+            return -1;
+        code |= (r->in[r->pos >> 3] >> (7 - (r->pos & 7))) & 1;
+        r->pos++;
+        if (code - count < first)
+            return h->syms[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+#define LOSSY_DEFINE_DECODE(T) \
+static int decode_##T (const struct huffman_table *h, struct bit_reader *r, \
+                       const T *outliers, uint64_t noutliers, \
+                       const uint64_t dims[3], double eb, T *out) \
+{ \
+    const uint64_t sj = dims[2], si = dims[1] * dims[2]; \
+    uint64_t i, j, k, idx = 0, o = 0; \
+    for (i = 0; i < dims[0]; i++) \
+    for (j = 0; j < dims[1]; j++) \
+    for (k = 0; k < dims[2]; k++, idx++) \
+    { \
+        int code = decode_symbol (h, r); \
+        if (code < 0) \
+            return -1; \
+        if (code == 0) \
+        { \
+            if (o == noutliers) \
+                return -1; \
+            memcpy (&out[idx], &outliers[o++], sizeof(T)); \
+        } \
+        else \
+        { \
+            out[idx] = (T) lossy_reconstruct (lossy_predict_##T (out, i, j, k, si, sj), eb, (uint16_t) code); \
+        } \
+    } \
+    return 0; \
+}
+
+LOSSY_DEFINE_DECODE(float)
+LOSSY_DEFINE_DECODE(double)
+
+#undef LOSSY_DEFINE_DECODE
+
+/* Decompress the transformed data of n values of elem_size bytes */
+static int decompress_lossy(const void *input, uint64_t input_len, int elem_size,
+                            void *output, uint64_t n)
+{
+    const unsigned char *in = (const unsigned char *) input;
+    uint64_t dims[3], noutliers, nbits, i;
+    uint32_t nsyms;
+    double eb;
+    struct huffman_table *h;
+    struct bit_reader r;
+    int rtn;
+
+    if (input_len < LOSSY_HDR_SIZE)
+        return -1;
+    memcpy(dims, in + LOSSY_HDR_DIMS, 3 * sizeof(uint64_t));
+    memcpy(&eb, in + LOSSY_HDR_EB, sizeof(double));
+    memcpy(&noutliers, in + LOSSY_HDR_NOUTLIERS, sizeof(uint64_t));
+    memcpy(&nbits, in + LOSSY_HDR_NBITS, sizeof(uint64_t));
+    memcpy(&nsyms, in + LOSSY_HDR_NSYMS, sizeof(uint32_t));
+
+    if (dims[0] * dims[1] * dims[2] != n || nsyms > LOSSY_NSYMS || noutliers > n ||
+        LOSSY_HDR_SIZE + (uint64_t) nsyms * LOSSY_SYM_ENTRY_SIZE + (nbits + 7) / 8 + noutliers * elem_size > input_len)
+    {
+        log_error("lossy transform: corrupted header of compressed data\n");
+        return -1;
+    }
+
+    h = (struct huffman_table *) calloc(1, sizeof(struct huffman_table));
+    if (!h)
+        return -1;
+    in += LOSSY_HDR_SIZE;
+    for (i = 0; i < nsyms; i++)
+    {
+        uint8_t len = in[2];
+        memcpy(&h->syms[i], in, sizeof(uint16_t));
+        if (len == 0 || len > LOSSY_MAX_CODE_LEN)
+        {
+            free(h);
+            return -1;
+        }
+        h->count[len]++;
+        in += LOSSY_SYM_ENTRY_SIZE;
+    }
+
+    r.in = in;
+    r.pos = 0;
+    r.nbits = nbits;
+    in += (nbits + 7) / 8;
+
+    // the outliers are copied out one by one, they may not be aligned
+    if (elem_size == sizeof(double))
+        rtn = decode_double(h, &r, (const double *) in, noutliers, dims, eb, (double *) output);
+    else
+        rtn = decode_float(h, &r, (const float *) in, noutliers, dims, eb, (float *) output);
+
+    free(h);
+    if (rtn)
+        log_error("lossy transform: corrupted compressed data\n");
+    return rtn;
+}
+
+int adios_transform_lossy_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                    adios_transform_pg_read_request *pg_reqgroup)
+{
+    void *buf = malloc(pg_reqgroup->raw_var_length);
+    assert(buf);
+    adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_lossy_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                             adios_transform_pg_read_request *pg_reqgroup,
+                                                             adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+adios_datablock * adios_transform_lossy_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                              adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    uint64_t compressed_size = (uint64_t)completed_pg_reqgroup->raw_var_length;
+    void* compressed_data = completed_pg_reqgroup->subreqs->data;
+    char compress_ok = *((char*)completed_pg_reqgroup->transform_metadata + LOSSY_META_OK);
+
+    int elem_size = (int) adios_get_type_size(reqgroup->transinfo->orig_type, "");
+    uint64_t uncompressed_size = elem_size;
+    int d = 0;
+    for(d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+    {
+        uncompressed_size *= (uint64_t)(completed_pg_reqgroup->orig_varblock->count[d]);
+    }
+
+    void* uncompressed_data = malloc(uncompressed_size);
+    if(!uncompressed_data)
+    {
+        return NULL;
+    }
+
+    if(compress_ok == 1)    // compression is successful
+    {
+        int rtn = -1;
+        if (elem_size == sizeof(double) || elem_size == sizeof(float))
+            rtn = decompress_lossy(compressed_data, compressed_size, elem_size,
+                                   uncompressed_data, uncompressed_size / elem_size);
+        if(0 != rtn)
+        {
+            free(uncompressed_data);
+            return NULL;
+        }
+    }
+    else    // just copy the buffer since data is not compressed
+    {
+        memcpy(uncompressed_data, compressed_data, compressed_size);
+    }
+
+    return adios_datablock_new_whole_pg(reqgroup, completed_pg_reqgroup, uncompressed_data);
+}
+
+adios_datablock * adios_transform_lossy_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
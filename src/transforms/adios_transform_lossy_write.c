@@ -0,0 +1,517 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <assert.h>
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_util.h"
+#include "adios_transform_lossy_common.h"
+
+#define LOSSY_DEFAULT_REL 1e-4
+
+// Error bound parameters from the transform spec, 0 if not given
+struct lossy_params
+{
+    double abs;
+    double rel;     // relative to the value range of the block
+};
+
+static void parse_params(const struct adios_transform_spec *spec, struct lossy_params *p)
+{
+    int i;
+
+    p->abs = 0;
+    p->rel = 0;
+    for (i = 0; i < spec->param_count; i++)
+    {
+        const struct adios_transform_spec_kv_pair *param = &spec->params[i];
+        if (!param->value)
+            continue;
+
+        if (!strcasecmp(param->key, "abs"))
+            p->abs = atof(param->value);
+        else if (!strcasecmp(param->key, "rel"))
+            p->rel = atof(param->value);
+        else
+            continue;
+
+        if (!(atof(param->value) > 0))
+            log_warn("lossy transform: invalid error bound %s=%s, ignoring it\n", param->key, param->value);
+    }
+    if (!(p->abs > 0)) p->abs = 0;
+    if (!(p->rel > 0)) p->rel = 0;
+    if (p->abs == 0 && p->rel == 0)
+        p->rel = LOSSY_DEFAULT_REL;
+}
+
+/*
+ * Dimensions to predict along: the local dimensions of the block, slowest
+ * first, the leading ones folded into the first of 3. Falls back to one
+ * dimension if they do not add up to n values.
+ */
+static void get_dims(const struct adios_file_struct *fd, const struct adios_var_struct *var,
+                     uint64_t n, uint64_t dims[3])
+{
+    uint64_t ldims[32];
+    int ndims = 0, i;
+    struct adios_dimension_struct *d;
+
+    for (d = var->pre_transform_dimensions; d && ndims < 32; d = d->next)
+    {
+        if (d->dimension.time_index == adios_flag_yes)
+            continue;
+        ldims[ndims++] = adios_get_dim_value(&d->dimension);
+    }
+
+    // Fortran order lists the fastest dimension first
+    if (fd->group->adios_host_language_fortran == adios_flag_yes)
+    {
+        for (i = 0; i < ndims / 2; i++)
+        {
+            uint64_t t = ldims[i];
+            ldims[i] = ldims[ndims - 1 - i];
+            ldims[ndims - 1 - i] = t;
+        }
+    }
+
+    dims[0] = dims[1] = dims[2] = 1;
+    for (i = 0; i < ndims; i++)
+    {
+        int slot = 3 - ndims + i;
+        if (slot < 0)
+            slot = 0;
+        dims[slot] *= ldims[i];
+    }
+
+    if (dims[0] * dims[1] * dims[2] != n)
+    {
+        dims[0] = dims[1] = 1;
+        dims[2] = n;
+    }
+}
+
+/*
+ * Quantize the prediction errors of the block into codes, store the values
+ * that cannot be quantized in outliers. recon receives the decoded values
+ * the predictor works from. Returns the number of outliers.
+ */
+#define LOSSY_DEFINE_QUANTIZE(T) \
+static uint64_t quantize_##T (const T *in, const uint64_t dims[3], double eb, \
+                              uint16_t *codes, T *recon, T *outliers) \
+{ \
+    const uint64_t sj = dims[2], si = dims[1] * dims[2]; \
+    uint64_t i, j, k, idx = 0, noutliers = 0; \
+    for (i = 0; i < dims[0]; i++) \
+    for (j = 0; j < dims[1]; j++) \
+    for (k = 0; k < dims[2]; k++, idx++) \
+    { \
+        double pred = lossy_predict_##T (recon, i, j, k, si, sj); \
+        double q = (eb > 0 ? floor((in[idx] - pred) / (2 * eb) + 0.5) : 0); \
+        if (q > -LOSSY_RADIUS && q < LOSSY_RADIUS) \
+        { \
+            uint16_t code = (uint16_t) ((int) q + LOSSY_RADIUS); \
+            T r = (T) lossy_reconstruct (pred, eb, code); \
+            if (fabs((double) in[idx] - (double) r) <= eb) \
+            { \
+                codes[idx] = code; \
+                recon[idx] = r; \
+                continue; \
+            } \
+        } \
+        codes[idx] = 0; \
+        recon[idx] = in[idx]; \
+        outliers[noutliers++] = in[idx]; \
+    } \
+    return noutliers; \
+}
+
+LOSSY_DEFINE_QUANTIZE(float)
+LOSSY_DEFINE_QUANTIZE(double)
+
+#undef LOSSY_DEFINE_QUANTIZE
+
+#define LOSSY_DEFINE_RANGE(T) \
+static double value_range_##T (const T *in, uint64_t n) \
+{ \
+    double lo = INFINITY, hi = -INFINITY; \
+    uint64_t i; \
+    for (i = 0; i < n; i++) \
+    { \
+        if (!isfinite(in[i])) \
+            continue; \
+        if (in[i] < lo) lo = in[i]; \
+        if (in[i] > hi) hi = in[i]; \
+    } \
+    return (hi >= lo ? hi - lo : 0); \
+}
+
+LOSSY_DEFINE_RANGE(float)
+LOSSY_DEFINE_RANGE(double)
+
+#undef LOSSY_DEFINE_RANGE
+
+struct huffman_leaf
+{
+    uint64_t weight;
+    uint16_t sym;
+};
+
+static int compare_leaves(const void *a, const void *b)
+{
+    const struct huffman_leaf *x = (const struct huffman_leaf *) a;
+    const struct huffman_leaf *y = (const struct huffman_leaf *) b;
+    if (x->weight != y->weight)
+        return (x->weight < y->weight ? -1 : 1);
+    return (int) x->sym - (int) y->sym;
+}
+
+/*
+ * Huffman code lengths of the symbols with non-zero frequency, at most
+ * LOSSY_MAX_CODE_LEN bits. syms[0..nsyms-1] receives the used symbols in
+ * symbol order. Returns nsyms.
+ */
+static uint32_t huffman_lengths(const uint64_t *freq, uint8_t *lens, uint16_t *syms)
+{
+    uint32_t nsyms = 0, m, i, s, maxlen;
+    struct huffman_leaf *leaves;
+    uint64_t *weight;
+    uint32_t *parent, *depth;
+    int scale = 0;
+
+    for (s = 0; s < LOSSY_NSYMS; s++)
+        if (freq[s])
+            syms[nsyms++] = (uint16_t) s;
+    if (nsyms <= 1)
+    {
+        if (nsyms)
+            lens[syms[0]] = 1;
+        return nsyms;
+    }
+
+    m = nsyms;
+    leaves = (struct huffman_leaf *) malloc(m * sizeof(struct huffman_leaf));
+    weight = (uint64_t *) malloc((2 * m - 1) * sizeof(uint64_t));
+    parent = (uint32_t *) malloc((2 * m - 1) * sizeof(uint32_t));
+    depth = (uint32_t *) malloc((2 * m - 1) * sizeof(uint32_t));
+
+    for (;;)
+    {
+        uint32_t leaf = 0, node = m, next;
+
+        for (i = 0; i < m; i++)
+        {
+            leaves[i].weight = (freq[syms[i]] >> scale) | 1;
+            leaves[i].sym = syms[i];
+        }
+        qsort(leaves, m, sizeof(struct huffman_leaf), compare_leaves);
+        for (i = 0; i < m; i++)
+            weight[i] = leaves[i].weight;
+
+        // two-queue construction, the internal nodes come out in weight order
+        for (next = m; next < 2 * m - 1; next++)
+        {
+            uint32_t pick[2], p;
+            for (p = 0; p < 2; p++)
+            {
+                if (leaf < m && (node >= next || weight[leaf] <= weight[node]))
+                    pick[p] = leaf++;
+                else
+                    pick[p] = node++;
+            }
+            weight[next] = weight[pick[0]] + weight[pick[1]];
+            parent[pick[0]] = parent[pick[1]] = next;
+        }
+
+        // parents come after their children
+        depth[2 * m - 2] = 0;
+        maxlen = 0;
+        for (i = 2 * m - 2; i-- > 0; )
+        {
+            depth[i] = depth[parent[i]] + 1;
+            if (i < m && depth[i] > maxlen)
+                maxlen = depth[i];
+        }
+        if (maxlen <= LOSSY_MAX_CODE_LEN)
+            break;
+        scale++; // flatten the distribution until the codes are short enough
+    }
+
+    for (i = 0; i < m; i++)
+        lens[leaves[i].sym] = (uint8_t) depth[i];
+
+    free(leaves);
+    free(weight);
+    free(parent);
+    free(depth);
+    return nsyms;
+}
+
+/*
+ * Canonical codes from the lengths. syms is reordered by (length, symbol),
+ * the order the code table is stored and decoded in.
+ */
+static void huffman_codes(const uint8_t *lens, uint16_t *syms, uint32_t nsyms, uint32_t *codes)
+{
+    uint32_t count[LOSSY_MAX_CODE_LEN + 1] = {0};
+    uint32_t offset[LOSSY_MAX_CODE_LEN + 2];
+    uint16_t *sorted = (uint16_t *) malloc(nsyms * sizeof(uint16_t));
+    uint32_t i, len, code = 0;
+
+    for (i = 0; i < nsyms; i++)
+        count[lens[syms[i]]]++;
+    offset[1] = 0;
+    for (len = 1; len <= LOSSY_MAX_CODE_LEN; len++)
+        offset[len + 1] = offset[len] + count[len];
+    for (i = 0; i < nsyms; i++) // syms is in symbol order
+        sorted[offset[lens[syms[i]]]++] = syms[i];
+    memcpy(syms, sorted, nsyms * sizeof(uint16_t));
+
+    for (i = 0, len = 1; len <= LOSSY_MAX_CODE_LEN; len++)
+    {
+        uint32_t c;
+        for (c = 0; c < count[len]; c++)
+            codes[syms[i++]] = code++;
+        code <<= 1;
+    }
+    free(sorted);
+}
+
+// Bit writer, MSB first
+struct bit_writer
+{
+    unsigned char *out;
+    uint64_t pos;       // bytes written
+    uint64_t acc;
+    int nbits;          // bits pending in acc
+};
+
+static inline void put_bits(struct bit_writer *w, uint32_t code, int len)
+{
+    w->acc = (w->acc << len) | code;
+    w->nbits += len;
+    while (w->nbits >= 8)
+    {
+        w->nbits -= 8;
+        w->out[w->pos++] = (unsigned char) (w->acc >> w->nbits);
+    }
+}
+
+static void flush_bits(struct bit_writer *w)
+{
+    if (w->nbits > 0)
+        w->out[w->pos++] = (unsigned char) (w->acc << (8 - w->nbits));
+    w->nbits = 0;
+}
+
+/*
+ * Compress n values of elem_size bytes into output, which has output_len
+ * bytes. Returns 0 and the length in *output_len, or -1 if the result
+ * would not be smaller.
+ */
+static int compress_lossy(const void *input, uint64_t n, int elem_size, const uint64_t dims[3], double eb,
+                          void *output, uint64_t *output_len)
+{
+    uint16_t *codes = (uint16_t *) malloc(n * sizeof(uint16_t));
+    void *recon = malloc(n * elem_size);
+    void *outliers = malloc(n * elem_size);
+    uint64_t *freq = (uint64_t *) calloc(LOSSY_NSYMS, sizeof(uint64_t));
+    uint8_t *lens = (uint8_t *) calloc(LOSSY_NSYMS, sizeof(uint8_t));
+    uint16_t *syms = (uint16_t *) malloc(LOSSY_NSYMS * sizeof(uint16_t));
+    uint32_t *hcodes = (uint32_t *) malloc(LOSSY_NSYMS * sizeof(uint32_t));
+    uint64_t noutliers, nbits = 0, size, i;
+    uint32_t nsyms;
+    int rtn = -1;
+
+    if (!codes || !recon || !outliers || !freq || !lens || !syms || !hcodes)
+    {
+        log_error("Out of memory in the lossy transform\n");
+        goto done;
+    }
+
+    if (elem_size == sizeof(double))
+        noutliers = quantize_double((const double *) input, dims, eb, codes, (double *) recon, (double *) outliers);
+    else
+        noutliers = quantize_float((const float *) input, dims, eb, codes, (float *) recon, (float *) outliers);
+
+    for (i = 0; i < n; i++)
+        freq[codes[i]]++;
+    nsyms = huffman_lengths(freq, lens, syms);
+    huffman_codes(lens, syms, nsyms, hcodes);
+    for (i = 0; i < nsyms; i++)
+        nbits += freq[syms[i]] * lens[syms[i]];
+
+    size = LOSSY_HDR_SIZE + (uint64_t) nsyms * LOSSY_SYM_ENTRY_SIZE + (nbits + 7) / 8 + noutliers * elem_size;
+    log_debug("lossy transform: %llu values, eb %g, %llu unpredictable, %u symbols, %llu bytes\n",
+              (unsigned long long) n, eb, (unsigned long long) noutliers, nsyms, (unsigned long long) size);
+    if (size >= *output_len)
+        goto done;
+
+    {
+        unsigned char *out = (unsigned char *) output;
+        struct bit_writer w;
+
+        memcpy(out + LOSSY_HDR_DIMS, dims, 3 * sizeof(uint64_t));
+        memcpy(out + LOSSY_HDR_EB, &eb, sizeof(double));
+        memcpy(out + LOSSY_HDR_NOUTLIERS, &noutliers, sizeof(uint64_t));
+        memcpy(out + LOSSY_HDR_NBITS, &nbits, sizeof(uint64_t));
+        memcpy(out + LOSSY_HDR_NSYMS, &nsyms, sizeof(uint32_t));
+        out += LOSSY_HDR_SIZE;
+
+        for (i = 0; i < nsyms; i++)
+        {
+            memcpy(out, &syms[i], sizeof(uint16_t));
+            out[2] = lens[syms[i]];
+            out += LOSSY_SYM_ENTRY_SIZE;
+        }
+
+        w.out = out;
+        w.pos = 0;
+        w.acc = 0;
+        w.nbits = 0;
+        for (i = 0; i < n; i++)
+            put_bits(&w, hcodes[codes[i]], lens[codes[i]]);
+        flush_bits(&w);
+        out += w.pos;
+
+        memcpy(out, outliers, noutliers * elem_size);
+    }
+
+    *output_len = size;
+    rtn = 0;
+
+done:
+    free(codes);
+    free(recon);
+    free(outliers);
+    free(freq);
+    free(lens);
+    free(syms);
+    free(hcodes);
+    return rtn;
+}
+
+uint16_t adios_transform_lossy_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    return LOSSY_META_SIZE;
+}
+
+void adios_transform_lossy_transformed_size_growth(
+		const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+		uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    // Do nothing, the data is stored as is if it does not get smaller
+}
+
+int adios_transform_lossy_apply(struct adios_file_struct *fd,
+                                struct adios_var_struct *var,
+                                uint64_t *transformed_len,
+                                int use_shared_buffer,
+                                int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for the lossy transform type
+    assert(var->transform_type == adios_transform_lossy);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const void *input_buff = var->data;
+
+    int elem_size = 0;
+    if (var->pre_transform_type == adios_double)
+        elem_size = sizeof(double);
+    else if (var->pre_transform_type == adios_real)
+        elem_size = sizeof(float);
+    else
+        log_warn("lossy transform: variable %s is not float or double, storing it unchanged\n", var->name);
+
+    // the absolute error bound of this block
+    struct lossy_params params;
+    parse_params(var->transform_spec, &params);
+    uint64_t n = (elem_size ? input_size / elem_size : 0);
+    double eb = params.abs;
+    if (params.rel > 0 && n > 0)
+    {
+        double range = (elem_size == sizeof(double) ? value_range_double((const double *) input_buff, n)
+                                                    : value_range_float((const float *) input_buff, n));
+        if (eb == 0 || params.rel * range < eb)
+            eb = params.rel * range;
+    }
+
+    // decide the output buffer
+    uint64_t output_size = input_size; // the result is kept only if smaller
+    void* output_buff = NULL;
+
+    if (use_shared_buffer)    // If shared buffer is permitted, serialize to there
+    {
+        *wrote_to_shared_buffer = 1;
+        if (!shared_buffer_reserve(fd, output_size))
+        {
+            log_error("Out of memory allocating %llu bytes for %s for lossy transform\n", output_size, var->name);
+            return 0;
+        }
+
+        // Write directly to the shared buffer
+        output_buff = fd->buffer + fd->offset;
+    }
+    else    // Else, fall back to var->data memory allocation
+    {
+        *wrote_to_shared_buffer = 0;
+        output_buff = malloc(output_size);
+        if (!output_buff)
+        {
+            log_error("Out of memory allocating %llu bytes for %s for lossy transform\n", output_size, var->name);
+            return 0;
+        }
+    }
+
+    // compress it
+    uint64_t actual_output_size = output_size;
+    char compress_ok = 1;
+
+    int rtn = -1;
+    if (n > 0)
+    {
+        uint64_t dims[3];
+        get_dims(fd, var, n, dims);
+        rtn = compress_lossy(input_buff, n, elem_size, dims, eb, output_buff, &actual_output_size);
+    }
+
+    if (0 != rtn)   // not float data, or it did not get smaller: store it as is
+    {
+        memcpy(output_buff, input_buff, input_size);
+        actual_output_size = input_size;
+        compress_ok = 0;
+        eb = 0;
+    }
+
+    // Wrap up, depending on buffer mode
+    if (use_shared_buffer)
+    {
+        shared_buffer_mark_written(fd, actual_output_size);
+    }
+    else
+    {
+        var->data = output_buff;
+        var->data_size = actual_output_size;
+        var->free_data = adios_flag_yes;
+    }
+
+    // copy the metadata
+    if(var->transform_metadata && var->transform_metadata_len >= LOSSY_META_SIZE)
+    {
+        char *meta = (char*)var->transform_metadata;
+        memcpy(meta + LOSSY_META_ORIG_SIZE, &input_size, sizeof(uint64_t));
+        memcpy(meta + LOSSY_META_OK, &compress_ok, sizeof(char));
+        memcpy(meta + LOSSY_META_EB, &eb, sizeof(double));
+    }
+
+    *transformed_len = actual_output_size; // Return the size of the data buffer
+
+    return 1;
+}
+
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(lossy)
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "core/util.h"
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/transforms/adios_transforms_chunked_read.h"
+#include "core/transforms/adios_transforms_shuffle.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+
+#ifdef LZ4
+
+#include "lz4.h"
+
+int adios_transform_lz4_is_implemented (void) {return 1;}
+
+int decompress_lz4_pre_allocated(const void* input_data,
+                                 const uint64_t input_len,
+                                 void* output_data,
+                                 uint64_t* output_len)
+{
+    assert(input_data != NULL && input_len > 0 && output_data != NULL && output_len != NULL && *output_len > 0);
+
+    if (input_len > INT_MAX || *output_len > INT_MAX)
+        return -1;
+
+    int rtn = LZ4_decompress_safe((const char*)input_data, (char*)output_data, (int)input_len, (int)*output_len);
+    if (rtn < 0)
+        return -1;
+
+    *output_len = (uint64_t)rtn;
+    return 0;
+}
+
+static int decompress_lz4_chunk(const void* input_data, uint64_t input_len,
+                                void* output_data, uint64_t* output_len, void* arg)
+{
+    return decompress_lz4_pre_allocated(input_data, input_len, output_data, output_len);
+}
+
+// Sub-chunk size of a PG compressed in sub-chunks, 0 otherwise
+static uint64_t get_chunk_size(const adios_transform_pg_read_request *pg_reqgroup)
+{
+    char compress_ok = *((char*)(pg_reqgroup->transform_metadata + sizeof(uint64_t)));
+    uint64_t chunk_size = 0;
+    if (compress_ok == 1)
+        memcpy(&chunk_size, (char*)pg_reqgroup->transform_metadata + sizeof(uint64_t) + sizeof(char), sizeof(uint64_t));
+    return chunk_size;
+}
+
+// Shuffle stage in front of the decompressor, if the data was shuffled
+static void get_shuffle(const adios_transform_pg_read_request *pg_reqgroup,
+                        struct adios_transform_shuffle_stage *shuffle)
+{
+    adios_transform_shuffle_read_metadata(shuffle, pg_reqgroup->transform_metadata,
+                                          pg_reqgroup->transform_metadata_len,
+                                          2 * sizeof(uint64_t) + sizeof(char));
+    shuffle->fn = decompress_lz4_chunk;
+    shuffle->arg = NULL;
+}
+
+int adios_transform_lz4_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                  adios_transform_pg_read_request *pg_reqgroup)
+{
+    // only read and decompress the sub-chunks the selection needs
+    uint64_t chunk_size = get_chunk_size(pg_reqgroup);
+    if (chunk_size > 0)
+        return adios_transform_chunked_generate_read_subrequests(reqgroup, pg_reqgroup, 0, chunk_size);
+
+    void *buf = malloc(pg_reqgroup->raw_var_length);
+    assert(buf);
+    adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
+    adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_lz4_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                           adios_transform_pg_read_request *pg_reqgroup,
+                                                           adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+adios_datablock * adios_transform_lz4_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                            adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    uint64_t compressed_size = (uint64_t)completed_pg_reqgroup->raw_var_length;
+    void* compressed_data = completed_pg_reqgroup->subreqs->data;
+
+    uint64_t uncompressed_size_meta = *((uint64_t*)completed_pg_reqgroup->transform_metadata);
+    char compress_ok = *((char*)(completed_pg_reqgroup->transform_metadata + sizeof(uint64_t)));
+    uint64_t chunk_size = get_chunk_size(completed_pg_reqgroup);
+    struct adios_transform_shuffle_stage shuffle;
+    get_shuffle(completed_pg_reqgroup, &shuffle);
+    if (chunk_size > 0)
+        return adios_transform_chunked_pg_reqgroup_completed(reqgroup, completed_pg_reqgroup, chunk_size,
+                                                             adios_transform_shuffle_decompress, &shuffle);
+
+    uint64_t uncompressed_size = adios_get_type_size(reqgroup->transinfo->orig_type, "");
+    int d = 0;
+    for(d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+    {
+        uncompressed_size *= (uint64_t)(completed_pg_reqgroup->orig_varblock->count[d]);
+    }
+
+    if(uncompressed_size_meta != uncompressed_size)
+    {
+        log_warn("lz4 transform: possible wrong data size or corrupted metadata\n");
+    }
+
+    void* uncompressed_data = malloc(uncompressed_size);
+    if(!uncompressed_data)
+    {
+        return NULL;
+    }
+
+    if(compress_ok == 1)    // compression is successful
+    {
+        int rtn = adios_transform_shuffle_decompress(compressed_data, compressed_size, uncompressed_data, &uncompressed_size, &shuffle);
+        if(0 != rtn)
+        {
+            free(uncompressed_data);
+            return NULL;
+        }
+    }
+    else    // just copy the buffer since data is not compressed
+    {
+        memcpy(uncompressed_data, compressed_data, compressed_size);
+    }
+
+    return adios_datablock_new_whole_pg(reqgroup, completed_pg_reqgroup, uncompressed_data);
+}
+
+adios_datablock * adios_transform_lz4_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
+
+
+#else
+
+DECLARE_TRANSFORM_READ_METHOD_UNIMPL(lz4);
+
+#endif
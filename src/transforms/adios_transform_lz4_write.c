@@ -0,0 +1,208 @@
+#include <stdint.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_util.h"
+#include "core/transforms/adios_transforms_chunked.h"
+#include "core/transforms/adios_transforms_shuffle.h"
+
+#ifdef LZ4
+
+#include "lz4.h"
+#include "lz4hc.h"
+
+// LZ4 takes int lengths, larger blocks are always compressed in sub-chunks
+#define LZ4_LARGE_CHUNK_SIZE (1024ULL * 1024 * 1024)
+
+/*
+ * level 0 is the default fast mode, a negative level is an acceleration
+ * (faster, less compression) and 1..12 selects the high compression mode
+ */
+int compress_lz4_pre_allocated(const void* input_data,
+                               const uint64_t input_len,
+                               void* output_data,
+                               uint64_t* output_len,
+                               int compress_level)
+{
+    assert(input_data != NULL && input_len > 0 && output_data != NULL && output_len != NULL && *output_len > 0);
+
+    if (input_len > LZ4_MAX_INPUT_SIZE)
+        return -1;
+
+    int capacity = (*output_len > INT_MAX ? INT_MAX : (int)*output_len);
+    int rtn;
+    if (compress_level > 0)
+        rtn = LZ4_compress_HC((const char*)input_data, (char*)output_data, (int)input_len, capacity, compress_level);
+    else
+        rtn = LZ4_compress_fast((const char*)input_data, (char*)output_data, (int)input_len, capacity, 1 - compress_level);
+
+    if (rtn <= 0)
+    {
+        // the output did not fit in *output_len bytes
+        return -1;
+    }
+
+    *output_len = (uint64_t)rtn;
+    return 0;
+}
+
+static int compress_lz4_chunk(const void* input_data, uint64_t input_len,
+                              void* output_data, uint64_t* output_len, void* arg)
+{
+    return compress_lz4_pre_allocated(input_data, input_len, output_data, output_len, *(int*)arg);
+}
+
+static void get_chunk_params(struct adios_transform_spec *transform_spec,
+                             const struct adios_transform_shuffle_stage *shuffle, uint64_t input_size,
+                             uint64_t *chunk_size, int *nthreads)
+{
+    adios_transform_chunked_parse_spec(transform_spec, chunk_size, nthreads);
+    *chunk_size = adios_transform_shuffle_align_chunk(shuffle, *chunk_size);
+    if (*chunk_size == 0 && input_size > LZ4_MAX_INPUT_SIZE)
+        *chunk_size = LZ4_LARGE_CHUNK_SIZE;
+    if (input_size <= *chunk_size)
+        *chunk_size = 0;
+}
+
+uint16_t adios_transform_lz4_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    // metadata: original data size (uint64_t) + compression succ flag (char)
+    //           + sub-chunk size (uint64_t), 0 if the block was compressed as one stream
+    //           [+ shuffle stage (ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE)]
+    return (sizeof(uint64_t) + sizeof(char) + sizeof(uint64_t) +
+            (transform_spec->shuffle != adios_transform_shuffle_none ? ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE : 0));
+}
+
+void adios_transform_lz4_transformed_size_growth(
+		const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+		uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    uint64_t chunk_size;
+    int nthreads;
+    adios_transform_chunked_parse_spec(transform_spec, &chunk_size, &nthreads);
+    if (chunk_size == 0)
+        chunk_size = LZ4_LARGE_CHUNK_SIZE;
+
+    // Chunked data may grow by its offset table
+    *constant_factor = sizeof(uint64_t);
+    *linear_factor = 1.0 + (double)sizeof(uint64_t) / chunk_size;
+}
+
+int adios_transform_lz4_apply(struct adios_file_struct *fd,
+                              struct adios_var_struct *var,
+                              uint64_t *transformed_len,
+                              int use_shared_buffer,
+                              int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for LZ4 transform type
+    assert(var->transform_type == adios_transform_lz4);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const void *input_buff= var->data;
+
+    // parse the compression parameter
+    int compress_level = 0;
+    if (var->transform_spec->param_count > 0 && !var->transform_spec->params[0].value) {
+        compress_level = atoi(var->transform_spec->params[0].key);
+        if (compress_level > LZ4HC_CLEVEL_MAX)
+            compress_level = LZ4HC_CLEVEL_MAX;
+    }
+
+    // shuffle the data (each sub-chunk on its own) before compressing it if asked for
+    struct adios_transform_shuffle_stage shuffle = {
+        var->transform_spec->shuffle, adios_get_type_size(var->pre_transform_type, NULL),
+        compress_lz4_chunk, &compress_level
+    };
+
+    uint64_t chunk_size;
+    int nthreads;
+    get_chunk_params(var->transform_spec, &shuffle, input_size, &chunk_size, &nthreads);
+
+    // decide the output buffer
+    uint64_t output_size = input_size; // for compression, at most the original data size
+    if (chunk_size)
+        output_size = adios_transform_chunked_bound(input_size, chunk_size); // and the offset table
+    void* output_buff = NULL;
+
+    if (use_shared_buffer)    // If shared buffer is permitted, serialize to there
+    {
+        *wrote_to_shared_buffer = 1;
+        if (!shared_buffer_reserve(fd, output_size))
+        {
+            log_error("Out of memory allocating %llu bytes for %s for lz4 transform\n", output_size, var->name);
+            return 0;
+        }
+
+        // Write directly to the shared buffer
+        output_buff = fd->buffer + fd->offset;
+    }
+    else    // Else, fall back to var->data memory allocation
+    {
+        *wrote_to_shared_buffer = 0;
+        output_buff = malloc(output_size);
+        if (!output_buff)
+        {
+            log_error("Out of memory allocating %llu bytes for %s for lz4 transform\n", output_size, var->name);
+            return 0;
+        }
+    }
+
+    // compress it
+    uint64_t actual_output_size = output_size;
+    char compress_ok = 1;
+
+    int rtn;
+    if (chunk_size)
+        rtn = adios_transform_chunked_compress(input_buff, input_size, chunk_size, nthreads,
+                                               adios_transform_shuffle_compress, &shuffle,
+                                               output_buff, &actual_output_size);
+    else
+        rtn = adios_transform_shuffle_compress(input_buff, input_size, output_buff, &actual_output_size, &shuffle);
+
+    if(0 != rtn                     // compression failed for some reason, then just copy the buffer
+        || actual_output_size > input_size)  // or size after compression is even larger
+    {
+        memcpy(output_buff, input_buff, input_size);
+        actual_output_size = input_size;
+        compress_ok = 0;    // succ sign set to 0
+    }
+
+    // Wrap up, depending on buffer mode
+    if (use_shared_buffer)
+    {
+        shared_buffer_mark_written(fd, actual_output_size);
+    }
+    else
+    {
+        var->data = output_buff;
+        var->data_size = actual_output_size;
+        var->free_data = adios_flag_yes;
+    }
+
+    // copy the metadata
+    if(var->transform_metadata && var->transform_metadata_len > 0)
+    {
+        memcpy((char*)var->transform_metadata, &input_size, sizeof(uint64_t));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t), &compress_ok, sizeof(char));
+        memcpy((char*)var->transform_metadata + sizeof(uint64_t) + sizeof(char), &chunk_size, sizeof(uint64_t));
+        if (var->transform_metadata_len >= 2 * sizeof(uint64_t) + sizeof(char) + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE)
+            adios_transform_shuffle_write_metadata(&shuffle, var->transform_metadata, 2 * sizeof(uint64_t) + sizeof(char));
+    }
+
+    *transformed_len = actual_output_size; // Return the size of the data buffer
+
+    return 1;
+}
+
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(lz4)
+
+#else
+
+DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(lz4)
+
+#endif
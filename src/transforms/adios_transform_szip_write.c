@@ -111,6 +111,8 @@ int adios_transform_szip_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(szip)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(szip)
@@ -64,6 +64,8 @@ int adios_transform_template_apply(struct adios_file_struct *fd,
     return 1;
 }
 
+DECLARE_TRANSFORM_WRITE_METHOD_NO_FINALIZE(template)
+
 #else
 
 DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(template)
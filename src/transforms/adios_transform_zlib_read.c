@@ -7,6 +7,8 @@
 #include "core/adios_logger.h"
 #include "core/transforms/adios_transforms_hooks_read.h"
 #include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/transforms/adios_transforms_chunked_read.h"
+#include "core/transforms/adios_transforms_shuffle.h"
 #include "core/adios_internals.h" // adios_get_type_size()
 
 #ifdef ZLIB
@@ -36,9 +38,41 @@ int decompress_zlib_pre_allocated(const void* input_data,
     return 0;
 }
 
+static int decompress_zlib_chunk(const void* input_data, uint64_t input_len,
+                                 void* output_data, uint64_t* output_len, void* arg)
+{
+    return decompress_zlib_pre_allocated(input_data, input_len, output_data, output_len);
+}
+
+// Sub-chunk size of a PG compressed in sub-chunks, 0 otherwise
+static uint64_t get_chunk_size(const adios_transform_pg_read_request *pg_reqgroup)
+{
+    char compress_ok = *((char*)(pg_reqgroup->transform_metadata + sizeof(uint64_t)));
+    uint64_t chunk_size = 0;
+    if (compress_ok == 1 && pg_reqgroup->transform_metadata_len >= 2 * sizeof(uint64_t) + sizeof(char))
+        memcpy(&chunk_size, (char*)pg_reqgroup->transform_metadata + sizeof(uint64_t) + sizeof(char), sizeof(uint64_t));
+    return chunk_size;
+}
+
+// Shuffle stage in front of the decompressor, if the data was shuffled
+static void get_shuffle(const adios_transform_pg_read_request *pg_reqgroup,
+                        struct adios_transform_shuffle_stage *shuffle)
+{
+    adios_transform_shuffle_read_metadata(shuffle, pg_reqgroup->transform_metadata,
+                                          pg_reqgroup->transform_metadata_len,
+                                          2 * sizeof(uint64_t) + sizeof(char));
+    shuffle->fn = decompress_zlib_chunk;
+    shuffle->arg = NULL;
+}
+
 int adios_transform_zlib_generate_read_subrequests(adios_transform_read_request *reqgroup,
                                                     adios_transform_pg_read_request *pg_reqgroup)
 {
+    // only read and decompress the sub-chunks the selection needs
+    uint64_t chunk_size = get_chunk_size(pg_reqgroup);
+    if (chunk_size > 0)
+        return adios_transform_chunked_generate_read_subrequests(reqgroup, pg_reqgroup, 0, chunk_size);
+
     void *buf = malloc(pg_reqgroup->raw_var_length);
     assert(buf);
     adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new_whole_pg(pg_reqgroup, buf);
@@ -64,6 +98,12 @@ adios_datablock * adios_transform_zlib_pg_reqgroup_completed(adios_transform_rea
     
     uint64_t uncompressed_size_meta = *((uint64_t*)completed_pg_reqgroup->transform_metadata);
     char compress_ok = *((char*)(completed_pg_reqgroup->transform_metadata + sizeof(uint64_t)));
+    uint64_t chunk_size = get_chunk_size(completed_pg_reqgroup);
+    struct adios_transform_shuffle_stage shuffle;
+    get_shuffle(completed_pg_reqgroup, &shuffle);
+    if (chunk_size > 0)
+        return adios_transform_chunked_pg_reqgroup_completed(reqgroup, completed_pg_reqgroup, chunk_size,
+                                                             adios_transform_shuffle_decompress, &shuffle);
 
     uint64_t uncompressed_size = adios_get_type_size(reqgroup->transinfo->orig_type, "");
     int d = 0;
@@ -85,7 +125,7 @@ adios_datablock * adios_transform_zlib_pg_reqgroup_completed(adios_transform_rea
     
     if(compress_ok == 1)    // compression is successful
     {
-        int rtn = decompress_zlib_pre_allocated(compressed_data, compressed_size, uncompressed_data, &uncompressed_size);
+        int rtn = adios_transform_shuffle_decompress(compressed_data, compressed_size, uncompressed_data, &uncompressed_size, &shuffle);
         if(0 != rtn)
         {
             return NULL;
@@ -0,0 +1,28 @@
+/*
+ * adios_transform_zstd_common.h
+ *
+ * Layout of the zstd transform metadata and data, shared by both sides.
+ *
+ * The transformed data of a PG is an optional dictionary followed by the
+ * payload: one zstd frame, the sub-chunk format of
+ * adios_transforms_chunked.h, or the raw data if compression failed.
+ *
+ * A dictionary is trained on the first block of a variable and reused for
+ * its later steps. It is stored in the first block of the variable that a
+ * process writes to each file, and the other blocks refer to it by its ID.
+ */
+
+#ifndef ADIOS_TRANSFORM_ZSTD_COMMON_H_
+#define ADIOS_TRANSFORM_ZSTD_COMMON_H_
+
+// metadata offsets
+#define ZSTD_META_ORIG_SIZE  0   // uint64_t, original data size
+#define ZSTD_META_OK         8   // char, compression succeeded
+#define ZSTD_META_CHUNK_SIZE 9   // uint64_t, sub-chunk size, 0 if one frame
+#define ZSTD_META_DICT_ID    17  // uint32_t, dictionary used, 0 if none
+#define ZSTD_META_DICT_LEN   21  // uint32_t, length of the dictionary stored in this PG
+#define ZSTD_META_WRITER     25  // uint32_t, rank of the writer, whose blocks share the dictionary
+#define ZSTD_META_SIZE       29
+// [+ shuffle stage at ZSTD_META_SIZE, see adios_transforms_shuffle.h]
+
+#endif /* ADIOS_TRANSFORM_ZSTD_COMMON_H_ */
@@ -0,0 +1,378 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "core/util.h"
+#include "core/adios_logger.h"
+#include "core/common_read.h"
+#include "public/adios_error.h"
+#include "core/transforms/adios_transforms_hooks_read.h"
+#include "core/transforms/adios_transforms_reqgroup.h"
+#include "core/transforms/adios_transforms_chunked_read.h"
+#include "core/transforms/adios_transforms_shuffle.h"
+#include "core/adios_internals.h" // adios_get_type_size()
+#include "adios_transform_zstd_common.h"
+
+#ifdef ZSTD
+
+#include "zstd.h"
+
+int adios_transform_zstd_is_implemented (void) {return 1;}
+
+// Metadata of a PG
+struct zstd_pg_meta
+{
+    uint64_t orig_size;
+    char compress_ok;
+    uint64_t chunk_size;
+    uint32_t dict_id;
+    uint32_t dict_len;
+};
+
+static void get_meta(const void *metadata, struct zstd_pg_meta *m)
+{
+    const char *meta = (const char *)metadata;
+    memcpy(&m->orig_size, meta + ZSTD_META_ORIG_SIZE, sizeof(uint64_t));
+    memcpy(&m->compress_ok, meta + ZSTD_META_OK, sizeof(char));
+    memcpy(&m->chunk_size, meta + ZSTD_META_CHUNK_SIZE, sizeof(uint64_t));
+    memcpy(&m->dict_id, meta + ZSTD_META_DICT_ID, sizeof(uint32_t));
+    memcpy(&m->dict_len, meta + ZSTD_META_DICT_LEN, sizeof(uint32_t));
+}
+
+// One decompression context per thread, freed when the thread exits
+static pthread_key_t dctx_key;
+static pthread_once_t dctx_key_once = PTHREAD_ONCE_INIT;
+
+static void free_dctx(void *dctx)
+{
+    ZSTD_freeDCtx((ZSTD_DCtx *)dctx);
+}
+
+static void create_dctx_key(void)
+{
+    pthread_key_create(&dctx_key, free_dctx);
+}
+
+static ZSTD_DCtx * get_dctx(void)
+{
+    ZSTD_DCtx *dctx;
+
+    pthread_once(&dctx_key_once, create_dctx_key);
+    dctx = (ZSTD_DCtx *)pthread_getspecific(dctx_key);
+    if (!dctx)
+    {
+        dctx = ZSTD_createDCtx();
+        if (!dctx)
+            return NULL;
+        if (pthread_setspecific(dctx_key, dctx))
+        {
+            ZSTD_freeDCtx(dctx);
+            return NULL;
+        }
+        // frames written with a large window (ldm) need it allowed
+        ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, ZSTD_dParam_getBounds(ZSTD_d_windowLogMax).upperBound);
+    }
+    return dctx;
+}
+
+static int decompress_zstd_chunk(const void* input_data, uint64_t input_len,
+                                 void* output_data, uint64_t* output_len, void* arg)
+{
+    const ZSTD_DDict *ddict = (const ZSTD_DDict *)arg;
+    ZSTD_DCtx *dctx = get_dctx();
+    size_t rtn;
+
+    if (!dctx)
+        return -1;
+
+    // resetting the session keeps the window limit, refDDict(NULL) drops
+    // the dictionary of the previous frame
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+    ZSTD_DCtx_refDDict(dctx, ddict);
+
+    rtn = ZSTD_decompressDCtx(dctx, output_data, *output_len, input_data, input_len);
+
+    if (ZSTD_isError(rtn))
+    {
+        log_error("zstd transform: %s\n", ZSTD_getErrorName(rtn));
+        return -1;
+    }
+
+    *output_len = (uint64_t)rtn;
+    return 0;
+}
+
+// A block storing a dictionary
+struct zstd_dict_block
+{
+    uint32_t writer;
+    uint32_t dict_id;
+    int blockidx;
+};
+
+/*
+ * The blocks of a variable storing a dictionary, by writer then block
+ * index. Built on the first lookup of a read request and kept in its
+ * transform_internal.
+ */
+struct zstd_dict_index
+{
+    int nblocks;
+    struct zstd_dict_block blocks[];
+};
+
+static int compare_dict_blocks(const void *a, const void *b)
+{
+    const struct zstd_dict_block *x = (const struct zstd_dict_block *)a;
+    const struct zstd_dict_block *y = (const struct zstd_dict_block *)b;
+    if (x->writer != y->writer)
+        return (x->writer < y->writer ? -1 : 1);
+    return x->blockidx - y->blockidx;
+}
+
+static uint32_t get_writer(const void *metadata)
+{
+    uint32_t writer;
+    memcpy(&writer, (const char *)metadata + ZSTD_META_WRITER, sizeof(uint32_t));
+    return writer;
+}
+
+static struct zstd_dict_index * get_dict_index(adios_transform_read_request *reqgroup)
+{
+    const ADIOS_TRANSFORM_METADATA *metas = reqgroup->transinfo->transform_metadatas;
+    int nblocks = reqgroup->raw_varinfo->sum_nblocks;
+    struct zstd_dict_index *index = (struct zstd_dict_index *)reqgroup->transform_internal;
+    int b, n = 0;
+
+    if (index)
+        return index;
+
+    for (b = 0; b < nblocks; b++)
+    {
+        struct zstd_pg_meta m;
+        if (metas[b].length < ZSTD_META_SIZE)
+            continue;
+        get_meta(metas[b].content, &m);
+        if (m.dict_len > 0)
+            n++;
+    }
+
+    index = (struct zstd_dict_index *)malloc(sizeof(struct zstd_dict_index) + n * sizeof(struct zstd_dict_block));
+    if (!index)
+        return NULL;
+    index->nblocks = 0;
+    for (b = 0; b < nblocks; b++)
+    {
+        struct zstd_pg_meta m;
+        if (metas[b].length < ZSTD_META_SIZE)
+            continue;
+        get_meta(metas[b].content, &m);
+        if (m.dict_len == 0)
+            continue;
+        index->blocks[index->nblocks].writer = get_writer(metas[b].content);
+        index->blocks[index->nblocks].dict_id = m.dict_id;
+        index->blocks[index->nblocks].blockidx = b;
+        index->nblocks++;
+    }
+    qsort(index->blocks, index->nblocks, sizeof(struct zstd_dict_block), compare_dict_blocks);
+
+    reqgroup->transform_internal = index;
+    return index;
+}
+
+/*
+ * Find the block holding dictionary dict_id of the block blockidx: a block
+ * of the same writer, the closest one at or before blockidx.
+ */
+static int find_dict_block(adios_transform_read_request *reqgroup, const void *metadata,
+                           int blockidx, uint32_t dict_id)
+{
+    const struct zstd_dict_index *index = get_dict_index(reqgroup);
+    const uint32_t writer = get_writer(metadata);
+    int lo = 0, hi, i;
+    int found = -1;
+
+    if (!index)
+        return -1;
+
+    // first block of the writer
+    hi = index->nblocks;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (index->blocks[mid].writer < writer)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (i = lo; i < index->nblocks && index->blocks[i].writer == writer; i++)
+    {
+        if (index->blocks[i].dict_id != dict_id)
+            continue;
+        if (index->blocks[i].blockidx > blockidx && found >= 0)
+            break;
+        found = index->blocks[i].blockidx;
+    }
+    return found;
+}
+
+int adios_transform_zstd_generate_read_subrequests(adios_transform_read_request *reqgroup,
+                                                   adios_transform_pg_read_request *pg_reqgroup)
+{
+    struct zstd_pg_meta m;
+    get_meta(pg_reqgroup->transform_metadata, &m);
+
+    // The payload (first request), after the dictionary stored in this PG
+    if (m.compress_ok == 1 && m.chunk_size > 0)
+    {
+        // only read and decompress the sub-chunks the selection needs
+        adios_transform_chunked_generate_read_subrequests(reqgroup, pg_reqgroup, m.dict_len, m.chunk_size);
+    }
+    else
+    {
+        uint64_t payload_len = pg_reqgroup->raw_var_length - m.dict_len;
+        void *buf = malloc(payload_len);
+        assert(buf);
+        adios_transform_raw_read_request *subreq =
+                adios_transform_raw_read_request_new_byte_segment(pg_reqgroup, m.dict_len, payload_len, buf);
+        adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    }
+
+    // The dictionary (second request), which may be in another PG
+    if (m.compress_ok == 1 && m.dict_id != 0)
+    {
+        int dict_blockidx = find_dict_block(reqgroup, pg_reqgroup->transform_metadata,
+                                            pg_reqgroup->blockidx, m.dict_id);
+        if (dict_blockidx < 0)
+        {
+            adios_error(err_unspecified,
+                        "zstd transform: dictionary %u of block %d was not found, "
+                        "it is stored in an earlier step of the variable\n",
+                        m.dict_id, pg_reqgroup->blockidx);
+            return 1;
+        }
+
+        struct zstd_pg_meta dm;
+        get_meta(reqgroup->transinfo->transform_metadatas[dict_blockidx].content, &dm);
+
+        ADIOS_SELECTION *sel = common_read_selection_writeblock(dict_blockidx);
+        sel->u.block.is_absolute_index = 1;
+        sel->u.block.is_sub_pg_selection = 1;
+        sel->u.block.element_offset = 0;
+        sel->u.block.nelements = dm.dict_len;
+
+        void *buf = malloc(dm.dict_len);
+        assert(buf);
+        adios_transform_raw_read_request *subreq = adios_transform_raw_read_request_new(sel, buf);
+        subreq->transform_internal = malloc(sizeof(uint32_t));
+        *(uint32_t *)subreq->transform_internal = dm.dict_len;
+        adios_transform_raw_read_request_append(pg_reqgroup, subreq);
+    }
+    return 0;
+}
+
+// Do nothing for individual subrequest
+adios_datablock * adios_transform_zstd_subrequest_completed(adios_transform_read_request *reqgroup,
+                                                            adios_transform_pg_read_request *pg_reqgroup,
+                                                            adios_transform_raw_read_request *completed_subreq)
+{
+    return NULL;
+}
+
+adios_datablock * adios_transform_zstd_pg_reqgroup_completed(adios_transform_read_request *reqgroup,
+                                                             adios_transform_pg_read_request *completed_pg_reqgroup)
+{
+    struct zstd_pg_meta m;
+    get_meta(completed_pg_reqgroup->transform_metadata, &m);
+
+    uint64_t compressed_size = (uint64_t)completed_pg_reqgroup->raw_var_length - m.dict_len;
+    const adios_transform_raw_read_request *subreq, *payload_subreq = NULL, *dict_subreq = NULL;
+    ZSTD_DDict *ddict = NULL;
+    adios_datablock *db = NULL;
+
+    // the dictionary request is the one with its length attached
+    for (subreq = completed_pg_reqgroup->subreqs; subreq; subreq = subreq->next)
+    {
+        if (subreq->transform_internal)
+            dict_subreq = subreq;
+        else
+            payload_subreq = subreq;
+    }
+
+    if (m.compress_ok == 1 && m.dict_id != 0)
+    {
+        if (!dict_subreq)
+            return NULL; // the dictionary was not found
+        ddict = ZSTD_createDDict(dict_subreq->data, *(uint32_t *)dict_subreq->transform_internal);
+        if (!ddict)
+            return NULL;
+    }
+
+    // shuffle stage in front of the decompressor, if the data was shuffled
+    struct adios_transform_shuffle_stage shuffle;
+    adios_transform_shuffle_read_metadata(&shuffle, completed_pg_reqgroup->transform_metadata,
+                                          completed_pg_reqgroup->transform_metadata_len, ZSTD_META_SIZE);
+    shuffle.fn = decompress_zstd_chunk;
+    shuffle.arg = ddict;
+
+    if (m.compress_ok == 1 && m.chunk_size > 0)
+    {
+        db = adios_transform_chunked_pg_reqgroup_completed(reqgroup, completed_pg_reqgroup, m.chunk_size,
+                                                           adios_transform_shuffle_decompress, &shuffle);
+        ZSTD_freeDDict(ddict);
+        return db;
+    }
+
+    uint64_t uncompressed_size = adios_get_type_size(reqgroup->transinfo->orig_type, "");
+    int d = 0;
+    for(d = 0; d < reqgroup->transinfo->orig_ndim; d++)
+    {
+        uncompressed_size *= (uint64_t)(completed_pg_reqgroup->orig_varblock->count[d]);
+    }
+
+    if(m.orig_size != uncompressed_size)
+    {
+        log_warn("zstd transform: possible wrong data size or corrupted metadata\n");
+    }
+
+    void* compressed_data = payload_subreq->data;
+    void* uncompressed_data = malloc(uncompressed_size);
+    if(!uncompressed_data)
+    {
+        ZSTD_freeDDict(ddict);
+        return NULL;
+    }
+
+    if(m.compress_ok == 1)    // compression is successful
+    {
+        int rtn = adios_transform_shuffle_decompress(compressed_data, compressed_size, uncompressed_data, &uncompressed_size, &shuffle);
+        ZSTD_freeDDict(ddict);
+        if(0 != rtn)
+        {
+            free(uncompressed_data);
+            return NULL;
+        }
+    }
+    else    // just copy the buffer since data is not compressed
+    {
+        memcpy(uncompressed_data, compressed_data, compressed_size);
+    }
+
+    return adios_datablock_new_whole_pg(reqgroup, completed_pg_reqgroup, uncompressed_data);
+}
+
+adios_datablock * adios_transform_zstd_reqgroup_completed(adios_transform_read_request *completed_reqgroup)
+{
+    return NULL;
+}
+
+
+#else
+
+DECLARE_TRANSFORM_READ_METHOD_UNIMPL(zstd);
+
+#endif
@@ -0,0 +1,451 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "core/adios_logger.h"
+#include "core/transforms/adios_transforms_common.h"
+#include "core/transforms/adios_transforms_write.h"
+#include "core/transforms/adios_transforms_hooks_write.h"
+#include "core/transforms/adios_transforms_util.h"
+#include "core/transforms/adios_transforms_chunked.h"
+#include "core/transforms/adios_transforms_shuffle.h"
+#include "adios_transform_zstd_common.h"
+
+#ifdef ZSTD
+
+#include "zstd.h"
+#include "zdict.h"
+
+#define ZSTD_DICT_SAMPLE_SIZE (16 * 1024)   // dictionary training samples
+#define ZSTD_DICT_MIN_SAMPLES 8
+
+// Compression parameters from the transform spec
+struct zstd_params
+{
+    int level;
+    int ldm;                // long distance matching
+    int window_log;         // 0 = zstd default
+    uint64_t dict_size;     // dictionary capacity, 0 = no dictionary
+    const ZSTD_CDict *cdict;
+};
+
+// Dictionary of a variable, kept across steps
+struct zstd_var_dict
+{
+    const struct adios_var_struct *var;     // the definition of the variable
+    int trained;            // training was tried
+    void *dict;
+    size_t dict_len;
+    uint32_t dict_id;
+    ZSTD_CDict *cdict;
+
+    // where the dictionary was last stored
+    char *file_name;
+    uint32_t time_index;
+
+    struct zstd_var_dict *next;
+};
+
+static struct zstd_var_dict *var_dicts = NULL;
+// deferred writes transform different variables at the same time
+static pthread_mutex_t var_dicts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void parse_params(const struct adios_transform_spec *spec, struct zstd_params *p)
+{
+    int i;
+
+    p->level = ZSTD_CLEVEL_DEFAULT;
+    p->ldm = 0;
+    p->window_log = 0;
+    p->dict_size = 0;
+    p->cdict = NULL;
+
+    for (i = 0; i < spec->param_count; i++)
+    {
+        const struct adios_transform_spec_kv_pair *param = &spec->params[i];
+        if (i == 0 && !param->value)
+        {
+            p->level = atoi(param->key);
+            if (p->level < ZSTD_minCLevel() || p->level > ZSTD_maxCLevel())
+                p->level = ZSTD_CLEVEL_DEFAULT;
+        }
+        else if (!strcasecmp(param->key, "ldm"))
+        {
+            p->ldm = (!param->value || atoi(param->value) != 0);
+        }
+        else if (!strcasecmp(param->key, "window") && param->value)
+        {
+            ZSTD_bounds bounds = ZSTD_cParam_getBounds(ZSTD_c_windowLog);
+            p->window_log = atoi(param->value);
+            if (p->window_log < bounds.lowerBound || p->window_log > bounds.upperBound)
+            {
+                log_warn("zstd transform: window log %s out of range, using the default\n", param->value);
+                p->window_log = 0;
+            }
+        }
+        else if (!strcasecmp(param->key, "dict") && param->value)
+        {
+            long long kb = atoll(param->value);
+            if (kb > 0)
+                p->dict_size = (uint64_t)kb * 1024;
+        }
+    }
+}
+
+// One compression context per thread, freed when the thread exits
+static pthread_key_t cctx_key;
+static pthread_once_t cctx_key_once = PTHREAD_ONCE_INIT;
+
+static void free_cctx(void *cctx)
+{
+    ZSTD_freeCCtx((ZSTD_CCtx *)cctx);
+}
+
+static void create_cctx_key(void)
+{
+    pthread_key_create(&cctx_key, free_cctx);
+}
+
+static ZSTD_CCtx * get_cctx(void)
+{
+    ZSTD_CCtx *cctx;
+
+    pthread_once(&cctx_key_once, create_cctx_key);
+    cctx = (ZSTD_CCtx *)pthread_getspecific(cctx_key);
+    if (!cctx)
+    {
+        cctx = ZSTD_createCCtx();
+        if (cctx && pthread_setspecific(cctx_key, cctx))
+        {
+            ZSTD_freeCCtx(cctx);
+            cctx = NULL;
+        }
+    }
+    return cctx;
+}
+
+static int compress_zstd_chunk(const void* input_data, uint64_t input_len,
+                               void* output_data, uint64_t* output_len, void* arg)
+{
+    const struct zstd_params *p = (const struct zstd_params *)arg;
+    ZSTD_CCtx *cctx = get_cctx();
+    size_t rtn;
+
+    if (!cctx)
+        return -1;
+
+    // the context keeps the parameters of its last use
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, p->level);
+    if (p->ldm)
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+    if (p->window_log)
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, p->window_log);
+    if (p->cdict)
+        ZSTD_CCtx_refCDict(cctx, p->cdict);
+
+    rtn = ZSTD_compress2(cctx, output_data, *output_len, input_data, input_len);
+
+    if (ZSTD_isError(rtn))
+    {
+        // including an output that does not fit in *output_len bytes
+        return -1;
+    }
+
+    *output_len = (uint64_t)rtn;
+    return 0;
+}
+
+static struct zstd_var_dict * find_var_dict(const struct adios_var_struct *var)
+{
+    struct zstd_var_dict *d;
+
+    // a deferred write transforms the copy of the variable in vars_written
+    if (var->parent_var)
+        var = var->parent_var;
+
+    pthread_mutex_lock(&var_dicts_lock);
+    for (d = var_dicts; d; d = d->next)
+        if (d->var == var)
+            break;
+
+    if (!d)
+    {
+        d = (struct zstd_var_dict *)calloc(1, sizeof(struct zstd_var_dict));
+        d->var = var;
+        d->next = var_dicts;
+        var_dicts = d;
+    }
+    pthread_mutex_unlock(&var_dicts_lock);
+    return d;
+}
+
+// Train a dictionary on samples spread over the block
+static void train_dict(struct zstd_var_dict *d, const struct zstd_params *p,
+                       const void *input, uint64_t input_size, const char *var_name)
+{
+    uint64_t nsamples = input_size / ZSTD_DICT_SAMPLE_SIZE;
+    uint64_t max_samples = 100 * p->dict_size / ZSTD_DICT_SAMPLE_SIZE; // ~100x the dictionary
+    uint64_t stride, i;
+    size_t *sizes;
+    char *samples;
+    size_t len;
+
+    d->trained = 1;
+    if (nsamples < ZSTD_DICT_MIN_SAMPLES)
+    {
+        log_warn("zstd transform: %s is too small to train a dictionary\n", var_name);
+        return;
+    }
+    if (nsamples > max_samples)
+        nsamples = max_samples;
+    stride = input_size / nsamples;
+
+    samples = (char *)malloc(nsamples * ZSTD_DICT_SAMPLE_SIZE);
+    sizes = (size_t *)malloc(nsamples * sizeof(size_t));
+    d->dict = malloc(p->dict_size);
+    if (!samples || !sizes || !d->dict)
+    {
+        free(samples);
+        free(sizes);
+        free(d->dict);
+        d->dict = NULL;
+        return;
+    }
+
+    for (i = 0; i < nsamples; i++)
+    {
+        memcpy(samples + i * ZSTD_DICT_SAMPLE_SIZE, (const char *)input + i * stride, ZSTD_DICT_SAMPLE_SIZE);
+        sizes[i] = ZSTD_DICT_SAMPLE_SIZE;
+    }
+
+    len = ZDICT_trainFromBuffer(d->dict, p->dict_size, samples, sizes, (unsigned)nsamples);
+    free(samples);
+    free(sizes);
+
+    if (ZDICT_isError(len))
+    {
+        log_warn("zstd transform: cannot train a dictionary for %s: %s\n", var_name, ZDICT_getErrorName(len));
+        free(d->dict);
+        d->dict = NULL;
+        return;
+    }
+
+    d->dict_len = len;
+    d->dict_id = ZDICT_getDictID(d->dict, len);
+    d->cdict = ZSTD_createCDict(d->dict, len, p->level);
+    log_debug("zstd transform: trained a %llu byte dictionary (id %u) for %s\n",
+              (unsigned long long)len, d->dict_id, var_name);
+}
+
+// Whether the dictionary must be stored in the block written now
+static int dict_needed_in_file(struct zstd_var_dict *d, const struct adios_file_struct *fd)
+{
+    if (!d->file_name || strcmp(d->file_name, fd->name))
+        return 1;
+    // a new file of the same name
+    return (fd->mode == adios_mode_write && d->time_index != fd->group->time_index);
+}
+
+uint16_t adios_transform_zstd_get_metadata_size(struct adios_transform_spec *transform_spec)
+{
+    if (transform_spec->shuffle != adios_transform_shuffle_none)
+        return ZSTD_META_SIZE + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE;
+    return ZSTD_META_SIZE;
+}
+
+void adios_transform_zstd_transformed_size_growth(
+		const struct adios_var_struct *var, const struct adios_transform_spec *transform_spec,
+		uint64_t *constant_factor, double *linear_factor, double *capped_linear_factor, uint64_t *capped_linear_cap)
+{
+    struct zstd_params p;
+    uint64_t chunk_size;
+    int nthreads;
+
+    parse_params(transform_spec, &p);
+    adios_transform_chunked_parse_spec(transform_spec, &chunk_size, &nthreads);
+
+    // The dictionary stored in the block, and the offset table of chunked data
+    *constant_factor = p.dict_size;
+    if (chunk_size) {
+        *constant_factor += sizeof(uint64_t);
+        *linear_factor = 1.0 + (double)sizeof(uint64_t) / chunk_size;
+    }
+}
+
+int adios_transform_zstd_apply(struct adios_file_struct *fd,
+                               struct adios_var_struct *var,
+                               uint64_t *transformed_len,
+                               int use_shared_buffer,
+                               int *wrote_to_shared_buffer)
+{
+    // Assume this function is only called for ZSTD transform type
+    assert(var->transform_type == adios_transform_zstd);
+
+    // Get the input data and data length
+    const uint64_t input_size = adios_transform_get_pre_transform_var_size(var);
+    const void *input_buff= var->data;
+
+    struct zstd_params params;
+    parse_params(var->transform_spec, &params);
+
+    // large blocks are compressed in sub-chunks if the spec asks for it
+    uint64_t chunk_size;
+    int nthreads;
+    adios_transform_chunked_parse_spec(var->transform_spec, &chunk_size, &nthreads);
+
+    // shuffle the data (each sub-chunk on its own) before compressing it if asked for
+    struct adios_transform_shuffle_stage shuffle = {
+        var->transform_spec->shuffle, adios_get_type_size(var->pre_transform_type, NULL),
+        compress_zstd_chunk, &params
+    };
+    chunk_size = adios_transform_shuffle_align_chunk(&shuffle, chunk_size);
+    if (input_size <= chunk_size)
+        chunk_size = 0;
+
+    // the dictionary of the variable, trained on its first block
+    struct zstd_var_dict *dict = NULL;
+    uint32_t dict_id = 0, dict_len = 0;
+    if (params.dict_size)
+    {
+        dict = find_var_dict(var);
+        if (!dict->trained && shuffle.kind != adios_transform_shuffle_none)
+        {
+            // train on data that looks like what the dictionary will compress
+            char *shuffled = malloc(2 * input_size);
+            if (shuffled)
+            {
+                adios_transform_shuffle(shuffle.kind, shuffle.elem_size, input_buff, input_size,
+                                        shuffled, shuffled + input_size);
+                train_dict(dict, &params, shuffled, input_size, var->name);
+                free(shuffled);
+            }
+        }
+        if (!dict->trained)
+            train_dict(dict, &params, input_buff, input_size, var->name);
+        if (dict->cdict)
+        {
+            params.cdict = dict->cdict;
+            dict_id = dict->dict_id;
+            if (dict_needed_in_file(dict, fd))
+                dict_len = (uint32_t)dict->dict_len;
+        }
+    }
+
+    // decide the output buffer
+    uint64_t payload_size = input_size; // for compression, at most the original data size
+    if (chunk_size)
+        payload_size = adios_transform_chunked_bound(input_size, chunk_size); // and the offset table
+    uint64_t output_size = dict_len + payload_size;
+    char* output_buff = NULL;
+
+    if (use_shared_buffer)    // If shared buffer is permitted, serialize to there
+    {
+        *wrote_to_shared_buffer = 1;
+        if (!shared_buffer_reserve(fd, output_size))
+        {
+            log_error("Out of memory allocating %llu bytes for %s for zstd transform\n", output_size, var->name);
+            return 0;
+        }
+
+        // Write directly to the shared buffer
+        output_buff = fd->buffer + fd->offset;
+    }
+    else    // Else, fall back to var->data memory allocation
+    {
+        *wrote_to_shared_buffer = 0;
+        output_buff = malloc(output_size);
+        if (!output_buff)
+        {
+            log_error("Out of memory allocating %llu bytes for %s for zstd transform\n", output_size, var->name);
+            return 0;
+        }
+    }
+
+    if (dict_len)
+        memcpy(output_buff, dict->dict, dict_len);
+
+    // compress it
+    uint64_t actual_output_size = payload_size;
+    char compress_ok = 1;
+
+    int rtn;
+    if (chunk_size)
+        rtn = adios_transform_chunked_compress(input_buff, input_size, chunk_size, nthreads,
+                                               adios_transform_shuffle_compress, &shuffle,
+                                               output_buff + dict_len, &actual_output_size);
+    else
+        rtn = adios_transform_shuffle_compress(input_buff, input_size, output_buff + dict_len, &actual_output_size, &shuffle);
+
+    if(0 != rtn                     // compression failed for some reason, then just copy the buffer
+        || actual_output_size > input_size)  // or size after compression is even larger
+    {
+        memcpy(output_buff + dict_len, input_buff, input_size);
+        actual_output_size = input_size;
+        compress_ok = 0;    // succ sign set to 0
+        chunk_size = 0;
+    }
+    actual_output_size += dict_len;
+
+    // a stored dictionary serves the later blocks of the file
+    if (dict_len)
+    {
+        free(dict->file_name);
+        dict->file_name = strdup(fd->name);
+        dict->time_index = fd->group->time_index;
+    }
+
+    // Wrap up, depending on buffer mode
+    if (use_shared_buffer)
+    {
+        shared_buffer_mark_written(fd, actual_output_size);
+    }
+    else
+    {
+        var->data = output_buff;
+        var->data_size = actual_output_size;
+        var->free_data = adios_flag_yes;
+    }
+
+    // copy the metadata
+    if(var->transform_metadata && var->transform_metadata_len >= ZSTD_META_SIZE)
+    {
+        char *meta = (char*)var->transform_metadata;
+        memcpy(meta + ZSTD_META_ORIG_SIZE, &input_size, sizeof(uint64_t));
+        memcpy(meta + ZSTD_META_OK, &compress_ok, sizeof(char));
+        memcpy(meta + ZSTD_META_CHUNK_SIZE, &chunk_size, sizeof(uint64_t));
+        memcpy(meta + ZSTD_META_DICT_ID, &dict_id, sizeof(uint32_t));
+        memcpy(meta + ZSTD_META_DICT_LEN, &dict_len, sizeof(uint32_t));
+        memcpy(meta + ZSTD_META_WRITER, &fd->group->process_id, sizeof(uint32_t));
+        if (var->transform_metadata_len >= ZSTD_META_SIZE + ADIOS_TRANSFORM_SHUFFLE_METADATA_SIZE)
+            adios_transform_shuffle_write_metadata(&shuffle, meta, ZSTD_META_SIZE);
+    }
+
+    *transformed_len = actual_output_size; // Return the size of the data buffer
+
+    return 1;
+}
+
+void adios_transform_zstd_finalize()
+{
+    pthread_mutex_lock(&var_dicts_lock);
+    while (var_dicts)
+    {
+        struct zstd_var_dict *d = var_dicts;
+        var_dicts = d->next;
+        ZSTD_freeCDict(d->cdict);
+        free(d->dict);
+        free(d->file_name);
+        free(d);
+    }
+    pthread_mutex_unlock(&var_dicts_lock);
+}
+
+#else
+
+DECLARE_TRANSFORM_WRITE_METHOD_UNIMPL(zstd)
+
+#endif
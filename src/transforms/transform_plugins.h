@@ -11,4 +11,7 @@ REGISTER_TRANSFORM_PLUGIN(szip, "szip", "szip", "szip compression")
 REGISTER_TRANSFORM_PLUGIN(isobar, "isobar", "ncsu-isobar", "ISOBAR compression")
 REGISTER_TRANSFORM_PLUGIN(aplod, "aplod", "ncsu-aplod", "APLOD byte-columnar precision-level-of-detail access format")
 REGISTER_TRANSFORM_PLUGIN(alacrity, "alacrity", "ncsu-alacrity", "ALACRITY indexing")
-
+REGISTER_TRANSFORM_PLUGIN(lz4, "lz4", "lz4", "LZ4 compression")
+REGISTER_TRANSFORM_PLUGIN(zstd, "zstd", "zstd", "Zstandard compression")
+REGISTER_TRANSFORM_PLUGIN(lossy, "lossy", "lossy", "Error-bounded lossy compression of floating-point data")
+REGISTER_TRANSFORM_PLUGIN(auto, "auto", "auto", "Per-block choice of the compression transform")
@@ -0,0 +1,833 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/*
+ * BURST_BUFFER method: each process writes its BP subfile to a node-local
+ * directory (tmpfs or an SSD) at adios_close(), and a thread drains the
+ * step into the subfile on the parallel file system while the application
+ * computes. The global metadata file is gathered at adios_close() as with
+ * POSIX, but it is only published, with an atomic rename, once every
+ * process has drained the step: at the next adios_open() or at
+ * adios_finalize(). Readers see either the previous or the new file, never
+ * subfiles that are still being copied.
+ *
+ * The output is the same as the POSIX method's:
+ *   name          global metadata
+ *   name.dir/     name.0, name.1, ... one subfile per process
+ *
+ * Parameters:
+ *   local_path=<dir>  node-local directory for the subfiles (default /tmp)
+ *   keep_local=yes    keep the local subfiles after the drain
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+
+// see if we have MPI or other tools
+#include "config.h"
+
+// xml parser
+#include <mxml.h>
+
+#include "public/adios_mpi.h"
+#include "public/adios_error.h"
+#include "core/adios_transport_hooks.h"
+#include "core/adios_bp_v1.h"
+#include "core/adios_internals.h"
+#include "core/buffer.h"
+#include "core/util.h"
+#include "core/adios_logger.h"
+
+#if defined(__APPLE__)
+#    define O_LARGEFILE 0
+#endif
+
+#define BB_DRAIN_BUFFER_SIZE (16*1024*1024)
+
+static int adios_bb_initialized = 0;
+
+/* The bytes of a subfile written in one step, copied from the local subfile
+   to the subfile on the parallel file system by a thread */
+struct adios_bb_drain_struct
+{
+    pthread_t thread;
+    char * local_name;
+    char * target_name;
+    uint64_t start;         // first byte written in this step
+    uint64_t end;           // end of the subfile (after the index)
+    int keep_local;
+    int started;            // 0 if drained (or failed) in adios_close
+    int error;              // errno of the failure, 0 if none
+};
+
+struct adios_BB_data_struct
+{
+    // our file bits (the local subfile)
+    struct adios_bp_buffer_struct_v1 b;
+
+    // old index structs we read in and have to be merged in
+    struct adios_index_struct_v1 * index;
+
+    char * local_path;
+    int keep_local;
+
+    MPI_Comm group_comm;    // duplicate, kept until the step is published
+    int rank;
+    int size;
+
+    char * local_name;
+    char * target_name;
+    struct adios_bb_drain_struct * drain; // step being drained, 0 if none
+
+    // global metadata of the last step, written by rank 0 after the drain
+    char * md_name;
+    char * md_buffer;
+    uint64_t md_size;
+};
+
+void adios_burst_buffer_init (const PairStruct * parameters
+                             ,struct adios_method_struct * method
+                             )
+{
+    struct adios_BB_data_struct * p = 0;
+
+    if (!adios_bb_initialized)
+    {
+        adios_bb_initialized = 1;
+    }
+    method->method_data = calloc (1, sizeof (struct adios_BB_data_struct));
+    p = (struct adios_BB_data_struct *) method->method_data;
+    adios_buffer_struct_init (&p->b);
+    p->index = adios_alloc_index_v1(1); // with hashtables
+    p->group_comm = MPI_COMM_NULL;
+
+    const PairStruct * pa = parameters;
+    while (pa)
+    {
+        if (!strcasecmp (pa->name, "local_path"))
+        {
+            free (p->local_path);
+            p->local_path = strdup (pa->value);
+        }
+        else if (!strcasecmp (pa->name, "keep_local"))
+        {
+            if (!strcasecmp (pa->value, "yes") || !strcmp (pa->value, "1"))
+            {
+                p->keep_local = 1;
+            }
+            else if (!strcasecmp (pa->value, "no") || !strcmp (pa->value, "0"))
+            {
+                p->keep_local = 0;
+            }
+            else
+            {
+                log_error ("Invalid 'keep_local' parameter given to the BURST_BUFFER "
+                           "method: '%s', use 'yes' or 'no'\n", pa->value);
+            }
+        }
+        else
+        {
+            log_warn ("Parameter name %s is not recognized by the BURST_BUFFER "
+                      "method\n", pa->name);
+        }
+        pa = pa->next;
+    }
+
+    if (!p->local_path)
+    {
+        p->local_path = strdup ("/tmp");
+    }
+}
+
+static int adios_bb_copy (int from, int to, uint64_t start, uint64_t end)
+{
+    char * buf = malloc (BB_DRAIN_BUFFER_SIZE);
+    uint64_t offset = start;
+    int err = 0;
+
+    if (!buf)
+        return ENOMEM;
+
+    while (offset < end && !err)
+    {
+        uint64_t n = end - offset;
+        ssize_t r, w, done = 0;
+
+        if (n > BB_DRAIN_BUFFER_SIZE)
+            n = BB_DRAIN_BUFFER_SIZE;
+
+        r = pread (from, buf, n, (off_t) offset);
+        if (r < 0)
+        {
+            if (errno != EINTR)
+                err = errno;
+            continue;
+        }
+        if (r == 0)
+        {
+            err = EIO;
+            break;
+        }
+        while (done < r)
+        {
+            w = pwrite (to, buf + done, r - done, (off_t) (offset + done));
+            if (w < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                err = errno;
+                break;
+            }
+            done += w;
+        }
+        offset += r;
+    }
+
+    free (buf);
+    return err;
+}
+
+static void * adios_bb_drain_thread (void * arg)
+{
+    struct adios_bb_drain_struct * d = (struct adios_bb_drain_struct *) arg;
+    int from, to;
+
+    from = open (d->local_name, O_RDONLY | O_LARGEFILE);
+    if (from == -1)
+    {
+        d->error = errno;
+        return NULL;
+    }
+    to = open (d->target_name, O_WRONLY | O_CREAT | O_LARGEFILE
+                             ,  S_IRUSR | S_IWUSR
+                              | S_IRGRP | S_IWGRP
+                              | S_IROTH | S_IWOTH
+              );
+    if (to == -1)
+    {
+        d->error = errno;
+        close (from);
+        return NULL;
+    }
+
+    d->error = adios_bb_copy (from, to, d->start, d->end);
+    // the old index of an appended subfile can be longer than the new one
+    if (!d->error && ftruncate (to, (off_t) d->end))
+        d->error = errno;
+    if (!d->error && fsync (to))
+        d->error = errno;
+    if (close (to) && !d->error)
+        d->error = errno;
+    close (from);
+
+    if (!d->error && !d->keep_local)
+    {
+        // an appending step reads the old index from the drained subfile
+        unlink (d->local_name);
+    }
+
+    return NULL;
+}
+
+// collect the drain of the last step, returns its errno
+static int adios_bb_wait_drain (struct adios_BB_data_struct * p)
+{
+    struct adios_bb_drain_struct * d = p->drain;
+    int err;
+
+    if (!d)
+        return 0;
+
+    if (d->started)
+    {
+        pthread_join (d->thread, NULL);
+    }
+    err = d->error;
+    if (err)
+    {
+        log_error ("BURST_BUFFER method: cannot drain %s to %s: %s\n"
+                  ,d->local_name, d->target_name, strerror (err)
+                  );
+    }
+
+    free (d->local_name);
+    free (d->target_name);
+    free (d);
+    p->drain = 0;
+
+    return err;
+}
+
+static int adios_bb_write_at (int f, const char * buf, uint64_t size, uint64_t offset)
+{
+    ssize_t s;
+
+    while (size > 0)
+    {
+        s = pwrite (f, buf, (size > MAX_MPIWRITE_SIZE ? MAX_MPIWRITE_SIZE : size)
+                   ,(off_t) offset
+                   );
+        if (s < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (s == 0)
+        {
+            return EIO;
+        }
+        buf += s;
+        size -= s;
+        offset += s;
+    }
+
+    return 0;
+}
+
+/* Wait until every process has drained the last step, then publish its
+   metadata file (rank 0). Collective over the processes of that step. */
+static void adios_bb_publish (struct adios_BB_data_struct * p)
+{
+    int err, any_err = 0;
+
+    if (p->group_comm == MPI_COMM_NULL)
+        return;
+
+    err = adios_bb_wait_drain (p);
+    MPI_Allreduce (&err, &any_err, 1, MPI_INT, MPI_MAX, p->group_comm);
+
+    if (p->md_buffer)
+    {
+        if (any_err)
+        {
+            log_error ("BURST_BUFFER method: a subfile of %s could not be drained, "
+                       "its metadata is not published\n", p->md_name);
+        }
+        else
+        {
+            char * tmp_name = malloc (strlen (p->md_name) + 5);
+            int f;
+
+            sprintf (tmp_name, "%s.tmp", p->md_name);
+            f = open (tmp_name, O_WRONLY | O_CREAT | O_TRUNC | O_LARGEFILE
+                              ,  S_IRUSR | S_IWUSR
+                               | S_IRGRP | S_IWGRP
+                               | S_IROTH | S_IWOTH
+                     );
+            err = (f == -1 ? errno : adios_bb_write_at (f, p->md_buffer, p->md_size, 0));
+            if (f != -1)
+            {
+                if (!err && fsync (f))
+                    err = errno;
+                close (f);
+            }
+            if (!err && rename (tmp_name, p->md_name))
+                err = errno;
+            if (err)
+            {
+                log_error ("BURST_BUFFER method: cannot write metadata file %s: %s\n"
+                          ,p->md_name, strerror (err)
+                          );
+                unlink (tmp_name);
+            }
+            free (tmp_name);
+        }
+
+        free (p->md_buffer);
+        p->md_buffer = 0;
+        p->md_size = 0;
+    }
+    free (p->md_name);
+    p->md_name = 0;
+
+    MPI_Comm_free (&p->group_comm);
+    p->group_comm = MPI_COMM_NULL;
+}
+
+int adios_burst_buffer_open (struct adios_file_struct * fd
+                            ,struct adios_method_struct * method, MPI_Comm comm
+                            )
+{
+    struct adios_BB_data_struct * p = (struct adios_BB_data_struct *)
+                                                          method->method_data;
+    char rank_string[16];
+    char * n;
+    struct stat s;
+
+    // the previous step has to be on the file system before this one
+    // overwrites its index
+    adios_bb_publish (p);
+    free (p->local_name);
+    free (p->target_name);
+    p->local_name = 0;
+    p->target_name = 0;
+
+    if (fd->mode == adios_mode_read)
+    {
+        adios_error (err_invalid_file_mode, "BURST_BUFFER method: "
+                     "read mode is not supported, file %s\n", fd->name);
+        return 0;
+    }
+
+    if (comm == MPI_COMM_NULL)
+    {
+        comm = MPI_COMM_SELF;
+    }
+    MPI_Comm_dup (comm, &p->group_comm);
+    MPI_Comm_rank (p->group_comm, &p->rank);
+    MPI_Comm_size (p->group_comm, &p->size);
+    fd->group->process_id = p->rank;
+    fd->subfile_index = p->rank;
+
+    n = strrchr (fd->name, '/');
+    if (!n)
+    {
+        n = fd->name;
+    }
+    else
+    {
+        n++;
+    }
+    sprintf (rank_string, "%d", p->rank);
+
+    // e.g. /tmp/restart.bp.0 and restart.bp.dir/restart.bp.0
+    p->local_name = malloc (strlen (p->local_path) + strlen (n) + strlen (rank_string) + 3);
+    sprintf (p->local_name, "%s/%s.%s", p->local_path, n, rank_string);
+    p->target_name = malloc (strlen (method->base_path) + strlen (fd->name)
+                            + strlen (n) + strlen (rank_string) + 7);
+    sprintf (p->target_name, "%s%s.dir/%s.%s", method->base_path, fd->name, n, rank_string);
+    p->md_name = malloc (strlen (method->base_path) + strlen (fd->name) + 1);
+    sprintf (p->md_name, "%s%s", method->base_path, fd->name);
+
+    if (p->rank == 0)
+    {
+        char * dir_name = malloc (strlen (p->md_name) + 5);
+        sprintf (dir_name, "%s.dir", p->md_name);
+        mkdir (dir_name, S_IRWXU | S_IRWXG);
+        free (dir_name);
+
+        if (fd->mode == adios_mode_write)
+        {
+            // the old subfiles are overwritten while they are drained
+            unlink (p->md_name);
+        }
+    }
+    mkdir (p->local_path, S_IRWXU | S_IRWXG);
+    MPI_Barrier (p->group_comm);
+
+    fd->base_offset = 0;
+    fd->pg_start_in_file = 0;
+
+    if (fd->mode == adios_mode_append || fd->mode == adios_mode_update)
+    {
+        // the index of the earlier steps is in the drained subfile
+        if (stat (p->target_name, &s) == 0 && s.st_size > 0)
+        {
+            uint32_t version;
+
+            p->b.file_size = s.st_size;
+            p->b.f = open (p->target_name, O_RDONLY | O_LARGEFILE);
+            if (p->b.f == -1)
+            {
+                adios_error (err_file_open_error, "BURST_BUFFER method: "
+                             "cannot open %s to append to it\n", p->target_name);
+                return 0;
+            }
+
+            adios_posix_read_version (&p->b);
+            adios_parse_version (&p->b, &version);
+
+            switch (version & ADIOS_VERSION_NUM_MASK)
+            {
+                case 1:
+                case 2:
+                {
+                    struct adios_index_process_group_struct_v1 * pg;
+                    uint32_t max_time_index = 0;
+
+                    adios_posix_read_index_offsets (&p->b);
+                    adios_parse_index_offsets_v1 (&p->b);
+
+                    adios_posix_read_process_group_index (&p->b);
+                    adios_parse_process_group_index_arena_v1 (&p->b, &p->index->pg_root, p->index->arena);
+
+                    // find the largest time index so we can append properly
+                    pg = p->index->pg_root;
+                    while (pg)
+                    {
+                        if (pg->time_index > max_time_index)
+                            max_time_index = pg->time_index;
+                        pg = pg->next;
+                    }
+                    fd->group->time_index = ++max_time_index;
+
+                    adios_posix_read_vars_index (&p->b);
+                    adios_parse_vars_index_arena_v1 (&p->b, &p->index->vars_root,
+                                               p->index->hashtbl_vars,
+                                               &p->index->vars_tail, p->index->arena);
+
+                    adios_posix_read_attributes_index (&p->b);
+                    adios_parse_attributes_index_arena_v1 (&p->b, &p->index->attrs_root, p->index->arena);
+
+                    fd->base_offset = p->b.end_of_pgs;
+                    fd->pg_start_in_file = p->b.end_of_pgs;
+                    break;
+                }
+
+                default:
+                    adios_error (err_file_open_error, "BURST_BUFFER method: "
+                                 "unknown bp version %d, cannot append to %s\n",
+                                 version, p->target_name);
+                    adios_posix_close_internal (&p->b);
+                    return 0;
+            }
+            adios_posix_close_internal (&p->b);
+        }
+    }
+
+    // the local subfile has the same layout as the drained one, it is
+    // sparse below the steps it holds
+    p->b.f = open (p->local_name, O_WRONLY | O_CREAT | O_LARGEFILE
+                                | (fd->mode == adios_mode_write ? O_TRUNC : 0)
+                                ,  S_IRUSR | S_IWUSR
+                                 | S_IRGRP | S_IWGRP
+                                 | S_IROTH | S_IWOTH
+                  );
+    if (p->b.f == -1)
+    {
+        adios_error (err_file_open_error, "BURST_BUFFER method: "
+                     "cannot open local subfile %s: %s\n", p->local_name, strerror (errno));
+        return 0;
+    }
+
+    return 1;
+}
+
+enum ADIOS_FLAG adios_burst_buffer_should_buffer (struct adios_file_struct * fd
+                                                 ,struct adios_method_struct * method
+                                                 )
+{
+    if (fd->shared_buffer == adios_flag_no && fd->mode != adios_mode_read)
+    {
+        adios_error (err_buffer_overflow, "BURST_BUFFER method: the output of %s "
+                     "does not fit in the ADIOS buffer, nothing will be written\n",
+                     fd->name);
+    }
+
+    return fd->shared_buffer;   // buffer if there is space
+}
+
+void adios_burst_buffer_write (struct adios_file_struct * fd
+                              ,struct adios_var_struct * v
+                              ,void * data
+                              ,struct adios_method_struct * method
+                              )
+{
+    if (v->got_buffer == adios_flag_yes)
+    {
+        if (data != v->data)  // if the user didn't give back the same thing
+        {
+            if (v->free_data == adios_flag_yes)
+            {
+                free (v->data);
+                adios_method_buffer_free (v->data_size);
+            }
+        }
+    }
+    // the variable is in the buffer, it is written at adios_close
+}
+
+void adios_burst_buffer_get_write_buffer (struct adios_file_struct * fd
+                                         ,struct adios_var_struct * v
+                                         ,uint64_t * size
+                                         ,void ** buffer
+                                         ,struct adios_method_struct * method
+                                         )
+{
+    uint64_t mem_allowed;
+
+    if (*size == 0)
+    {
+        *buffer = 0;
+
+        return;
+    }
+
+    if (v->data && v->free_data)
+    {
+        adios_method_buffer_free (v->data_size);
+        free (v->data);
+    }
+
+    mem_allowed = adios_method_buffer_alloc (*size);
+    if (mem_allowed == *size)
+    {
+        *buffer = malloc (*size);
+        if (!*buffer)
+        {
+            adios_method_buffer_free (mem_allowed);
+            fprintf (stderr, "Out of memory allocating %llu bytes for %s\n"
+                    ,*size, v->name
+                    );
+            v->got_buffer = adios_flag_no;
+            v->free_data = adios_flag_no;
+            v->data_size = 0;
+            v->data = 0;
+            *size = 0;
+            *buffer = 0;
+        }
+        else
+        {
+            v->got_buffer = adios_flag_yes;
+            v->free_data = adios_flag_yes;
+            v->data_size = mem_allowed;
+            v->data = *buffer;
+        }
+    }
+    else
+    {
+        adios_method_buffer_free (mem_allowed);
+        fprintf (stderr, "OVERFLOW: Cannot allocate requested buffer of %llu "
+                         "bytes for %s\n"
+                ,*size
+                ,v->name
+                );
+        *size = 0;
+        *buffer = 0;
+    }
+}
+
+void adios_burst_buffer_read (struct adios_file_struct * fd
+                             ,struct adios_var_struct * v
+                             ,void * buffer
+                             ,uint64_t buffer_size
+                             ,struct adios_method_struct * method
+                             )
+{
+}
+
+// gather the subfile indexes on rank 0 and keep the global metadata
+static void adios_bb_gather_index (struct adios_file_struct * fd
+                                  ,struct adios_BB_data_struct * p
+                                  ,char * buffer, uint64_t buffer_size
+                                  )
+{
+    struct adios_index_process_group_struct_v1 * new_pg_root = 0;
+    struct adios_index_var_struct_v1 * new_vars_root = 0;
+    struct adios_index_attribute_struct_v1 * new_attrs_root = 0;
+
+    if (p->rank == 0)
+    {
+        int * index_sizes = malloc (4 * p->size);
+        int * index_offsets = malloc (4 * p->size);
+        char * recv_buffer = 0;
+        int i;
+        uint32_t size = 0, total_size = 0;
+
+        MPI_Gather (&size, 1, MPI_INT
+                   ,index_sizes, 1, MPI_INT
+                   ,0, p->group_comm
+                   );
+
+        for (i = 0; i < p->size; i++)
+        {
+            index_offsets [i] = total_size;
+            total_size += index_sizes [i];
+        }
+
+        recv_buffer = malloc (total_size);
+        MPI_Gatherv (&size, 0, MPI_BYTE
+                    ,recv_buffer, index_sizes, index_offsets
+                    ,MPI_BYTE, 0, p->group_comm
+                    );
+
+        char * buffer_save = p->b.buff;
+        uint64_t buffer_size_save = p->b.length;
+        uint64_t offset_save = p->b.offset;
+
+        for (i = 1; i < p->size; i++)
+        {
+            p->b.buff = recv_buffer + index_offsets [i];
+            p->b.length = index_sizes [i];
+            p->b.offset = 0;
+
+            adios_parse_process_group_index_v1 (&p->b
+                                               ,&new_pg_root
+                                               );
+            adios_parse_vars_index_v1 (&p->b, &new_vars_root, NULL, NULL);
+            // do not merge attributes from other processes from 1.4
+
+            adios_merge_index_v1 (p->index, new_pg_root,
+                                  new_vars_root, new_attrs_root);
+            new_pg_root = 0;
+            new_vars_root = 0;
+            new_attrs_root = 0;
+        }
+
+        if (fd->mode != adios_mode_write)
+        {
+            adios_sort_index_v1 (&p->index->pg_root
+                                ,&p->index->vars_root
+                                ,&p->index->attrs_root
+                                );
+        }
+
+        p->b.buff = buffer_save;
+        p->b.length = buffer_size_save;
+        p->b.offset = offset_save;
+
+        free (recv_buffer);
+        free (index_sizes);
+        free (index_offsets);
+
+        uint64_t global_index_buffer_size = 0;
+        uint64_t global_index_start = 0;
+        uint16_t flag = 0;
+
+        p->md_buffer = 0;
+        p->md_size = 0;
+        adios_write_index_v1 (&p->md_buffer, &global_index_buffer_size
+                             ,&p->md_size, global_index_start
+                             ,p->index);
+
+        flag |= ADIOS_VERSION_HAVE_SUBFILE;
+
+        adios_write_version_flag_v1 (&p->md_buffer
+                                    ,&global_index_buffer_size
+                                    ,&p->md_size
+                                    ,flag
+                                    );
+    }
+    else
+    {
+        // Added this explicit cast to avoid truncation of low-order bytes on BGP
+        int i_buffer_size = (int) buffer_size;
+        MPI_Gather (&i_buffer_size, 1, MPI_INT
+                   ,0, 0, MPI_INT
+                   ,0, p->group_comm
+                   );
+
+        MPI_Gatherv (buffer, buffer_size, MPI_BYTE
+                    ,0, 0, 0, MPI_BYTE
+                    ,0, p->group_comm
+                    );
+    }
+}
+
+void adios_burst_buffer_close (struct adios_file_struct * fd
+                              ,struct adios_method_struct * method
+                              )
+{
+    struct adios_BB_data_struct * p = (struct adios_BB_data_struct *)
+                                                          method->method_data;
+    struct adios_bb_drain_struct * d;
+    char * buffer = 0;
+    uint64_t buffer_size = 0;
+    uint64_t buffer_offset = 0;
+    uint64_t index_start;
+    int err = 0;
+
+    if (fd->mode == adios_mode_read || p->b.f == -1)
+    {
+        return;
+    }
+
+    // buffered: the process group starts at pg_start_in_file, the index
+    // follows it
+    index_start = fd->base_offset + fd->offset;
+
+    adios_build_index_v1 (fd, p->index);
+    adios_write_index_v1 (&buffer, &buffer_size, &buffer_offset
+                         ,index_start, p->index);
+    adios_bb_gather_index (fd, p, buffer, buffer_offset);
+    adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset);
+
+    if (fd->shared_buffer == adios_flag_yes)
+    {
+        err = adios_bb_write_at (p->b.f, fd->buffer, fd->bytes_written
+                                ,fd->pg_start_in_file
+                                );
+    }
+    if (!err)
+    {
+        err = adios_bb_write_at (p->b.f, buffer, buffer_offset, index_start);
+    }
+    free (buffer);
+    if (close (p->b.f) && !err)
+    {
+        err = errno;
+    }
+    p->b.f = -1;
+
+    adios_posix_close_internal (&p->b);
+    adios_clear_index_v1 (p->index);
+
+    if (err)
+    {
+        adios_error (err_write_error, "BURST_BUFFER method: cannot write local subfile %s: %s\n"
+                    ,p->local_name, strerror (err)
+                    );
+    }
+
+    // drain in the background, also after a failed write so that every
+    // process takes part in the publication of the step
+    d = (struct adios_bb_drain_struct *) calloc (1, sizeof (struct adios_bb_drain_struct));
+    d->local_name = p->local_name;
+    d->target_name = p->target_name;
+    d->start = fd->pg_start_in_file;
+    d->end = index_start + buffer_offset;
+    d->keep_local = p->keep_local;
+    d->error = err;
+    p->local_name = 0;
+    p->target_name = 0;
+    p->drain = d;
+
+    if (!err)
+    {
+        if (pthread_create (&d->thread, NULL, adios_bb_drain_thread, d))
+        {
+            adios_bb_drain_thread (d);
+        }
+        else
+        {
+            d->started = 1;
+        }
+    }
+}
+
+void adios_burst_buffer_finalize (int mype, struct adios_method_struct * method)
+{
+    struct adios_BB_data_struct * p = (struct adios_BB_data_struct *)
+                                                          method->method_data;
+
+    adios_bb_publish (p);
+    adios_free_index_v1 (p->index);
+    free (p->local_path);
+    p->local_path = 0;
+    if (adios_bb_initialized)
+        adios_bb_initialized = 0;
+}
+
+void adios_burst_buffer_end_iteration (struct adios_method_struct * method)
+{
+}
+
+void adios_burst_buffer_start_calculation (struct adios_method_struct * method)
+{
+}
+
+void adios_burst_buffer_stop_calculation (struct adios_method_struct * method)
+{
+}
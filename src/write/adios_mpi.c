@@ -38,6 +38,16 @@ static int adios_mpi_initialized = 0;
 
 #define COLLECT_METRICS 0
 
+#if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
+// Indices for the timer object
+static int ADIOS_TIMER_MPI_INDEX_ARENA = ADIOS_TIMING_MAX_USER_TIMERS + 0; // peak MB, not a time
+
+static int timer_count = 1;
+static char * timer_names[] = {
+        "index_arena_peak_MB"
+};
+#endif
+
 
 struct adios_MPI_data_struct
 {
@@ -56,8 +66,18 @@ struct adios_MPI_data_struct
     uint64_t vars_start;
     uint64_t vars_header_size;
     uint16_t storage_targets;  // number of storage targets being used
+
+    int index_reduction;       // how rank 0 collects the index at close
+    int timing;                // write the timing object (index_arena_peak_MB)
 };
 
+// values of index_reduction
+#define ADIOS_MPI_INDEX_GATHER 0  // gather all indices to rank 0 and merge there
+#define ADIOS_MPI_INDEX_TREE   1  // merge pairwise up a binomial tree
+
+// tag of the index_reduction=tree messages, every MPI_TAG_UB is at least 32767
+#define ADIOS_MPI_INDEX_TAG 32767
+
 #if COLLECT_METRICS
 // see adios_adaptive_finalize for what each represents
 struct timeval_writer
@@ -294,6 +314,40 @@ void adios_mpi_init (const PairStruct * parameters
     md->vars_start = 0;
     md->vars_header_size = 0;
     md->storage_targets = 0;
+    md->index_reduction = ADIOS_MPI_INDEX_GATHER;
+    md->timing = 0;
+
+    const PairStruct * p = parameters;
+    while (p)
+    {
+        if (!strcasecmp (p->name, "index_reduction"))
+        {
+            if (!strcasecmp (p->value, "tree"))
+            {
+                md->index_reduction = ADIOS_MPI_INDEX_TREE;
+            }
+            else if (!strcasecmp (p->value, "gather"))
+            {
+                md->index_reduction = ADIOS_MPI_INDEX_GATHER;
+            }
+            else
+            {
+                log_error ("Invalid 'index_reduction' parameter given to the MPI "
+                           "method: '%s', use 'gather' or 'tree'\n", p->value);
+            }
+        }
+        else if (!strcasecmp (p->name, "timing"))
+        {
+            // the timers become extra variables of the output, so only on request
+            md->timing = (!strcasecmp (p->value, "yes") || !strcasecmp (p->value, "1"));
+        }
+        else
+        {
+            log_warn ("Parameter name %s is not recognized by the MPI "
+                      "method\n", p->name);
+        }
+        p = p->next;
+    }
 
     adios_buffer_struct_init (&md->b);
 #if COLLECT_METRICS
@@ -323,6 +377,20 @@ int adios_mpi_open (struct adios_file_struct * fd
     }
     fd->group->process_id = md->rank;
 
+#if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
+    // Ensure both timing objects exist
+    // timing_obj should get created at every open
+    // prev_timing_obj should only be created at the first open
+    if (fd->group && md->timing)
+    {
+        if (!fd->group->timing_obj)
+            fd->group->timing_obj = adios_timing_create (timer_count, timer_names);
+
+        if (!fd->group->prev_timing_obj)
+            fd->group->prev_timing_obj = adios_timing_create (timer_count, timer_names);
+    }
+#endif
+
 #if COLLECT_METRICS
     timing.write_count = 0;
     timing.write_size = 0;
@@ -616,7 +684,7 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.pg_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_process_group_index_v1 (&md->b, &md->index->pg_root);
+                adios_parse_process_group_index_arena_v1 (&md->b, &md->index->pg_root, md->index->arena);
 
 #if 1
                 adios_init_buffer_read_vars_index (&md->b);
@@ -626,9 +694,9 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.vars_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_vars_index_v1 (&md->b, &md->index->vars_root, 
+                adios_parse_vars_index_arena_v1 (&md->b, &md->index->vars_root, 
                                            md->index->hashtbl_vars,
-                                           &md->index->vars_tail);
+                                           &md->index->vars_tail, md->index->arena);
 
                 adios_init_buffer_read_attributes_index (&md->b);
                 MPI_File_seek (md->fh, md->b.attrs_index_offset
@@ -637,7 +705,7 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.attrs_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_attributes_index_v1 (&md->b, &md->index->attrs_root);
+                adios_parse_attributes_index_arena_v1 (&md->b, &md->index->attrs_root, md->index->arena);
 #endif
 
                 fd->base_offset = md->b.end_of_pgs;
@@ -878,7 +946,7 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                                   ,&md->status
                                   );
 
-                    adios_parse_process_group_index_v1 (&md->b, &md->index->pg_root);
+                    adios_parse_process_group_index_arena_v1 (&md->b, &md->index->pg_root, md->index->arena);
 
                     // find the largest time index so we can append properly
                     struct adios_index_process_group_struct_v1 * p;
@@ -902,9 +970,9 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                     MPI_File_read (md->fh, md->b.buff, md->b.vars_size, MPI_BYTE
                                   ,&md->status
                                   );
-                    adios_parse_vars_index_v1 (&md->b, &md->index->vars_root, 
+                    adios_parse_vars_index_arena_v1 (&md->b, &md->index->vars_root, 
                                                md->index->hashtbl_vars,
-                                               &md->index->vars_tail);
+                                               &md->index->vars_tail, md->index->arena);
 
                     adios_init_buffer_read_attributes_index (&md->b);
                     MPI_File_seek (md->fh, md->b.attrs_index_offset
@@ -913,7 +981,7 @@ enum ADIOS_FLAG adios_mpi_should_buffer (struct adios_file_struct * fd
                     MPI_File_read (md->fh, md->b.buff, md->b.attrs_size
                                   ,MPI_BYTE, &md->status
                                   );
-                    adios_parse_attributes_index_v1 (&md->b, &md->index->attrs_root);
+                    adios_parse_attributes_index_arena_v1 (&md->b, &md->index->attrs_root, md->index->arena);
 
                     fd->base_offset = md->b.end_of_pgs;
                     fd->pg_start_in_file = fd->base_offset;
@@ -1104,8 +1172,9 @@ void adios_mpi_write (struct adios_file_struct * fd
         {
             if (v->free_data == adios_flag_yes)
             {
-                free (v->data);
                 adios_method_buffer_free (v->data_size);
+                adios_buffer_pool_put (v->data, v->data_capacity);
+                v->data_capacity = 0;
             }
         }
         else
@@ -1254,7 +1323,7 @@ void adios_mpi_get_write_buffer (struct adios_file_struct * fd
                                 ,struct adios_method_struct * method
                                 )
 {
-    uint64_t mem_allowed;
+    uint64_t mem_allowed, capacity;
     struct adios_MPI_data_struct * md = (struct adios_MPI_data_struct *)
                                                       method->method_data;
 
@@ -1268,13 +1337,14 @@ void adios_mpi_get_write_buffer (struct adios_file_struct * fd
     if (v->data && v->free_data)
     {
         adios_method_buffer_free (v->data_size);
-        free (v->data);
+        adios_buffer_pool_put (v->data, v->data_capacity);
+        v->data_capacity = 0;
     }
 
     mem_allowed = adios_method_buffer_alloc (*size);
     if (mem_allowed == *size)
     {
-        *buffer = malloc (*size);
+        *buffer = adios_buffer_pool_get (*size, &capacity);
         if (!*buffer)
         {
             adios_method_buffer_free (mem_allowed);
@@ -1293,6 +1363,7 @@ void adios_mpi_get_write_buffer (struct adios_file_struct * fd
             v->got_buffer = adios_flag_yes;
             v->free_data = adios_flag_yes;
             v->data_size = mem_allowed;
+            v->data_capacity = capacity;
             v->data = *buffer;
         }
     }
@@ -1421,6 +1492,189 @@ static void adios_mpi_do_read (struct adios_file_struct * fd
     adios_buffer_struct_clear (&md->b);
 }
 
+// Write the buffer and the zero-copy payloads between its parts at
+// fd->base_offset with one MPI_File_write of a datatype that describes all
+// pieces by their absolute address.
+static void adios_mpi_write_zero_copy (struct adios_file_struct * fd
+                                      ,struct adios_MPI_data_struct * md
+                                      )
+{
+    struct iovec * iov = 0;
+    int * lengths;
+    MPI_Aint * displs;
+    MPI_Datatype type;
+    int count, i;
+    int err;
+
+    if (fd->base_offset + fd->bytes_written + fd->zero_copy_bytes >
+        fd->pg_start_in_file + fd->write_size_bytes)
+    {
+        adios_error (err_out_of_bound,
+                "MPI method, rank %d: size of buffered data exceeds pg bound.\n"
+                "File is corrupted. Need to enlarge group size in adios_group_size().\n"
+                "Group size=%llu, offset at end of variable buffer=%llu\n",
+                md->rank,
+                fd->write_size_bytes,
+                fd->base_offset - fd->pg_start_in_file + fd->bytes_written
+                + fd->zero_copy_bytes);
+    }
+
+    count = adios_get_zero_copy_iovec_v1 (fd, MAX_MPIWRITE_SIZE, &iov);
+    if (count <= 0)
+    {
+        return;
+    }
+
+    lengths = (int *) malloc (count * sizeof (int));
+    displs = (MPI_Aint *) malloc (count * sizeof (MPI_Aint));
+    if (!lengths || !displs)
+    {
+        adios_error (err_no_memory,
+                "MPI method, rank %d: cannot allocate the datatype of %d "
+                "pieces to write file %s\n", md->rank, count, fd->name);
+        free (displs);
+        free (lengths);
+        free (iov);
+        return;
+    }
+    for (i = 0; i < count; i++)
+    {
+        lengths [i] = (int) iov [i].iov_len;
+        MPI_Get_address (iov [i].iov_base, &displs [i]);
+    }
+    MPI_Type_create_hindexed (count, lengths, displs, MPI_BYTE, &type);
+    MPI_Type_commit (&type);
+
+    MPI_File_seek (md->fh, fd->base_offset, MPI_SEEK_SET);
+    err = MPI_File_write (md->fh, MPI_BOTTOM, 1, type, &md->status);
+    if (err != MPI_SUCCESS)
+    {
+        char e [MPI_MAX_ERROR_STRING];
+        int len = 0;
+        memset (e, 0, MPI_MAX_ERROR_STRING);
+        MPI_Error_string (err, e, &len);
+        adios_error (err_write_error,
+                "MPI method, rank %d: adios_close(): writing of buffered data "
+                "of %llu bytes to file %s failed: '%s'\n",
+                md->rank, fd->bytes_written + fd->zero_copy_bytes, fd->name, e);
+    }
+
+    MPI_Type_free (&type);
+    free (displs);
+    free (lengths);
+    free (iov);
+}
+
+// Collect the index of every process on rank 0 with a binomial tree
+// (index_reduction=tree). In the round with bit 'mask', a process with that
+// bit set sends its index, with everything it has merged so far, to
+// rank - mask and drops out; rank - mask merges it. A process therefore
+// merges the subtrees rank+1, rank+2, rank+4, ... in rank order and rank 0
+// ends up with the same index as with the gather, after log2(size) rounds
+// and without holding every serialized index at once.
+static void adios_mpi_reduce_index (struct adios_MPI_data_struct * md)
+{
+    struct adios_index_process_group_struct_v1 * new_pg_root = 0;
+    struct adios_index_var_struct_v1 * new_vars_root = 0;
+    struct adios_index_attribute_struct_v1 * new_attrs_root = 0;
+    char * buffer = 0;
+    uint64_t buffer_size = 0;
+    uint64_t buffer_offset = 0;
+    char * recv_buffer = 0;
+    uint64_t recv_buffer_size = 0;
+    MPI_Status status;
+    int mask;
+
+    for (mask = 1; mask < md->size; mask <<= 1)
+    {
+        if (md->rank & mask)
+        {
+            uint64_t size;
+            uint64_t sent = 0;
+
+            adios_write_index_v1 (&buffer, &buffer_size, &buffer_offset
+                                 ,0, md->index);
+            size = buffer_offset;
+            MPI_Send (&size, 1, MPI_UNSIGNED_LONG_LONG, md->rank - mask
+                     ,ADIOS_MPI_INDEX_TAG, md->group_comm
+                     );
+            // the count of MPI_Send is an int
+            while (sent < size)
+            {
+                int len = (size - sent > MAX_MPIWRITE_SIZE) ? MAX_MPIWRITE_SIZE
+                                                            : size - sent;
+                MPI_Send (buffer + sent, len, MPI_BYTE, md->rank - mask
+                         ,ADIOS_MPI_INDEX_TAG, md->group_comm
+                         );
+                sent += len;
+            }
+            break;
+        }
+        else if (md->rank + mask < md->size)
+        {
+            uint64_t size = 0;
+            uint64_t received = 0;
+
+            MPI_Recv (&size, 1, MPI_UNSIGNED_LONG_LONG, md->rank + mask
+                     ,ADIOS_MPI_INDEX_TAG, md->group_comm, &status
+                     );
+            if (size > recv_buffer_size)
+            {
+                free (recv_buffer);
+                recv_buffer = malloc (size);
+                if (!recv_buffer)
+                {
+                    // the sender is blocked on us, there is no way to skip
+                    adios_error (err_no_memory,
+                            "MPI method, rank %d: cannot allocate %llu bytes "
+                            "for the index of rank %d\n",
+                            md->rank, size, md->rank + mask);
+                    MPI_Abort (md->group_comm, -1);
+                }
+                recv_buffer_size = size;
+            }
+            while (received < size)
+            {
+                int len = (size - received > MAX_MPIWRITE_SIZE)
+                          ? MAX_MPIWRITE_SIZE : size - received;
+                MPI_Recv (recv_buffer + received, len, MPI_BYTE
+                         ,md->rank + mask, ADIOS_MPI_INDEX_TAG, md->group_comm, &status
+                         );
+                received += len;
+            }
+
+            char * buffer_save = md->b.buff;
+            uint64_t buffer_size_save = md->b.length;
+            uint64_t offset_save = md->b.offset;
+
+            md->b.buff = recv_buffer;
+            md->b.length = size;
+            md->b.offset = 0;
+
+            adios_parse_process_group_index_arena_v1 (&md->b
+                                                     ,&new_pg_root
+                                                     ,md->index->arena
+                                                     );
+            adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL
+                                            ,md->index->arena
+                                            );
+            // do not merge attributes from other processes from 1.4
+            adios_merge_index_v1 (md->index, new_pg_root,
+                                  new_vars_root, new_attrs_root);
+            new_pg_root = 0;
+            new_vars_root = 0;
+            new_attrs_root = 0;
+
+            md->b.buff = buffer_save;
+            md->b.length = buffer_size_save;
+            md->b.offset = offset_save;
+        }
+    }
+
+    free (recv_buffer);
+    free (buffer);
+}
+
 void adios_mpi_close (struct adios_file_struct * fd
                      ,struct adios_method_struct * method
                      )
@@ -1666,7 +1920,13 @@ void adios_mpi_close (struct adios_file_struct * fd
             // build index appending to any existing index
             adios_build_index_v1 (fd, md->index);
             // if collective, gather the indexes from the rest and call
-            if (md->group_comm != MPI_COMM_NULL)
+            if (   md->group_comm != MPI_COMM_NULL
+                && md->index_reduction == ADIOS_MPI_INDEX_TREE
+               )
+            {
+                adios_mpi_reduce_index (md);
+            }
+            else if (md->group_comm != MPI_COMM_NULL)
             {
                 if (md->rank == 0)
                 {
@@ -1705,10 +1965,11 @@ void adios_mpi_close (struct adios_file_struct * fd
                         md->b.length = index_sizes [i];
                         md->b.offset = 0;
 
-                        adios_parse_process_group_index_v1 (&md->b
+                        adios_parse_process_group_index_arena_v1 (&md->b
                                                            ,&new_pg_root
+                                                           ,md->index->arena
                                                            );
-                        adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
+                        adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
                         // do not merge attributes from other processes from 1.4
                         /*
                         adios_parse_attributes_index_v1 (&md->b
@@ -1748,7 +2009,11 @@ void adios_mpi_close (struct adios_file_struct * fd
 #if COLLECT_METRICS
             gettimeofday (&timing.t13, NULL);
 #endif
-            if (fd->shared_buffer == adios_flag_yes)
+            if (fd->shared_buffer == adios_flag_yes && fd->zero_copy_count)
+            {
+                adios_mpi_write_zero_copy (fd, md);
+            }
+            else if (fd->shared_buffer == adios_flag_yes)
             {
                 // if we need to write > 2 GB, need to do it in parts
                 // since count is limited to MAX_MPIWRITE_SIZE (signed 32-bit max).
@@ -2097,7 +2362,13 @@ timeval_subtract (&timing.t8, &b, &a);
             // build index appending to any existing index
             adios_build_index_v1 (fd, md->index);
             // if collective, gather the indexes from the rest and call
-            if (md->group_comm != MPI_COMM_NULL)
+            if (   md->group_comm != MPI_COMM_NULL
+                && md->index_reduction == ADIOS_MPI_INDEX_TREE
+               )
+            {
+                adios_mpi_reduce_index (md);
+            }
+            else if (md->group_comm != MPI_COMM_NULL)
             {
                 if (md->rank == 0)
                 {
@@ -2136,10 +2407,11 @@ timeval_subtract (&timing.t8, &b, &a);
                         md->b.length = index_sizes [i];
                         md->b.offset = 0;
 
-                        adios_parse_process_group_index_v1 (&md->b
+                        adios_parse_process_group_index_arena_v1 (&md->b
                                                            ,&new_pg_root
+                                                           ,md->index->arena
                                                            );
-                        adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
+                        adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
                         // do not merge attributes from other processes from 1.4
                         /*
                         adios_parse_attributes_index_v1 (&md->b
@@ -2177,7 +2449,11 @@ timeval_subtract (&timing.t8, &b, &a);
                 }
             }
 
-            if (fd->shared_buffer == adios_flag_yes)
+            if (fd->shared_buffer == adios_flag_yes && fd->zero_copy_count)
+            {
+                adios_mpi_write_zero_copy (fd, md);
+            }
+            else if (fd->shared_buffer == adios_flag_yes)
             {
                 if (fd->base_offset + fd->bytes_written > 
                     fd->pg_start_in_file + fd->write_size_bytes) 
@@ -2320,6 +2596,25 @@ timeval_subtract (&timing.t8, &b, &a);
     memset (&md->status, 0, sizeof (MPI_Status));
     md->group_comm = MPI_COMM_NULL;
 
+#if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
+    if (md->timing)
+    {
+        // memory the index (merged on rank 0) needed at most
+        if (md->index->arena)
+        {
+            adios_timing_set_value (fd->group->timing_obj, ADIOS_TIMER_MPI_INDEX_ARENA,
+                                    md->index->arena->peak / (1024.0 * 1024.0));
+        }
+
+        //Finished timing this cycle, swap the timing buffers
+        adios_timing_destroy(fd->group->prev_timing_obj);
+        fd->group->prev_timing_obj = fd->group->timing_obj;
+        fd->group->timing_obj = 0;
+        // prev_timing_obj points to unwritten timing info, timing_obj is
+        // ready to allocate at the next open
+    }
+#endif
+
     adios_clear_index_v1 (md->index);
 }
 
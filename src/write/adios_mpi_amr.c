@@ -113,6 +113,11 @@ struct adios_MPI_data_struct
     struct adios_MPI_thread_data_open * open_thread_data;
     struct adios_MPI_thread_data_reopen * reopen_thread_data;
     enum ADIOS_MPI_AMR_IO_TYPE g_io_type;
+    int g_node_aggregation; // aggregation groups do not span nodes
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    MPI_Win g_shm_win;      // PGs of the group, in the aggregator's shared memory
+    char * g_shm_base;
+#endif
 };
 
 struct adios_MPI_thread_data_open
@@ -503,6 +508,106 @@ adios_mpi_amr_set_have_mdf (char * parameters, struct adios_MPI_data_struct * md
     free (temp_string);
 }
 
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+// Aggregation groups that do not span nodes. The processes of each node are
+// split into consecutive groups, about g_num_aggregators groups in total and
+// at least one per node. The groups (and subfiles) are numbered node after
+// node, so the subfiles of neighbouring nodes are striped to different OSTs
+// (subfile i goes to OST i % num_ost, see adios_mpi_amr_set_striping_unit).
+static void adios_mpi_amr_set_node_groups (struct adios_MPI_data_struct * md)
+{
+    MPI_Comm node_comm, leader_comm;
+    int node_rank, node_size, nnodes, node_id;
+    int group_size, remain, local_group;
+    int groups[3]; // groups on this node, first group of this node, all groups
+
+    // key=rank keeps the processes of a node in rank order
+    MPI_Comm_split_type (md->group_comm, MPI_COMM_TYPE_SHARED, md->rank
+                        ,MPI_INFO_NULL, &node_comm
+                        );
+    MPI_Comm_rank (node_comm, &node_rank);
+    MPI_Comm_size (node_comm, &node_size);
+    MPI_Comm_split (md->group_comm, (node_rank == 0 ? 0 : MPI_UNDEFINED)
+                   ,md->rank, &leader_comm
+                   );
+
+    if (node_rank == 0)
+    {
+        MPI_Comm_size (leader_comm, &nnodes);
+        MPI_Comm_rank (leader_comm, &node_id);
+
+        groups[0] = md->g_num_aggregators / nnodes;
+        if (groups[0] < 1)
+            groups[0] = 1;
+        if (groups[0] > node_size)
+            groups[0] = node_size;
+
+        MPI_Exscan (&groups[0], &groups[1], 1, MPI_INT, MPI_SUM, leader_comm);
+        if (node_id == 0)
+            groups[1] = 0; // undefined on the first node
+        MPI_Allreduce (&groups[0], &groups[2], 1, MPI_INT, MPI_SUM, leader_comm);
+        MPI_Comm_free (&leader_comm);
+    }
+
+    MPI_Bcast (groups, 3, MPI_INT, 0, node_comm);
+    MPI_Comm_free (&node_comm);
+
+    md->g_num_aggregators = groups[2];
+
+    // the first 'remain' groups of the node have one more process
+    group_size = node_size / groups[0];
+    remain = node_size - group_size * groups[0];
+    if (node_rank < (group_size + 1) * remain)
+    {
+        local_group = node_rank / (group_size + 1);
+        md->g_color2 = node_rank % (group_size + 1);
+    }
+    else
+    {
+        local_group = remain + (node_rank - (group_size + 1) * remain) / group_size;
+        md->g_color2 = (node_rank - (group_size + 1) * remain) % group_size;
+    }
+    md->g_color1 = groups[1] + local_group;
+}
+
+// Every process of the group copies its PG into a shared memory window of
+// the aggregator at offset disp, so the aggregator finds the PGs of the
+// group one after the other at md->g_shm_base and writes them in one call.
+// The window stays until the next step (adios_mpi_amr_shm_free) so that the
+// processes do not wait for the aggregator's write.
+static void adios_mpi_amr_shm_deposit (struct adios_MPI_data_struct * md
+                                      ,const char * buffer, int size
+                                      ,int disp, int total_size
+                                      )
+{
+    MPI_Aint win_size;
+    int disp_unit;
+    char * base;
+
+    MPI_Win_allocate_shared ((is_aggregator (md->rank) ? (MPI_Aint) total_size : 0), 1
+                            ,MPI_INFO_NULL, md->g_comm1, &base, &md->g_shm_win
+                            );
+    MPI_Win_shared_query (md->g_shm_win, 0, &win_size, &disp_unit, &md->g_shm_base);
+
+    MPI_Win_lock_all (MPI_MODE_NOCHECK, md->g_shm_win);
+    memcpy (md->g_shm_base + disp, buffer, size);
+    MPI_Win_sync (md->g_shm_win);
+    MPI_Barrier (md->g_comm1);
+    MPI_Win_sync (md->g_shm_win);
+    MPI_Win_unlock_all (md->g_shm_win);
+}
+
+// Collective over the aggregation group of the previous step
+static void adios_mpi_amr_shm_free (struct adios_MPI_data_struct * md)
+{
+    if (md->g_shm_win != MPI_WIN_NULL)
+    {
+        MPI_Win_free (&md->g_shm_win);
+        md->g_shm_base = 0;
+    }
+}
+#endif
+
 static void
 adios_mpi_amr_set_aggregation_parameters(char * parameters, struct adios_MPI_data_struct * md)
 {
@@ -670,6 +775,41 @@ adios_mpi_amr_set_aggregation_parameters(char * parameters, struct adios_MPI_dat
         md->g_io_type = ADIOS_MPI_AMR_IO_BG;
     }
 
+    // set up whether aggregation groups stay within a node
+    strcpy (temp_string, parameters);
+    trim_spaces (temp_string);
+
+    if ( (p_size = strstr (temp_string, "node_aggregation")) )
+    {
+        char * p = strchr (p_size, '=');
+        char * q = strtok (p, ";");
+
+        if (!q)
+            md->g_node_aggregation = atoi (q + 1);
+        else
+            md->g_node_aggregation = atoi (p + 1);
+    }
+    else
+    {
+        // by default, groups are consecutive ranks
+        md->g_node_aggregation = 0;
+    }
+
+#if !defined(MPI_VERSION) || MPI_VERSION < 3
+    if (md->g_node_aggregation)
+    {
+        log_warn ("MPI_AMR method: node_aggregation needs MPI-3, ignored\n");
+        md->g_node_aggregation = 0;
+    }
+#endif
+    // the groups given by color may span nodes, the PGs cannot be gathered
+    // in a shared memory window then
+    if (md->g_node_aggregation && md->is_color_set)
+    {
+        log_warn ("MPI_AMR method: node_aggregation cannot be combined with color, ignored\n");
+        md->g_node_aggregation = 0;
+    }
+
     free (temp_string);
 
     if (md->g_num_aggregators > nproc || md->g_num_aggregators <= 0)
@@ -685,6 +825,26 @@ adios_mpi_amr_set_aggregation_parameters(char * parameters, struct adios_MPI_dat
     }
     memset (md->g_is_aggregator, 0, nproc * sizeof(int));
 
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    // the window of the previous step, its PGs are written by now
+    adios_mpi_amr_shm_free (md);
+
+    if (md->g_node_aggregation)
+    {
+        int aggr;
+
+        adios_mpi_amr_set_node_groups (md);
+
+        aggr = (md->g_color2 == 0);
+        MPI_Allgather (&aggr, 1, MPI_INT, md->g_is_aggregator, 1, MPI_INT
+                      ,md->group_comm
+                      );
+
+        MPI_Comm_split (md->group_comm, md->g_color1, md->rank, &md->g_comm1);
+        MPI_Comm_split (md->group_comm, md->g_color2, md->rank, &md->g_comm2);
+    }
+    else
+#endif
     if (!md->is_color_set)
     {
         aggr_group_size = nproc / md->g_num_aggregators;
@@ -824,6 +984,7 @@ struct adios_var_struct * adios_mpi_amr_copy_var (struct adios_var_struct * v)
     v_new->free_data = v->free_data;
     v_new->data = 0;
     v_new->data_size = v->data_size;
+    v_new->data_capacity = 0;
     v_new->next = 0;
 
     //struct adios_dimension_struct * dimensions;
@@ -1016,7 +1177,7 @@ void * adios_mpi_amr_do_reopen_thread (void * param)
         MPI_File_seek (md->fh, md->b.pg_index_offset, MPI_SEEK_SET);
         MPI_File_read (md->fh, md->b.buff, md->b.pg_size, MPI_BYTE, &md->status);
 
-        adios_parse_process_group_index_v1 (&md->b, &md->index->pg_root);
+        adios_parse_process_group_index_arena_v1 (&md->b, &md->index->pg_root, md->index->arena);
 
         // find the largest time index so we can append properly
         struct adios_index_process_group_struct_v1 * p;
@@ -1033,14 +1194,14 @@ void * adios_mpi_amr_do_reopen_thread (void * param)
         adios_init_buffer_read_vars_index (&md->b);
         MPI_File_seek (md->fh, md->b.vars_index_offset, MPI_SEEK_SET);
         MPI_File_read (md->fh, md->b.buff, md->b.vars_size, MPI_BYTE, &md->status);
-        adios_parse_vars_index_v1 (&md->b, &md->index->vars_root, 
+        adios_parse_vars_index_arena_v1 (&md->b, &md->index->vars_root, 
                                     md->index->hashtbl_vars,
-                                   &md->index->vars_tail);
+                                   &md->index->vars_tail, md->index->arena);
 
         adios_init_buffer_read_attributes_index (&md->b);
         MPI_File_seek (md->fh, md->b.attrs_index_offset, MPI_SEEK_SET);
         MPI_File_read (md->fh, md->b.buff, md->b.attrs_size, MPI_BYTE, &md->status);
-        adios_parse_attributes_index_v1 (&md->b, &md->index->attrs_root);
+        adios_parse_attributes_index_arena_v1 (&md->b, &md->index->attrs_root, md->index->arena);
 
         fd->base_offset = md->b.end_of_pgs;
         fd->pg_start_in_file = fd->base_offset;
@@ -1138,6 +1299,11 @@ void adios_mpi_amr_init (const PairStruct * parameters
     md->open_thread_data = 0;
     md->reopen_thread_data = 0;
     md->g_io_type = ADIOS_MPI_AMR_IO_BG;
+    md->g_node_aggregation = 0;
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    md->g_shm_win = MPI_WIN_NULL;
+    md->g_shm_base = 0;
+#endif
 
     adios_buffer_struct_init (&md->b);
 
@@ -1159,6 +1325,7 @@ int ADIOS_TIMER_MPI_AMR_MD = ADIOS_TIMING_MAX_USER_TIMERS + 2;
 int ADIOS_TIMER_MPI_AMR_AD_WRITE = ADIOS_TIMING_MAX_USER_TIMERS + 3;
 int ADIOS_TIMER_MPI_AMR_AD_CLOSE = ADIOS_TIMING_MAX_USER_TIMERS + 4;
 int ADIOS_TIMER_MPI_AMR_AD_SHOULD_BUFFER = ADIOS_TIMING_MAX_USER_TIMERS + 5;
+int ADIOS_TIMER_MPI_AMR_INDEX_ARENA = ADIOS_TIMING_MAX_USER_TIMERS + 6; // peak MB, not a time
 #endif
 
 
@@ -1179,7 +1346,7 @@ int adios_mpi_amr_open (struct adios_file_struct * fd
     fd->group->process_id = md->rank;
     
 #if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
-    int timer_count = 6;
+    int timer_count = 7;
     char ** timer_names = (char**) malloc (timer_count * sizeof (char*) );
     timer_names [0] = "Communication";
     timer_names [1] = "I/O"; 
@@ -1187,6 +1354,7 @@ int adios_mpi_amr_open (struct adios_file_struct * fd
     timer_names [3] = "ad_write"; 
     timer_names [4] = "ad_close";
     timer_names [5] = "ad_should_buffer";
+    timer_names [6] = "index_arena_peak_MB";
 
 
     // Ensure both timing objects exist
@@ -1626,8 +1794,9 @@ void adios_mpi_amr_write (struct adios_file_struct * fd
         {
             if (v->free_data == adios_flag_yes)
             {
-                free (v->data);
                 adios_method_buffer_free (v->data_size);
+                adios_buffer_pool_put (v->data, v->data_capacity);
+                v->data_capacity = 0;
             }
         }
         else
@@ -1740,7 +1909,7 @@ void adios_mpi_amr_get_write_buffer (struct adios_file_struct * fd
                                 ,struct adios_method_struct * method
                                 )
 {
-    uint64_t mem_allowed;
+    uint64_t mem_allowed, capacity;
 
     if (*size == 0)
     {
@@ -1752,13 +1921,14 @@ void adios_mpi_amr_get_write_buffer (struct adios_file_struct * fd
     if (v->data && v->free_data)
     {
         adios_method_buffer_free (v->data_size);
-        free (v->data);
+        adios_buffer_pool_put (v->data, v->data_capacity);
+        v->data_capacity = 0;
     }
 
     mem_allowed = adios_method_buffer_alloc (*size);
     if (mem_allowed == *size)
     {
-        *buffer = malloc (*size);
+        *buffer = adios_buffer_pool_get (*size, &capacity);
         if (!*buffer)
         {
             adios_method_buffer_free (mem_allowed);
@@ -1777,6 +1947,7 @@ void adios_mpi_amr_get_write_buffer (struct adios_file_struct * fd
             v->got_buffer = adios_flag_yes;
             v->free_data = adios_flag_yes;
             v->data_size = mem_allowed;
+            v->data_capacity = capacity;
             v->data = *buffer;
         }
     }
@@ -1961,6 +2132,7 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
             uint64_t index_start1;
             int * pg_sizes = 0, * disp = 0;
             void * aggr_buff = 0, * recv_buff = 0;
+            uint64_t aggr_buff_size = 0, recv_buff_size = 0;
             struct adios_MPI_thread_data_write write_thread_data;
             int i, new_rank, new_group_size, new_rank2, new_group_size2, max_data_size = 0, total_data_size = 0, total_data_size1 = 0;
             START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
@@ -2134,8 +2306,71 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                 MPI_File_seek (md->fh, fd->base_offset, MPI_SEEK_SET);
             }
 
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+            // node aggregation: the processes of the group deposit their PG
+            // in the aggregator's shared memory instead of passing it along
+            // the brigade, and the aggregator writes all of them at once
+            if (   fd->shared_buffer == adios_flag_yes && !md->g_merging_pgs
+                && md->g_node_aggregation
+               )
+            {
+                int pg_size;
+
+                pg_size = fd->bytes_written;
+
+                pg_sizes = (int *) malloc (new_group_size * 4);
+                disp = (int *) malloc (new_group_size * 4);
+                if (pg_sizes == 0 || disp == 0)
+                {
+                    adios_error (err_no_memory, "MPI_AMR method: Cannot allocate memory "
+                                "for merging process blocks (mpi_amr_bg_close)\n");
+                    return;
+                }
+
+                START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                MPI_Allgather (&pg_size, 1, MPI_INT
+                              ,pg_sizes, 1, MPI_INT
+                              ,md->g_comm1);
+                STOP_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+
+                disp[0] = 0;
+                for (i = 1; i < new_group_size; i++)
+                {
+                    disp[i] = disp[i - 1] + pg_sizes[i - 1];
+                }
+                total_data_size = disp[new_group_size - 1]
+                                + pg_sizes[new_group_size - 1];
+
+                START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                adios_mpi_amr_shm_deposit (md, fd->buffer, pg_size
+                                          ,disp[new_rank], total_data_size
+                                          );
+                STOP_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+
+                if (is_aggregator (md->rank))
+                {
+                    if (md->g_threading)
+                    {
+                        pthread_join (md->g_sot, NULL);
+                    }
+
+                    index_start1 = fd->pg_start_in_file;
+                    write_thread_data.fh = &md->fh;
+                    write_thread_data.base_offset = &index_start1;
+                    write_thread_data.aggr_buff = md->g_shm_base;
+                    write_thread_data.total_data_size = &total_data_size;
+
+                    START_TIMER (ADIOS_TIMER_MPI_AMR_IO);
+                    adios_mpi_amr_do_write_thread ((void *) &write_thread_data);
+                    STOP_TIMER (ADIOS_TIMER_MPI_AMR_IO);
+                }
+            }
+#endif
+
             // if not merge PG's on the aggregator side
-            if (fd->shared_buffer == adios_flag_yes && !md->g_merging_pgs)
+            if (   fd->shared_buffer == adios_flag_yes && !md->g_merging_pgs
+                && !md->g_node_aggregation
+               )
             {
                 //printf ("do not merge pg\n");
                 int pg_size;
@@ -2168,10 +2403,12 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                     max_data_size = (pg_sizes[i] > max_data_size) ? pg_sizes[i] : max_data_size;
                 }
 
+                // both buffers are needed at every step, keep them in the
+                // buffer pool instead of faulting them in again each time
                 if (is_aggregator (md->rank))
                 {
-                    aggr_buff = malloc (max_data_size);
-                    recv_buff = malloc (max_data_size);
+                    aggr_buff = adios_buffer_pool_get (max_data_size, &aggr_buff_size);
+                    recv_buff = adios_buffer_pool_get (max_data_size, &recv_buff_size);
                     if (aggr_buff == 0 || recv_buff == 0)
                     {
                         adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
@@ -2185,7 +2422,7 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                 }
                 else
                 {
-                    recv_buff = malloc (max_data_size);
+                    recv_buff = adios_buffer_pool_get (max_data_size, &recv_buff_size);
                     if (recv_buff == 0)
                     {
                         adios_error (err_no_memory, "MPI_AMR method (with brigade strategy): Cannot allocate "
@@ -2275,8 +2512,10 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                     }
                 }
 
-                FREE (aggr_buff);
-                FREE (recv_buff);
+                adios_buffer_pool_put (aggr_buff, aggr_buff_size);
+                adios_buffer_pool_put (recv_buff, recv_buff_size);
+                aggr_buff = 0;
+                recv_buff = 0;
             }
 
             // build index appending to any existing index
@@ -2350,12 +2589,14 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                         md->b.length = index_sizes [i];
                         md->b.offset = 0;
 
-                        adios_parse_process_group_index_v1 (&md->b
+                        adios_parse_process_group_index_arena_v1 (&md->b
                                                            ,&new_pg_root
+                                                           ,md->index->arena
                                                            );
-                        adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
-                        adios_parse_attributes_index_v1 (&md->b
+                        adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
+                        adios_parse_attributes_index_arena_v1 (&md->b
                                                         ,&new_attrs_root
+                                                        ,md->index->arena
                                                         );
                         if (md->g_merging_pgs)
                             new_pg_root = 0;
@@ -2489,12 +2730,14 @@ void adios_mpi_amr_bg_close (struct adios_file_struct * fd
                             md->b.length = index_sizes [i];
                             md->b.offset = 0;
 
-                            adios_parse_process_group_index_v1 (&md->b
+                            adios_parse_process_group_index_arena_v1 (&md->b
                                                                ,&new_pg_root
+                                                               ,md->index->arena
                                                                );
-                            adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
-                            adios_parse_attributes_index_v1 (&md->b
+                            adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
+                            adios_parse_attributes_index_arena_v1 (&md->b
                                                             ,&new_attrs_root
+                                                            ,md->index->arena
                                                             );
 
                             adios_merge_index_v1 (md->index, new_pg_root, 
@@ -2893,34 +3136,49 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                 total_data_size = disp[new_group_size - 1]
                                 + pg_sizes[new_group_size - 1];
 
-                if (is_aggregator (md->rank))
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+                // node aggregation: deposit the PG in the aggregator's
+                // shared memory, it is written from there with the index
+                if (md->g_node_aggregation)
                 {
-                    if (total_data_size > MAX_AGG_BUF)
+                    START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                    adios_mpi_amr_shm_deposit (md, fd->buffer, pg_size
+                                              ,disp[new_rank], total_data_size
+                                              );
+                    STOP_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                }
+                else
+#endif
+                {
+                    if (is_aggregator (md->rank))
                     {
-                        log_warn ("The max allowed aggregation buffer is %d. Requested %d.\n"
-                                "Need to increase the number of aggregators.\n",
-                                MAX_AGG_BUF, total_data_size);
+                        if (total_data_size > MAX_AGG_BUF)
+                        {
+                            log_warn ("The max allowed aggregation buffer is %d. Requested %d.\n"
+                                    "Need to increase the number of aggregators.\n",
+                                    MAX_AGG_BUF, total_data_size);
+                        }
+                        aggr_buff = malloc (total_data_size);
+                        if (aggr_buff == 0)
+                        {
+                            adios_error (err_no_memory, 
+                                    "MPI_AMR method (AG): Cannot allocate %d bytes "
+                                    "for aggregation buffer.\n"
+                                    "Need to increase the number of aggregators.\n",
+                                    total_data_size);
+                            return;
+                        }
                     }
-                    aggr_buff = malloc (total_data_size);
-                    if (aggr_buff == 0)
+                    else
                     {
-                        adios_error (err_no_memory, 
-                                "MPI_AMR method (AG): Cannot allocate %d bytes "
-                                "for aggregation buffer.\n"
-                                "Need to increase the number of aggregators.\n",
-                                total_data_size);
-                        return;
                     }
-                }
-                else
-                {
-                }
 
-                START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
-                MPI_Gatherv (fd->buffer, pg_size, MPI_BYTE
-                            ,aggr_buff, pg_sizes, disp, MPI_BYTE
-                            ,0, md->g_comm1);
-                STOP_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                    START_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                    MPI_Gatherv (fd->buffer, pg_size, MPI_BYTE
+                                ,aggr_buff, pg_sizes, disp, MPI_BYTE
+                                ,0, md->g_comm1);
+                    STOP_TIMER (ADIOS_TIMER_MPI_AMR_COMM);
+                }
             }
 
             // Merge PG's on the aggregator side
@@ -3278,12 +3536,14 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                         md->b.length = index_sizes [i];
                         md->b.offset = 0;
 
-                        adios_parse_process_group_index_v1 (&md->b
+                        adios_parse_process_group_index_arena_v1 (&md->b
                                                            ,&new_pg_root
+                                                           ,md->index->arena
                                                            );
-                        adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
-                        adios_parse_attributes_index_v1 (&md->b
+                        adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
+                        adios_parse_attributes_index_arena_v1 (&md->b
                                                         ,&new_attrs_root
+                                                        ,md->index->arena
                                                         );
                         if (md->g_merging_pgs)
                             new_pg_root = 0;
@@ -3356,9 +3616,6 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
 
                 if (fd->shared_buffer == adios_flag_yes)
                 {
-                    aggr_buff = realloc (aggr_buff, total_data_size + buffer_offset);
-                    memcpy (aggr_buff + total_data_size, buffer, buffer_offset); 
-
                     // Waiting for the subfile to open if pthread is enabled
                     if (md->g_threading)
                     {
@@ -3366,11 +3623,35 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                     }
 
                     index_start1 = fd->pg_start_in_file;
-                    total_data_size1 = total_data_size + buffer_offset;
+
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+                    if (md->g_node_aggregation && !md->g_merging_pgs)
+                    {
+                        // The PGs are in the shared memory window, which
+                        // cannot grow: write the index behind them first
+                        START_TIMER (ADIOS_TIMER_MPI_AMR_IO);
+                        adios_mpi_amr_striping_unit_write (md->fh
+                                                          ,index_start1 + total_data_size
+                                                          ,buffer
+                                                          ,buffer_offset
+                                                          );
+                        STOP_TIMER (ADIOS_TIMER_MPI_AMR_IO);
+
+                        total_data_size1 = total_data_size;
+                        write_thread_data.aggr_buff = md->g_shm_base;
+                    }
+                    else
+#endif
+                    {
+                        aggr_buff = realloc (aggr_buff, total_data_size + buffer_offset);
+                        memcpy (aggr_buff + total_data_size, buffer, buffer_offset); 
+
+                        total_data_size1 = total_data_size + buffer_offset;
+                        write_thread_data.aggr_buff = aggr_buff;
+                    }
 
                     write_thread_data.fh = &md->fh;
                     write_thread_data.base_offset = &index_start1;
-                    write_thread_data.aggr_buff = aggr_buff;
                     write_thread_data.total_data_size = &total_data_size1;
 
                     // Threading the write so that we can overlap write with index collection.
@@ -3440,12 +3721,14 @@ void adios_mpi_amr_ag_close (struct adios_file_struct * fd
                         md->b.length = index_sizes [i];
                         md->b.offset = 0;
 
-                        adios_parse_process_group_index_v1 (&md->b
+                        adios_parse_process_group_index_arena_v1 (&md->b
                                                            ,&new_pg_root
+                                                           ,md->index->arena
                                                            );
-                        adios_parse_vars_index_v1 (&md->b, &new_vars_root, NULL, NULL);
-                        adios_parse_attributes_index_v1 (&md->b
+                        adios_parse_vars_index_arena_v1 (&md->b, &new_vars_root, NULL, NULL, md->index->arena);
+                        adios_parse_attributes_index_arena_v1 (&md->b
                                                         ,&new_attrs_root
+                                                        ,md->index->arena
                                                         );
 
                         adios_merge_index_v1 (md->index, new_pg_root, 
@@ -3643,6 +3926,13 @@ void adios_mpi_amr_close (struct adios_file_struct * fd
 
 #if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
 
+    // memory the index (merged on the aggregators) needed at most
+    if (md->index->arena)
+    {
+        adios_timing_set_value (fd->group->timing_obj, ADIOS_TIMER_MPI_AMR_INDEX_ARENA,
+                                md->index->arena->peak / (1024.0 * 1024.0));
+    }
+
     //Finished timing this cycle, swap the timing buffers
     adios_timing_destroy(fd->group->prev_timing_obj);
     fd->group->prev_timing_obj = fd->group->timing_obj;
@@ -3660,6 +3950,9 @@ void adios_mpi_amr_finalize (int mype, struct adios_method_struct * method)
     struct adios_MPI_data_struct * md = (struct adios_MPI_data_struct *)
                                                  method->method_data;
     adios_free_index_v1 (md->index);
+#if defined(MPI_VERSION) && MPI_VERSION >= 3
+    adios_mpi_amr_shm_free (md);
+#endif
 
 #ifdef HAVE_FGR
     fgr_finalize ();
@@ -695,7 +695,7 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.pg_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_process_group_index_v1 (&md->b, &md->index->pg_root);
+                adios_parse_process_group_index_arena_v1 (&md->b, &md->index->pg_root, md->index->arena);
 
 #if 1
                 adios_init_buffer_read_vars_index (&md->b);
@@ -705,9 +705,9 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.vars_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_vars_index_v1 (&md->b, &md->index->vars_root, 
+                adios_parse_vars_index_arena_v1 (&md->b, &md->index->vars_root, 
                                            md->index->hashtbl_vars,
-                                           &md->index->vars_tail);
+                                           &md->index->vars_tail, md->index->arena);
 
                 adios_init_buffer_read_attributes_index (&md->b);
                 MPI_File_seek (md->fh, md->b.attrs_index_offset
@@ -716,7 +716,7 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                 MPI_File_read (md->fh, md->b.buff, md->b.attrs_size, MPI_BYTE
                               ,&md->status
                               );
-                adios_parse_attributes_index_v1 (&md->b, &md->index->attrs_root);
+                adios_parse_attributes_index_arena_v1 (&md->b, &md->index->attrs_root, md->index->arena);
 #endif
 
                 fd->base_offset = md->b.end_of_pgs;
@@ -1026,7 +1026,7 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                     MPI_File_read (md->fh, md->b.buff, md->b.pg_size, MPI_BYTE
                                   ,&md->status
                                   );
-                    adios_parse_process_group_index_v1 (&md->b ,&md->index->pg_root);
+                    adios_parse_process_group_index_arena_v1 (&md->b ,&md->index->pg_root, md->index->arena);
 
                     adios_init_buffer_read_vars_index (&md->b);
                     MPI_File_seek (md->fh, md->b.vars_index_offset
@@ -1035,9 +1035,9 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                     MPI_File_read (md->fh, md->b.buff, md->b.vars_size, MPI_BYTE
                                   ,&md->status
                                   );
-                    adios_parse_vars_index_v1 (&md->b, &md->index->vars_root, 
+                    adios_parse_vars_index_arena_v1 (&md->b, &md->index->vars_root, 
                                                md->index->hashtbl_vars,
-                                               &md->index->vars_tail);
+                                               &md->index->vars_tail, md->index->arena);
 
 
                     adios_init_buffer_read_attributes_index (&md->b);
@@ -1047,8 +1047,9 @@ enum ADIOS_FLAG adios_mpi_lustre_should_buffer (struct adios_file_struct * fd
                     MPI_File_read (md->fh, md->b.buff, md->b.attrs_size
                                   ,MPI_BYTE, &md->status
                                   );
-                    adios_parse_attributes_index_v1 (&md->b
+                    adios_parse_attributes_index_arena_v1 (&md->b
                                                     ,&md->index->attrs_root
+                                                    ,md->index->arena
                                                     );
 
                     fd->base_offset = md->b.end_of_pgs;
@@ -13,6 +13,10 @@
 #include <math.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <limits.h>   // IOV_MAX
+#include <sys/uio.h>  // writev
+#include <pthread.h>
 
 // see if we have MPI or other tools
 #include "config.h"
@@ -22,11 +26,14 @@
 #include <mxml.h>
 
 #include "public/adios_mpi.h" // MPI or dummy MPI for seq. build
+#include "public/adios_error.h"
 #include "core/adios_transport_hooks.h"
 #include "core/adios_bp_v1.h"
 #include "core/adios_internals.h"
 #include "core/buffer.h"
 #include "core/util.h"
+#include "core/adios_logger.h"
+#include "write/adios_posix_uring.h"
 
 #if defined(__APPLE__) 
 #    define O_LARGEFILE 0
@@ -47,11 +54,41 @@
 
 static int adios_posix_initialized = 0;
 
+/* An output step written by the write-behind thread: the buffered data and
+   the index of the step. The thread owns the file and the buffers until
+   adios_posix_wait_flush() collects them. */
+struct adios_posix_flush_struct
+{
+    pthread_t thread;
+    int f;
+    char * name;
+
+    char * data;            // the output buffer taken from the file struct
+    uint64_t data_capacity; // to give it back to the buffer pool
+    uint64_t data_size;
+    uint64_t data_offset;
+
+    char * index;
+    uint64_t index_size;
+    uint64_t index_offset;
+
+    uint64_t reserved;      // bytes of the buffer budget held by data
+    struct adios_posix_uring * uring; // write through io_uring/O_DIRECT if not 0
+    int error;              // errno of the failed write or close, 0 if none
+};
+
 struct adios_POSIX_data_struct
 {
     // our file bits
     struct adios_bp_buffer_struct_v1 b;
 
+    // write the buffered output of adios_close() in the background
+    int write_behind;
+    struct adios_posix_flush_struct * flush; // step being written, 0 if none
+
+    // batch the writes of a step through io_uring and/or O_DIRECT
+    struct adios_posix_uring * uring;
+
     // old index structs we read in and have to be merged in
     struct adios_index_struct_v1 * index;
 
@@ -63,6 +100,14 @@ struct adios_POSIX_data_struct
     MPI_Comm group_comm;
     int rank;
     int size;
+
+    // When a process of the group writes its step in the background, the
+    // global metadata is written (by rank 0) once all processes have waited
+    // for their writes, at their next adios_open() with this method or at
+    // adios_finalize(). Readers must not open the file before that.
+    MPI_Comm md_comm;       // dup of group_comm, MPI_COMM_NULL if nothing pending
+    char * md_buffer;       // rank 0: the global metadata to write to mf
+    uint64_t md_size;
 #endif
 };
 
@@ -84,14 +129,291 @@ void adios_posix_init (const PairStruct * parameters
     p->index = adios_alloc_index_v1(1); // with hashtables
     p->vars_start = 0;
     p->vars_header_size = 0;
+    p->write_behind = 0;
+    p->flush = 0;
+    p->uring = 0;
 #ifdef HAVE_MPI
     p->mf = 0;
     p->group_comm = MPI_COMM_NULL;
     p->rank = 0;
     p->size = 0;
+    p->md_comm = MPI_COMM_NULL;
+    p->md_buffer = 0;
+    p->md_size = 0;
+#endif
+
+    int use_uring = 0, direct_io = 0;
+    const PairStruct * pa = parameters;
+    while (pa)
+    {
+        int * flag = 0;
+        if (!strcasecmp (pa->name, "write_behind"))
+        {
+            flag = &p->write_behind;
+        }
+        else if (!strcasecmp (pa->name, "io_uring"))
+        {
+            flag = &use_uring;
+        }
+        else if (!strcasecmp (pa->name, "direct_io"))
+        {
+            flag = &direct_io;
+        }
+
+        if (flag)
+        {
+            if (!strcasecmp (pa->value, "yes") || !strcmp (pa->value, "1"))
+            {
+                *flag = 1;
+            }
+            else if (!strcasecmp (pa->value, "no") || !strcmp (pa->value, "0"))
+            {
+                *flag = 0;
+            }
+            else
+            {
+                log_error ("Invalid '%s' parameter given to the POSIX "
+                           "method: '%s', use 'yes' or 'no'\n", pa->name, pa->value);
+            }
+        }
+        else
+        {
+            log_warn ("Parameter name %s is not recognized by the POSIX "
+                      "method\n", pa->name);
+        }
+        pa = pa->next;
+    }
+
+    p->uring = adios_posix_uring_new (use_uring, direct_io);
+}
+
+// write size bytes at offset, returns 0 or the errno of the failure
+static int adios_posix_write_at (int f, const char * buf, uint64_t size, uint64_t offset)
+{
+    ssize_t s;
+
+    while (size > 0)
+    {
+        s = pwrite (f, buf, (size > MAX_MPIWRITE_SIZE ? MAX_MPIWRITE_SIZE : size)
+                   ,(off_t) offset
+                   );
+        if (s < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (s == 0)
+        {
+            return EIO;
+        }
+        buf += s;
+        size -= s;
+        offset += s;
+    }
+
+    return 0;
+}
+
+static void * adios_posix_flush_thread (void * arg)
+{
+    struct adios_posix_flush_struct * w = (struct adios_posix_flush_struct *) arg;
+
+    if (w->uring)
+    {
+        adios_posix_uring_begin (w->uring, w->f);
+        adios_posix_uring_add (w->uring, w->data, w->data_size, w->data_offset);
+        adios_posix_uring_add (w->uring, w->index, w->index_size, w->index_offset);
+        w->error = adios_posix_uring_end (w->uring);
+    }
+    else
+    {
+        w->error = adios_posix_write_at (w->f, w->data, w->data_size, w->data_offset);
+        if (!w->error)
+        {
+            w->error = adios_posix_write_at (w->f, w->index, w->index_size, w->index_offset);
+        }
+    }
+    if (close (w->f) && !w->error)
+    {
+        w->error = errno;
+    }
+
+    return 0;
+}
+
+/* Wait for the step being written in the background, if any, and give its
+   buffer back to the pool and the buffer budget */
+#ifdef HAVE_MPI
+/* rank 0: write the global metadata and close the metadata file */
+static void adios_posix_write_md (struct adios_POSIX_data_struct * p)
+{
+    ssize_t s = write (p->mf, p->md_buffer, p->md_size);
+    if (s != p->md_size)
+    {
+        fprintf (stderr, "POSIX method tried to write %llu, "
+                         "only wrote %lld\n"
+                         ,p->md_size
+                         ,(int64_t)s
+                );
+    }
+
+    close (p->mf);
+    free (p->md_buffer);
+    p->md_buffer = 0;
+    p->md_size = 0;
+}
+
+/* Write the global metadata rank 0 has built (md_buffer) at the end of a
+   step, or leave it to adios_posix_wait_flush() if any process of the
+   group writes its step in the background. Called by all processes. */
+static void adios_posix_end_md (struct adios_POSIX_data_struct * p, int flushing)
+{
+    int * all = (int *) malloc (p->size * sizeof (int));
+    int any = flushing, i;
+
+    MPI_Allgather (&flushing, 1, MPI_INT, all, 1, MPI_INT, p->group_comm);
+    for (i = 0; i < p->size; i++)
+    {
+        any |= all [i];
+    }
+    free (all);
+
+    if (any)
+    {
+        MPI_Comm_dup (p->group_comm, &p->md_comm);
+    }
+    else if (p->md_buffer)
+    {
+        adios_posix_write_md (p);
+    }
+}
+#endif
+
+/* Wait for the step being written in the background, if any, and give its
+   buffer back to the pool and the buffer budget. Then write the global
+   metadata of the step, once the other processes are done too. */
+static void adios_posix_wait_flush (struct adios_POSIX_data_struct * p)
+{
+    struct adios_posix_flush_struct * w = p->flush;
+
+    if (w)
+    {
+        pthread_join (w->thread, NULL);
+        if (w->error)
+        {
+            adios_error (err_write_error, "POSIX method: writing %s in the background "
+                         "failed: %s\n", w->name, strerror (w->error));
+        }
+
+        adios_buffer_pool_put (w->data, w->data_capacity);
+        adios_method_buffer_free (w->reserved);
+        free (w->index);
+        free (w->name);
+        free (w);
+        p->flush = 0;
+    }
+
+#ifdef HAVE_MPI
+    if (p->md_comm != MPI_COMM_NULL)
+    {
+        // all subfiles are complete after this
+        MPI_Barrier (p->md_comm);
+        if (p->md_buffer)
+        {
+            adios_posix_write_md (p);
+        }
+        MPI_Comm_free (&p->md_comm);
+        p->md_comm = MPI_COMM_NULL;
+    }
 #endif
 }
 
+/* Hand the buffered output and the index of the step to a thread writing
+   them to the file, instead of adios_posix_do_write(). The core frees its
+   part of the buffer budget after close, so the buffer kept until the
+   write finishes is reserved again here; this is possible only if the
+   budget has room for a second buffer. The buffer is taken from the file
+   struct, so this is done only if no other method of the group writes it
+   after us, and zero-copy payloads still in user memory are written
+   synchronously. Returns 1 if the thread owns the index now. */
+static int adios_posix_start_flush (struct adios_file_struct * fd
+                                   ,struct adios_method_struct * method
+                                   ,char * index
+                                   ,uint64_t index_size
+                                   )
+{
+    struct adios_POSIX_data_struct * p = (struct adios_POSIX_data_struct *)
+                                                          method->method_data;
+    struct adios_method_list_struct * m = fd->group->methods;
+    struct adios_posix_flush_struct * w;
+
+    if (!p->write_behind || fd->shared_buffer != adios_flag_yes || fd->zero_copy_count)
+    {
+        return 0;
+    }
+
+    while (m && m->method != method)
+    {
+        m = m->next;
+    }
+    if (!m || m->next)
+    {
+        return 0;
+    }
+
+    w = (struct adios_posix_flush_struct *) calloc (1, sizeof (struct adios_posix_flush_struct));
+    if (!w)
+    {
+        return 0;
+    }
+
+    w->reserved = adios_method_buffer_alloc (fd->write_size_bytes);
+    if (w->reserved != fd->write_size_bytes)
+    {
+        log_debug ("POSIX method: no room in the buffer for writing %s "
+                   "in the background, needs %llu more bytes\n"
+                  ,fd->name, fd->write_size_bytes - w->reserved
+                  );
+        adios_method_buffer_free (w->reserved);
+        free (w);
+        return 0;
+    }
+
+    if (p->b.end_of_pgs + fd->bytes_written > fd->pg_start_in_file + fd->write_size_bytes)
+        fprintf (stderr, "adios_posix_write exceeds pg bound. File is corrupted. "
+                         "Need to enlarge group size. \n");
+
+    w->f = p->b.f;
+    w->name = strdup (fd->name);
+    w->data = fd->buffer;
+    w->data_capacity = fd->buffer_size;
+    w->data_size = fd->bytes_written;
+    w->data_offset = p->b.end_of_pgs;
+    w->index = index;
+    w->index_size = index_size;
+    // see the index location in adios_posix_do_write()
+    w->index_offset = fd->base_offset + fd->offset;
+    w->uring = p->uring;
+    adios_posix_uring_register (p->uring, fd->buffer, fd->buffer_size);
+
+    if (!w->name || pthread_create (&w->thread, NULL, adios_posix_flush_thread, w))
+    {
+        adios_method_buffer_free (w->reserved);
+        free (w->name);
+        free (w);
+        return 0;
+    }
+
+    // the thread closes the file and the core must not reuse the buffer
+    p->b.f = -1;
+    fd->buffer = 0;
+    fd->buffer_size = 0;
+    p->flush = w;
+
+    return 1;
+}
+
 
 // Indices for the timer object
 #if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
@@ -114,6 +436,9 @@ int adios_posix_open (struct adios_file_struct * fd
     struct adios_POSIX_data_struct * p = (struct adios_POSIX_data_struct *)
                                                           method->method_data;
 
+    // the previous step may still be written to this file
+    adios_posix_wait_flush (p);
+
 #if defined ADIOS_TIMERS || defined ADIOS_TIMER_EVENTS
     int timer_count = 7;
     char ** timer_names = (char**) malloc (timer_count * sizeof (char*) );
@@ -402,7 +727,7 @@ START_TIMER (ADIOS_TIMER_POSIX_AD_OPEN);
                         adios_parse_index_offsets_v1 (&p->b);
 
                         adios_posix_read_process_group_index (&p->b);
-                        adios_parse_process_group_index_v1 (&p->b, &p->index->pg_root);
+                        adios_parse_process_group_index_arena_v1 (&p->b, &p->index->pg_root, p->index->arena);
 
                         // find the largest time index so we can append properly
                         struct adios_index_process_group_struct_v1 * pg;
@@ -417,12 +742,12 @@ START_TIMER (ADIOS_TIMER_POSIX_AD_OPEN);
                         fd->group->time_index = ++max_time_index;
 
                         adios_posix_read_vars_index (&p->b);
-                        adios_parse_vars_index_v1 (&p->b, &p->index->vars_root, 
+                        adios_parse_vars_index_arena_v1 (&p->b, &p->index->vars_root, 
                                                    p->index->hashtbl_vars,
-                                                   &p->index->vars_tail);
+                                                   &p->index->vars_tail, p->index->arena);
 
                         adios_posix_read_attributes_index (&p->b);
-                        adios_parse_attributes_index_v1 (&p->b, &p->index->attrs_root);
+                        adios_parse_attributes_index_arena_v1 (&p->b, &p->index->attrs_root, p->index->arena);
 
                         fd->base_offset = p->b.end_of_pgs;
                         fd->pg_start_in_file = p->b.end_of_pgs;
@@ -534,8 +859,9 @@ void adios_posix_write (struct adios_file_struct * fd
         {
             if (v->free_data == adios_flag_yes)
             {
-                free (v->data);
                 adios_method_buffer_free (v->data_size);
+                adios_buffer_pool_put (v->data, v->data_capacity);
+                v->data_capacity = 0;
             }
         }
         else
@@ -629,7 +955,7 @@ void adios_posix_get_write_buffer (struct adios_file_struct * fd
                                   ,struct adios_method_struct * method
                                   )
 {
-    uint64_t mem_allowed;
+    uint64_t mem_allowed, capacity;
 
     if (*size == 0)
     {
@@ -641,13 +967,14 @@ void adios_posix_get_write_buffer (struct adios_file_struct * fd
     if (v->data && v->free_data)
     {
         adios_method_buffer_free (v->data_size);
-        free (v->data);
+        adios_buffer_pool_put (v->data, v->data_capacity);
+        v->data_capacity = 0;
     }
 
     mem_allowed = adios_method_buffer_alloc (*size);
     if (mem_allowed == *size)
     {
-        *buffer = malloc (*size);
+        *buffer = adios_buffer_pool_get (*size, &capacity);
         if (!*buffer)
         {
             adios_method_buffer_free (mem_allowed);
@@ -666,6 +993,7 @@ void adios_posix_get_write_buffer (struct adios_file_struct * fd
             v->got_buffer = adios_flag_yes;
             v->free_data = adios_flag_yes;
             v->data_size = mem_allowed;
+            v->data_capacity = capacity;
             v->data = *buffer;
         }
     }
@@ -693,6 +1021,104 @@ void adios_posix_read (struct adios_file_struct * fd
     v->data_size = buffer_size;
 }
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// write the buffer and the zero-copy payloads between its parts
+static void adios_posix_do_write_zero_copy (struct adios_file_struct * fd
+                                           ,struct adios_POSIX_data_struct * p
+                                           )
+{
+    struct iovec * iov = 0;
+    struct iovec * v;
+    int count, n;
+    ssize_t s;
+
+    count = adios_get_zero_copy_iovec_v1 (fd, MAX_MPIWRITE_SIZE, &iov);
+    v = iov;
+    while (count > 0)
+    {
+        n = (count > IOV_MAX ? IOV_MAX : count);
+        s = writev (p->b.f, v, n);
+        if (s < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (s <= 0)
+        {
+            adios_error (err_write_error, "POSIX method: writing %s failed: %s\n"
+                        ,fd->name, (s < 0 ? strerror (errno) : "nothing written")
+                        );
+            break;
+        }
+        // skip what has been written, a piece may be partially written
+        while (count > 0 && (size_t) s >= v->iov_len)
+        {
+            s -= v->iov_len;
+            v++;
+            count--;
+        }
+        if (count > 0)
+        {
+            v->iov_base = (char *) v->iov_base + s;
+            v->iov_len -= s;
+        }
+    }
+    free (iov);
+}
+
+// write the buffer, the zero-copy payloads and the index as one batch
+static void adios_posix_do_write_uring (struct adios_file_struct * fd
+                                       ,struct adios_POSIX_data_struct * p
+                                       ,char * buffer
+                                       ,uint64_t buffer_size
+                                       )
+{
+    struct iovec * iov = 0;
+    uint64_t offset = p->b.end_of_pgs;
+    int i, count, err;
+
+    adios_posix_uring_begin (p->uring, p->b.f);
+
+    if (fd->shared_buffer == adios_flag_yes)
+    {
+        if (p->b.end_of_pgs + fd->bytes_written + fd->zero_copy_bytes
+            > fd->pg_start_in_file + fd->write_size_bytes)
+            fprintf (stderr, "adios_posix_write exceeds pg bound. File is corrupted. "
+                             "Need to enlarge group size. \n");
+
+        adios_posix_uring_register (p->uring, fd->buffer, fd->buffer_size);
+        if (fd->zero_copy_count)
+        {
+            count = adios_get_zero_copy_iovec_v1 (fd, MAX_MPIWRITE_SIZE, &iov);
+            for (i = 0; i < count; i++)
+            {
+                adios_posix_uring_add (p->uring, iov[i].iov_base, iov[i].iov_len, offset);
+                offset += iov[i].iov_len;
+            }
+        }
+        else
+        {
+            adios_posix_uring_add (p->uring, fd->buffer, fd->bytes_written, offset);
+        }
+    }
+
+    // see the index location in adios_posix_do_write()
+    adios_posix_uring_add (p->uring, buffer, buffer_size
+                          ,fd->base_offset + fd->offset + fd->zero_copy_bytes
+                          );
+
+    err = adios_posix_uring_end (p->uring);
+    if (err)
+    {
+        fprintf (stderr, "POSIX method: writing %s failed: %s\n"
+                ,fd->name, strerror (err)
+                );
+    }
+    free (iov);
+}
+
 static void adios_posix_do_write (struct adios_file_struct * fd
                                  ,struct adios_method_struct * method
                                  ,char * buffer
@@ -704,7 +1130,23 @@ static void adios_posix_do_write (struct adios_file_struct * fd
     int32_t to_write;
     uint64_t bytes_written = 0;
 
-    if (fd->shared_buffer == adios_flag_yes)
+    if (p->uring)
+    {
+        adios_posix_do_write_uring (fd, p, buffer, buffer_size);
+        return;
+    }
+
+    if (fd->shared_buffer == adios_flag_yes && fd->zero_copy_count)
+    {
+        lseek (p->b.f, p->b.end_of_pgs, SEEK_SET);
+        if (p->b.end_of_pgs + fd->bytes_written + fd->zero_copy_bytes
+            > fd->pg_start_in_file + fd->write_size_bytes)
+            fprintf (stderr, "adios_posix_write exceeds pg bound. File is corrupted. "
+                             "Need to enlarge group size. \n");
+
+        adios_posix_do_write_zero_copy (fd, p);
+    }
+    else if (fd->shared_buffer == adios_flag_yes)
     {
         lseek (p->b.f, p->b.end_of_pgs, SEEK_SET);
         if (p->b.end_of_pgs + fd->bytes_written > fd->pg_start_in_file + fd->write_size_bytes)
@@ -742,7 +1184,8 @@ static void adios_posix_do_write (struct adios_file_struct * fd
     // for buffered, base_offset = 0, fd->offset = write loc
     // for unbuffered, base_offset = write loc, fd->offset = 0
     // for append buffered, base_offset = start, fd->offset = size
-    lseek (p->b.f, fd->base_offset + fd->offset, SEEK_SET);
+    // (zero-copy payloads are not in fd->offset)
+    lseek (p->b.f, fd->base_offset + fd->offset + fd->zero_copy_bytes, SEEK_SET);
     write (p->b.f, buffer, buffer_size);
 
 }
@@ -774,13 +1217,13 @@ static void adios_posix_do_read (struct adios_file_struct * fd
             adios_parse_index_offsets_v1 (&p->b);
 
             adios_posix_read_process_group_index (&p->b);
-            adios_parse_process_group_index_v1 (&p->b, &pg_root);
+            adios_parse_process_group_index_arena_v1 (&p->b, &pg_root, index->arena);
 #if 1
             adios_posix_read_vars_index (&p->b);
-            adios_parse_vars_index_v1 (&p->b, &index->vars_root, NULL, NULL);
+            adios_parse_vars_index_arena_v1 (&p->b, &index->vars_root, NULL, NULL, index->arena);
 
             adios_posix_read_attributes_index (&p->b);
-            adios_parse_attributes_index_v1 (&p->b, &index->attrs_root);
+            adios_parse_attributes_index_arena_v1 (&p->b, &index->attrs_root, index->arena);
 #endif
 
             // the three section headers
@@ -981,7 +1424,8 @@ void adios_posix_close (struct adios_file_struct * fd
             char * buffer = 0;
             uint64_t buffer_size = 0;
             uint64_t buffer_offset = 0;
-            uint64_t index_start = fd->base_offset + fd->offset;
+            uint64_t index_start = fd->base_offset + fd->offset
+                                 + fd->zero_copy_bytes;
 
             // build index
             adios_build_index_v1 (fd, p->index);
@@ -991,7 +1435,11 @@ void adios_posix_close (struct adios_file_struct * fd
                                  ,index_start, p->index);
             adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset);
             START_TIMER (ADIOS_TIMER_POSIX_IO);
-            adios_posix_do_write (fd, method, buffer, buffer_offset); // Buffered vars written here
+            int flushing = adios_posix_start_flush (fd, method, buffer, buffer_offset);
+            if (!flushing)
+            {
+                adios_posix_do_write (fd, method, buffer, buffer_offset); // Buffered vars written here
+            }
             STOP_TIMER (ADIOS_TIMER_POSIX_IO);
 #ifdef HAVE_MPI
             if (p->group_comm != MPI_COMM_SELF)
@@ -1078,19 +1526,9 @@ void adios_posix_close (struct adios_file_struct * fd
                                                 ,&global_index_buffer_offset
                                                 ,flag
                                                 );
-                    START_TIMER (ADIOS_TIMER_POSIX_MD);
-                    ssize_t s = write (p->mf, global_index_buffer, global_index_buffer_offset);
-                    STOP_TIMER (ADIOS_TIMER_POSIX_MD);
-                    if (s != global_index_buffer_offset)
-                    {
-                        fprintf (stderr, "POSIX method tried to write %llu, "
-                                         "only wrote %lld\n"
-                                         ,fd->bytes_written
-                                         ,(int64_t)s
-                                );
-                    }
-
-                    close (p->mf);
+                    // written by adios_posix_end_md()
+                    p->md_buffer = global_index_buffer;
+                    p->md_size = global_index_buffer_offset;
                 }
                 else
                 {
@@ -1108,9 +1546,16 @@ void adios_posix_close (struct adios_file_struct * fd
                                 );
                     STOP_TIMER (ADIOS_TIMER_POSIX_COMM);
                 }
+
+                START_TIMER (ADIOS_TIMER_POSIX_MD);
+                adios_posix_end_md (p, flushing);
+                STOP_TIMER (ADIOS_TIMER_POSIX_MD);
             }
 #endif
-            free (buffer);
+            if (!flushing)
+            {
+                free (buffer);
+            }
 
             break;
         }
@@ -1202,7 +1647,8 @@ void adios_posix_close (struct adios_file_struct * fd
             char * buffer = 0;
             uint64_t buffer_size = 0;
             uint64_t buffer_offset = 0;
-            uint64_t index_start = fd->base_offset + fd->offset;
+            uint64_t index_start = fd->base_offset + fd->offset
+                                 + fd->zero_copy_bytes;
 
             // build index
             adios_build_index_v1 (fd, p->index);
@@ -1301,21 +1747,9 @@ void adios_posix_close (struct adios_file_struct * fd
                                                 ,flag
                                                 );
 
-                    START_TIMER (ADIOS_TIMER_POSIX_MD);
-                    ssize_t s = write (p->mf, global_index_buffer, global_index_buffer_offset);
-                    STOP_TIMER (ADIOS_TIMER_POSIX_MD);
-                    if (s != global_index_buffer_offset)
-                    {
-                        fprintf (stderr, "POSIX method tried to write %llu, "
-                                         "only wrote %lld, Mode: a\n"
-                                         ,global_index_buffer_offset
-                                         ,(int64_t)s
-                                );
-                    }
-
-                    close (p->mf);
-
-                    free (global_index_buffer);
+                    // written by adios_posix_end_md()
+                    p->md_buffer = global_index_buffer;
+                    p->md_size = global_index_buffer_offset;
                 }
                 else
                 {
@@ -1335,11 +1769,20 @@ void adios_posix_close (struct adios_file_struct * fd
 #endif
             adios_write_version_v1 (&buffer, &buffer_size, &buffer_offset);
             START_TIMER (ADIOS_TIMER_POSIX_MD);
-            adios_posix_do_write (fd, method, buffer, buffer_offset);
+            int flushing = adios_posix_start_flush (fd, method, buffer, buffer_offset);
+            if (!flushing)
+            {
+                adios_posix_do_write (fd, method, buffer, buffer_offset);
+                free (buffer);
+            }
+#ifdef HAVE_MPI
+            if (p->group_comm != MPI_COMM_SELF)
+            {
+                adios_posix_end_md (p, flushing);
+            }
+#endif
             STOP_TIMER (ADIOS_TIMER_POSIX_MD);
 
-            free (buffer);
-
             break;
         }
 
@@ -1388,6 +1831,9 @@ void adios_posix_finalize (int mype, struct adios_method_struct * method)
 {
     struct adios_POSIX_data_struct * p = (struct adios_POSIX_data_struct *)
                                                           method->method_data;
+    adios_posix_wait_flush (p);
+    adios_posix_uring_free (p->uring);
+    p->uring = 0;
     adios_free_index_v1 (p->index);
     if (adios_posix_initialized)
         adios_posix_initialized = 0;
@@ -13,6 +13,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
 
 // see if we have MPI or other tools
 #include "config.h"
@@ -26,6 +27,8 @@
 #include "core/adios_internals.h"
 #include "core/buffer.h"
 #include "core/util.h"
+#include "core/adios_logger.h"
+#include "write/adios_posix_uring.h"
 
 static int adios_posix1_initialized = 0;
 
@@ -39,6 +42,9 @@ struct adios_POSIX1_data_struct
 
     uint64_t vars_start;
     uint64_t vars_header_size;
+
+    // batch the writes of a step through io_uring and/or O_DIRECT
+    struct adios_posix_uring * uring;
 };
 
 void adios_posix1_init (const PairStruct * parameters
@@ -57,6 +63,46 @@ void adios_posix1_init (const PairStruct * parameters
     p->index = adios_alloc_index_v1(1); // with hashtables
     p->vars_start = 0;
     p->vars_header_size = 0;
+
+    int use_uring = 0, direct_io = 0;
+    const PairStruct * pa = parameters;
+    while (pa)
+    {
+        int * flag = 0;
+        if (!strcasecmp (pa->name, "io_uring"))
+        {
+            flag = &use_uring;
+        }
+        else if (!strcasecmp (pa->name, "direct_io"))
+        {
+            flag = &direct_io;
+        }
+
+        if (flag)
+        {
+            if (!strcasecmp (pa->value, "yes") || !strcmp (pa->value, "1"))
+            {
+                *flag = 1;
+            }
+            else if (!strcasecmp (pa->value, "no") || !strcmp (pa->value, "0"))
+            {
+                *flag = 0;
+            }
+            else
+            {
+                log_error ("Invalid '%s' parameter given to the POSIX1 "
+                           "method: '%s', use 'yes' or 'no'\n", pa->name, pa->value);
+            }
+        }
+        else
+        {
+            log_warn ("Parameter name %s is not recognized by the POSIX1 "
+                      "method\n", pa->name);
+        }
+        pa = pa->next;
+    }
+
+    p->uring = adios_posix_uring_new (use_uring, direct_io);
 }
 
 int adios_posix1_open (struct adios_file_struct * fd
@@ -174,8 +220,9 @@ int adios_posix1_open (struct adios_file_struct * fd
                         adios_parse_index_offsets_v1 (&p->b);
 
                         adios_posix_read_process_group_index (&p->b);
-                        adios_parse_process_group_index_v1 (&p->b
+                        adios_parse_process_group_index_arena_v1 (&p->b
                                                            ,&p->index->pg_root
+                                                           ,p->index->arena
                                                            );
 
                         // find the largest time index so we can append properly
@@ -191,13 +238,14 @@ int adios_posix1_open (struct adios_file_struct * fd
                         fd->group->time_index = ++max_time_index;
 
                         adios_posix_read_vars_index (&p->b);
-                        adios_parse_vars_index_v1 (&p->b, &p->index->vars_root, 
+                        adios_parse_vars_index_arena_v1 (&p->b, &p->index->vars_root, 
                                                    p->index->hashtbl_vars,
-                                                   &p->index->vars_tail);
+                                                   &p->index->vars_tail, p->index->arena);
 
                         adios_posix_read_attributes_index (&p->b);
-                        adios_parse_attributes_index_v1 (&p->b
+                        adios_parse_attributes_index_arena_v1 (&p->b
                                                         ,&p->index->attrs_root
+                                                        ,p->index->arena
                                                         );
 
                         fd->base_offset = p->b.end_of_pgs;
@@ -452,6 +500,31 @@ static void adios_posix1_do_write (struct adios_file_struct * fd
     int32_t to_write;
     uint64_t bytes_written = 0;
 
+    if (p->uring)
+    {
+        // the buffer and the index as one batch
+        adios_posix_uring_begin (p->uring, p->b.f);
+        if (fd->shared_buffer == adios_flag_yes)
+        {
+            if (p->b.end_of_pgs + fd->bytes_written > fd->pg_start_in_file + fd->write_size_bytes)
+                fprintf (stderr, "adios_posix1_write exceeds pg bound. File is corrupted. "
+                                 "Need to enlarge group size. \n");
+
+            adios_posix_uring_register (p->uring, fd->buffer, fd->buffer_size);
+            adios_posix_uring_add (p->uring, fd->buffer, fd->bytes_written, p->b.end_of_pgs);
+        }
+        adios_posix_uring_add (p->uring, buffer, buffer_size, fd->base_offset + fd->offset);
+
+        int err = adios_posix_uring_end (p->uring);
+        if (err)
+        {
+            fprintf (stderr, "POSIX1 method: writing %s failed: %s\n"
+                    ,fd->name, strerror (err)
+                    );
+        }
+        return;
+    }
+
     if (fd->shared_buffer == adios_flag_yes)
     {
         lseek (p->b.f, p->b.end_of_pgs, SEEK_SET);
@@ -521,13 +594,13 @@ static void adios_posix1_do_read (struct adios_file_struct * fd
             adios_parse_index_offsets_v1 (&p->b);
 
             adios_posix_read_process_group_index (&p->b);
-            adios_parse_process_group_index_v1 (&p->b, &pg_root);
+            adios_parse_process_group_index_arena_v1 (&p->b, &pg_root, index->arena);
 #if 1
             adios_posix_read_vars_index (&p->b);
-            adios_parse_vars_index_v1 (&p->b, &index->vars_root, NULL, NULL);
+            adios_parse_vars_index_arena_v1 (&p->b, &index->vars_root, NULL, NULL, index->arena);
 
             adios_posix_read_attributes_index (&p->b);
-            adios_parse_attributes_index_v1 (&p->b, &index->attrs_root);
+            adios_parse_attributes_index_arena_v1 (&p->b, &index->attrs_root, index->arena);
 #endif
 
             // the three section headers
@@ -855,6 +928,8 @@ void adios_posix1_finalize (int mype, struct adios_method_struct * method)
 {
     struct adios_POSIX1_data_struct * p = (struct adios_POSIX1_data_struct *)
         method->method_data;
+    adios_posix_uring_free (p->uring);
+    p->uring = 0;
     adios_free_index_v1 (p->index);
     if (adios_posix1_initialized)
         adios_posix1_initialized = 0;
@@ -0,0 +1,576 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // O_DIRECT
+#endif
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+// see if we have MPI or other tools
+#include "config.h"
+
+#include "core/adios_logger.h"
+#include "write/adios_posix_uring.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+/* IORING_OP_WRITE came with the RW_CUR_POS feature (Linux 5.6) */
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define ADIOS_POSIX_HAVE_URING 1
+#endif
+#endif
+
+#define URING_ENTRIES   64
+#define URING_MAX_WRITE (1024*1024*1024) // per request, also the size of a registered piece
+#define URING_MAX_REGS  64               // registered pieces of the output buffer
+
+#ifdef ADIOS_POSIX_HAVE_URING
+// a queued request, to write again what a short write has left
+struct ring_request
+{
+    int f;
+    const char * buf;
+    uint64_t len;
+    uint64_t offset;
+    int res;            // result of the request, -ECANCELED until completed
+};
+#endif
+
+struct adios_posix_uring
+{
+    int use_uring;
+    int direct;
+
+    // current batch
+    int f;
+    int df;             // O_DIRECT descriptor of f, -1 if none
+    int error;
+
+#ifdef ADIOS_POSIX_HAVE_URING
+    int ring_fd;
+    unsigned entries;
+    unsigned * sq_head, * sq_tail, * sq_mask, * sq_array;
+    unsigned * cq_head, * cq_tail, * cq_mask;
+    struct io_uring_sqe * sqes;
+    struct io_uring_cqe * cqes;
+    void * sq_ptr, * cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+
+    unsigned queued;            // requests not submitted yet
+    struct io_uring_sqe * last; // last request queued, ends the chain
+    struct ring_request reqs[URING_ENTRIES];
+
+    // pieces of the output buffer registered for the current batch
+    struct iovec regs[URING_MAX_REGS];
+    int nregs;
+#endif
+};
+
+// write size bytes at offset with pwrite(), returns 0 or errno
+static int write_at (int f, const char * buf, uint64_t size, uint64_t offset)
+{
+    ssize_t s;
+
+    while (size > 0)
+    {
+        s = pwrite (f, buf, (size > URING_MAX_WRITE ? URING_MAX_WRITE : size)
+                   ,(off_t) offset
+                   );
+        if (s < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (s == 0)
+        {
+            return EIO;
+        }
+        buf += s;
+        size -= s;
+        offset += s;
+    }
+
+    return 0;
+}
+
+#ifdef ADIOS_POSIX_HAVE_URING
+
+static int ring_setup (struct adios_posix_uring * u)
+{
+    struct io_uring_params params;
+    char * sq, * cq;
+
+    memset (&params, 0, sizeof (params));
+    u->ring_fd = (int) syscall (__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (u->ring_fd < 0)
+    {
+        return errno;
+    }
+    if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        close (u->ring_fd);
+        return ENOSYS;
+    }
+
+    u->sq_len = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    u->cq_len = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (u->cq_len > u->sq_len)
+            u->sq_len = u->cq_len;
+        u->cq_len = u->sq_len;
+    }
+    u->sqes_len = params.sq_entries * sizeof (struct io_uring_sqe);
+
+    u->sq_ptr = mmap (0, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE
+                     ,u->ring_fd, IORING_OFF_SQ_RING
+                     );
+    if (u->sq_ptr == MAP_FAILED)
+    {
+        close (u->ring_fd);
+        return errno;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        u->cq_ptr = u->sq_ptr;
+    }
+    else
+    {
+        u->cq_ptr = mmap (0, u->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE
+                         ,u->ring_fd, IORING_OFF_CQ_RING
+                         );
+    }
+    u->sqes = (struct io_uring_sqe *) mmap (0, u->sqes_len, PROT_READ | PROT_WRITE
+                                           ,MAP_SHARED | MAP_POPULATE
+                                           ,u->ring_fd, IORING_OFF_SQES
+                                           );
+    if (u->cq_ptr == MAP_FAILED || u->sqes == MAP_FAILED)
+    {
+        int err = errno;
+        if (u->sqes != MAP_FAILED)
+            munmap (u->sqes, u->sqes_len);
+        if (u->cq_ptr != MAP_FAILED && u->cq_ptr != u->sq_ptr)
+            munmap (u->cq_ptr, u->cq_len);
+        munmap (u->sq_ptr, u->sq_len);
+        close (u->ring_fd);
+        return err;
+    }
+
+    sq = (char *) u->sq_ptr;
+    cq = (char *) u->cq_ptr;
+    u->sq_head = (unsigned *) (sq + params.sq_off.head);
+    u->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    u->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+    u->sq_array = (unsigned *) (sq + params.sq_off.array);
+    u->cq_head = (unsigned *) (cq + params.cq_off.head);
+    u->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+    u->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    u->entries = (params.sq_entries < URING_ENTRIES ? params.sq_entries : URING_ENTRIES);
+
+    return 0;
+}
+
+static void ring_free (struct adios_posix_uring * u)
+{
+    munmap (u->sqes, u->sqes_len);
+    if (u->cq_ptr != u->sq_ptr)
+        munmap (u->cq_ptr, u->cq_len);
+    munmap (u->sq_ptr, u->sq_len);
+    close (u->ring_fd);
+}
+
+static void ring_queue (struct adios_posix_uring * u, int f, const char * buf,
+                        uint64_t size, uint64_t offset);
+
+/* Check the results of the n requests of a submission, in the order of the
+   chain. A short write cancels the rest of the chain, so its remainder and
+   the cancelled requests are queued and submitted again, in the same order.
+   Any other failure is the error of the batch. */
+static void ring_check (struct adios_posix_uring * u, unsigned n)
+{
+    struct ring_request redo[URING_ENTRIES];
+    unsigned i, nredo = 0;
+    int cut = 0;
+
+    for (i = 0; i < n && !u->error; i++)
+    {
+        struct ring_request * r = &u->reqs[i];
+
+        if (r->res >= 0 && (uint64_t) r->res == r->len)
+        {
+            continue;
+        }
+        if (r->res > 0 && (uint64_t) r->res < r->len)
+        {
+            redo[nredo] = *r;
+            redo[nredo].buf += r->res;
+            redo[nredo].len -= r->res;
+            redo[nredo].offset += r->res;
+            nredo++;
+            cut = 1;
+        }
+        else if (r->res == -ECANCELED && cut)
+        {
+            redo[nredo++] = *r;
+        }
+        else
+        {
+            u->error = (r->res < 0 ? -r->res : EIO);
+        }
+    }
+
+    for (i = 0; i < nredo && !u->error; i++)
+    {
+        ring_queue (u, redo[i].f, redo[i].buf, redo[i].len, redo[i].offset);
+    }
+}
+
+// submit the queued requests and wait for all of them
+static void ring_submit_and_wait (struct adios_posix_uring * u)
+{
+    unsigned n = u->queued, submitted = 0, completed = 0, head, tail;
+    int ret;
+    struct io_uring_cqe * cqe;
+
+    if (!n)
+    {
+        return;
+    }
+
+    // a chain cannot go on in the next submission, which waits for this one anyway
+    u->last->flags &= ~IOSQE_IO_LINK;
+
+    while (completed < n)
+    {
+        ret = (int) syscall (__NR_io_uring_enter, u->ring_fd, n - submitted
+                            ,(submitted < n ? 0 : 1), IORING_ENTER_GETEVENTS, NULL, 0
+                            );
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // the ring is unusable, write with pwrite() from now on
+            if (!u->error)
+                u->error = errno;
+            u->use_uring = 0;
+            if (submitted < n)
+                break;
+        }
+        else if (submitted < n)
+        {
+            submitted += ret;
+        }
+
+        head = *u->cq_head;
+        tail = __atomic_load_n (u->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            cqe = &u->cqes[head & *u->cq_mask];
+            u->reqs[cqe->user_data].res = cqe->res;
+            head++;
+            completed++;
+        }
+        __atomic_store_n (u->cq_head, head, __ATOMIC_RELEASE);
+
+        if (ret < 0 && completed >= submitted)
+        {
+            break;
+        }
+    }
+
+    u->queued = 0;
+    u->last = 0;
+
+    // short writes are queued again, and submitted at the end of the batch
+    ring_check (u, n);
+}
+
+// index of the registered piece holding buf, and the bytes from buf to its end
+static int ring_find_reg (const struct adios_posix_uring * u, const char * buf, uint64_t * room)
+{
+    int i;
+
+    for (i = 0; i < u->nregs; i++)
+    {
+        const char * base = (const char *) u->regs[i].iov_base;
+        if (buf >= base && buf < base + u->regs[i].iov_len)
+        {
+            *room = base + u->regs[i].iov_len - buf;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void ring_queue (struct adios_posix_uring * u, int f, const char * buf,
+                        uint64_t size, uint64_t offset)
+{
+    struct io_uring_sqe * sqe;
+    unsigned tail, idx;
+    uint64_t len, room;
+    int reg;
+
+    while (size > 0 && u->use_uring)
+    {
+        if (u->queued == u->entries)
+        {
+            ring_submit_and_wait (u);
+            if (!u->use_uring)
+                break;
+        }
+
+        len = (size > URING_MAX_WRITE ? URING_MAX_WRITE : size);
+        reg = ring_find_reg (u, buf, &room);
+        if (reg >= 0 && room < len)
+            len = room;
+
+        tail = *u->sq_tail;
+        idx = tail & *u->sq_mask;
+        sqe = &u->sqes[idx];
+        memset (sqe, 0, sizeof (struct io_uring_sqe));
+        sqe->opcode = (reg >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE);
+        sqe->fd = f;
+        sqe->off = offset;
+        sqe->addr = (uint64_t) (uintptr_t) buf;
+        sqe->len = (uint32_t) len;
+        sqe->buf_index = (reg >= 0 ? reg : 0);
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = u->queued;
+        u->sq_array[idx] = idx;
+
+        u->reqs[u->queued].f = f;
+        u->reqs[u->queued].buf = buf;
+        u->reqs[u->queued].len = len;
+        u->reqs[u->queued].offset = offset;
+        u->reqs[u->queued].res = -ECANCELED;
+        __atomic_store_n (u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        u->queued++;
+        u->last = sqe;
+        buf += len;
+        size -= len;
+        offset += len;
+    }
+
+    if (size > 0 && !u->error)
+    {
+        u->error = write_at (f, buf, size, offset);
+    }
+}
+
+#endif /* ADIOS_POSIX_HAVE_URING */
+
+static void queue_write (struct adios_posix_uring * u, int f, const char * buf,
+                         uint64_t size, uint64_t offset)
+{
+    if (u->error || !size)
+    {
+        return;
+    }
+#ifdef ADIOS_POSIX_HAVE_URING
+    if (u->use_uring)
+    {
+        ring_queue (u, f, buf, size, offset);
+        return;
+    }
+#endif
+    u->error = write_at (f, buf, size, offset);
+}
+
+struct adios_posix_uring * adios_posix_uring_new (int use_uring, int direct)
+{
+    struct adios_posix_uring * u;
+
+    if (!use_uring && !direct)
+    {
+        return 0;
+    }
+
+    u = (struct adios_posix_uring *) calloc (1, sizeof (struct adios_posix_uring));
+    if (!u)
+    {
+        return 0;
+    }
+    u->f = -1;
+    u->df = -1;
+
+#ifdef ADIOS_POSIX_HAVE_URING
+    u->ring_fd = -1;
+    if (use_uring)
+    {
+        int err = ring_setup (u);
+        if (err)
+        {
+            log_warn ("POSIX method: cannot set up io_uring (%s), "
+                      "using blocking writes\n", strerror (err));
+            u->ring_fd = -1;
+        }
+        else
+        {
+            u->use_uring = 1;
+        }
+    }
+#else
+    if (use_uring)
+    {
+        log_warn ("POSIX method: io_uring is not supported by this build, "
+                  "using blocking writes\n");
+    }
+#endif
+
+#ifdef O_DIRECT
+    u->direct = direct;
+#else
+    if (direct)
+    {
+        log_warn ("POSIX method: direct I/O is not supported on this system\n");
+    }
+#endif
+
+    return u;
+}
+
+void adios_posix_uring_free (struct adios_posix_uring * u)
+{
+    if (!u)
+    {
+        return;
+    }
+#ifdef ADIOS_POSIX_HAVE_URING
+    if (u->ring_fd != -1)
+    {
+        ring_free (u);
+    }
+#endif
+    free (u);
+}
+
+#ifdef ADIOS_POSIX_HAVE_URING
+static void ring_unregister (struct adios_posix_uring * u)
+{
+    if (u->nregs)
+    {
+        syscall (__NR_io_uring_register, u->ring_fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        u->nregs = 0;
+    }
+}
+#endif
+
+void adios_posix_uring_register (struct adios_posix_uring * u, const void * buf, uint64_t size)
+{
+#ifdef ADIOS_POSIX_HAVE_URING
+    const char * b = (const char *) buf;
+    uint64_t off;
+    int n = 0;
+
+    if (!u || !u->use_uring || !b || !size)
+    {
+        return;
+    }
+
+    /* Registered again for each batch: the pages pinned for an earlier
+       buffer at the same address may not be the ones of this buffer. */
+    ring_unregister (u);
+
+    for (off = 0; off < size && n < URING_MAX_REGS; off += URING_MAX_WRITE, n++)
+    {
+        u->regs[n].iov_base = (void *) (b + off);
+        u->regs[n].iov_len = (size - off > URING_MAX_WRITE ? URING_MAX_WRITE : size - off);
+    }
+    if (!syscall (__NR_io_uring_register, u->ring_fd, IORING_REGISTER_BUFFERS, u->regs, n))
+    {
+        u->nregs = n;
+        return;
+    }
+
+    // e.g. over the locked memory limit, the buffer is written with plain requests
+    log_debug ("POSIX method: cannot register the output buffer for io_uring: %s\n",
+               strerror (errno));
+#endif
+}
+
+void adios_posix_uring_begin (struct adios_posix_uring * u, int f)
+{
+    u->f = f;
+    u->df = -1;
+    u->error = 0;
+
+#ifdef O_DIRECT
+    if (u->direct)
+    {
+        // a second open file description, the flags of f stay as they are
+        char path[64];
+        snprintf (path, sizeof (path), "/proc/self/fd/%d", f);
+        u->df = open (path, O_WRONLY | O_DIRECT);
+        if (u->df == -1)
+        {
+            log_debug ("POSIX method: cannot open the file for direct I/O: %s\n",
+                       strerror (errno));
+        }
+    }
+#endif
+}
+
+void adios_posix_uring_add (struct adios_posix_uring * u, const void * buf,
+                            uint64_t size, uint64_t offset)
+{
+    const char * b = (const char *) buf;
+    uint64_t head, body;
+
+    if (u->df != -1 && size >= ADIOS_POSIX_DIRECT_ALIGN)
+    {
+        head = (ADIOS_POSIX_DIRECT_ALIGN - offset % ADIOS_POSIX_DIRECT_ALIGN)
+               % ADIOS_POSIX_DIRECT_ALIGN;
+        body = (size - head) / ADIOS_POSIX_DIRECT_ALIGN * ADIOS_POSIX_DIRECT_ALIGN;
+        if (body > 0 && (uintptr_t) (b + head) % ADIOS_POSIX_DIRECT_ALIGN == 0)
+        {
+            queue_write (u, u->f, b, head, offset);
+            queue_write (u, u->df, b + head, body, offset + head);
+            queue_write (u, u->f, b + head + body, size - head - body, offset + head + body);
+            return;
+        }
+    }
+
+    queue_write (u, u->f, b, size, offset);
+}
+
+int adios_posix_uring_end (struct adios_posix_uring * u)
+{
+#ifdef ADIOS_POSIX_HAVE_URING
+    // until the remainders of short writes are written too
+    while (u->use_uring && u->queued)
+    {
+        ring_submit_and_wait (u);
+    }
+    if (u->ring_fd != -1)
+    {
+        // the buffer may be freed or reused after the batch
+        ring_unregister (u);
+    }
+#endif
+    if (u->df != -1)
+    {
+        close (u->df);
+        u->df = -1;
+    }
+    u->f = -1;
+
+    return u->error;
+}
@@ -0,0 +1,50 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+#ifndef ADIOS_POSIX_URING_H
+#define ADIOS_POSIX_URING_H
+
+#include <stdint.h>
+
+/* Writes of an output step of the POSIX methods, done as one batch.
+ *
+ * With io_uring (Linux, HAVE_LINUX_IO_URING_H) the writes of a batch are
+ * queued as linked requests: each one starts when the previous one has
+ * completed, so the index lands after the data, and the rest of the batch
+ * is cancelled if a write fails. Sources in the registered output buffers
+ * are written with fixed-buffer requests. Without io_uring, or if a ring
+ * cannot be set up, the same writes are done with pwrite() one by one.
+ *
+ * With direct I/O, the parts of the writes that are aligned to
+ * ADIOS_POSIX_DIRECT_ALIGN in the file and in memory go through a second
+ * descriptor of the file opened with O_DIRECT, bypassing the page cache,
+ * and the unaligned heads and tails go through the file descriptor.
+ */
+
+#define ADIOS_POSIX_DIRECT_ALIGN 4096
+
+struct adios_posix_uring;
+
+/* Set up for batches of writes, with io_uring and/or direct I/O.
+ * Returns NULL if nothing is asked for. */
+struct adios_posix_uring * adios_posix_uring_new (int use_uring, int direct);
+void adios_posix_uring_free (struct adios_posix_uring * u);
+
+/* Register the output buffer of the next batch for fixed-buffer writes,
+ * until the end of the batch. Failing is not an error, the buffer is
+ * written with plain requests. */
+void adios_posix_uring_register (struct adios_posix_uring * u, const void * buf, uint64_t size);
+
+/* Start a batch of writes to file f */
+void adios_posix_uring_begin (struct adios_posix_uring * u, int f);
+/* Add a write of size bytes from buf at offset of the file to the batch */
+void adios_posix_uring_add (struct adios_posix_uring * u, const void * buf,
+                            uint64_t size, uint64_t offset);
+/* Write the batch and wait for it, returns 0 or the errno of the first failure */
+int adios_posix_uring_end (struct adios_posix_uring * u);
+
+#endif
@@ -65,6 +65,10 @@ int performQuery(ADIOS_QUERY_TEST_INFO *queryInfo, ADIOS_FILE *f, int use_stream
 
         ADIOS_SELECTION* currBatch = NULL;
 
+        // estimate first, as applications do, then evaluate in batches
+        int64_t estimate = adios_query_estimate(queryInfo->query, use_streaming ? 0 : timestep);
+        fprintf(stderr, "estimated number of hits: %"PRId64"\n", estimate);
+
         while (adios_query_evaluate(queryInfo->query, queryInfo->outputSelection, use_streaming ? 0 : timestep, queryInfo->batchSize, &currBatch) >= 0) {
         	if (currBatch == NULL) {
         		break;
@@ -134,7 +138,7 @@ int main(int argc, char ** argv) {
     MPI_Init(&argc, &argv);
 
     if (argc < 4 || argc > 7) {
-        fprintf(stderr," usage: %s {input bp file} {xml file} {query engine (ALACRITY/FASTBIT)} [mode (FILE/stream)] [print points? (TRUE/false)] [read results? (true/FALSE)]\n", argv[0]);
+        fprintf(stderr," usage: %s {input bp file} {xml file} {query engine (ALACRITY/FASTBIT/MINMAX)} [mode (FILE/stream)] [print points? (TRUE/false)] [read results? (true/FALSE)]\n", argv[0]);
         MPI_Abort(comm, 1);
     }
     else {
@@ -153,6 +157,9 @@ int main(int argc, char ** argv) {
     	//fprintf(stderr,"FastBit not supported in this test yet, exiting...\n");
     	//MPI_Abort(comm, 1);
     }
+    else if (strcasecmp(argv[3], "MINMAX") == 0) {
+    	query_method = ADIOS_QUERY_METHOD_MINMAX;
+    }
     else {
     	fprintf(stderr,"Unsupported query engine %s, exiting...\n", argv[3]);
         MPI_Abort(comm, 1);
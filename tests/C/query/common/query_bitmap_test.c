@@ -0,0 +1,205 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Check the compressed query bitmap (set_bits, and, or, count, next)
+ *  against plain bitmaps of words. The bitmaps are empty, sparse (array
+ *  chunks), dense (bitmap chunks) or full, their size is not a multiple of
+ *  the chunk size or of 64, and their bits are set in runs that cross
+ *  chunk boundaries and out of order.
+ *
+ * How to run: query_bitmap_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include "query/query_bitmap.h"
+#include "core/adios_logger.h"
+
+enum pattern { EMPTY, SPARSE, DENSE, MIXED, FULL };
+static const char * pattern_names[] = { "empty", "sparse", "dense", "mixed", "full" };
+#define NPATTERNS 5
+
+/* deterministic pseudo-random numbers in [0,1) */
+static uint64_t seed = 12345;
+static double rnd ()
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (seed >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#define GETBIT(w, i) (((w)[(i) / 64] >> ((i) % 64)) & 1)
+#define SETBIT(w, i) ((w)[(i) / 64] |= (uint64_t) 1 << ((i) % 64))
+
+/* plain bitmap of nbits bits with pattern p, chunk k of MIXED alternates */
+static uint64_t * make_words (uint64_t nbits, enum pattern p)
+{
+    uint64_t * w = (uint64_t *) calloc ((nbits + 63) / 64 + 1, sizeof (uint64_t));
+    uint64_t i;
+    double density;
+
+    for (i = 0; i < nbits; i++)
+    {
+        switch (p)
+        {
+            case EMPTY:  density = 0.0; break;
+            case SPARSE: density = 0.01; break;
+            case DENSE:  density = 0.5; break;
+            case MIXED:  density = ((i >> QUERY_BITMAP_CHUNK_BITS) % 2 ? 0.3 : 0.002); break;
+            default:     density = 1.0; break;
+        }
+        if (rnd () < density)
+            SETBIT (w, i);
+    }
+    return w;
+}
+
+/* compressed copy of w, filled by runs of random length in reverse order */
+static QUERY_BITMAP * make_bitmap (const uint64_t * w, uint64_t nbits)
+{
+    QUERY_BITMAP * b = query_bitmap_new (nbits);
+    uint64_t end = nbits, n;
+
+    while (end > 0)
+    {
+        n = 1 + (uint64_t) (rnd () * 100000);
+        if (n > end)
+            n = end;
+        query_bitmap_set_bits (b, end - n, w, end - n, n);
+        end -= n;
+    }
+    query_bitmap_seal (b);
+    return b;
+}
+
+/* compare b to w with count and next, return the number of errors */
+static int check (const char * what, const QUERY_BITMAP * b, const uint64_t * w, uint64_t nbits)
+{
+    uint64_t i, count = 0, pos, expected;
+
+    for (i = 0; i < nbits; i++)
+        count += GETBIT (w, i);
+    if (query_bitmap_count (b) != count)
+    {
+        printf ("ERROR: %s of %" PRIu64 " bits: count is %" PRIu64 " instead of %" PRIu64 "\n",
+                what, nbits, query_bitmap_count (b), count);
+        return 1;
+    }
+
+    /* walk all set bits, then look from a few positions in between */
+    pos = 0;
+    for (i = 0; i <= nbits; i++)
+    {
+        if (i < nbits && !GETBIT (w, i))
+            continue;
+        pos = query_bitmap_next (b, pos);
+        if (pos != i)
+        {
+            printf ("ERROR: %s of %" PRIu64 " bits: next set bit is %" PRIu64 " instead of %" PRIu64 "\n",
+                    what, nbits, pos, i);
+            return 1;
+        }
+        if (i == nbits)
+            break;
+        pos++;
+    }
+    for (i = 0; i < 100; i++)
+    {
+        pos = (uint64_t) (rnd () * nbits);
+        for (expected = pos; expected < nbits && !GETBIT (w, expected); expected++)
+            ;
+        if (query_bitmap_next (b, pos) != expected)
+        {
+            printf ("ERROR: %s of %" PRIu64 " bits: next set bit from %" PRIu64 " is %" PRIu64
+                    " instead of %" PRIu64 "\n", what, nbits, pos, query_bitmap_next (b, pos), expected);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main (int argc, char ** argv)
+{
+    const uint64_t sizes[] = { 1, 63, 64, 1000, QUERY_BITMAP_CHUNK_SIZE,
+                               3 * QUERY_BITMAP_CHUNK_SIZE + 77 };
+    const int nsizes = sizeof (sizes) / sizeof (sizes[0]);
+    int s, p, q, errors = 0;
+    uint64_t i, nwords;
+    char what[64];
+
+    for (s = 0; s < nsizes; s++)
+    {
+        uint64_t nbits = sizes[s];
+        nwords = (nbits + 63) / 64;
+        for (p = 0; p < NPATTERNS; p++)
+        {
+            uint64_t * wa = make_words (nbits, p);
+            QUERY_BITMAP * a = make_bitmap (wa, nbits);
+
+            snprintf (what, sizeof (what), "%s bitmap", pattern_names[p]);
+            errors += check (what, a, wa, nbits);
+
+            for (q = 0; q < NPATTERNS; q++)
+            {
+                uint64_t * wb = make_words (nbits, q);
+                uint64_t * wr = (uint64_t *) malloc ((nwords + 1) * sizeof (uint64_t));
+                QUERY_BITMAP * b = make_bitmap (wb, nbits);
+                QUERY_BITMAP * r;
+
+                for (i = 0; i < nwords; i++) wr[i] = wa[i] & wb[i];
+                r = make_bitmap (wa, nbits);
+                if (query_bitmap_and (r, b))
+                {
+                    printf ("ERROR: %s AND %s failed\n", pattern_names[p], pattern_names[q]);
+                    errors++;
+                }
+                snprintf (what, sizeof (what), "%s AND %s", pattern_names[p], pattern_names[q]);
+                errors += check (what, r, wr, nbits);
+                query_bitmap_free (r);
+
+                for (i = 0; i < nwords; i++) wr[i] = wa[i] | wb[i];
+                r = make_bitmap (wa, nbits);
+                if (query_bitmap_or (r, b))
+                {
+                    printf ("ERROR: %s OR %s failed\n", pattern_names[p], pattern_names[q]);
+                    errors++;
+                }
+                snprintf (what, sizeof (what), "%s OR %s", pattern_names[p], pattern_names[q]);
+                errors += check (what, r, wr, nbits);
+                query_bitmap_free (r);
+
+                query_bitmap_free (b);
+                free (wb);
+                free (wr);
+            }
+            query_bitmap_free (a);
+            free (wa);
+        }
+    }
+
+    /* bitmaps of different sizes cannot be combined, do not log the expected error */
+    {
+        QUERY_BITMAP * a = query_bitmap_new (100);
+        QUERY_BITMAP * b = query_bitmap_new (101);
+        adios_verbose_level = 0;
+        if (!query_bitmap_and (a, b) || !query_bitmap_or (a, b))
+        {
+            printf ("ERROR: bitmaps of 100 and 101 bits were combined\n");
+            errors++;
+        }
+        query_bitmap_free (a);
+        query_bitmap_free (b);
+    }
+
+    if (errors)
+        printf ("%d errors\n", errors);
+    else
+        printf ("All query bitmap checks passed\n");
+    return errors != 0;
+}
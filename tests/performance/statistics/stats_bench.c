@@ -0,0 +1,350 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* Microbenchmark of the variable statistics computed at adios_write().
+   For every numeric ADIOS type it times the old scalar loop (copied from
+   adios_generate_var_characteristics_v1 before it used core/adios_stats.c)
+   against adios_stats_compute() and checks that both give the same result.
+   Floating point arrays contain some NaN and Inf values.
+   The only intentional difference: the old loop squared integers in the
+   element type, which overflows, so the reference here squares in double.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "core/adios_stats.h"
+#include "core/adios_internals.h"
+
+uint64_t nelems = 4*1024*1024;
+int      nreps  = 5;
+
+void printUsage(char *prgname)
+{
+    printf("Usage: %s [<n> [<reps>]]\n"
+           "  <n>     number of elements in each array (default %llu)\n"
+           "  <reps>  number of repetitions, the best time is reported (default %d)\n",
+           prgname, (unsigned long long) nelems, nreps);
+}
+
+static double now ()
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* result of one run; values are stored in the largest type */
+struct result
+{
+    long double min[3], max[3], sum[3], sum_square[3];
+    uint32_t cnt[3];
+    uint8_t finite;
+};
+
+#define IS_FINITE_INT(v) 1
+#define IS_FINITE_FLT(v) (!isnan (v) && isfinite (v))
+
+/* The old ADIOS_STATISTICS() loop */
+#define LEGACY_STATS(T, IS_FINITE)                                          \
+static void legacy_##T (void * vdata, uint64_t n, struct result * r)        \
+{                                                                           \
+    T * data = (T *) vdata;                                                 \
+    T min = 0, max = 0;                                                     \
+    double sum = 0, sum_square = 0;                                         \
+    uint32_t cnt = 0;                                                       \
+    int finite = 0;                                                         \
+    uint64_t size = 0;                                                      \
+    while (size < n)                                                        \
+    {                                                                       \
+        if (!IS_FINITE (data [size])) {                                     \
+            size ++;                                                        \
+            continue;                                                       \
+        }                                                                   \
+        if (!finite) {                                                      \
+            min = data [size];                                              \
+            max = data [size];                                              \
+            sum = data [size];                                              \
+            sum_square = ((double) data [size] * data [size]);              \
+            cnt = cnt + 1;                                                  \
+            finite = 1;                                                     \
+            size ++;                                                        \
+            continue;                                                       \
+        }                                                                   \
+        if (data [size] < min)                                              \
+            min = data [size];                                              \
+        if (data [size] > max)                                              \
+            max = data [size];                                              \
+        sum += data [size];                                                 \
+        sum_square += ((double) data [size] * data [size]);                 \
+        cnt = cnt + 1;                                                      \
+        size++;                                                             \
+    }                                                                       \
+    r->min[0] = min; r->max[0] = max;                                       \
+    r->sum[0] = sum; r->sum_square[0] = sum_square;                         \
+    r->cnt[0] = cnt; r->finite = finite;                                    \
+}
+
+typedef long double ldouble;
+
+LEGACY_STATS(int8_t, IS_FINITE_INT)
+LEGACY_STATS(uint8_t, IS_FINITE_INT)
+LEGACY_STATS(int16_t, IS_FINITE_INT)
+LEGACY_STATS(uint16_t, IS_FINITE_INT)
+LEGACY_STATS(int32_t, IS_FINITE_INT)
+LEGACY_STATS(uint32_t, IS_FINITE_INT)
+LEGACY_STATS(int64_t, IS_FINITE_INT)
+LEGACY_STATS(uint64_t, IS_FINITE_INT)
+LEGACY_STATS(float, IS_FINITE_FLT)
+LEGACY_STATS(double, IS_FINITE_FLT)
+LEGACY_STATS(ldouble, IS_FINITE_FLT)
+
+/* The old complex loops (magnitude, real, imaginary) */
+#define LEGACY_COMPLEX(NAME, T, ACC)                                        \
+static void NAME (void * vdata, uint64_t n, struct result * r)              \
+{                                                                           \
+    T * data = (T *) vdata;                                                 \
+    ACC v[3];                                                               \
+    uint64_t size = 0;                                                      \
+    int c;                                                                  \
+    for (c = 0; c < 3; c++) {                                               \
+        r->min[c] = HUGE_VAL; r->max[c] = -HUGE_VAL;                        \
+        r->sum[c] = r->sum_square[c] = 0; r->cnt[c] = 0;                    \
+    }                                                                       \
+    r->finite = 0;                                                          \
+    while (size < 2 * n)                                                    \
+    {                                                                       \
+        v[0] = sqrt ((ACC) data [size] * data [size] +                      \
+                     (ACC) data [size + 1] * data [size + 1]);              \
+        if (!IS_FINITE_FLT (data [size]) || !IS_FINITE_FLT (data [size + 1])) { \
+            size += 2;                                                      \
+            continue;                                                       \
+        }                                                                   \
+        r->finite = 1;                                                      \
+        v[1] = data [size];                                                 \
+        v[2] = data [size + 1];                                             \
+        for (c = 0; c < 3; c++) {                                           \
+            if (v[c] < r->min[c]) r->min[c] = v[c];                         \
+            if (v[c] > r->max[c]) r->max[c] = v[c];                         \
+            r->sum[c] += v[c];                                              \
+            r->sum_square[c] += v[c] * v[c];                                \
+            r->cnt[c]++;                                                    \
+        }                                                                   \
+        size += 2;                                                          \
+    }                                                                       \
+}
+
+LEGACY_COMPLEX(legacy_complex, float, double)
+LEGACY_COMPLEX(legacy_double_complex, double, long double)
+
+/* Run adios_stats_compute() and convert its output into struct result */
+#define NEW_STATS(T, VT, ST)                                                \
+static void new_##T (enum ADIOS_DATATYPES type, void * data, uint64_t n,    \
+                     struct result * r, int nsets)                          \
+{                                                                           \
+    VT min[3], max[3];                                                      \
+    ST sum[3], sum_square[3];                                               \
+    uint8_t finite[3];                                                      \
+    struct adios_stats_out out[3];                                          \
+    int c;                                                                  \
+    memset (out, 0, sizeof (out));                                          \
+    for (c = 0; c < nsets; c++) {                                           \
+        out[c].min = &min[c]; out[c].max = &max[c];                         \
+        out[c].sum = &sum[c]; out[c].sum_square = &sum_square[c];           \
+        out[c].cnt = &r->cnt[c]; out[c].finite = &finite[c];                \
+    }                                                                       \
+    adios_stats_compute (type, data, n, out);                               \
+    for (c = 0; c < nsets; c++) {                                           \
+        r->min[c] = min[c]; r->max[c] = max[c];                             \
+        r->sum[c] = sum[c]; r->sum_square[c] = sum_square[c];               \
+    }                                                                       \
+    r->finite = finite[0];                                                  \
+}
+
+NEW_STATS(int8_t, int8_t, double)
+NEW_STATS(uint8_t, uint8_t, double)
+NEW_STATS(int16_t, int16_t, double)
+NEW_STATS(uint16_t, uint16_t, double)
+NEW_STATS(int32_t, int32_t, double)
+NEW_STATS(uint32_t, uint32_t, double)
+NEW_STATS(int64_t, int64_t, double)
+NEW_STATS(uint64_t, uint64_t, double)
+NEW_STATS(float, float, double)
+NEW_STATS(double, double, double)
+NEW_STATS(ldouble, ldouble, double)
+NEW_STATS(complex, double, double)
+NEW_STATS(double_complex, ldouble, ldouble)
+
+/* deterministic pseudo-random numbers in [0,1) */
+static uint64_t seed = 12345;
+static double rnd ()
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (seed >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#define FILL_INT(T, LO, RANGE)                                              \
+    { T * d = (T *) data; for (i = 0; i < n; i++) d[i] = (T) ((LO) + rnd () * (RANGE)); }
+
+/* floating point arrays: ~1% NaN, ~1% +-Inf */
+#define FILL_FLT(T, N)                                                      \
+    { T * d = (T *) data; for (i = 0; i < (N); i++) {                       \
+        double x = rnd ();                                                  \
+        if (x < 0.01) d[i] = NAN;                                           \
+        else if (x < 0.015) d[i] = INFINITY;                                \
+        else if (x < 0.02) d[i] = -INFINITY;                                \
+        else d[i] = (T) ((rnd () - 0.5) * 2000.0); } }
+
+static void fill (enum ADIOS_DATATYPES type, void * data, uint64_t n)
+{
+    uint64_t i;
+    switch (type)
+    {
+        case adios_byte:             FILL_INT(int8_t, -128, 256) break;
+        case adios_unsigned_byte:    FILL_INT(uint8_t, 0, 256) break;
+        case adios_short:            FILL_INT(int16_t, -32768, 65536) break;
+        case adios_unsigned_short:   FILL_INT(uint16_t, 0, 65536) break;
+        case adios_integer:          FILL_INT(int32_t, -2147483648.0, 4294967296.0) break;
+        case adios_unsigned_integer: FILL_INT(uint32_t, 0, 4294967296.0) break;
+        case adios_long:             FILL_INT(int64_t, -1e18, 2e18) break;
+        case adios_unsigned_long:    FILL_INT(uint64_t, 0, 1.8e19) break;
+        case adios_real:             FILL_FLT(float, n) break;
+        case adios_double:           FILL_FLT(double, n) break;
+        case adios_long_double:      FILL_FLT(long double, n) break;
+        case adios_complex:          FILL_FLT(float, 2 * n) break;
+        case adios_double_complex:   FILL_FLT(double, 2 * n) break;
+        default: break;
+    }
+}
+
+struct bench_type
+{
+    enum ADIOS_DATATYPES type;
+    const char * name;
+    int size;
+    int nsets;
+    void (* legacy) (void *, uint64_t, struct result *);
+    void (* new) (enum ADIOS_DATATYPES, void *, uint64_t, struct result *, int);
+};
+
+static struct bench_type types[] = {
+    { adios_byte,             "byte",           1,  1, legacy_int8_t,   new_int8_t },
+    { adios_unsigned_byte,    "unsigned byte",  1,  1, legacy_uint8_t,  new_uint8_t },
+    { adios_short,            "short",          2,  1, legacy_int16_t,  new_int16_t },
+    { adios_unsigned_short,   "unsigned short", 2,  1, legacy_uint16_t, new_uint16_t },
+    { adios_integer,          "integer",        4,  1, legacy_int32_t,  new_int32_t },
+    { adios_unsigned_integer, "unsigned integer", 4, 1, legacy_uint32_t, new_uint32_t },
+    { adios_long,             "long",           8,  1, legacy_int64_t,  new_int64_t },
+    { adios_unsigned_long,    "unsigned long",  8,  1, legacy_uint64_t, new_uint64_t },
+    { adios_real,             "real",           4,  1, legacy_float,    new_float },
+    { adios_double,           "double",         8,  1, legacy_double,   new_double },
+    { adios_long_double,      "long double",    sizeof(long double), 1, legacy_ldouble, new_ldouble },
+    { adios_complex,          "complex",        8,  3, legacy_complex,  new_complex },
+    { adios_double_complex,   "double complex", 16, 3, legacy_double_complex, new_double_complex },
+};
+
+/* Sums are added up in a different order, so allow for rounding errors
+   relative to scale (a bound of the sum of absolute values). */
+static int close_enough (long double a, long double b, long double scale)
+{
+    return fabsl (a - b) <= 1e-9 * scale;
+}
+
+static int compare (struct result * a, struct result * b, int nsets)
+{
+    int c;
+    if (a->finite != b->finite)
+        return 0;
+    for (c = 0; c < nsets; c++)
+    {
+        if (a->min[c] != b->min[c] || a->max[c] != b->max[c] || a->cnt[c] != b->cnt[c])
+            return 0;
+        long double scale = sqrtl (a->sum_square[c] * a->cnt[c]);
+        if (!close_enough (a->sum[c], b->sum[c], scale)
+            || !close_enough (a->sum_square[c], b->sum_square[c], a->sum_square[c]))
+            return 0;
+    }
+    return 1;
+}
+
+int main (int argc, char ** argv)
+{
+    int t, r, nerrors = 0;
+    int ntypes = sizeof (types) / sizeof (types[0]);
+
+    if (argc > 1)
+    {
+        if (!strcmp (argv[1], "-h") || !strcmp (argv[1], "--help"))
+        {
+            printUsage (argv[0]);
+            return 0;
+        }
+        nelems = strtoull (argv[1], NULL, 10);
+    }
+    if (argc > 2)
+        nreps = atoi (argv[2]);
+    if (!nelems || nreps < 1)
+    {
+        printUsage (argv[0]);
+        return 1;
+    }
+
+    printf ("%llu elements, best of %d runs\n", (unsigned long long) nelems, nreps);
+    printf ("%-18s %12s %12s %10s %10s  %s\n",
+            "type", "old (ms)", "new (ms)", "speedup", "new GB/s", "check");
+
+    for (t = 0; t < ntypes; t++)
+    {
+        struct bench_type * bt = &types[t];
+        struct result ref, res;
+        double told = 1e30, tnew = 1e30, t0;
+        void * data = malloc (nelems * bt->size);
+
+        if (!data)
+        {
+            fprintf (stderr, "Cannot allocate %llu bytes\n",
+                     (unsigned long long) nelems * bt->size);
+            return 1;
+        }
+        fill (bt->type, data, nelems);
+
+        for (r = 0; r < nreps; r++)
+        {
+            memset (&ref, 0, sizeof (ref));
+            memset (&res, 0, sizeof (res));
+
+            t0 = now ();
+            bt->legacy (data, nelems, &ref);
+            t0 = now () - t0;
+            if (t0 < told) told = t0;
+
+            t0 = now ();
+            bt->new (bt->type, data, nelems, &res, bt->nsets);
+            t0 = now () - t0;
+            if (t0 < tnew) tnew = t0;
+        }
+
+        int ok = compare (&ref, &res, bt->nsets);
+        if (!ok)
+            nerrors++;
+        printf ("%-18s %12.3f %12.3f %10.2f %10.2f  %s\n", bt->name,
+                told * 1e3, tnew * 1e3, told / tnew,
+                nelems * bt->size / tnew / 1e9, ok ? "OK" : "MISMATCH");
+        if (!ok)
+        {
+            printf ("    old: min=%Lg max=%Lg sum=%Lg sumsq=%Lg cnt=%u finite=%d\n",
+                    ref.min[0], ref.max[0], ref.sum[0], ref.sum_square[0], ref.cnt[0], ref.finite);
+            printf ("    new: min=%Lg max=%Lg sum=%Lg sumsq=%Lg cnt=%u finite=%d\n",
+                    res.min[0], res.max[0], res.sum[0], res.sum_square[0], res.cnt[0], res.finite);
+        }
+        free (data);
+    }
+
+    return nerrors ? 1 : 0;
+}
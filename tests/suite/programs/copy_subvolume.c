@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/time.h>
 
 #include "public/adios_types.h"
 #include "core/adios_subvolume.h"
@@ -253,6 +254,170 @@ int runtest_helper(const char *cmdline) {
     return ret;
 }
 
+// Copy the subvolume one element at a time, as a reference for copy_subvolume
+static void reference_copy(char *dst, const char *src, int ndims, const uint64_t *subv_dims,
+                           const uint64_t *dst_dims, const uint64_t *dst_offsets,
+                           const uint64_t *src_dims, const uint64_t *src_offsets,
+                           int elem_size) {
+    uint64_t n = prod(ndims, (uint64_t *)subv_dims);
+    uint64_t k;
+    int d;
+
+    for (k = 0; k < n; k++) {
+        uint64_t rem = k, src_pos = 0, dst_pos = 0, stride = 1;
+        uint64_t idx[32];
+        for (d = ndims - 1; d >= 0; d--) {
+            idx[d] = rem % subv_dims[d];
+            rem /= subv_dims[d];
+        }
+        for (d = ndims - 1; d >= 0; d--) {
+            src_pos += (src_offsets[d] + idx[d]) * stride;
+            stride *= src_dims[d];
+        }
+        stride = 1;
+        for (d = ndims - 1; d >= 0; d--) {
+            dst_pos += (dst_offsets[d] + idx[d]) * stride;
+            stride *= dst_dims[d];
+        }
+        memcpy(dst + dst_pos * elem_size, src + src_pos * elem_size, elem_size);
+    }
+}
+
+/*
+ * Copy a subvolume of random data with copy_subvolume and element by element
+ * and compare the whole destination, so that bytes outside the subvolume are
+ * checked too. Returns 0 if they are the same.
+ */
+static int check_copy(int ndims, const uint64_t *subv_dims,
+                      const uint64_t *src_dims, const uint64_t *src_offsets,
+                      const uint64_t *dst_dims, const uint64_t *dst_offsets,
+                      enum ADIOS_DATATYPES type, int elem_size) {
+    uint64_t src_size = prod(ndims, (uint64_t *)src_dims) * elem_size;
+    uint64_t dst_size = prod(ndims, (uint64_t *)dst_dims) * elem_size;
+    char *src = malloc(src_size);
+    char *dst = malloc(dst_size);
+    char *expected = malloc(dst_size);
+    uint64_t i;
+    int ret;
+
+    assert(src && dst && expected);
+    for (i = 0; i < src_size; i++)
+        src[i] = (char)rand();
+    memset(dst, 0xAB, dst_size);
+    memset(expected, 0xAB, dst_size);
+
+    copy_subvolume(dst, src, ndims, subv_dims, dst_dims, dst_offsets,
+                   src_dims, src_offsets, type, adios_flag_no);
+    reference_copy(expected, src, ndims, subv_dims, dst_dims, dst_offsets,
+                   src_dims, src_offsets, elem_size);
+
+    ret = (memcmp(dst, expected, dst_size) != 0);
+    if (ret) {
+        printf("Failed: %d-D copy of %d-byte elements, subvolume", ndims, elem_size);
+        for (i = 0; i < ndims; i++)
+            printf(" %llu", (unsigned long long)subv_dims[i]);
+        printf("\n");
+    }
+
+    free(src);
+    free(dst);
+    free(expected);
+    return ret;
+}
+
+static const struct {
+    enum ADIOS_DATATYPES type;
+    int size;
+} check_types[] = {
+    { adios_byte, 1 },
+    { adios_short, 2 },
+    { adios_double, 8 },
+    { adios_double_complex, 16 },
+};
+#define NCHECK_TYPES (sizeof(check_types) / sizeof(check_types[0]))
+
+/*
+ * Copies taking each of the row kernels: short rows of every size around the
+ * fixed-size copies, 1-D to 5-D volumes, Fortran-like copies of one element
+ * per row, and one copy large enough to be split among OpenMP threads.
+ */
+static int runchecks() {
+    int t, errors = 0;
+    uint64_t n;
+
+    for (t = 0; t < NCHECK_TYPES; t++) {
+        const enum ADIOS_DATATYPES type = check_types[t].type;
+        const int size = check_types[t].size;
+
+        // 1-D
+        {
+            uint64_t sub[1] = { 100 }, sd[1] = { 150 }, so[1] = { 7 }, dd[1] = { 120 }, doff[1] = { 3 };
+            errors += check_copy(1, sub, sd, so, dd, doff, type, size);
+        }
+        // 2-D and 3-D with rows of 1 to 9 elements
+        for (n = 1; n <= 9; n++) {
+            uint64_t sub2[2] = { 13, n }, sd2[2] = { 20, 12 }, so2[2] = { 2, 1 }, dd2[2] = { 15, 11 }, do2[2] = { 1, 2 };
+            uint64_t sub3[3] = { 7, 9, n }, sd3[3] = { 10, 12, 14 }, so3[3] = { 1, 2, 3 },
+                     dd3[3] = { 9, 11, 10 }, do3[3] = { 2, 0, 1 };
+            errors += check_copy(2, sub2, sd2, so2, dd2, do2, type, size);
+            errors += check_copy(3, sub3, sd3, so3, dd3, do3, type, size);
+        }
+        // 3-D with longer rows, and with rows covering the fastest dimension
+        {
+            uint64_t sub[3] = { 5, 6, 33 }, sd[3] = { 8, 8, 40 }, so[3] = { 3, 1, 7 }, dd[3] = { 6, 7, 35 }, doff[3] = { 0, 1, 2 };
+            uint64_t sub_full[3] = { 5, 6, 40 }, doff_full[3] = { 1, 0, 0 }, dd_full[3] = { 7, 6, 40 }, so_full[3] = { 2, 2, 0 };
+            errors += check_copy(3, sub, sd, so, dd, doff, type, size);
+            errors += check_copy(3, sub_full, sd, so_full, dd_full, doff_full, type, size);
+        }
+        // 4-D and 5-D, recursing down to the 3-D kernel
+        {
+            uint64_t sub4[4] = { 3, 4, 5, 2 }, sd4[4] = { 5, 6, 7, 8 }, so4[4] = { 1, 2, 0, 3 },
+                     dd4[4] = { 4, 5, 6, 3 }, do4[4] = { 0, 1, 1, 1 };
+            uint64_t sub5[5] = { 2, 3, 2, 4, 3 }, sd5[5] = { 3, 4, 5, 6, 7 }, so5[5] = { 1, 0, 2, 1, 4 },
+                     dd5[5] = { 2, 5, 3, 4, 5 }, do5[5] = { 0, 1, 1, 0, 2 };
+            errors += check_copy(4, sub4, sd4, so4, dd4, do4, type, size);
+            errors += check_copy(5, sub5, sd5, so5, dd5, do5, type, size);
+        }
+    }
+
+    // Larger than ADIOS_SUBVOLUME_OMP_MIN_BYTES
+    {
+        uint64_t sub[2] = { 600, 2040 }, sd[2] = { 600, 2048 }, so[2] = { 0, 3 }, dd[2] = { 610, 2048 }, doff[2] = { 5, 5 };
+        assert(prod(2, sub) * sizeof(double) >= ADIOS_SUBVOLUME_OMP_MIN_BYTES);
+        errors += check_copy(2, sub, sd, so, dd, doff, adios_double, sizeof(double));
+    }
+
+    printf("%s\n", errors ? "Failed!" : "Success!");
+    return (errors ? 1 : 0);
+}
+
+/*
+ * Time reading a 256x256x2 subvolume of doubles out of a 256^3 block, a read
+ * with short rows. Not part of the tests, run as "copy_subvolume bench".
+ */
+static int runbench() {
+    const int reps = 200;
+    uint64_t src_dims[3] = { 256, 256, 256 }, src_offsets[3] = { 0, 0, 100 };
+    uint64_t subv_dims[3] = { 256, 256, 2 }, dst_offsets[3] = { 0, 0, 0 };
+    double *src = calloc(prod(3, src_dims), sizeof(double));
+    double *dst = malloc(prod(3, subv_dims) * sizeof(double));
+    struct timeval t0, t1;
+    int r;
+
+    assert(src && dst);
+    gettimeofday(&t0, NULL);
+    for (r = 0; r < reps; r++)
+        copy_subvolume(dst, src, 3, subv_dims, subv_dims, dst_offsets,
+                       src_dims, src_offsets, adios_double, adios_flag_no);
+    gettimeofday(&t1, NULL);
+
+    printf("256x256x2 out of 256^3 doubles: %.3f ms per copy\n",
+           ((t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_usec - t0.tv_usec) * 1e-3) / reps);
+    free(src);
+    free(dst);
+    return 0;
+}
+
 int main(int argc, char **argv) {
     if (argc == 1) {
         printf("Running copy_volume tests...\n");
@@ -268,7 +433,10 @@ int main(int argc, char **argv) {
         if (ret != 0)
             return ret;
 
-        return 0;
+        printf("Checking copies against an element by element copy...\n");
+        return runchecks();
+    } else if (argc == 2 && !strcmp(argv[1], "bench")) {
+        return runbench();
     } else {
         return runtest(argc, argv);
     }
@@ -9,7 +9,7 @@
  *  Write a huge number of variables
  *  Then read them all and check if they are correct. 
  *
- * How to run: mpirun -np <N> many_vars <nvars> <blocks per process> <steps>
+ * How to run: mpirun -np <N> many_vars <nvars> <blocks per process> <steps> [MPI method parameters]
  * Output: many_vars.bp
  *
  */
@@ -31,6 +31,7 @@
 int NVARS = 1;
 int NBLOCKS = 1;
 int NSTEPS = 1;
+char * METHOD_PARAMS = "";
 static const char FILENAME[] = "many_vars.bp";
 #define VALUE(rank, step, block) (step * 10000 + 10*rank + block)
 
@@ -118,10 +119,11 @@ void fini_vars()
 
 void Usage() 
 {
-    printf("Usage: many_vars <nvars> <nblocks> <nsteps>\n" 
+    printf("Usage: many_vars <nvars> <nblocks> <nsteps> [params]\n" 
             "    <nvars>:   Number of variables to generate\n"
             "    <nblocks>: Number of blocks per process to write\n"
-            "    <nsteps>:  Number of write cycles (to same file)\n");
+            "    <nsteps>:  Number of write cycles (to same file)\n"
+            "    [params]:  Parameters of the MPI write method\n");
 }
 
 void define_vars ();
@@ -155,6 +157,10 @@ int main (int argc, char ** argv)
         NSTEPS = i;
     }
 
+    if (argc > 4) {
+        METHOD_PARAMS = argv[4];
+    }
+
     alloc_vars();
     adios_init_noxml (comm);
     adios_allocate_buffer (ADIOS_BUFFER_ALLOC_NOW, 100);
@@ -164,7 +170,7 @@ int main (int argc, char ** argv)
     }
 
     adios_declare_group (&m_adios_group, "multiblock", "iter", adios_flag_yes);
-    adios_select_method (m_adios_group, "MPI", "", "");
+    adios_select_method (m_adios_group, "MPI", METHOD_PARAMS, "");
 
 
     define_vars();
@@ -8,6 +8,8 @@
 /* ADIOS C test: 
  *  Write some variables and then 
  *  read them using different selections
+ *  (point selections of each process's own block, then of all blocks,
+ *  including a 2D array decomposed along its second dimension)
  *
  * How to run: mpirun -np <N> selections
  * Output: selections.bp
@@ -41,6 +43,7 @@ int a0;
 int  *a1;
 int  *a2;
 int  *a3;
+int  *a2t;  // a2 transposed, decomposed along the second dimension
 
 /* Variables to read */
 int r0;
@@ -77,6 +80,7 @@ void alloc_vars()
     n = ldim1 * ldim2;
     a2  = (int*) malloc (n * sizeof(int));
     r2  = (int*) malloc (n * sizeof(int));
+    a2t = (int*) malloc (n * sizeof(int));
 
     n = ldim1 * ldim2 * ldim3;
     a3  = (int*) malloc (n * sizeof(int));
@@ -93,6 +97,7 @@ void set_vars(int step)
         a1[i] = VALUE1D(rank,step,i);
         for (j=0; j<ldim2; j++) {
             a2[i*ldim2+j] = VALUE2D(rank,step,i,j);
+            a2t[j*ldim1+i] = VALUE2D(rank,step,i,j);
             for (k=0; k<ldim3; k++) {
                 a3[i*ldim2*ldim3+j*ldim3+k] = VALUE3D(rank,step,i,j,k);
             }
@@ -106,6 +111,7 @@ void fini_vars()
     free (r1);
     free (a2);
     free (r2);
+    free (a2t);
     free (a3);
     free (r3);
 }
@@ -114,6 +120,7 @@ void fini_vars()
 void define_vars();
 int write_file (int step);
 int read_points ();
+int read_points_all_blocks ();
 //int read_writeblocks ();
 
 void Usage() 
@@ -200,6 +207,9 @@ int main (int argc, char ** argv)
     if (!err && do_read)
         err = read_points (); 
 
+    if (!err && do_read)
+        err = read_points_all_blocks (); 
+
     //if (!err && do_read)
     //    err = read_writerblocks (); 
 
@@ -239,6 +249,9 @@ void define_vars ()
 
     adios_define_var (m_adios_group, "a3", "", adios_integer,
             "ldim1,ldim2,ldim3", "gdim1,gdim2,gdim3", "offs1,offs2,offs3");
+
+    adios_define_var (m_adios_group, "a2t", "", adios_integer,
+            "ldim2,ldim1", "gdim2,gdim1", "offs2,offs1");
 }
 
 int write_file (int step) 
@@ -253,6 +266,7 @@ int write_file (int step)
     groupsize += 3 * sizeof(int);                           // scalars 
     groupsize += 3 * ldim1 * sizeof(int);                   // 1D 
     groupsize += 3 * ldim1 * ldim2 * sizeof(int);           // 2D 
+    groupsize += 3 * ldim1 * ldim2 * sizeof(int);           // 2D transposed
     groupsize += 3 * ldim1 * ldim2 * ldim3 * sizeof(int);   // 3D
 
     adios_group_size (fh, groupsize, &totalsize);
@@ -271,6 +285,7 @@ int write_file (int step)
     adios_write (fh, "a1", a1);
     adios_write (fh, "a2", a2);
     adios_write (fh, "a3", a3);
+    adios_write (fh, "a2t", a2t);
 
     adios_close (fh);
     MPI_Barrier (comm);
@@ -488,3 +503,118 @@ endread:
     return err;
 }
 
+/* Read points of all blocks of a variable, in reverse order so that
+   consecutive points are in different blocks, and check them. The owner
+   of a point (and its index in the owner's block) is derived from the
+   global index along the decomposed dimension.
+ */
+int read_points_all_blocks ()
+{
+    ADIOS_SELECTION *sel2, *sel3, *sel2t;
+    ADIOS_FILE * f;
+    int err=0, n, n1, i, j, k, p, owner;
+    int np2 = gdim1*gdim2, np3 = gdim1*gdim2*gdim3;
+    int v;
+
+    uint64_t *pts2 = (uint64_t*) malloc (2*sizeof(uint64_t)*np2);
+    uint64_t *pts3 = (uint64_t*) malloc (3*sizeof(uint64_t)*np3);
+    uint64_t *pts2t = (uint64_t*) malloc (2*sizeof(uint64_t)*np2);
+    int *d2 = (int*) malloc (sizeof(int)*np2);
+    int *d3 = (int*) malloc (sizeof(int)*np3);
+    int *d2t = (int*) malloc (sizeof(int)*np2);
+
+    n = np2;
+    for (i=0; i<gdim1; i++) {
+        for (j=0; j<gdim2; j++) {
+            n--;
+            pts2[2*n]   = i;
+            pts2[2*n+1] = j;
+            pts2t[2*n]   = j;
+            pts2t[2*n+1] = i;
+        }
+    }
+    n = np3;
+    for (i=0; i<gdim1; i++) {
+        for (j=0; j<gdim2; j++) {
+            for (k=0; k<gdim3; k++) {
+                n--;
+                pts3[3*n]   = i;
+                pts3[3*n+1] = j;
+                pts3[3*n+2] = k;
+            }
+        }
+    }
+
+    log ("Read and check data in %s using point selections over all blocks\n", FILENAME);
+    f = adios_read_open (FILENAME, read_method, comm,
+                         ADIOS_LOCKMODE_CURRENT, 0.0);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        err = 1;
+        goto endread;
+    }
+
+    sel2 = adios_selection_points (2, np2, pts2);
+    sel3 = adios_selection_points (3, np3, pts3);
+    sel2t = adios_selection_points (2, np2, pts2t);
+
+    n1=0;
+    while (n1 < NSTEPS && adios_errno != err_end_of_stream) {
+        n1++;
+        log ("  Step %d\n", f->current_step);
+
+        memset (d2, -1, sizeof(int)*np2);
+        memset (d3, -1, sizeof(int)*np3);
+        memset (d2t, -1, sizeof(int)*np2);
+        adios_schedule_read (f, sel2, "a2",  0, 1, d2);
+        adios_schedule_read (f, sel3, "a3",  0, 1, d3);
+        adios_schedule_read (f, sel2t, "a2t",  0, 1, d2t);
+        adios_perform_reads (f, 1);
+
+        for (p=0; p<np2; p++) {
+            owner = pts2[2*p] / ldim1;
+            v = VALUE2D(owner, f->current_step, pts2[2*p] % ldim1, pts2[2*p+1]);
+            if (d2[p] != v) {
+                printE ("Error: a2[%d,%d]=%d  !=  read=%d\n",
+                        (int)pts2[2*p], (int)pts2[2*p+1], v, d2[p]);
+                err = 1;
+            }
+            owner = pts2t[2*p+1] / ldim1;
+            v = VALUE2D(owner, f->current_step, pts2t[2*p+1] % ldim1, pts2t[2*p]);
+            if (d2t[p] != v) {
+                printE ("Error: a2t[%d,%d]=%d  !=  read=%d\n",
+                        (int)pts2t[2*p], (int)pts2t[2*p+1], v, d2t[p]);
+                err = 1;
+            }
+        }
+        for (p=0; p<np3; p++) {
+            owner = pts3[3*p] / ldim1;
+            v = VALUE3D(owner, f->current_step, pts3[3*p] % ldim1, pts3[3*p+1], pts3[3*p+2]);
+            if (d3[p] != v) {
+                printE ("Error: a3[%d,%d,%d]=%d  !=  read=%d\n",
+                        (int)pts3[3*p], (int)pts3[3*p+1], (int)pts3[3*p+2], v, d3[p]);
+                err = 1;
+            }
+        }
+
+        if (n1 < NSTEPS)
+        {
+            adios_advance_step (f, 0, -1.0);
+        }
+    }
+
+    adios_selection_delete (sel2);
+    adios_selection_delete (sel3);
+    adios_selection_delete (sel2t);
+    adios_read_close(f);
+
+endread:
+    free(pts2);
+    free(pts3);
+    free(pts2t);
+    free(d2);
+    free(d3);
+    free(d2t);
+    MPI_Barrier (comm);
+    return err;
+}
@@ -0,0 +1,278 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Check that the vectorized statistics of adios_stats_compute() (min, max,
+ *  sum, sum of squares, count, finite) are the same as the ones of its
+ *  scalar kernels, for every real type, for lengths around the vector
+ *  widths and for floating point data with NaN and Inf values (none, some,
+ *  leading, trailing, all). The scalar kernels are the ones used when a
+ *  histogram is asked for. Both are also compared to a plain loop here.
+ *
+ * How to run: stats_check
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "core/adios_stats.h"
+#include "core/adios_internals.h"
+
+/* statistics of one run, values converted to the largest type */
+struct result
+{
+    long double min, max, sum, sum_square;
+    uint32_t cnt;
+    uint8_t finite;
+};
+
+/* data patterns of the floating point arrays */
+enum pattern { PLAIN, SOME_NONFINITE, NONFINITE_FIRST, NONFINITE_LAST, ALL_NAN, ALL_INF };
+static const char * pattern_names[] = { "plain", "some NaN/Inf", "NaN/Inf first",
+                                        "NaN/Inf last", "all NaN", "all Inf" };
+#define NPATTERNS 6
+
+/* deterministic pseudo-random numbers in [0,1) */
+static uint64_t seed = 12345;
+static double rnd ()
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (seed >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#define FILL_INT(T, LO, RANGE) \
+    { T * d = (T *) data; for (i = 0; i < n; i++) d[i] = (T) ((LO) + rnd () * (RANGE)); }
+
+#define FILL_FLT(T) \
+    { T * d = (T *) data; \
+      for (i = 0; i < n; i++) { \
+          double x = rnd (); \
+          if (p == ALL_NAN) d[i] = NAN; \
+          else if (p == ALL_INF) d[i] = (i % 2 ? INFINITY : -INFINITY); \
+          else if (p == SOME_NONFINITE && x < 0.05) d[i] = NAN; \
+          else if (p == SOME_NONFINITE && x < 0.1) d[i] = (x < 0.075 ? INFINITY : -INFINITY); \
+          else d[i] = (T) ((rnd () - 0.5) * 2000.0); \
+      } \
+      if (n && p == NONFINITE_FIRST) { d[0] = NAN; if (n > 1) d[1] = -INFINITY; } \
+      if (n && p == NONFINITE_LAST) { d[n-1] = INFINITY; if (n > 1) d[n-2] = NAN; } }
+
+static void fill (enum ADIOS_DATATYPES type, void * data, uint64_t n, enum pattern p)
+{
+    uint64_t i;
+    switch (type)
+    {
+        case adios_byte:             FILL_INT(int8_t, -128, 256) break;
+        case adios_unsigned_byte:    FILL_INT(uint8_t, 0, 256) break;
+        case adios_short:            FILL_INT(int16_t, -32768, 65536) break;
+        case adios_unsigned_short:   FILL_INT(uint16_t, 0, 65536) break;
+        case adios_integer:          FILL_INT(int32_t, -2147483648.0, 4294967296.0) break;
+        case adios_unsigned_integer: FILL_INT(uint32_t, 0, 4294967296.0) break;
+        case adios_long:             FILL_INT(int64_t, -1e18, 2e18) break;
+        case adios_unsigned_long:    FILL_INT(uint64_t, 0, 1.8e19) break;
+        case adios_real:             FILL_FLT(float) break;
+        case adios_double:           FILL_FLT(double) break;
+        case adios_long_double:      FILL_FLT(long double) break;
+        default: break;
+    }
+}
+
+/* The plain loop: skip NaN and Inf, square in double */
+#define REFERENCE(T) \
+    { const T * d = (const T *) data; \
+      for (i = 0; i < n; i++) { \
+          if (!isfinite ((long double) d[i])) continue; \
+          if (!r->cnt || d[i] < r->min) r->min = d[i]; \
+          if (!r->cnt || d[i] > r->max) r->max = d[i]; \
+          r->sum += d[i]; \
+          r->sum_square += (double) d[i] * d[i]; \
+          r->cnt++; \
+      } }
+
+static void reference (enum ADIOS_DATATYPES type, const void * data, uint64_t n,
+                       struct result * r)
+{
+    uint64_t i;
+    memset (r, 0, sizeof (struct result));
+    switch (type)
+    {
+        case adios_byte:             REFERENCE(int8_t) break;
+        case adios_unsigned_byte:    REFERENCE(uint8_t) break;
+        case adios_short:            REFERENCE(int16_t) break;
+        case adios_unsigned_short:   REFERENCE(uint16_t) break;
+        case adios_integer:          REFERENCE(int32_t) break;
+        case adios_unsigned_integer: REFERENCE(uint32_t) break;
+        case adios_long:             REFERENCE(int64_t) break;
+        case adios_unsigned_long:    REFERENCE(uint64_t) break;
+        case adios_real:             REFERENCE(float) break;
+        case adios_double:           REFERENCE(double) break;
+        case adios_long_double:      REFERENCE(long double) break;
+        default: break;
+    }
+    r->finite = (r->cnt > 0);
+}
+
+/* min/max of the element type, sums in double */
+#define GET_MINMAX(T) \
+    { T a, b; memcpy (&a, &min, sizeof (T)); memcpy (&b, &max, sizeof (T)); \
+      r->min = a; r->max = b; }
+
+/* Run adios_stats_compute(), with a histogram to get the scalar kernels */
+static void compute (enum ADIOS_DATATYPES type, const void * data, uint64_t n,
+                     int scalar, struct result * r)
+{
+    long double min = 0, max = 0;   // large enough for any element type
+    double sum = 0, sum_square = 0;
+    double breaks[2] = { -100.0, 100.0 };
+    uint32_t freq[3] = { 0, 0, 0 };
+    struct adios_hist_struct hist;
+    struct adios_stats_out out;
+
+    memset (r, 0, sizeof (struct result));
+    memset (&out, 0, sizeof (out));
+    out.min = &min;
+    out.max = &max;
+    out.sum = &sum;
+    out.sum_square = &sum_square;
+    out.cnt = &r->cnt;
+    out.finite = &r->finite;
+    if (scalar)
+    {
+        hist.min = breaks[0];
+        hist.max = breaks[1];
+        hist.num_breaks = 2;
+        hist.breaks = breaks;
+        hist.frequencies = freq;
+        out.hist = &hist;
+    }
+
+    adios_stats_compute (type, data, n, &out);
+
+    switch (type)
+    {
+        case adios_byte:             GET_MINMAX(int8_t) break;
+        case adios_unsigned_byte:    GET_MINMAX(uint8_t) break;
+        case adios_short:            GET_MINMAX(int16_t) break;
+        case adios_unsigned_short:   GET_MINMAX(uint16_t) break;
+        case adios_integer:          GET_MINMAX(int32_t) break;
+        case adios_unsigned_integer: GET_MINMAX(uint32_t) break;
+        case adios_long:             GET_MINMAX(int64_t) break;
+        case adios_unsigned_long:    GET_MINMAX(uint64_t) break;
+        case adios_real:             GET_MINMAX(float) break;
+        case adios_double:           GET_MINMAX(double) break;
+        case adios_long_double:      GET_MINMAX(long double) break;
+        default: break;
+    }
+    r->sum = sum;
+    r->sum_square = sum_square;
+
+    if (scalar && freq[0] + freq[1] + freq[2] != r->cnt)
+    {
+        printf ("    histogram has %u values instead of %u\n",
+                freq[0] + freq[1] + freq[2], r->cnt);
+        r->cnt = (uint32_t) -1;
+    }
+}
+
+/* Sums are added up in a different order, so allow for rounding errors
+   relative to a bound of the sum of absolute values */
+static int close_enough (long double a, long double b, long double scale)
+{
+    return fabsl (a - b) <= 1e-9 * scale;
+}
+
+static int same (const struct result * a, const struct result * b)
+{
+    long double scale = sqrtl (a->sum_square * a->cnt);
+    if (a->finite != b->finite || a->cnt != b->cnt)
+        return 0;
+    // min/max are 0 if there is no finite value
+    if (a->cnt && (a->min != b->min || a->max != b->max))
+        return 0;
+    return close_enough (a->sum, b->sum, scale) &&
+           close_enough (a->sum_square, b->sum_square, a->sum_square);
+}
+
+static void print_result (const char * name, const struct result * r)
+{
+    printf ("    %-9s min=%Lg max=%Lg sum=%Lg sumsq=%Lg cnt=%u finite=%d\n",
+            name, r->min, r->max, r->sum, r->sum_square, r->cnt, r->finite);
+}
+
+struct check_type
+{
+    enum ADIOS_DATATYPES type;
+    const char * name;
+    int size;
+    int is_float;
+};
+
+static struct check_type types[] = {
+    { adios_byte,             "byte",             1, 0 },
+    { adios_unsigned_byte,    "unsigned byte",    1, 0 },
+    { adios_short,            "short",            2, 0 },
+    { adios_unsigned_short,   "unsigned short",   2, 0 },
+    { adios_integer,          "integer",          4, 0 },
+    { adios_unsigned_integer, "unsigned integer", 4, 0 },
+    { adios_long,             "long",             8, 0 },
+    { adios_unsigned_long,    "unsigned long",    8, 0 },
+    { adios_real,             "real",             4, 1 },
+    { adios_double,           "double",           8, 1 },
+    { adios_long_double,      "long double",      sizeof(long double), 1 },
+};
+
+/* around the SSE2/AVX2 widths and the accumulator lanes, and one split
+   among OpenMP threads (if built with OpenMP) */
+static const uint64_t lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33,
+                                    63, 64, 65, 127, 1000, 4099,
+                                    ADIOS_STATS_OMP_MIN_ELEMENTS + 3 };
+
+int main (int argc, char ** argv)
+{
+    int ntypes = sizeof (types) / sizeof (types[0]);
+    int nlengths = sizeof (lengths) / sizeof (lengths[0]);
+    int t, l, p, nerrors = 0, nchecks = 0;
+    void * data = malloc (lengths[nlengths-1] * sizeof (long double));
+
+    if (!data)
+    {
+        printf ("Cannot allocate the test data\n");
+        return 1;
+    }
+
+    for (t = 0; t < ntypes; t++)
+    {
+        for (p = 0; p < (types[t].is_float ? NPATTERNS : 1); p++)
+        {
+            for (l = 0; l < nlengths; l++)
+            {
+                struct result ref, vec, scal;
+                uint64_t n = lengths[l];
+
+                fill (types[t].type, data, n, p);
+                reference (types[t].type, data, n, &ref);
+                compute (types[t].type, data, n, 0, &vec);
+                compute (types[t].type, data, n, 1, &scal);
+                nchecks++;
+
+                if (!same (&vec, &scal) || !same (&ref, &vec))
+                {
+                    printf ("ERROR: %s, %s, %llu elements: statistics differ\n",
+                            types[t].name, pattern_names[p], (unsigned long long) n);
+                    print_result ("reference", &ref);
+                    print_result ("vector", &vec);
+                    print_result ("scalar", &scal);
+                    nerrors++;
+                }
+            }
+        }
+    }
+
+    free (data);
+    printf ("%d of %d statistics checks passed\n", nchecks - nerrors, nchecks);
+    return (nerrors ? 1 : 0);
+}
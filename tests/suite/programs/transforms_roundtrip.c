@@ -0,0 +1,314 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a 3D double array with a data transform in two steps, then read
+ *  it back in full, in a bounding box across blocks, as a single plane,
+ *  one writeblock, and as chunks (without user buffer), and check that
+ *  every value is the one written (or within the error bound of a lossy
+ *  transform).
+ *
+ * How to run: mpirun -np <N> transforms_roundtrip <transform> [abs=<E>|rel=<R>]
+ *   e.g. transforms_roundtrip "zlib:5,chunk=16,threads=4"
+ *        transforms_roundtrip "lossy:rel=1e-4" rel=1e-4
+ * Output: transforms_roundtrip.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "adios.h"
+#include "adios_read.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+#define NSTEPS 2
+static const char FILENAME[] = "transforms_roundtrip.bp";
+
+/* Block of each process, decomposed along the slowest dimension */
+static const uint64_t NX = 8;
+static const uint64_t NY = 32;
+static const uint64_t NZ = 128;   // 256 KB per block
+uint64_t gdim0;
+
+char * TRANSFORM;
+double ABS_TOL = 0;               // error bounds of the check, 0: exact
+double REL_TOL = 0;
+double block_tol [NSTEPS][1024];  // absolute error bound of each block
+
+int64_t       m_adios_group;
+MPI_Comm      comm = MPI_COMM_WORLD;
+int rank;
+int size;
+
+/*
+ * Value at global position i,j,k. Smooth in the first half of each plane,
+ * noise in the second half, so that some sub-chunks do not compress.
+ */
+double value (int step, uint64_t i, uint64_t j, uint64_t k)
+{
+    if (k < NZ/2) {
+        return step * 100.0 + i + sin (0.1 * j) * cos (0.05 * k);
+    } else {
+        uint64_t x = ((step * gdim0 + i) * NY + j) * NZ + k;
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        return step * 100.0 + (double) (x >> 11) / (double) (1ULL << 53);
+    }
+}
+
+void compute_tolerances ()
+{
+    int step, r;
+    uint64_t i, j, k;
+    for (step = 0; step < NSTEPS; step++) {
+        for (r = 0; r < size; r++) {
+            double min = value (step, r*NX, 0, 0), max = min;
+            for (i = r*NX; i < (r+1)*NX; i++)
+                for (j = 0; j < NY; j++)
+                    for (k = 0; k < NZ; k++) {
+                        double v = value (step, i, j, k);
+                        if (v < min) min = v;
+                        if (v > max) max = v;
+                    }
+            block_tol[step][r] = ABS_TOL;
+            if (REL_TOL > 0 && (block_tol[step][r] == 0 || REL_TOL * (max - min) < block_tol[step][r]))
+                block_tol[step][r] = REL_TOL * (max - min);
+        }
+    }
+}
+
+void Usage()
+{
+    printf("Usage: transforms_roundtrip <transform> [abs=<E>|rel=<R>]\n"
+            "    <transform>: Transform spec of the variable, e.g. zlib:5,chunk=16\n"
+            "    abs=<E>:     Check that values are within E of the written ones\n"
+            "    rel=<R>:     ... within R times the value range of their block\n");
+}
+
+int write_file (int step);
+int read_file ();
+
+int main (int argc, char ** argv)
+{
+    int err = 0, step;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (argc < 2 || size > 1024) { Usage(); return 1; }
+    TRANSFORM = argv[1];
+    if (argc > 2) {
+        if (!strncmp (argv[2], "abs=", 4)) {
+            ABS_TOL = atof (argv[2] + 4);
+        } else if (!strncmp (argv[2], "rel=", 4)) {
+            REL_TOL = atof (argv[2] + 4);
+        } else {
+            printf("Invalid 2nd argument %s\n", argv[2]); Usage(); return 1;
+        }
+    }
+    gdim0 = size * NX;
+    compute_tolerances ();
+
+    adios_init_noxml (comm);
+    adios_allocate_buffer (ADIOS_BUFFER_ALLOC_NOW, 10);
+    err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+    if (err) {
+        printE ("%s\n", adios_errmsg());
+    }
+
+    adios_declare_group (&m_adios_group, "roundtrip", "", adios_flag_yes);
+    adios_select_method (m_adios_group, "MPI", "", "");
+
+    adios_define_var (m_adios_group, "gdim0", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim0", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim1", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim2", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs0", "", adios_unsigned_long, 0, 0, 0);
+    int64_t varid = adios_define_var (m_adios_group, "data", "", adios_double,
+                                      "ldim0,ldim1,ldim2", "gdim0,ldim1,ldim2", "offs0,0,0");
+    if (adios_set_transform (varid, TRANSFORM)) {
+        printE ("Cannot set transform %s: %s\n", TRANSFORM, adios_errmsg());
+        err = 1;
+    }
+
+    for (step = 0; step < NSTEPS; step++) {
+        if (!err) {
+            err = write_file (step);
+        }
+    }
+
+    if (!err)
+        err = read_file ();
+
+    adios_free_group (m_adios_group);
+    adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+    adios_finalize (rank);
+    MPI_Finalize ();
+    return err;
+}
+
+int write_file (int step)
+{
+    int64_t       fh;
+    uint64_t      groupsize, totalsize;
+    uint64_t      offs0 = rank * NX;
+    uint64_t      i, j, k;
+    double        *a = (double *) malloc (NX*NY*NZ * sizeof(double));
+
+    for (i = 0; i < NX; i++)
+        for (j = 0; j < NY; j++)
+            for (k = 0; k < NZ; k++)
+                a[(i*NY + j)*NZ + k] = value (step, offs0 + i, j, k);
+
+    log ("Write step %d to %s with transform %s\n", step, FILENAME, TRANSFORM);
+    adios_open (&fh, "roundtrip", FILENAME, (step ? "a" : "w"), comm);
+    groupsize = 5 * sizeof(uint64_t) + NX*NY*NZ * sizeof(double);
+    adios_group_size (fh, groupsize, &totalsize);
+    adios_write (fh, "gdim0", &gdim0);
+    adios_write (fh, "ldim0", (void *) &NX);
+    adios_write (fh, "ldim1", (void *) &NY);
+    adios_write (fh, "ldim2", (void *) &NZ);
+    adios_write (fh, "offs0", &offs0);
+    adios_write (fh, "data", a);
+    adios_close (fh);
+
+    MPI_Barrier (comm);
+    free (a);
+    return 0;
+}
+
+/* Check count values of a box at start, returns the number of mismatches */
+int check_box (const char * what, int step, const uint64_t * start, const uint64_t * count, const double * r)
+{
+    uint64_t i, j, k;
+    int nerr = 0;
+    for (i = 0; i < count[0]; i++)
+        for (j = 0; j < count[1]; j++)
+            for (k = 0; k < count[2]; k++) {
+                uint64_t gi = start[0]+i, gj = start[1]+j, gk = start[2]+k;
+                double v = value (step, gi, gj, gk);
+                double d = r[(i*count[1] + j)*count[2] + k];
+                double tol = block_tol[step][gi / NX];
+                if ((tol == 0 && memcmp (&d, &v, sizeof(double))) || fabs (d - v) > tol) {
+                    if (nerr < 10) {
+                        printE ("%s step %d: data[%llu][%llu][%llu] = %.17g, expected %.17g (tolerance %g)\n",
+                                what, step, (unsigned long long) gi, (unsigned long long) gj,
+                                (unsigned long long) gk, d, v, tol);
+                    }
+                    nerr++;
+                }
+            }
+    return nerr;
+}
+
+int read_box (ADIOS_FILE * f, const char * what, int step, uint64_t * start, uint64_t * count)
+{
+    double * r = (double *) malloc (count[0]*count[1]*count[2] * sizeof(double));
+    ADIOS_SELECTION * sel = adios_selection_boundingbox (3, start, count);
+    int nerr;
+
+    adios_schedule_read (f, sel, "data", step, 1, r);
+    adios_perform_reads (f, 1);
+    nerr = check_box (what, step, start, count, r);
+    log ("  %s of step %d: %d errors\n", what, step, nerr);
+
+    adios_selection_delete (sel);
+    free (r);
+    return nerr;
+}
+
+int read_block (ADIOS_FILE * f, int step, int block)
+{
+    double * r = (double *) malloc (NX*NY*NZ * sizeof(double));
+    ADIOS_SELECTION * sel = adios_selection_writeblock (block);
+    uint64_t start[3] = {block*NX, 0, 0}, count[3] = {NX, NY, NZ};
+    int nerr;
+
+    adios_schedule_read (f, sel, "data", step, 1, r);
+    adios_perform_reads (f, 1);
+    nerr = check_box ("writeblock", step, start, count, r);
+    log ("  writeblock %d of step %d: %d errors\n", block, step, nerr);
+
+    adios_selection_delete (sel);
+    free (r);
+    return nerr;
+}
+
+/* Read a box without user buffer, checking each chunk returned */
+int read_chunks (ADIOS_FILE * f, int step, uint64_t * start, uint64_t * count)
+{
+    ADIOS_SELECTION * sel = adios_selection_boundingbox (3, start, count);
+    ADIOS_VARCHUNK * chunk = NULL;
+    uint64_t nread = 0;
+    int nerr = 0;
+
+    adios_schedule_read (f, sel, "data", step, 1, NULL);
+    adios_perform_reads (f, 0);
+    while (adios_check_reads (f, &chunk) > 0) {
+        if (!chunk)
+            continue;
+        if (chunk->sel->type != ADIOS_SELECTION_BOUNDINGBOX) {
+            printE ("chunk of step %d has a selection of type %d\n", step, chunk->sel->type);
+            nerr++;
+        } else {
+            const ADIOS_SELECTION_BOUNDINGBOX_STRUCT * bb = &chunk->sel->u.bb;
+            nerr += check_box ("chunk", step, bb->start, bb->count, (const double *) chunk->data);
+            nread += bb->count[0] * bb->count[1] * bb->count[2];
+        }
+        adios_free_chunk (chunk);
+    }
+    if (nread != count[0]*count[1]*count[2]) {
+        printE ("chunks of step %d hold %llu values instead of %llu\n", step,
+                (unsigned long long) nread, (unsigned long long) (count[0]*count[1]*count[2]));
+        nerr++;
+    }
+    log ("  chunks of step %d: %d errors\n", step, nerr);
+
+    adios_selection_delete (sel);
+    return nerr;
+}
+
+int read_file ()
+{
+    ADIOS_FILE * f;
+    int step, nerr = 0;
+
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    log ("Read %s back\n", FILENAME);
+    for (step = 0; step < NSTEPS; step++) {
+        uint64_t all_start[3]   = {0, 0, 0};
+        uint64_t all_count[3]   = {gdim0, NY, NZ};
+        // across the block boundaries, not aligned to sub-chunks
+        uint64_t box_start[3]   = {NX/2, 3, 5};
+        uint64_t box_count[3]   = {gdim0 - NX/2 - 1, NY - 7, NZ - 13};
+        uint64_t plane_start[3] = {gdim0 - 3, 0, 0};
+        uint64_t plane_count[3] = {1, NY, NZ};
+
+        nerr += read_box (f, "full", step, all_start, all_count);
+        nerr += read_box (f, "box", step, box_start, box_count);
+        nerr += read_box (f, "plane", step, plane_start, plane_count);
+        nerr += read_block (f, step, (rank + 1) % size);
+        nerr += read_chunks (f, step, box_start, box_count);
+    }
+
+    adios_read_close (f);
+    MPI_Barrier (comm);
+    return (nerr > 0);
+}
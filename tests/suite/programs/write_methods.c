@@ -0,0 +1,227 @@
+/*
+ * ADIOS is freely available under the terms of the BSD license described
+ * in the COPYING file in the top level directory of this source distribution.
+ *
+ * Copyright (c) 2008 - 2009.  UT-BATTELLE, LLC. All rights reserved.
+ */
+
+/* ADIOS C test:
+ *  Write a global array of uneven blocks with a given write method and
+ *  method parameters, in two steps (the first opened with "w", the second
+ *  with "a"). Then, after adios_finalize, read both steps back and check
+ *  every value. The test script compares the content written by the
+ *  methods and parameters.
+ *
+ * How to run: mpirun -np <N> write_methods <method> [method parameters]
+ *   e.g. write_methods POSIX "write_behind=yes"
+ *        write_methods BURST_BUFFER "local_path=/tmp"
+ * Output: write_methods.bp
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "adios.h"
+#include "adios_read.h"
+
+#ifdef DMALLOC
+#include "dmalloc.h"
+#endif
+
+#define log(...) fprintf (stderr, "[rank=%3.3d, line %d]: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+#define printE(...) fprintf (stderr, "[rank=%3.3d, line %d]: ERROR: ", rank, __LINE__); fprintf (stderr, __VA_ARGS__); fflush(stderr);
+
+#define NSTEPS 2
+static const char FILENAME[] = "write_methods.bp";
+
+/*
+ * Block of each process. The number of rows depends on the rank, so that
+ * the blocks, and the offsets of the blocks in the subfiles, are not
+ * multiples of the page size.
+ */
+static const uint64_t NY = 100;
+uint64_t ldim0, gdim0, offs0;
+
+char * METHOD;
+char * METHOD_PARAMS = "";
+
+int64_t       m_adios_group;
+MPI_Comm      comm = MPI_COMM_WORLD;
+int rank;
+int size;
+
+#define ROWS(r) (64 + 3*(r))
+#define VALUE(step, i, j) ((step) * 1000000.0 + (i) * 1000.0 + (j))
+
+void Usage()
+{
+    printf("Usage: write_methods <method> [params]\n"
+            "    <method>:  Write method, e.g. POSIX, BURST_BUFFER\n"
+            "    [params]:  Parameters of the write method\n");
+}
+
+int write_file (int step);
+int read_file ();
+
+int main (int argc, char ** argv)
+{
+    int err = 0, step, r;
+
+    MPI_Init (&argc, &argv);
+    MPI_Comm_rank (comm, &rank);
+    MPI_Comm_size (comm, &size);
+
+    if (argc < 2) { Usage(); return 1; }
+    METHOD = argv[1];
+    if (argc > 2) {
+        METHOD_PARAMS = argv[2];
+    }
+
+    ldim0 = ROWS(rank);
+    gdim0 = 0;
+    offs0 = 0;
+    for (r = 0; r < size; r++) {
+        if (r < rank)
+            offs0 += ROWS(r);
+        gdim0 += ROWS(r);
+    }
+
+    adios_init_noxml (comm);
+    // two steps of output, for methods writing a step in the background
+    adios_allocate_buffer (ADIOS_BUFFER_ALLOC_NOW, 10);
+
+    adios_declare_group (&m_adios_group, "methods", "", adios_flag_yes);
+    adios_select_method (m_adios_group, METHOD, METHOD_PARAMS, "");
+
+    adios_define_var (m_adios_group, "step", "", adios_integer, 0, 0, 0);
+    adios_define_var (m_adios_group, "gdim0", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim0", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "ldim1", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "offs0", "", adios_unsigned_long, 0, 0, 0);
+    adios_define_var (m_adios_group, "data", "", adios_double,
+                      "ldim0,ldim1", "gdim0,ldim1", "offs0,0");
+
+    for (step = 0; step < NSTEPS; step++) {
+        if (!err) {
+            err = write_file (step);
+        }
+    }
+
+    adios_free_group (m_adios_group);
+    // the output of some methods is complete only after this
+    adios_finalize (rank);
+
+    if (!err) {
+        err = adios_read_init_method(ADIOS_READ_METHOD_BP, comm, "verbose=2");
+        if (err) {
+            printE ("%s\n", adios_errmsg());
+        } else {
+            err = read_file ();
+            adios_read_finalize_method (ADIOS_READ_METHOD_BP);
+        }
+    }
+
+    MPI_Finalize ();
+    return err;
+}
+
+int write_file (int step)
+{
+    int64_t       fh;
+    uint64_t      groupsize, totalsize;
+    uint64_t      i, j;
+    double        *a = (double *) malloc (ldim0*NY * sizeof(double));
+
+    for (i = 0; i < ldim0; i++)
+        for (j = 0; j < NY; j++)
+            a[i*NY + j] = VALUE (step, offs0 + i, j);
+
+    log ("Write step %d to %s with %s:%s\n", step, FILENAME, METHOD, METHOD_PARAMS);
+    adios_open (&fh, "methods", FILENAME, (step ? "a" : "w"), comm);
+    groupsize = sizeof(int) + 4 * sizeof(uint64_t) + ldim0*NY * sizeof(double);
+    adios_group_size (fh, groupsize, &totalsize);
+    adios_write (fh, "step", &step);
+    adios_write (fh, "gdim0", &gdim0);
+    adios_write (fh, "ldim0", &ldim0);
+    adios_write (fh, "ldim1", (void *) &NY);
+    adios_write (fh, "offs0", &offs0);
+    adios_write (fh, "data", a);
+    adios_close (fh);
+
+    free (a);
+    return 0;
+}
+
+int read_file ()
+{
+    ADIOS_FILE * f;
+    ADIOS_VARINFO * vi;
+    ADIOS_SELECTION * sel;
+    uint64_t start[2] = {0, 0}, count[2] = {0, NY};
+    uint64_t i, j;
+    double * r;
+    int step, s, nerr = 0;
+
+    f = adios_read_open_file (FILENAME, ADIOS_READ_METHOD_BP, comm);
+    if (f == NULL) {
+        printE ("Error at opening file: %s\n", adios_errmsg());
+        return 1;
+    }
+
+    log ("Read %s back\n", FILENAME);
+    vi = adios_inq_var (f, "data");
+    if (vi == NULL) {
+        printE ("No such variable: data\n");
+        adios_read_close (f);
+        return 1;
+    }
+    if (vi->nsteps != NSTEPS || vi->ndim != 2 || vi->dims[0] != gdim0 || vi->dims[1] != NY) {
+        printE ("data has %d steps and %d dimensions %llu x %llu, expected %d steps of %llu x %llu\n",
+                vi->nsteps, vi->ndim, (unsigned long long) vi->dims[0],
+                (unsigned long long) (vi->ndim > 1 ? vi->dims[1] : 0), NSTEPS,
+                (unsigned long long) gdim0, (unsigned long long) NY);
+        nerr++;
+    }
+    adios_free_varinfo (vi);
+
+    // read the block of the next process
+    start[0] = 0;
+    for (i = 0; i < (rank + 1) % size; i++)
+        start[0] += ROWS(i);
+    count[0] = ROWS((rank + 1) % size);
+    r = (double *) malloc (count[0]*count[1] * sizeof(double));
+    sel = adios_selection_boundingbox (2, start, count);
+
+    for (step = 0; step < NSTEPS && !nerr; step++) {
+        memset (r, 0, count[0]*count[1] * sizeof(double));
+        s = -1;
+        adios_schedule_read (f, sel, "data", step, 1, r);
+        adios_schedule_read (f, NULL, "step", step, 1, &s);
+        adios_perform_reads (f, 1);
+
+        if (s != step) {
+            printE ("step %d: step is %d\n", step, s);
+            nerr++;
+        }
+        for (i = 0; i < count[0]; i++)
+            for (j = 0; j < count[1]; j++) {
+                double v = VALUE (step, start[0] + i, j);
+                if (r[i*count[1] + j] != v) {
+                    if (nerr < 10) {
+                        printE ("step %d: data[%llu][%llu] = %g, expected %g\n", step,
+                                (unsigned long long) (start[0] + i), (unsigned long long) j,
+                                r[i*count[1] + j], v);
+                    }
+                    nerr++;
+                }
+            }
+        log ("  step %d: %d errors\n", step, nerr);
+    }
+
+    adios_selection_delete (sel);
+    free (r);
+    adios_read_close (f);
+    MPI_Barrier (comm);
+    return (nerr > 0);
+}
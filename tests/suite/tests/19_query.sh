@@ -180,6 +180,15 @@ function build_indexed_datasets_fastbit() {
   set +o xtrace
 }
 
+function build_indexed_datasets_minmax() {
+  local DSID="$1"
+  local DSOUTPUT="$2"
+  [[ $# -eq 2 ]] || die "ERROR: Internal testing error, invalid parameters to build_indexed_datasets_minmax: $@"
+  
+  # MINMAX needs no index, only the block statistics every BP file has
+  invoke_dataset_builder "$DSID" "$DSOUTPUT.noindex" "none"
+}
+
 function build_datasets() {
   echo "STEP 2: INDEXING ALL TEST DATASETS USING ALL ENABLED INDEXING METHODS"
   echo "(ALSO PRODUCING A NON-INDEXED VERSION OF EACH DATASET FOR REFERENCE)"
@@ -207,6 +216,40 @@ function build_datasets() {
 }
 
 
+# Run one query with one query engine and compare the points to the expected ones
+function run_query() {
+  local QUERY_ENGINE="$1"
+  local INDEXED_DS="$2"
+  local QUERY_XML_LOCAL="$3"
+  local FILEMODE="$4"
+  local OUTPUT_POINTS_FILE="$5"
+  local EXPECTED_POINTS_FILE="$6"
+  [[ $# -eq 6 ]] || die "ERROR: Internal testing error, invalid parameters to run_query: $@"
+
+  # Run the query through ADIOS Query to get actual results
+  echo
+  echo "====== RUNNING QUERY $QUERY_NAME USING QUERY ENGINE $QUERY_ENGINE ON DATASET $DSID IN $FILEMODE MODE ======"
+  echo
+  set -o xtrace
+  $MPIRUN_SERIAL "$QUERY_EXE_LOCAL" "$INDEXED_DS" "$QUERY_XML_LOCAL" "$QUERY_ENGINE" "$FILEMODE" > "$OUTPUT_POINTS_FILE" ||
+    die "ERROR: $QUERY_EXE_LOCAL failed with exit code $?"
+  set +o xtrace
+
+  # Sort the output points in C array order, since the query engine makes no guarantee as to the ordering of the results
+  # Sort file in place (-o FILE) with numerical sort order (-n) on each of the first 9 fields (-k1,1 ...)
+  # Assumes the output will have at most 8 dimensions (+ 1 timestep column == 9), add more if needed (or use a generalized column counter)
+  sort -n -k1,1 -k2,2 -k3,3 -k4,4 -k5,5 -k6,6 -k7,7 -k8,8 -k9,9 \
+    "$OUTPUT_POINTS_FILE" -o "$OUTPUT_POINTS_FILE"
+
+  # Compare the actual and expected results via diff (the matching points are sorted by tuple components)
+  if ! diff -q "$EXPECTED_POINTS_FILE" "$OUTPUT_POINTS_FILE"; then
+    echo "ERROR: ADIOS Query does not return the expected points matching query $QUERY_NAME on dataset $DSID in $FILEMODE mode using query engine $QUERY_ENGINE"
+    echo "Compare \"$EXPECTED_POINTS_FILE\" (expected points) vs. \"$OUTPUT_POINTS_FILE\" (returned points) in \"$PWD\""
+    echo "The BP file queried is \"$INDEXED_DS\" and the query is specified by \"$QUERY_XML_LOCAL\""
+    exit 1  
+  fi
+}
+
 # STEP 3: RUN ALL QUERIES USING ALL QUERY ENGINES
 function query_datasets() {
   echo "STEP 3: RUNNING ALL QUERIES USING ALL ENABLED QUERY ENGINES ON THE INDEXED DATASETS"
@@ -258,33 +301,25 @@ function query_datasets() {
             INDEXING_NAME=${INDEXING_NAME%.bp}
 
             for FILEMODE in file stream; do
-              local OUTPUT_POINTS_FILE="$QE_WORKDIR/$DSID.$QUERY_NAME.$FILEMODE-mode.$QUERY_ENGINE-$INDEXING_NAME-points.txt"
-
-              # Run the query through ADIOS Query to get actual results
-              echo
-              echo "====== RUNNING QUERY $QUERY_NAME USING QUERY ENGINE $QUERY_ENGINE ON DATASET $DSID IN $FILEMODE MODE ======"
-              echo
-              set -o xtrace
-              $MPIRUN_SERIAL "$QUERY_EXE_LOCAL" "$INDEXED_DS" "$QUERY_XML_LOCAL" "$QUERY_ENGINE" "$FILEMODE" > "$OUTPUT_POINTS_FILE" ||
-                die "ERROR: $QUERY_EXE_LOCAL failed with exit code $?"
-              set +o xtrace
-
-              # Sort the output points in C array order, since the query engine makes no guarantee as to the ordering of the results
-              # Sort file in place (-o FILE) with numerical sort order (-n) on each of the first 9 fields (-k1,1 ...)
-              # Assumes the output will have at most 8 dimensions (+ 1 timestep column == 9), add more if needed (or use a generalized column counter)
-              sort -n -k1,1 -k2,2 -k3,3 -k4,4 -k5,5 -k6,6 -k7,7 -k8,8 -k9,9 \
-                "$OUTPUT_POINTS_FILE" -o "$OUTPUT_POINTS_FILE"
-
-              # Compare the actual and expected results via diff (the matching points are sorted by tuple components)
-              if ! diff -q "$EXPECTED_POINTS_FILE" "$OUTPUT_POINTS_FILE"; then
-                echo "ERROR: ADIOS Query does not return the expected points matching query $QUERY_NAME on dataset $DSID in $FILEMODE mode using query engine $QUERY_ENGINE"
-                echo "Compare \"$EXPECTED_POINTS_FILE\" (expected points) vs. \"$OUTPUT_POINTS_FILE\" (returned points) in \"$PWD\""
-                echo "The BP file queried is \"$INDEXED_DS\" and the query is specified by \"$QUERY_XML_LOCAL\""
-                exit 1  
-              fi
+              run_query "$QUERY_ENGINE" "$INDEXED_DS" "$QUERY_XML_LOCAL" "$FILEMODE" \
+                "$QE_WORKDIR/$DSID.$QUERY_NAME.$FILEMODE-mode.$QUERY_ENGINE-$INDEXING_NAME-points.txt" \
+                "$DSID.$QUERY_NAME.$FILEMODE-mode.expected-points.txt"
             done
           done
         done
+
+        # MINMAX scans one block at a time: also return its hits in batches
+        # much smaller than a block, after an estimate (see adios_query_test)
+        case $ALL_QUERY_ENGINES in *minmax*)
+          local BATCH_XML_LOCAL="$QUERY_NAME.batch3.xml"
+          sed -e 's/batchsize="[0-9]*"/batchsize="3"/' "$QUERY_XML_LOCAL" > "$BATCH_XML_LOCAL"
+          for FILEMODE in file stream; do
+            run_query minmax "./minmax/$DSID.minmax.noindex.bp" "$BATCH_XML_LOCAL" "$FILEMODE" \
+              "./minmax/$DSID.$QUERY_NAME.$FILEMODE-mode.minmax-batch3-points.txt" \
+              "$DSID.$QUERY_NAME.$FILEMODE-mode.expected-points.txt"
+          done
+          ;;
+        esac
       done
   done
 }
@@ -0,0 +1,50 @@
+#!/bin/bash
+#
+# Test if the MPI method's tree index reduction (index_reduction=tree)
+# produces the same index as the default gather, on a process count that
+# is not a power of two and with several blocks, variables and steps.
+# Uses ../programs/many_vars
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=5
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/many_vars .
+
+for RED in gather tree; do
+    echo "Run many_vars with index_reduction=$RED"
+    rm -f many_vars.bp
+    $MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./many_vars 4 3 3 "index_reduction=$RED"
+    EX=$?
+    if [ ! -f many_vars.bp ]; then
+        echo "ERROR: many_vars failed at creating the BP file with index_reduction=$RED. Exit code=$EX"
+        exit 1
+    fi
+    if [ $EX != 0 ]; then
+        echo "ERROR: many_vars failed with index_reduction=$RED, exit code=$EX"
+        exit 1
+    fi
+    mv many_vars.bp many_vars_$RED.bp
+    $TRUNKDIR/utils/bpls/bpls -lavD many_vars_$RED.bp | grep -v -e endianness -e 'file size' > bpls_$RED.txt
+done
+
+echo "Compare the metadata"
+diff -q bpls_gather.txt bpls_tree.txt
+if [ $? != 0 ]; then
+    echo "ERROR: index_reduction=tree produced a different index than the gather."
+    echo "Compare $PWD/bpls_gather.txt to $PWD/bpls_tree.txt"
+    exit 1
+fi
+
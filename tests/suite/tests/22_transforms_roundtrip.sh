@@ -0,0 +1,86 @@
+#!/bin/bash
+#
+# Test if the compression transforms read back what was written, in full
+# and partial selections: chunked zlib/bzip2 (chunk=, threads=),
+# shuffle+zstd with and without a dictionary (dict=), lz4, bitshuffle
+# before zstd, lz4 and zlib, the error-bounded lossy transform (abs=,
+# rel=) and auto.
+# Transforms not built into this ADIOS are skipped.
+# Uses ../programs/transforms_roundtrip
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=3
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/transforms_roundtrip .
+
+TRANSFORMS=$($TRUNKDIR/utils/list_methods/list_methods |
+  awk '/^Available/{ transforms = ($2 == "data"); next } transforms { gsub("\"","",$1); print $1 }')
+
+# transform spec, and the error bound to check (none: bit-exact)
+CASES="
+zlib:5,chunk=16,threads=4
+zlib:9,chunk=3
+bzip2:5,chunk=16,threads=4
+shuffle+zstd:3
+shuffle+zstd:3,chunk=16,threads=2
+zstd:3,dict=4
+shuffle+zstd:3,dict=4,chunk=16
+shuffle+zlib:5,chunk=16
+lz4
+lz4:9,chunk=16,threads=4
+bitshuffle+zstd:3
+bitshuffle+zstd:3,chunk=16,threads=2
+bitshuffle+lz4
+bitshuffle+lz4:chunk=16,threads=4
+bitshuffle+zlib:5,chunk=16
+lossy:abs=1e-3|abs=1e-3
+lossy:rel=1e-5|rel=1e-5
+auto
+auto:chunk=16,threads=4
+"
+
+NRUN=0
+for CASE in $CASES; do
+    SPEC=${CASE%%|*}
+    BOUND=""
+    if [ "$SPEC" != "$CASE" ]; then
+        BOUND=${CASE#*|}
+    fi
+
+    # the transform after the shuffle stage must be available
+    T=${SPEC%%:*}
+    T=${T##*+}
+    if ! echo "$TRANSFORMS" | grep -qx "$T"; then
+        echo "Skip $SPEC, $T is not available"
+        continue
+    fi
+
+    echo "Run transforms_roundtrip with $SPEC $BOUND"
+    rm -f transforms_roundtrip.bp
+    $MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./transforms_roundtrip "$SPEC" $BOUND
+    EX=$?
+    if [ $EX != 0 ]; then
+        echo "ERROR: transforms_roundtrip failed with transform $SPEC, exit code=$EX"
+        exit 1
+    fi
+    NRUN=$((NRUN+1))
+done
+
+if [ $NRUN == 0 ]; then
+    echo "WARNING: None of the transforms is available"
+    exit 77
+fi
+
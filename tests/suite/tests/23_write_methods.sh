@@ -0,0 +1,102 @@
+#!/bin/bash
+#
+# Test if the write methods that defer or stage the writes produce the same
+# output as the plain methods: POSIX with write_behind=yes, io_uring=yes and
+# direct_io=yes, POSIX1 with io_uring=yes and direct_io=yes, BURST_BUFFER
+# against POSIX, and MPI_AGGREGATE with node_aggregation=1.
+# Each run writes two steps (modes "w" then "a") and reads them back after
+# adios_finalize. The files themselves cannot be compared, since each process
+# group records the method parameters and the ADIOS timers, so the metadata,
+# the decomposition and every value (to the last bit) are compared instead.
+# Methods not built into this ADIOS are skipped.
+# Uses ../programs/write_methods
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=3
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/write_methods .
+
+METHODS=$($TRUNKDIR/utils/list_methods/list_methods |
+  awk '/^Available/{ methods = ($2 == "write"); next } methods { gsub("\"","",$1); print $1 }')
+
+rm -rf bb_local
+mkdir bb_local
+
+# all but the timers of ADIOS, which some methods do not write
+VARS="step gdim0 ldim0 ldim1 offs0 data"
+
+# name, number of processes, method, parameters, and the name of the run
+# whose output it must be identical to (none for the references)
+CASES="
+posix|$PROCS|POSIX||
+posix_behind|$PROCS|POSIX|write_behind=yes|posix
+posix_uring|$PROCS|POSIX|io_uring=yes|posix
+posix_direct|$PROCS|POSIX|direct_io=yes|posix
+posix_uring_direct|$PROCS|POSIX|io_uring=yes;direct_io=yes|posix
+posix_all|$PROCS|POSIX|write_behind=yes;io_uring=yes;direct_io=yes|posix
+burst_buffer|$PROCS|BURST_BUFFER|local_path=$PWD/bb_local|posix
+posix1|1|POSIX1||
+posix1_uring_direct|1|POSIX1|io_uring=yes;direct_io=yes|posix1
+aggr_bg|$PROCS|MPI_AGGREGATE|num_aggregators=2;num_ost=2|
+aggr_bg_node|$PROCS|MPI_AGGREGATE|num_aggregators=2;num_ost=2;node_aggregation=1|aggr_bg
+aggr_ag|$PROCS|MPI_AGGREGATE|num_aggregators=2;num_ost=2;aggregation_type=1|
+aggr_ag_node|$PROCS|MPI_AGGREGATE|num_aggregators=2;num_ost=2;aggregation_type=1;node_aggregation=1|aggr_ag
+"
+
+NRUN=0
+for CASE in $CASES; do
+    IFS='|' read NAME NP METHOD PARAMS REF <<< "$CASE"
+
+    if ! echo "$METHODS" | grep -qx "$METHOD"; then
+        echo "Skip $NAME, $METHOD is not available"
+        continue
+    fi
+    if [ -n "$REF" ] && [ ! -f bpls_$REF.txt ]; then
+        echo "Skip $NAME, $REF did not run"
+        continue
+    fi
+
+    echo "Run write_methods with $METHOD \"$PARAMS\" on $NP processes"
+    rm -rf write_methods.bp write_methods.bp.dir out_$NAME bpls_$NAME.txt
+    $MPIRUN $NP_MPIRUN $NP $EXEOPT ./write_methods $METHOD "$PARAMS"
+    EX=$?
+    if [ $EX != 0 ]; then
+        echo "ERROR: write_methods failed with $METHOD \"$PARAMS\", exit code=$EX"
+        exit 1
+    fi
+    # (the columns depend on the length of the names, including the timers)
+    $TRUNKDIR/utils/bpls/bpls -lavD write_methods.bp $VARS |
+        grep -v -e endianness -e 'file size' -e 'of variables' | tr -s ' ' > bpls_$NAME.txt
+    $TRUNKDIR/utils/bpls/bpls -d -f "%.17g" write_methods.bp data | tr -s ' ' >> bpls_$NAME.txt
+    mkdir out_$NAME
+    mv write_methods.bp* out_$NAME/
+
+    if [ -n "$REF" ]; then
+        diff -q bpls_$REF.txt bpls_$NAME.txt
+        if [ $? != 0 ]; then
+            echo "ERROR: $METHOD \"$PARAMS\" wrote different data than the $REF run."
+            echo "Compare $PWD/bpls_$REF.txt to $PWD/bpls_$NAME.txt"
+            exit 1
+        fi
+    fi
+    NRUN=$((NRUN+1))
+done
+
+if [ $NRUN == 0 ]; then
+    echo "WARNING: None of the methods is available"
+    exit 77
+fi
+
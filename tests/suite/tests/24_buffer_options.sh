@@ -0,0 +1,82 @@
+#!/bin/bash
+#
+# Test if the options of the <buffer> element that change how the output
+# buffer is filled produce the same output as the plain buffer:
+# zero-copy-threshold-KB (large arrays are written from user memory at close)
+# and deferred-write-threads (statistics and transforms of arrays are done at
+# close, along with the ADIOS timers written at each open) with the MPI and
+# POSIX methods.
+# Each case runs write_read with a modified write_read.xml and compares the
+# listing with statistics and all data of the files to the plain run.
+# write_read itself checks the values it reads back; the deferred cases marked
+# untransformed check them for arrays written without a transform even when
+# the suite runs with TRANSFORM set.
+# Uses ../programs/write_read
+#
+# Environment variables set by caller:
+# MPIRUN        Run command
+# NP_MPIRUN     Run commands option to set number of processes
+# MAXPROCS      Max number of processes allowed
+# HAVE_FORTRAN  yes or no
+# SRCDIR        Test source dir (.. of this script)
+# TRUNKDIR      ADIOS trunk dir
+
+PROCS=3
+
+if [ $MAXPROCS -lt $PROCS ]; then
+    echo "WARNING: Needs $PROCS processes at least"
+    exit 77  # not failure, just skip
+fi
+
+# copy codes and inputs to .
+cp $SRCDIR/programs/write_read .
+# (not named *.xml, add_transform_to_xmls would change it)
+cp $SRCDIR/programs/write_read.xml write_read.xml.orig
+
+# name, method, attributes added to <buffer>, the name of the run whose
+# output it must be identical to (none for the references), and "untransformed"
+# to ignore TRANSFORM
+# (with a 1KB threshold the 3D and 6D arrays are zero-copy, 1D and 2D are not)
+CASES="
+mpi|MPI|||
+mpi_zero_copy|MPI|zero-copy-threshold-KB=\"1\"|mpi|
+mpi_deferred|MPI|deferred-write-threads=\"2\"|mpi|
+mpi_deferred_plain|MPI|deferred-write-threads=\"1\"||untransformed
+posix|POSIX|||
+posix_zero_copy|POSIX|zero-copy-threshold-KB=\"1\"|posix|
+posix_deferred|POSIX|deferred-write-threads=\"2\"|posix|
+posix_deferred_plain|POSIX|deferred-write-threads=\"1\"||untransformed
+"
+
+for CASE in $CASES; do
+    IFS='|' read NAME METHOD ATTRS REF PLAIN <<< "$CASE"
+
+    sed -e "s|method=\"MPI\"|method=\"$METHOD\"|" \
+        -e "s|<buffer |<buffer $ATTRS |" write_read.xml.orig > write_read.xml
+    # Insert transform=X if requested by user
+    if [ -z "$PLAIN" ]; then
+        add_transform_to_xmls
+    fi
+
+    echo "Run write_read with $METHOD and <buffer $ATTRS>"
+    rm -rf write_read_1.bp* write_read_2.bp*
+    $MPIRUN $NP_MPIRUN $PROCS $EXEOPT ./write_read
+    EX=$?
+    if [ $EX != 0 ]; then
+        echo "ERROR: write_read failed with $METHOD and <buffer $ATTRS>, exit code=$EX"
+        exit 1
+    fi
+
+    $TRUNKDIR/utils/bpls/bpls -la write_read_1.bp > bpls_$NAME.txt
+    $TRUNKDIR/utils/bpls/bpls -d write_read_1.bp >> bpls_$NAME.txt
+
+    if [ -n "$REF" ]; then
+        diff -q bpls_$REF.txt bpls_$NAME.txt
+        if [ $? != 0 ]; then
+            echo "ERROR: $METHOD with <buffer $ATTRS> wrote different data than the $REF run."
+            echo "Compare $PWD/bpls_$REF.txt to $PWD/bpls_$NAME.txt"
+            exit 1
+        fi
+    fi
+done
+
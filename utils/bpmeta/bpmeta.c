@@ -23,6 +23,7 @@
 #include "adios_transport_hooks.h"
 #include "adios_bp_v1.h"
 #include "bp_utils.h"
+#include "bpidx.h"
 #include "adios_transforms_common.h" // NCSU ALACRITY-ADIOS
 #include "adios_transforms_read.h" // NCSU ALACRITY-ADIOS
 
@@ -38,11 +39,13 @@ int nthreads=1;  // Number of threads to use (main counts as 1 thread)
 char * filename; // process 'filename'.dir/'filename'.NNN subfiles and 
                  //   generate metadata file 'filename'
 int nsubfiles=0; // number of subfiles to process
+int write_sidecar=0; // 1: also write the 'filename'.bpidx index sidecar
 
 struct option options[] = {
     {"help",                 no_argument,          NULL,    'h'},
     {"verbose",              no_argument,          NULL,    'v'},
     {"nsubfiles",            required_argument,    NULL,    'n'},
+    {"index",                no_argument,          NULL,    'i'},
 #if HAVE_PTHREAD
     {"nthreads",             required_argument,    NULL,    't'},
 #endif
@@ -50,9 +53,9 @@ struct option options[] = {
 };
 
 #if HAVE_PTHREAD
-static const char *optstring = "hvn:t:";
+static const char *optstring = "hvin:t:";
 #else
-static const char *optstring = "hvn:";
+static const char *optstring = "hvin:";
 #endif
 
 // help function
@@ -65,6 +68,8 @@ void display_help() {
             "\n"
             "  --nsubfiles | -n <N>   The number of subfiles to process in\n"
             "                           <filename>.dir\n"
+            "  --index     | -i       Also write the index sidecar <filename>.bpidx\n"
+            "                           used by the BP read method with 'use_bpidx'\n"
 #if HAVE_PTHREAD
             "  --nthreads  | -t <T>   Parallel reading with <T> threads.\n"
             "                           The main thread is counted in.\n"
@@ -86,6 +91,7 @@ struct adios_index_struct_v1 ** subindex;
 
 int process_subfiles (int tid, int startidx, int endidx);
 int write_index (struct adios_index_struct_v1 * index, char * fname);
+int write_bpidx (char * fname);
 int get_nsubfiles (char *filename);
 void print_pg_index ( int tid, struct adios_index_process_group_struct_v1 * pg_root);
 void print_variable_index (int tid, struct adios_index_var_struct_v1 * vars_root);
@@ -139,6 +145,10 @@ int main (int argc, char ** argv)
                 verbose++;
                 break;
 
+            case 'i':
+                write_sidecar = 1;
+                break;
+
             default:
                 printf("Unrecognized argument: %s\n", optarg);
                 break;
@@ -259,6 +269,8 @@ int main (int argc, char ** argv)
                               subindex[tid]->attrs_root); 
     }
     write_index (globalindex, filename);
+    if (write_sidecar)
+        write_bpidx (filename);
 
     /* Clean-up */
     adios_clear_index_v1 (globalindex);
@@ -321,6 +333,35 @@ int write_index (struct adios_index_struct_v1 * index, char * fname)
     return 0;
 }
 
+/* Open the metadata file just written and generate its index sidecar */
+int write_bpidx (char * fname)
+{
+    BP_FILE * fh;
+    int err;
+
+    fh = (BP_FILE *) calloc (1, sizeof (BP_FILE));
+    fh->fname = strdup (fname);
+    fh->comm = MPI_COMM_SELF;
+    fh->b = malloc (sizeof (struct adios_bp_buffer_struct_v1));
+
+    if (bp_open (fname, MPI_COMM_SELF, fh))
+    {
+        fprintf (stderr, "Failed to open metadata file %s to index it\n", fname);
+        bp_close (fh);
+        return -1;
+    }
+
+    err = bpidx_write (fh, fname);
+    if (verbose && !err) {
+        char * name = bpidx_filename (fname);
+        printf ("Wrote index sidecar %s\n", name);
+        free (name);
+    }
+
+    bp_close (fh);
+    return err;
+}
+
 int process_subfiles (int tid, int startidx, int endidx)
 {
     char fn[256];